@@ -100,6 +100,42 @@ for index, app in enumerate(context['applications']):
     app['id'] = index + 1
 
 
+# COMMANDS
+# build a perfect hash table for the host commands; the same FNV-1a variant is
+# implemented in i2c_stick_cmd_table.cpp (i2c_stick_cmd_hash).
+def command_hash(token, seed, size):
+    h = seed
+    for c in token.encode():
+        h ^= c
+        h = (h * 16777619) & 0xFFFFFFFF
+    h ^= h >> 16
+    return h & (size - 1)
+
+
+def build_command_table(commands):
+    size = 1
+    while size < len(commands):
+        size <<= 1
+    while True:
+        for seed in range(1, 0x10000):
+            indexes = [command_hash(cmd['token'], seed, size) for cmd in commands]
+            if len(set(indexes)) == len(indexes):
+                slots = [None] * size
+                for cmd, index in zip(commands, indexes):
+                    slots[index] = cmd
+                return {'seed': seed, 'size': size, 'slots': slots}
+        size <<= 1
+
+
+for cmd in context['commands']:
+    cmd['token'] = cmd['match'].rstrip(':')
+    cmd['handler'] = 'handle_cmd_token_' + cmd['name']
+    if 'help' not in cmd:
+        cmd['help'] = ''
+
+context['command_table'] = build_command_table(context['commands'])
+
+
 # remove the disabled boards
 for board in context['boards']:
     if 'disable' not in board:
@@ -16,6 +16,10 @@
 #include "i2c_stick_cmd.h"
 #include "i2c_stick_dispatcher.h"
 #include "i2c_stick_hal.h"
+#include "i2c_stick_tx.h"
+#include "i2c_stick_acq.h"
+#include "i2c_stick_sched.h"
+#include "i2c_stick_calib_cache.h"
 
 
 #include <stdlib.h>
@@ -83,8 +87,15 @@
 
 
 
+#ifdef HAS_CORE1
+  #include <pico/mutex.h>
+  auto_init_mutex(g_i2c_bus_mutex);
+  static volatile int8_t g_i2c_bus_owner = -1; // the core which holds g_i2c_bus_mutex
+#endif // HAS_CORE1
+
+
 // global variables
-int8_t g_mode;
+volatile int8_t g_mode;
 int8_t g_active_slave;
 uint16_t g_config_host;
 
@@ -110,19 +121,50 @@ uint8_t g_channel_mask =
 
 void uart_welcome()
 {
-  Serial.println("melexis-i2c-stick booted: '?' for help");
+  send_broadcast_message("melexis-i2c-stick booted: '?' for help");
   g_channel_mask |= (1U<<CHANNEL_UART);
   g_state = 1;
 }
 
 
 #ifdef HAS_CORE1
-void main_core1()
+void
+setup1()
+{
+  hal_mem_stack_paint(); // core1 paints its own stack
+}
+
+
+void
+loop1()
+{ // core1 does the continuous mode acquisition; core0 parses the commands and transmits.
+  hal_mem_stack_poll();
+  if (g_mode == MODE_CONTINUOUS)
+  {
+    acquire_continuous_mode();
+  }
+}
+#endif // HAS_CORE1
+
+
+void
+hal_i2c_bus_lock()
 {
-  while(true)
-  {}
+#ifdef HAS_CORE1
+  mutex_enter_blocking(&g_i2c_bus_mutex);
+  g_i2c_bus_owner = rp2040.cpuid();
+#endif // HAS_CORE1
 }
+
+
+void
+hal_i2c_bus_unlock()
+{
+#ifdef HAS_CORE1
+  g_i2c_bus_owner = -1;
+  mutex_exit(&g_i2c_bus_mutex);
 #endif // HAS_CORE1
+}
 
 
 const char *
@@ -165,11 +207,9 @@ int16_t
 hal_i2c_slave_address_available(uint8_t sa)
 {
   if (sa > 127) return 0; // invalid slave addresses are not available
-  WIRE.endTransmission();
-  delayMicroseconds(5);
 
-  WIRE.beginTransmission(sa);
-  byte result = WIRE.endTransmission();     // stop transmitting
+  // address only write; queued behind any transaction in progress.
+  int16_t result = hal_i2c_transfer(sa, NULL, 0, NULL, 0, 0);
 
   if (result != 2)
   {
@@ -179,55 +219,21 @@ hal_i2c_slave_address_available(uint8_t sa)
 }
 
 
-void
-hal_i2c_set_clock_frequency(uint32_t frequency_in_hz)
-{
-  uint32_t frequency_in_hz_corrected = frequency_in_hz;
-#ifdef ARDUINO_ARCH_RP2040
-  if (frequency_in_hz ==  100000) frequency_in_hz_corrected = frequency_in_hz * 1.05;
-  if (frequency_in_hz == 1000000) frequency_in_hz_corrected = frequency_in_hz * 1.25;
-  if (frequency_in_hz ==  400000) frequency_in_hz_corrected = frequency_in_hz * 1.105;
-#endif
-  WIRE.end();
-  WIRE.setClock(frequency_in_hz_corrected); // RP2040 requires first to set the clock
-  WIRE.begin();
-  WIRE.setClock(frequency_in_hz_corrected); // NRF52840 requires first begin, then set clock.
-}
-
-
 int16_t
 hal_i2c_direct_read(uint8_t sa, uint8_t *read_buffer, uint16_t read_n_bytes)
 {
-  WIRE.endTransmission();
-  delayMicroseconds(5);
-
-  WIRE.requestFrom((uint8_t)sa, uint8_t(read_n_bytes), uint8_t(true));
-
-  uint8_t bytes_available = WIRE.available();
-  if (bytes_available >= read_n_bytes)
+  if (hal_i2c_transfer(sa, NULL, 0, read_buffer, read_n_bytes, 0) != 0)
   {
-    for (uint16_t i=0; i<read_n_bytes; i++)
-    {
-      read_buffer[i] = (uint8_t)WIRE.read();
-    }
-    return 0;
+    return 1;
   }
-  return 1;
+  return 0;
 }
 
 
 int16_t
 hal_i2c_direct_write(uint8_t sa, uint8_t *write_buffer, uint16_t write_n_bytes)
 {
-  WIRE.endTransmission();
-  delayMicroseconds(5);
-
-  WIRE.beginTransmission(sa);
-  for (uint16_t i=0; i<write_n_bytes; i++)
-  {
-    WIRE.write(write_buffer[i]);
-  }
-  byte result = WIRE.endTransmission();     // stop transmitting
+  int16_t result = hal_i2c_transfer(sa, write_buffer, write_n_bytes, NULL, 0, 0);
 
   if (write_n_bytes == 0) // shorthand for hal_i2c_slave_address_available
   {
@@ -237,10 +243,6 @@ hal_i2c_direct_write(uint8_t sa, uint8_t *write_buffer, uint16_t write_n_bytes)
     }
     return 1; // not found return not-ok.
   }
-
-#ifdef ARDUINO_ARCH_RP2040
-  if (result == 4) result = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
   return result;
 }
 
@@ -248,48 +250,204 @@ hal_i2c_direct_write(uint8_t sa, uint8_t *write_buffer, uint16_t write_n_bytes)
 int16_t
 hal_i2c_indirect_read(uint8_t sa, uint8_t *write_buffer, uint16_t write_n_bytes, uint8_t *read_buffer, uint16_t read_n_bytes)
 {
-  WIRE.endTransmission();
-  delayMicroseconds(5);
+  return hal_i2c_transfer(sa, write_buffer, write_n_bytes, read_buffer, read_n_bytes, 0);
+}
+
+
+void
+hal_i2c_set_pwm(uint8_t pin_no, uint8_t pwm)
+{
+  analogWrite(pin_no, pwm);
+}
+
+
+#if defined(ENABLE_USB_MSC)
+// the non-volatile area is the last CALIB_CACHE_NV_SIZE bytes of the flash
+// partition; the USB drive ends before it (see setup), so the host never
+// sees it and the file system is never written by the firmware. Writes go
+// to a one sector buffer; flash is only erased and programmed when another
+// sector is needed or at the commit, both from the calibration cache flush
+// on core0 (the RP2040 flash transport idles the other core meanwhile).
+#define NV_SECTOR_SIZE 4096
+
+static uint32_t g_nv_base; // flash address of the area; 0 => not available
+static uint8_t g_nv_sector_buffer[NV_SECTOR_SIZE];
+static int32_t g_nv_sector = -1; // flash address of the buffered sector
+static uint8_t g_nv_dirty;
+
+
+static void
+nv_setup()
+{ // call after fatfs.begin(); sets the size of the USB drive.
+  uint32_t nv_base = (flash.size() > CALIB_CACHE_NV_SIZE) ? (flash.size() - CALIB_CACHE_NV_SIZE) : 0;
+  g_nv_base = nv_base;
+  if ((nv_base) && (fs_formatted))
+  { // a file system over the full partition keeps the area; no cache then.
+    uint32_t fs_end = (fatfs.dataStartSector() + fatfs.clusterCount() * fatfs.sectorsPerCluster()) * 512;
+    if (fs_end > nv_base)
+    {
+      g_nv_base = 0;
+    }
+  }
+  usb_msc.setCapacity((g_nv_base ? nv_base : flash.size())/512, 512);
+}
+
+
+static int16_t
+nv_sector_flush()
+{
+  if (!g_nv_dirty) return 0;
+  flash.syncBlocks(); // pending host writes first; they share the flash
+  if (!flash.eraseSector(g_nv_sector / NV_SECTOR_SIZE)) return -1;
+  if (flash.writeBuffer(g_nv_sector, g_nv_sector_buffer, NV_SECTOR_SIZE) != NV_SECTOR_SIZE) return -1;
+  g_nv_dirty = 0;
+  return 0;
+}
+
+
+uint32_t
+hal_nv_size()
+{
+  return g_nv_base ? CALIB_CACHE_NV_SIZE : 0;
+}
+
 
-  WIRE.beginTransmission(sa);
-  for (uint16_t i=0; i<write_n_bytes; i++)
+int16_t
+hal_nv_read(uint32_t address, void *buffer, uint16_t n_bytes)
+{
+  if ((address + n_bytes) > hal_nv_size()) return -1;
+  uint8_t *p = (uint8_t *)buffer;
+  while (n_bytes > 0)
   {
-    WIRE.write(write_buffer[i]);
+    uint32_t flash_address = g_nv_base + address;
+    uint32_t sector = flash_address & ~(NV_SECTOR_SIZE - 1);
+    uint16_t n = NV_SECTOR_SIZE - (flash_address - sector);
+    if (n > n_bytes) n = n_bytes;
+    if ((int32_t)sector == g_nv_sector)
+    {
+      memcpy(p, &g_nv_sector_buffer[flash_address - sector], n);
+    } else if (flash.readBuffer(flash_address, p, n) != n)
+    {
+      return -1;
+    }
+    p += n;
+    address += n;
+    n_bytes -= n;
   }
-  byte result = WIRE.endTransmission(false);     // repeated start
-#ifdef ARDUINO_ARCH_RP2040
-  if (result == 4) result = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-  if (result != 0) return result;
+  return 0;
+}
 
-  result = WIRE.requestFrom((uint8_t)sa, uint8_t(read_n_bytes), uint8_t(true));
-  if (result != uint8_t(read_n_bytes))
+
+int16_t
+hal_nv_write(uint32_t address, const void *buffer, uint16_t n_bytes)
+{
+  if ((address + n_bytes) > hal_nv_size()) return -1;
+  const uint8_t *p = (const uint8_t *)buffer;
+  while (n_bytes > 0)
   {
-    return -1;
+    uint32_t flash_address = g_nv_base + address;
+    uint32_t sector = flash_address & ~(NV_SECTOR_SIZE - 1);
+    uint16_t n = NV_SECTOR_SIZE - (flash_address - sector);
+    if (n > n_bytes) n = n_bytes;
+    if ((int32_t)sector != g_nv_sector)
+    {
+      if (nv_sector_flush() != 0) return -1;
+      g_nv_sector = -1;
+      if (flash.readBuffer(sector, g_nv_sector_buffer, NV_SECTOR_SIZE) != NV_SECTOR_SIZE) return -1;
+      g_nv_sector = sector;
+    }
+    memcpy(&g_nv_sector_buffer[flash_address - sector], p, n);
+    g_nv_dirty = 1;
+    p += n;
+    address += n;
+    n_bytes -= n;
   }
-  for (uint16_t i=0; i<read_n_bytes; i++)
+  return 0;
+}
+
+
+void
+hal_nv_commit()
+{
+  nv_sector_flush();
+}
+
+
+#elif defined(HAS_EEPROM_H)
+// the non-volatile area is the part of the emulated EEPROM not used by the applications
+uint32_t
+hal_nv_size()
+{
+  return EEPROM_EMULATION_SIZE - CALIB_CACHE_EEPROM_OFFSET;
+}
+
+
+int16_t
+hal_nv_read(uint32_t address, void *buffer, uint16_t n_bytes)
+{
+  if ((address + n_bytes) > hal_nv_size()) return -1;
+  uint8_t *p = (uint8_t *)buffer;
+  for (uint16_t i=0; i<n_bytes; i++)
   {
-    read_buffer[i] = (uint8_t)WIRE.read();
+    p[i] = EEPROM.read(CALIB_CACHE_EEPROM_OFFSET + address + i);
   }
+  return 0;
+}
 
-  result = WIRE.endTransmission();     // stop transmitting
-#ifdef ARDUINO_ARCH_RP2040
-  if (result == 4) result = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-  return result;
+
+int16_t
+hal_nv_write(uint32_t address, const void *buffer, uint16_t n_bytes)
+{
+  if ((address + n_bytes) > hal_nv_size()) return -1;
+  const uint8_t *p = (const uint8_t *)buffer;
+  for (uint16_t i=0; i<n_bytes; i++)
+  {
+    EEPROM.write(CALIB_CACHE_EEPROM_OFFSET + address + i, p[i]);
+  }
+  return 0;
 }
 
 
 void
-hal_i2c_set_pwm(uint8_t pin_no, uint8_t pwm)
+hal_nv_commit()
+{ // EEPROM.write only changes the RAM copy; the commit idles the other core.
+  EEPROM.commit(); // one flash sector erase+program for the whole area
+}
+
+
+#else
+uint32_t
+hal_nv_size()
 {
-  analogWrite(pin_no, pwm);
+  return 0;
+}
+
+
+int16_t
+hal_nv_read(uint32_t address, void *buffer, uint16_t n_bytes)
+{
+  return -1;
+}
+
+
+int16_t
+hal_nv_write(uint32_t address, const void *buffer, uint16_t n_bytes)
+{
+  return -1;
 }
 
 
+void
+hal_nv_commit()
+{
+}
+#endif
+
+
 void
 setup()
 {
+  hal_mem_stack_paint(); // first thing; the 'mem' command reports the stack watermark
 #ifdef ENABLE_USB_MSC
 
   flash.begin();
@@ -300,25 +458,19 @@ setup()
   // Set callback
   usb_msc.setReadWriteCallback(msc_read_cb, msc_write_cb, msc_flush_cb);
 
-  // Set disk size, block size should be 512 regardless of spi flash page size
-  usb_msc.setCapacity(flash.size()/512, 512);
+  // Init file system on the flash
+  fs_formatted = fatfs.begin(&flash);
+
+  // Set disk size, block size should be 512 regardless of spi flash page size;
+  // the calibration cache area at the end is not part of it.
+  nv_setup();
 
   // MSC is ready for read/write
   usb_msc.setUnitReady(true);
 
   usb_msc.begin();
-
-  // Init file system on the flash
-  fs_formatted = fatfs.begin(&flash);
 #endif // ENABLE_USB_MSC
 
-
-#ifdef HAS_CORE1
-  multicore_launch_core1(main_core1);
-  if (rp2040.fifo.available())
-  {}
-#endif // HAS_CORE1
-
   Serial.begin(1000000);
   g_channel_mask &= ~(1U<<CHANNEL_UART);
 
@@ -329,17 +481,20 @@ setup()
 
   i2c_stick_register_all_drivers();
 
+#ifdef HAS_EEPROM_H
+  EEPROM.begin(EEPROM_EMULATION_SIZE); // before the scan; drivers load their calibration cache.
+#endif // HAS_EEPROM_H
+
   uint8_t channel_mask = 0; // run quitely...
   handle_cmd(channel_mask, "scan"); // scan at startup!
   if (Serial) uart_welcome();
-
-  EEPROM.begin(512);
 }
 
 
 void
 loop()
 {
+  uart_tx_drain();
   if (g_state == 0)
   {
     if (Serial)
@@ -356,8 +511,14 @@ loop()
   if (g_mode == MODE_CONTINUOUS)
   {
     handle_continuous_mode();
+  } else
+  {
+    i2c_stick_acq_flush();
   }
+  hal_i2c_bus_lock();
   handle_applications(g_channel_mask);
+  hal_i2c_bus_unlock();
+  i2c_stick_calib_cache_flush(); // flash writes only here, on core0
 }
 
 
@@ -415,7 +576,9 @@ int_uart()
 
     if (p_cmd == cmd)
     { // first char might be a single char task!
+      hal_i2c_bus_lock();
       const char *p_answer = handle_task(channel_mask, ch);
+      hal_i2c_bus_unlock();
       if (p_answer)
       {
         return 0;
@@ -426,8 +589,10 @@ int_uart()
         ((p_cmd - cmd + 1) >= (int)(sizeof(cmd)))) // cmd buffer full! lets try to handle the command; some command will read more bytes later if needed....
     {
       if (p_cmd == cmd) return 0; // empty command; likely only <LF> was sent!
+      hal_i2c_bus_lock();
       const char *p_answer = handle_cmd(channel_mask, cmd);
-      if (p_answer) Serial.println(p_answer);
+      hal_i2c_bus_unlock();
+      if (p_answer) send_answer_chunk(channel_mask, p_answer, 1);
 
       memset(cmd, 0, sizeof(cmd));
       p_cmd = cmd;
@@ -440,23 +605,63 @@ int_uart()
 }
 
 
+void
+uart_tx_drain()
+{ // move as much as the USB/UART driver accepts from the TX ring buffer, without waiting.
+  int room = Serial.availableForWrite();
+  while (room > 0)
+  {
+    const uint8_t *data = NULL;
+    uint16_t n = i2c_stick_tx_peek(&data);
+    if (n == 0) break;
+    if (n > room) n = room;
+    n = Serial.write(data, n);
+    if (n == 0) break;
+    i2c_stick_tx_consume(n);
+    room -= n;
+  }
+}
+
+
+void
+uart_tx_wait()
+{ // the TX ring buffer is full; commands run with the bus lock taken, but
+  // core1 must not stall on it until the host has caught up.
+#ifdef HAS_CORE1
+  if (g_i2c_bus_owner == (int8_t)rp2040.cpuid())
+  {
+    hal_i2c_bus_unlock();
+    uart_tx_drain();
+    hal_i2c_bus_lock();
+    return;
+  }
+#endif // HAS_CORE1
+  uart_tx_drain();
+}
+
+
+void
+uart_tx_queue(const char *data, uint16_t length)
+{
+  if (!Serial)
+  { // nobody is listening; do not block on a full buffer, drop what does not fit.
+    i2c_stick_tx_queue((const uint8_t *)data, length, NULL);
+    return;
+  }
+  i2c_stick_tx_queue((const uint8_t *)data, length, uart_tx_wait);
+  uart_tx_drain();
+}
+
+
 void
 send_answer_chunk(uint8_t channel_mask, const char *answer, uint8_t terminate)
 { // we currently have only UART/Serial,
   if (channel_mask & (1U<<CHANNEL_UART))
   {
-    while (Serial.availableForWrite() < 200)
-    {
-      // wait!!
-    }
-
+    uart_tx_queue(answer, strlen(answer));
     if (terminate)
     {
-      Serial.println(answer);
-      Serial.flush();
-    } else
-    {
-      Serial.print(answer);
+      uart_tx_queue("\r\n", 2);
     }
   }
   if (channel_mask & (1U<<CHANNEL_ETHERNET))
@@ -492,11 +697,7 @@ send_answer_chunk_binary(uint8_t channel_mask, const char *blob, uint16_t length
 { // we currently have only UART/Serial,
   if (channel_mask & (1U<<CHANNEL_UART))
   {
-    Serial.write(blob, length);
-    if (terminate)
-    {
-      Serial.flush();
-    }
+    uart_tx_queue(blob, length);
   }
   if (channel_mask & (1U<<CHANNEL_ETHERNET))
   { // todo
@@ -513,44 +714,113 @@ send_answer_chunk_binary(uint8_t channel_mask, const char *blob, uint16_t length
 void
 send_broadcast_message(const char *msg)
 {// currently we do only UART
-  Serial.println(msg);
+  uart_tx_queue(msg, strlen(msg));
+  uart_tx_queue("\r\n", 2);
 }
 
 
 void
-handle_continuous_mode()
-{
-  uint8_t old_active_slave = g_active_slave;
+acquire_continuous_mode()
+{ // only poll the slaves for which new data is expected by now.
   const char *error_message = NULL;
-  for (uint8_t sa=0; sa<128; sa++)
+  uint32_t now = hal_get_millis();
+  for (;;)
   {
-    int16_t spot = g_sa_list[sa].spot_;
-    if (g_sa_list[sa].found_ && (!(g_sa_drv_register[spot].disabled_)) && (g_sa_drv_register[spot].drv_ > 0))
+    acq_frame_t *frame = i2c_stick_acq_claim();
+    if (frame == NULL)
+    { // the transmitter is behind
+      return;
+    }
+    // the slave list and the driver register are changed under the bus lock (scan, dis, raw,...)
+    hal_i2c_bus_lock();
+    int16_t sa = i2c_stick_sched_due(now);
+    if (sa < 0)
     {
-      g_active_slave = sa;
-      uint8_t nd = 0; // new data
+      hal_i2c_bus_unlock();
+      return;
+    }
+    int16_t spot = g_sa_list[sa].spot_;
+    uint8_t nd = 0; // new data
+    uint32_t period_ms = 0;
+    if ((g_sa_list[sa].found_) && (spot >= 0) && (g_sa_drv_register[spot].drv_ > 0))
+    { // still there since the schedule was built
       cmd_nd(sa, &nd, &error_message);
       if (nd > 0)
       {
-        char buf[32];
-        memset(buf, 0, sizeof(buf));
-        char *p = buf;
-        *p = '@'; p++;
-        uint8_to_hex(p, sa); p += 2;
-        *p = ':'; p++;
-        uint8_to_hex(p, g_sa_drv_register[spot].drv_); p += 2;
-        *p = ':'; p++;
-        // Serial.println(Serial.availableForWrite());
-        send_answer_chunk(g_channel_mask, buf, 0);
-        handle_cmd_mv(sa, g_channel_mask);
-        if (g_sa_drv_register[spot].raw_)
-        {
-          send_answer_chunk(g_channel_mask, buf, 0);
-          handle_cmd_raw(sa, g_channel_mask);
-        }
+        i2c_stick_acq_fill(frame, sa, g_sa_drv_register[spot].drv_, g_sa_drv_register[spot].raw_);
+        cmd_rp(sa, &period_ms, &error_message);
       }
     }
+    hal_i2c_bus_unlock();
+    i2c_stick_sched_done(sa, nd, period_ms, now);
+    if (nd > 0)
+    {
+      i2c_stick_acq_publish();
+#ifdef HAS_CORE1
+      rp2040.fifo.push_nb(sa); // wake-up core0
+#endif // HAS_CORE1
+    }
+  }
+}
+
+
+void
+send_continuous_mv(const acq_frame_t *frame)
+{ // the full mv answer, or only the changes with `+ch:DELTA` (see i2c_stick_delta.h).
+  uint8_t fmt = g_config_host & 0x000F;
+  if ((fmt == HOST_CFG_FORMAT_DEC) || (fmt == HOST_CFG_FORMAT_FRAME))
+  {
+    const delta_run_t *run_list = NULL;
+    int16_t run_count = i2c_stick_delta_update(frame->sa_, frame->mv_list_, frame->mv_count_, frame->mv_error_message_, &run_list);
+    if (run_count >= 0)
+    {
+      send_mv_delta_answer(frame->sa_, g_channel_mask, frame->mv_list_, frame->mv_count_, frame->mv_time_stamp_, run_list, run_count);
+      return;
+    }
+  }
+  send_mv_answer(frame->sa_, g_channel_mask, frame->mv_list_, frame->mv_count_, frame->mv_time_stamp_, frame->mv_error_message_);
+}
+
+
+void
+handle_continuous_mode()
+{
+#ifdef HAS_CORE1
+  uint32_t notification;
+  while (rp2040.fifo.pop_nb(&notification))
+  { // the data itself is in the acquisition queue.
   }
+#else
+  acquire_continuous_mode();
+#endif // HAS_CORE1
 
-  g_active_slave = old_active_slave;
+  for (acq_frame_t *frame = i2c_stick_acq_peek(); frame != NULL; frame = i2c_stick_acq_peek())
+  {
+    if ((g_config_host & 0x000F) == HOST_CFG_FORMAT_FRAME)
+    { // frames carry the slave address and driver in their header.
+      send_continuous_mv(frame);
+      if (frame->has_raw_)
+      {
+        send_raw_answer(frame->sa_, g_channel_mask, frame->raw_list_, frame->raw_count_, frame->raw_time_stamp_, frame->raw_error_message_);
+      }
+    } else
+    {
+      char buf[32];
+      memset(buf, 0, sizeof(buf));
+      char *p = buf;
+      *p = '@'; p++;
+      uint8_to_hex(p, frame->sa_); p += 2;
+      *p = ':'; p++;
+      uint8_to_hex(p, frame->drv_); p += 2;
+      *p = ':'; p++;
+      send_answer_chunk(g_channel_mask, buf, 0);
+      send_continuous_mv(frame);
+      if (frame->has_raw_)
+      {
+        send_answer_chunk(g_channel_mask, buf, 0);
+        send_raw_answer(frame->sa_, g_channel_mask, frame->raw_list_, frame->raw_count_, frame->raw_time_stamp_, frame->raw_error_message_);
+      }
+    }
+    i2c_stick_acq_release();
+  }
 }
@@ -1,4 +1,5 @@
 #include "i2c_stick.h"
+#include "i2c_stick_dispatcher.h"
 
 sa_list_t g_sa_list[128];
 sa_drv_register_t g_sa_drv_register[MAX_SA_DRV_REGISTRATIONS];
@@ -61,6 +62,10 @@ i2c_stick_register_driver(uint8_t sa, uint8_t drv)
   g_sa_drv_register[spot].disabled_ = 0;
   g_sa_drv_register[spot].nd_ = 0;
   g_sa_drv_register[spot].raw_ = 0;
+  if (g_sa_list[sa].spot_ == spot)
+  { // the slave address uses this registration; keep the ops cache in line.
+    i2c_stick_update_sa_ops(sa);
+  }
   return spot;
 }
 
@@ -28,6 +28,7 @@ struct sa_list_t
 #define HOST_CFG_FORMAT_DEC  0
 #define HOST_CFG_FORMAT_HEX  1
 #define HOST_CFG_FORMAT_BIN  2
+#define HOST_CFG_FORMAT_FRAME 3 // see i2c_stick_frame.h
 // 4 bit i2c field (nibble 1)
 #define HOST_CFG_I2C_F100k   0
 #define HOST_CFG_I2C_F400k   1
@@ -53,7 +54,7 @@ struct sa_list_t
 
 
 // global variables
-extern int8_t g_mode;
+extern volatile int8_t g_mode; // read by core1
 extern uint16_t g_config_host;
 
 extern sa_list_t g_sa_list[128];
@@ -0,0 +1,117 @@
+#include "i2c_stick_acq.h"
+#include "i2c_stick_dispatcher.h"
+#include "i2c_stick_hal.h"
+
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the indices run over twice the number of slots to tell a full queue from an
+// empty one; they wrap explicitly, so ACQ_QUEUE_SIZE need not be a power of two.
+#define ACQ_INDEX_WRAP (2 * ACQ_QUEUE_SIZE)
+
+static acq_frame_t g_acq_queue[ACQ_QUEUE_SIZE];
+static volatile uint32_t g_acq_head; // written by the producer only
+static volatile uint32_t g_acq_tail; // written by the consumer only
+
+
+static uint32_t
+acq_index_next(uint32_t index)
+{
+  index++;
+  return (index < ACQ_INDEX_WRAP) ? index : 0;
+}
+
+
+acq_frame_t *
+i2c_stick_acq_claim()
+{ // returns NULL when all slots are in use.
+  if (((g_acq_head + ACQ_INDEX_WRAP - g_acq_tail) % ACQ_INDEX_WRAP) >= ACQ_QUEUE_SIZE)
+  {
+    return NULL;
+  }
+  return &g_acq_queue[g_acq_head % ACQ_QUEUE_SIZE];
+}
+
+
+void
+i2c_stick_acq_publish()
+{
+  __sync_synchronize(); // make the slot content visible before the index.
+  g_acq_head = acq_index_next(g_acq_head);
+}
+
+
+acq_frame_t *
+i2c_stick_acq_peek()
+{
+  if (g_acq_head == g_acq_tail)
+  {
+    return NULL;
+  }
+  __sync_synchronize(); // read the index before the slot content.
+  return &g_acq_queue[g_acq_tail % ACQ_QUEUE_SIZE];
+}
+
+
+void
+i2c_stick_acq_release()
+{
+  __sync_synchronize(); // done reading the slot before handing it back.
+  g_acq_tail = acq_index_next(g_acq_tail);
+}
+
+
+void
+i2c_stick_acq_flush()
+{
+  while (i2c_stick_acq_peek() != NULL)
+  {
+    i2c_stick_acq_release();
+  }
+}
+
+
+void
+i2c_stick_acq_fill(acq_frame_t *frame, uint8_t sa, uint8_t drv, uint8_t with_raw)
+{ // take the measurement; the new data flag is already checked by the caller.
+  frame->sa_ = sa;
+  frame->drv_ = drv;
+  frame->has_raw_ = with_raw;
+
+  frame->mv_error_message_ = NULL;
+  frame->mv_count_ = sizeof(frame->mv_list_)/sizeof(frame->mv_list_[0]);
+  if (cmd_mv(sa, frame->mv_list_, &frame->mv_count_, &frame->mv_error_message_) == 0)
+  {
+    frame->mv_error_message_ = "no device driver assigned";
+    frame->mv_count_ = 0;
+  } else if ((frame->mv_error_message_ == NULL) && (frame->mv_count_ == 0))
+  {
+    frame->mv_error_message_ = "local buffer not big enough";
+  }
+  frame->mv_time_stamp_ = hal_get_millis();
+
+  if (!with_raw)
+  {
+    return;
+  }
+  frame->raw_error_message_ = NULL;
+  frame->raw_count_ = sizeof(frame->raw_list_)/sizeof(frame->raw_list_[0]);
+  memset(frame->raw_list_, 0, sizeof(frame->raw_list_));
+  if (cmd_raw(sa, frame->raw_list_, &frame->raw_count_, &frame->raw_error_message_) == 0)
+  {
+    frame->raw_error_message_ = "no device driver assigned";
+    frame->raw_count_ = 0;
+  } else if ((frame->raw_error_message_ == NULL) && (frame->raw_count_ == 0))
+  {
+    frame->raw_error_message_ = "local buffer not big enough";
+  }
+  frame->raw_time_stamp_ = hal_get_millis();
+}
+
+
+#ifdef __cplusplus
+}
+#endif
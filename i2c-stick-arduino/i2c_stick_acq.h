@@ -0,0 +1,49 @@
+#ifndef __I2C_STICK_ACQ_H__
+#define __I2C_STICK_ACQ_H__
+
+#include <stdint.h>
+#include "i2c_stick_fw_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Acquisition queue
+// *****************
+//
+// In continuous mode the measurements are acquired by the producer (core1
+// when available) and transmitted by the consumer (core0). The queue is a
+// lock-free single-producer/single-consumer ring of ACQ_QUEUE_SIZE slots.
+
+struct acq_frame_t
+{
+  uint8_t sa_;
+  uint8_t drv_;
+  uint8_t has_raw_;
+  uint16_t mv_count_;
+  uint16_t raw_count_;
+  uint32_t mv_time_stamp_;
+  uint32_t raw_time_stamp_;
+  const char *mv_error_message_;
+  const char *raw_error_message_;
+  float mv_list_[768+1];
+  uint16_t raw_list_[834];
+};
+
+
+// producer side
+acq_frame_t *i2c_stick_acq_claim();
+void i2c_stick_acq_publish();
+
+// consumer side
+acq_frame_t *i2c_stick_acq_peek();
+void i2c_stick_acq_release();
+void i2c_stick_acq_flush();
+
+void i2c_stick_acq_fill(acq_frame_t *frame, uint8_t sa, uint8_t drv, uint8_t with_raw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_ACQ_H__
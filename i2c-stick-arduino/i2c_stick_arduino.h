@@ -17,8 +17,8 @@ extern "C" {
 // for a limited set of architectures only.
 #ifdef ARDUINO_ARCH_RP2040
   #define HAS_EEPROM_H
-  // no need for CORE1 yet!
-  // #define HAS_CORE1
+  // core1 does the continuous mode acquisition, core0 the communication.
+  #define HAS_CORE1
   #define BUFFER_COMMAND_ENABLE
   #ifdef USE_TINYUSB
     #define ENABLE_USB_MSC
@@ -0,0 +1,260 @@
+#include "i2c_stick_calib_cache.h"
+#include "i2c_stick_cmd.h"
+#include "i2c_stick_hal.h"
+
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#ifdef CALIB_CACHE_ENABLE
+static calib_cache_pending_t g_calib_cache_pending[CALIB_CACHE_MAX_PENDING];
+static uint8_t g_calib_cache_pending_count;
+
+
+static void
+calib_cache_key(calib_cache_header_t *header, uint8_t drv, const uint16_t *sn_list, uint8_t sn_count)
+{
+  memset(header, 0, sizeof(calib_cache_header_t));
+  header->magic_ = CALIB_CACHE_MAGIC;
+  header->drv_ = drv;
+  if (sn_count > 4) sn_count = 4;
+  header->sn_count_ = sn_count;
+  for (uint8_t i=0; i<sn_count; i++)
+  {
+    header->sn_[i] = sn_list[i];
+  }
+}
+
+
+static uint8_t
+calib_cache_key_match(const calib_cache_header_t *a, const calib_cache_header_t *b)
+{
+  if (a->drv_ != b->drv_) return 0;
+  if (a->sn_count_ != b->sn_count_) return 0;
+  return memcmp(a->sn_, b->sn_, sizeof(a->sn_)) == 0;
+}
+
+
+static uint16_t
+calib_cache_crc(const calib_cache_header_t *header, const void *data)
+{
+  calib_cache_header_t h = *header;
+  h.crc_ = 0;
+  uint16_t crc = crc16_update(0xFFFF, &h, sizeof(h));
+  return crc16_update(crc, data, header->size_);
+}
+
+
+static int16_t
+calib_cache_find(const calib_cache_header_t *key, calib_cache_header_t *header, uint32_t *address)
+{ // returns 0 and the address of the matching record or -1 and the end of the list.
+  uint32_t nv_size = hal_nv_size();
+  *address = 0;
+  while ((*address + sizeof(calib_cache_header_t)) <= nv_size)
+  {
+    if (hal_nv_read(*address, header, sizeof(calib_cache_header_t)) != 0) break;
+    if ((header->magic_ != CALIB_CACHE_MAGIC) && (header->magic_ != CALIB_CACHE_MAGIC_DELETED)) break;
+    if ((header->magic_ == CALIB_CACHE_MAGIC) && (calib_cache_key_match(header, key)))
+    {
+      return 0;
+    }
+    *address += sizeof(calib_cache_header_t) + header->size_;
+  }
+  return -1;
+}
+
+
+static int16_t
+calib_cache_write_record(uint32_t address, const calib_cache_header_t *header, const void *data)
+{
+  if (hal_nv_write(address + sizeof(calib_cache_header_t), data, header->size_) != 0) return -1;
+  return hal_nv_write(address, header, sizeof(calib_cache_header_t));
+}
+
+
+static void
+calib_cache_remove_pending(uint8_t (*match)(const calib_cache_pending_t *pending, const void *ref), const void *ref)
+{
+  uint8_t count = 0;
+  for (uint8_t i=0; i<g_calib_cache_pending_count; i++)
+  {
+    if (!match(&g_calib_cache_pending[i], ref))
+    {
+      g_calib_cache_pending[count++] = g_calib_cache_pending[i];
+    }
+  }
+  g_calib_cache_pending_count = count;
+}
+
+
+static uint8_t
+calib_cache_pending_key_match(const calib_cache_pending_t *pending, const void *ref)
+{
+  return calib_cache_key_match(&pending->key_, (const calib_cache_header_t *)ref);
+}
+
+
+static uint8_t
+calib_cache_pending_data_match(const calib_cache_pending_t *pending, const void *ref)
+{
+  return (pending->op_ == CALIB_CACHE_OP_STORE) && (pending->data_ == ref);
+}
+
+
+static int16_t
+calib_cache_queue(uint8_t op, const calib_cache_header_t *key, const void *data)
+{ // a newer operation on the same key replaces the queued one.
+  // the drivers call in with the bus lock held, like the flush.
+  calib_cache_remove_pending(calib_cache_pending_key_match, key);
+  if (g_calib_cache_pending_count >= CALIB_CACHE_MAX_PENDING)
+  {
+    return -1;
+  }
+  calib_cache_pending_t *pending = &g_calib_cache_pending[g_calib_cache_pending_count++];
+  pending->op_ = op;
+  pending->key_ = *key;
+  pending->data_ = data;
+  return 0;
+}
+
+
+static int16_t
+calib_cache_store_now(const calib_cache_header_t *key_in, const void *data)
+{
+  calib_cache_header_t key = *key_in;
+  calib_cache_header_t header;
+  uint32_t address;
+  uint32_t nv_size = hal_nv_size();
+  uint32_t record_size = sizeof(calib_cache_header_t) + key.size_;
+  if (record_size > nv_size) return -1;
+
+  key.crc_ = calib_cache_crc(&key, data);
+
+  int16_t found = calib_cache_find(&key, &header, &address);
+  if (found == 0)
+  {
+    if (header.size_ == key.size_)
+    { // same slot, update in place.
+      return calib_cache_write_record(address, &key, data);
+    }
+    header.magic_ = CALIB_CACHE_MAGIC_DELETED;
+    if (hal_nv_write(address, &header, sizeof(header)) != 0) return -1;
+    calib_cache_find(&key, &header, &address); // => end of list
+  }
+
+  if ((address + record_size) > nv_size)
+  { // full; start over from the beginning, the older records are dropped.
+    address = 0;
+  }
+  if (calib_cache_write_record(address, &key, data) != 0) return -1;
+  address += record_size;
+  if ((address + sizeof(calib_cache_header_t)) <= nv_size)
+  { // terminate the list; records behind it are stale after a restart.
+    memset(&header, 0xFF, sizeof(header));
+    hal_nv_write(address, &header, sizeof(header));
+  }
+  return 0;
+}
+
+
+static int16_t
+calib_cache_invalidate_now(const calib_cache_header_t *key)
+{
+  calib_cache_header_t header;
+  uint32_t address;
+  if (calib_cache_find(key, &header, &address) != 0) return 0; // nothing cached
+  header.magic_ = CALIB_CACHE_MAGIC_DELETED;
+  return hal_nv_write(address, &header, sizeof(header));
+}
+#endif // CALIB_CACHE_ENABLE
+
+
+int16_t
+i2c_stick_calib_cache_load(uint8_t drv, const uint16_t *sn_list, uint8_t sn_count, void *data, uint16_t size)
+{
+#ifdef CALIB_CACHE_ENABLE
+  calib_cache_header_t key;
+  calib_cache_header_t header;
+  uint32_t address;
+  calib_cache_key(&key, drv, sn_list, sn_count);
+  if (calib_cache_find(&key, &header, &address) != 0) return -1;
+  if (header.size_ != size) return -1;
+  if (hal_nv_read(address + sizeof(calib_cache_header_t), data, size) != 0) return -1;
+  if (calib_cache_crc(&header, data) != header.crc_) return -1;
+  return 0;
+#else
+  return -1;
+#endif // CALIB_CACHE_ENABLE
+}
+
+
+int16_t
+i2c_stick_calib_cache_store(uint8_t drv, const uint16_t *sn_list, uint8_t sn_count, const void *data, uint16_t size)
+{
+#ifdef CALIB_CACHE_ENABLE
+  calib_cache_header_t key;
+  if ((sizeof(calib_cache_header_t) + size) > hal_nv_size()) return -1;
+  calib_cache_key(&key, drv, sn_list, sn_count);
+  key.size_ = size;
+  return calib_cache_queue(CALIB_CACHE_OP_STORE, &key, data);
+#else
+  return -1;
+#endif // CALIB_CACHE_ENABLE
+}
+
+
+int16_t
+i2c_stick_calib_cache_invalidate(uint8_t drv, const uint16_t *sn_list, uint8_t sn_count)
+{
+#ifdef CALIB_CACHE_ENABLE
+  calib_cache_header_t key;
+  calib_cache_key(&key, drv, sn_list, sn_count);
+  return calib_cache_queue(CALIB_CACHE_OP_INVALIDATE, &key, NULL);
+#else
+  return 0;
+#endif // CALIB_CACHE_ENABLE
+}
+
+
+void
+i2c_stick_calib_cache_cancel(const void *data)
+{
+#ifdef CALIB_CACHE_ENABLE
+  calib_cache_remove_pending(calib_cache_pending_data_match, data);
+#endif // CALIB_CACHE_ENABLE
+}
+
+
+void
+i2c_stick_calib_cache_flush()
+{
+#ifdef CALIB_CACHE_ENABLE
+  if (g_calib_cache_pending_count == 0)
+  {
+    return;
+  }
+  hal_i2c_bus_lock(); // no driver init (or release) on the other core meanwhile
+  for (uint8_t i=0; i<g_calib_cache_pending_count; i++)
+  {
+    const calib_cache_pending_t *pending = &g_calib_cache_pending[i];
+    if (pending->op_ == CALIB_CACHE_OP_STORE)
+    {
+      calib_cache_store_now(&pending->key_, pending->data_);
+    } else
+    {
+      calib_cache_invalidate_now(&pending->key_);
+    }
+  }
+  g_calib_cache_pending_count = 0;
+  hal_nv_commit();
+  hal_i2c_bus_unlock();
+#endif // CALIB_CACHE_ENABLE
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,72 @@
+#ifndef __I2C_STICK_CALIB_CACHE_H__
+#define __I2C_STICK_CALIB_CACHE_H__
+
+#include <stdint.h>
+#include "i2c_stick_fw_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Calibration cache
+// *****************
+//
+// Sensor drivers store their extracted calibration parameters in the
+// non-volatile area of the HAL (hal_nv_*), keyed by driver id and the
+// sensor serial number. At the next init a hit skips the EEPROM dump and
+// parameter extraction.
+//
+// Each record is a calib_cache_header_t followed by `size_` bytes of data;
+// the records are packed back to back and the list ends at the first header
+// without a valid magic. The crc covers header (with crc_ = 0) and data; a
+// record that fails the crc is a miss.
+//
+// The cached data is a raw image of the driver's parameter struct; the
+// version in the magic must be bumped when such a struct changes layout.
+//
+// Store and invalidate are only queued: the drivers init lazily, also on
+// core1 during continuous mode, and a flash erase must not run there.
+// i2c_stick_calib_cache_flush() executes the queue from the main loop on
+// core0, with the bus lock held like the drivers hold it when they queue;
+// the commit of the HAL parks the other core around the erase. A store reads
+// the data at flush time, so a driver must cancel it when the data goes away.
+
+#define CALIB_CACHE_MAGIC 0xCA01 // valid record, layout version 1
+#define CALIB_CACHE_MAGIC_DELETED 0xCA00 // record invalidated; skipped
+
+struct calib_cache_header_t
+{
+  uint16_t magic_;
+  uint8_t drv_;
+  uint8_t sn_count_;
+  uint16_t sn_[4];
+  uint16_t size_;
+  uint16_t crc_;
+};
+
+#define CALIB_CACHE_OP_STORE      1
+#define CALIB_CACHE_OP_INVALIDATE 2
+
+struct calib_cache_pending_t
+{
+  uint8_t op_; // CALIB_CACHE_OP_*
+  calib_cache_header_t key_;
+  const void *data_; // store: read at flush time
+};
+
+
+// all return 0 on success; load returns non-zero on a miss; store and
+// invalidate return non-zero when the queue is full.
+int16_t i2c_stick_calib_cache_load(uint8_t drv, const uint16_t *sn_list, uint8_t sn_count, void *data, uint16_t size);
+int16_t i2c_stick_calib_cache_store(uint8_t drv, const uint16_t *sn_list, uint8_t sn_count, const void *data, uint16_t size);
+int16_t i2c_stick_calib_cache_invalidate(uint8_t drv, const uint16_t *sn_list, uint8_t sn_count);
+// drop the queued stores of 'data' (handle released before the flush).
+void i2c_stick_calib_cache_cancel(const void *data);
+// execute the queue; core0 only.
+void i2c_stick_calib_cache_flush();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_CALIB_CACHE_H__
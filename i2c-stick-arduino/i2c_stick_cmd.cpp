@@ -2,7 +2,13 @@
 #include "i2c_stick_cmd.h"
 #include "i2c_stick_task.h"
 #include "i2c_stick_hal.h"
+#include "i2c_stick_pool.h"
+#include "i2c_stick_scratch.h"
 #include "i2c_stick_dispatcher.h"
+#include "i2c_stick_cmd_table.h"
+#include "i2c_stick_tx.h"
+#include "i2c_stick_frame.h"
+#include "i2c_stick_quant.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -56,6 +62,28 @@ uint32_to_dec(char *str, uint32_t dec, int8_t digits)
 }
 
 
+uint16_t
+crc16_update(uint16_t crc, const void *data, uint16_t length)
+{ // CRC-16/CCITT-FALSE (poly 0x1021); start with crc = 0xFFFF.
+  const uint8_t *p = (const uint8_t *)data;
+  for (uint16_t i=0; i<length; i++)
+  {
+    crc ^= (uint16_t)p[i] << 8;
+    for (uint8_t b=0; b<8; b++)
+    {
+      if (crc & 0x8000)
+      {
+        crc = (crc << 1) ^ 0x1021;
+      } else
+      {
+        crc <<= 1;
+      }
+    }
+  }
+  return crc;
+}
+
+
 int16_t atohex8(const char *in)
 {
    uint8_t c, h;
@@ -145,244 +173,357 @@ bytetostr(uint8_t dec)
   return str;
 }
 
-// https://github.com/pmalasp/dtostrf/blob/master/dtostrf.c
-char *my_dtostrf( float val,  int8_t char_num, uint8_t precision, char *chr_buffer)
-{
-  int       right_j;
-  int       i, j ;
-  float     r_val;
-  long      i_val;
-  char      c_sign;
 
+void
+send_float_list_dec(uint8_t channel_mask, const float *list, uint16_t count, uint8_t precision)
+{ // render the comma separated list in a local buffer, and send it in a few big chunks.
+  char buf[512];
+  uint16_t pos = 0;
+  for (uint16_t i=0; i<count; i++)
+  {
+    if ((pos + FLOAT_TO_DEC_MAX_LEN + 2) > sizeof(buf))
+    {
+      buf[pos] = '\0';
+      send_answer_chunk(channel_mask, buf, 0);
+      pos = 0;
+    }
+    if (i > 0)
+    {
+      buf[pos++] = ',';
+    }
+    pos += float_to_dec(buf + pos, list[i], precision);
+  }
+  buf[pos] = '\0';
+  send_answer_chunk(channel_mask, buf, 1);
+}
 
-  // check the sign
-  if (val < 0.0) {
-    // print the - sign
-    c_sign = '-';
 
-    // process the absolute value
-    val = - val;
-  } else {
-    // put a space for positive numbers
-    c_sign = ' ';
+void
+send_cs_value(uint8_t sa, uint8_t channel_mask, const char *var_name, const char *value)
+{
+  char buf[4];
+  send_answer_chunk(channel_mask, "cs:", 0);
+  uint8_to_hex(buf, sa);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ":", 0);
+  send_answer_chunk(channel_mask, var_name, 0);
+  send_answer_chunk(channel_mask, "=", 0);
+  send_answer_chunk(channel_mask, value, 1);
+}
 
-  }
 
-  // check the left-right justification
-  if (char_num < 0)
+void
+send_cs_write_answer(uint8_t sa, uint8_t channel_mask, const char *var_name, int8_t result, const char *fail_reason)
+{
+  char buf[4];
+  send_answer_chunk(channel_mask, "+cs:", 0);
+  uint8_to_hex(buf, sa);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ":", 0);
+  send_answer_chunk(channel_mask, var_name, 0);
+  if (result == 0)
   {
-    // set the flag
-    right_j = 1;
-
-    // make the number positive
-    char_num = -char_num;
-
-  } else {
-    right_j = 0;
+    send_answer_chunk(channel_mask, "=OK [hub-register]", 1);
+  } else
+  {
+    send_answer_chunk(channel_mask, "=FAIL; ", 0);
+    send_answer_chunk(channel_mask, fail_reason, 1);
   }
+}
 
 
-  // no native exponential function for int
-  j=1;
-  for(i=0; i < (char_num - precision - 3 );i++) j *= 10;
-
-  // Hackish fail-fast behavior for larger-than-what-can-be-printed values, countig the precision + sign ('-') +'.' + '\0'
-  if (val >= (float)(j))
+static void
+send_quant_list(uint8_t channel_mask, const float *list, uint16_t count, float offset, float scale)
+{ // quantise in small chunks; into the open frame in FRAME format, otherwise as binary answer.
+  uint8_t buf[64];
+  for (uint16_t i=0; i<count; i+=sizeof(buf))
   {
-    // not enough space
-    // strcpy(chr_buffer, "ovf"); - this is very byte consuming (388 bytes) , so we go for the cheap array
-    chr_buffer[0] = 'o';
-    chr_buffer[1] = 'v';
-    chr_buffer[2] = 'f';
-    chr_buffer[3] = '\0';
-
-    // finish here
-    return chr_buffer;
+    uint16_t n = ((count - i) < sizeof(buf)) ? (count - i) : sizeof(buf);
+    i2c_stick_quant_list(list + i, n, offset, scale, buf);
+    if ((g_config_host & 0x000F) == HOST_CFG_FORMAT_FRAME)
+    {
+      send_frame_data(buf, n);
+    } else
+    {
+      send_answer_chunk_binary(channel_mask, (const char *)buf, n, 0);
+    }
   }
+}
 
 
+// end supporting functions
 
-  // Simplistic rounding strategy so that e.g. print(1.999, 2)
-  // prints as "2.00"
-  r_val = 0.5;
-  for ( i = 0; i < precision; i++) {
-      r_val /= 10.0;
-  }
-  val += r_val;
 
-  // Extract the integer and decimal part of the number and print it
-  i_val = (long) val;
-  r_val = val - (float) i_val;
+
+// MeLeXis test command
+const char *
+handle_cmd_token_mlx(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  send_answer_chunk(channel_mask, "mlx:MELEXIS I2C STICK", 1);
+  send_answer_chunk(channel_mask, "mlx:=================", 1);
+  send_answer_chunk(channel_mask, "mlx:", 1);
+  send_answer_chunk(channel_mask, "mlx:Melexis Innovation with Heart", 1);
+  send_answer_chunk(channel_mask, "mlx:", 1);
+  send_answer_chunk(channel_mask, "mlx:hit '?' for help", 1);
+  return NULL;
+}
 
 
-  // print the integral part ... but it is in reverse order ... so leaves the space for  '.' and the decimal part (and remember that array indexes start from 0
-  i = char_num - precision - 2;
-  do
-  {
-      chr_buffer[i] = '0' + ( i_val % 10);
-      i_val /= 10;
-      i--;
+// get Firmware Version
+const char *
+handle_cmd_token_fv(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  char buf[16]; memset(buf, 0, sizeof(buf));
+  send_answer_chunk(channel_mask, "fv:" FW_VERSION, 1);
+  return NULL;
+}
+
 
-  }   while ( i_val > 0) ;
+// Board Information command
+const char *
+handle_cmd_token_bi(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  char buf[64]; memset(buf, 0, sizeof(buf));
+  send_answer_chunk(channel_mask, "bi:", 0);
+  send_answer_chunk(channel_mask, hal_get_board_info(), 1);
+  return NULL;
+}
 
-  // add the sign char
-  chr_buffer[i] = c_sign;
 
-  // prepare for the decimal part
-  j = char_num - precision - 1;
+// MEMory statistics command
+const char *
+handle_cmd_token_mem(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  char buf[16]; memset(buf, 0, sizeof(buf));
+  for (const pool_t *pool = pool_first(); pool != NULL; pool = pool->next_)
+  {
+    send_answer_chunk(channel_mask, this_cmd, 0);
+    send_answer_chunk(channel_mask, ":POOL:", 0);
+    send_answer_chunk(channel_mask, pool->name_, 0);
+    send_answer_chunk(channel_mask, "=", 0);
+    itoa(pool_used(pool), buf, 10);
+    send_answer_chunk(channel_mask, buf, 0);
+    send_answer_chunk(channel_mask, "/", 0);
+    itoa(pool->capacity_, buf, 10);
+    send_answer_chunk(channel_mask, buf, 0);
+    send_answer_chunk(channel_mask, ",PEAK=", 0);
+    itoa(pool->peak_, buf, 10);
+    send_answer_chunk(channel_mask, buf, 0);
+    send_answer_chunk(channel_mask, ",SIZE=", 0);
+    itoa(pool->object_size_, buf, 10);
+    send_answer_chunk(channel_mask, buf, 1);
+  }
 
-  // Print the decimal point, but only if there are digits beyond
-  if (precision > 0) {
-    chr_buffer[j] = '.';
-    j++;
+  send_answer_chunk(channel_mask, this_cmd, 0);
+  send_answer_chunk(channel_mask, ":HEAP=", 0);
+  itoa(hal_mem_heap_used(), buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",PEAK=", 0);
+  itoa(hal_mem_heap_peak(), buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",SIZE=", 0);
+  itoa(hal_mem_heap_size(), buf, 10);
+  send_answer_chunk(channel_mask, buf, 1);
 
-    // Extract digits from the remainder one at a time
-    while (precision > 0) {
-      // prepare the data
-      r_val *= 10.0;
-      i_val  = (int)    r_val;
-      r_val -= (float)  i_val;
+  send_answer_chunk(channel_mask, this_cmd, 0);
+  send_answer_chunk(channel_mask, ":SCRATCH=", 0);
+  itoa(scratch_used(), buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",PEAK=", 0);
+  itoa(scratch_peak(), buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",SIZE=", 0);
+  itoa(scratch_size(), buf, 10);
+  send_answer_chunk(channel_mask, buf, 1);
 
-      // update the string
-      chr_buffer[j] = '0' + ( i_val );
-      j++;
+  send_answer_chunk(channel_mask, this_cmd, 0);
+  send_answer_chunk(channel_mask, ":STACK=", 0);
+  itoa(hal_mem_stack_peak(0), buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",SIZE=", 0);
+  itoa(hal_mem_stack_size(0), buf, 10);
+  send_answer_chunk(channel_mask, buf, 1);
 
-      // use precision as the counter
-      precision--;
-    }
+  if (hal_mem_stack_size(1) > 0)
+  {
+    send_answer_chunk(channel_mask, this_cmd, 0);
+    send_answer_chunk(channel_mask, ":STACK1=", 0);
+    itoa(hal_mem_stack_peak(1), buf, 10);
+    send_answer_chunk(channel_mask, buf, 0);
+    send_answer_chunk(channel_mask, ",SIZE=", 0);
+    itoa(hal_mem_stack_size(1), buf, 10);
+    send_answer_chunk(channel_mask, buf, 1);
   }
+  return NULL;
+}
 
-  // terminate the string
-  chr_buffer[j] = '\0';
 
-  // check the justification direction
-  if (right_j)
+// STACK depth probe command
+//   stack        => peak stack depth since startup (or the last reset), the
+//                   current depth and the total size; with two cores a
+//                   second line with the peak and size of the core1 stack.
+//   stack:reset  => re-paint the unused stack and restart the peak
+//                   measurement (also of the scratch arena); issue the
+//                   command(s) to probe next and read 'stack' again.
+//                   core1 re-paints its own stack on its next loop pass.
+const char *
+handle_cmd_token_stack(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  char buf[16]; memset(buf, 0, sizeof(buf));
+  const char *p = cmd + strlen(this_cmd);
+  if (!strcmp(p, ":reset"))
   {
-    // pad the string with leading ' '
-    while (i > 0)
-    {
-      i--;
+    hal_mem_stack_paint();
+    scratch_reset_peak();
+  } else if (strcmp(p, ""))
+  {
+    send_answer_chunk(channel_mask, this_cmd, 0);
+    send_answer_chunk(channel_mask, ":FAIL: unknown option; try 'stack' or 'stack:reset'", 1);
+    return NULL;
+  }
 
-      chr_buffer[i] = ' ';
-    }
+  send_answer_chunk(channel_mask, this_cmd, 0);
+  send_answer_chunk(channel_mask, ":PEAK=", 0);
+  itoa(hal_mem_stack_peak(0), buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",NOW=", 0);
+  itoa(hal_mem_stack_now(), buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",SIZE=", 0);
+  itoa(hal_mem_stack_size(0), buf, 10);
+  send_answer_chunk(channel_mask, buf, 1);
 
+  if (hal_mem_stack_size(1) > 0)
+  { // the current depth of core1 is only known to core1 itself
+    send_answer_chunk(channel_mask, this_cmd, 0);
+    send_answer_chunk(channel_mask, ":CORE1:PEAK=", 0);
+    itoa(hal_mem_stack_peak(1), buf, 10);
+    send_answer_chunk(channel_mask, buf, 0);
+    send_answer_chunk(channel_mask, ",SIZE=", 0);
+    itoa(hal_mem_stack_size(1), buf, 10);
+    send_answer_chunk(channel_mask, buf, 1);
   }
-
- // return the pointer to the first char of the prepared string
- return ( &chr_buffer[i]);
+  return NULL;
 }
 
 
-// end supporting functions
+// Config Hub command
+const char *
+handle_cmd_token_ch(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  handle_cmd_ch(channel_mask, cmd+strlen(this_cmd));
+  return NULL;
+}
+
 
+// Config Hub command
+const char *
+handle_cmd_token_ch_write(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  handle_cmd_ch_write(channel_mask, cmd+strlen(this_cmd));
+  return NULL;
+}
 
 
+// help command, same as task ?
 const char *
-handle_cmd(uint8_t channel_mask, const char *cmd)
+handle_cmd_token_help(uint8_t channel_mask, const char *cmd, const char *this_cmd)
 {
-  const char *this_cmd;
+  return handle_task(channel_mask, '?');
+}
 
-  this_cmd = "mlx"; // MeLeXis test command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
-  {
-    send_answer_chunk(channel_mask, "mlx:MELEXIS I2C STICK", 1);
-    send_answer_chunk(channel_mask, "mlx:=================", 1);
-    send_answer_chunk(channel_mask, "mlx:", 1);
-    send_answer_chunk(channel_mask, "mlx:Melexis Innovation with Heart", 1);
-    send_answer_chunk(channel_mask, "mlx:", 1);
-    send_answer_chunk(channel_mask, "mlx:hit '?' for help", 1);
-    return NULL;
-  }
 
-  this_cmd = "fv"; // get Firmware Version
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
-  {
-    char buf[16]; memset(buf, 0, sizeof(buf));
-    send_answer_chunk(channel_mask, "fv:" FW_VERSION, 1);
-    return NULL;
-  }
+// SOS command, get more help on a specific command
+const char *
+handle_cmd_token_sos(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  handle_cmd_sos(channel_mask, cmd+strlen(this_cmd));
+  return NULL;
+}
 
-  this_cmd = "bi"; // Board Information command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
-  {
-    char buf[64]; memset(buf, 0, sizeof(buf));
-    send_answer_chunk(channel_mask, "bi:", 0);
-    send_answer_chunk(channel_mask, hal_get_board_info(), 1);
-    return NULL;
-  }
 
-  this_cmd = "ch"; // Config Hub command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
-  {
-    handle_cmd_ch(channel_mask, cmd+strlen(this_cmd));
-    return NULL;
-  }
+#ifdef BUFFER_COMMAND_ENABLE
+// buffer command
+const char *
+handle_cmd_token_buf(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  send_answer_chunk(channel_mask, g_channel_buffer, 1);
+  return NULL;
+}
+#endif // BUFFER_COMMAND_ENABLE
 
-  this_cmd = "+ch:"; // Config Hub command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
-  {
-    handle_cmd_ch_write(channel_mask, cmd+strlen(this_cmd));
-    return NULL;
-  }
 
-  this_cmd = "help"; // help command, same as task ?
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
-  {
-    return handle_task(channel_mask, '?');
-  }
+// raw I2C command
+const char *
+handle_cmd_token_i2c(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  char buf[128]; memset(buf, 0, sizeof(buf));
+  send_answer_chunk(channel_mask, this_cmd, 0);
 
-  this_cmd = "sos"; // SOS command, get more help on a specific command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+  int16_t sa = atohex8(cmd+strlen(this_cmd));
+  if ((sa < 0) || (sa >= 0x80) || (cmd[6] != ':'))
   {
-    handle_cmd_sos(channel_mask, cmd+strlen(this_cmd));
+    send_answer_chunk(channel_mask, "ERROR:syntax error in slave address", 1);
     return NULL;
   }
 
-#ifdef BUFFER_COMMAND_ENABLE
-  this_cmd = "buf"; // buffer command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
-  {
-    send_answer_chunk(channel_mask, g_channel_buffer, 1);
-    return NULL;
-  }
-#endif // BUFFER_COMMAND_ENABLE
+  uint8_to_hex(buf, sa);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ":", 0);
 
-  this_cmd = "i2c:"; // raw I2C command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+  if (cmd[7] == 'R')
   {
-    char buf[128]; memset(buf, 0, sizeof(buf));
-    send_answer_chunk(channel_mask, this_cmd, 0);
+    // example: read 1 byte from slave address 0x33 (sa is 7bit)
+    // cmd: i2c:33:R1
+    // cmd: 012345678
+    send_answer_chunk(channel_mask, "R:", 0);
+    uint16_t read_n_bytes = atoi(&cmd[8]);
 
-    int16_t sa = atohex8(cmd+strlen(this_cmd));
-    if ((sa < 0) || (sa >= 0x80) || (cmd[6] != ':'))
+    uint8_t read_buffer[64]; memset(read_buffer, 0, sizeof(read_buffer));
+
+    int16_t result = hal_i2c_direct_read(sa, read_buffer, read_n_bytes);
+    for (uint8_t i=0; i<read_n_bytes; i++)
     {
-      send_answer_chunk(channel_mask, "ERROR:syntax error in slave address", 1);
-      return NULL;
+      uint8_to_hex(buf, read_buffer[i]);
+      send_answer_chunk(channel_mask, buf, 0);
     }
 
-    uint8_to_hex(buf, sa);
-    send_answer_chunk(channel_mask, buf, 0);
-    send_answer_chunk(channel_mask, ":", 0);
-
-    if (cmd[7] == 'R')
+    if (result == 0) // SUCCESS
     {
-      // example: read 1 byte from slave address 0x33 (sa is 7bit)
-      // cmd: i2c:33:R1
-      // cmd: 012345678
-      send_answer_chunk(channel_mask, "R:", 0);
-      uint16_t read_n_bytes = atoi(&cmd[8]);
-
+      send_answer_chunk(channel_mask, ":OK", 1);
+    } else
+    {
+      send_answer_chunk(channel_mask, ":FAIL:", 0);
+      uint8_to_hex(buf, result);
+      send_answer_chunk(channel_mask, buf, 1);
+    }
+  } else if (cmd[7] == 'W')
+  {
+    // check if a read follows => repeated start => indirect read functions
+    if (strchr(&cmd[7], 'R'))
+    { // 'R' is found
       uint8_t read_buffer[64]; memset(read_buffer, 0, sizeof(read_buffer));
-
-      int16_t result = hal_i2c_direct_read(sa, read_buffer, read_n_bytes);
-      for (uint8_t i=0; i<read_n_bytes; i++)
+      uint8_t write_buffer[8]; memset(write_buffer, 0, sizeof(write_buffer));
+      uint8_t i=0;
+      for(; i<8; i++)
       {
-        uint8_to_hex(buf, read_buffer[i]);
+        int16_t data = atohex8(cmd+8+i*2);
+        if (data < 0) break;
+        write_buffer[i] = data;
+        uint8_to_hex(buf, write_buffer[i]);
         send_answer_chunk(channel_mask, buf, 0);
       }
-
+      uint16_t read_n_bytes = atoi(&cmd[8+i*2+1]);
+      int16_t result = hal_i2c_indirect_read(sa, write_buffer, i, read_buffer, read_n_bytes);
       if (result == 0) // SUCCESS
       {
+        send_answer_chunk(channel_mask, ":R:", 0);
+        for (uint8_t i=0; i<read_n_bytes; i++)
+        {
+          uint8_t data = read_buffer[i];
+          uint8_to_hex(buf, data);
+          send_answer_chunk(channel_mask, buf, 0);
+        }
         send_answer_chunk(channel_mask, ":OK", 1);
       } else
       {
@@ -390,714 +531,749 @@ handle_cmd(uint8_t channel_mask, const char *cmd)
         uint8_to_hex(buf, result);
         send_answer_chunk(channel_mask, buf, 1);
       }
-    } else if (cmd[7] == 'W')
-    {
-      // check if a read follows => repeated start => indirect read functions
-      if (strchr(&cmd[7], 'R'))
-      { // 'R' is found
-        uint8_t read_buffer[64]; memset(read_buffer, 0, sizeof(read_buffer));
-        uint8_t write_buffer[8]; memset(write_buffer, 0, sizeof(write_buffer));
-        uint8_t i=0;
-        for(; i<8; i++)
-        {
-          int16_t data = atohex8(cmd+8+i*2);
-          if (data < 0) break;
-          write_buffer[i] = data;
-          uint8_to_hex(buf, write_buffer[i]);
-          send_answer_chunk(channel_mask, buf, 0);
-        }
-        uint16_t read_n_bytes = atoi(&cmd[8+i*2+1]);
-        int16_t result = hal_i2c_indirect_read(sa, write_buffer, i, read_buffer, read_n_bytes);
-        if (result == 0) // SUCCESS
-        {
-          send_answer_chunk(channel_mask, ":R:", 0);
-          for (uint8_t i=0; i<read_n_bytes; i++)
-          {
-            uint8_t data = read_buffer[i];
-            uint8_to_hex(buf, data);
-            send_answer_chunk(channel_mask, buf, 0);
-          }
-          send_answer_chunk(channel_mask, ":OK", 1);
-        } else
-        {
-          send_answer_chunk(channel_mask, ":FAIL:", 0);
-          uint8_to_hex(buf, result);
-          send_answer_chunk(channel_mask, buf, 1);
-        }
+    } else
+    { // no 'R' => direct write
+      uint8_t write_buffer[64]; memset(write_buffer, 0, sizeof(write_buffer));
+      uint8_t i=0;
+      for(; i<64; i++)
+      {
+        int16_t data = atohex8(cmd+8+i*2);
+        if (data < 0) break;
+        write_buffer[i] = data;
+        uint8_to_hex(buf, write_buffer[i]);
+        send_answer_chunk(channel_mask, buf, 0);
+      }
+      int16_t result = hal_i2c_direct_write(sa, write_buffer, i);
+      if (result == 0) // SUCCESS
+      {
+        send_answer_chunk(channel_mask, ":OK", 1);
       } else
-      { // no 'R' => direct write
-        uint8_t write_buffer[64]; memset(write_buffer, 0, sizeof(write_buffer));
-        uint8_t i=0;
-        for(; i<64; i++)
-        {
-          int16_t data = atohex8(cmd+8+i*2);
-          if (data < 0) break;
-          write_buffer[i] = data;
-          uint8_to_hex(buf, write_buffer[i]);
-          send_answer_chunk(channel_mask, buf, 0);
-        }
-        int16_t result = hal_i2c_direct_write(sa, write_buffer, i);
-        if (result == 0) // SUCCESS
-        {
-          send_answer_chunk(channel_mask, ":OK", 1);
-        } else
-        {
-          send_answer_chunk(channel_mask, ":FAIL:", 0);
-          uint8_to_hex(buf, result);
-          send_answer_chunk(channel_mask, buf, 1);
-        }
+      {
+        send_answer_chunk(channel_mask, ":FAIL:", 0);
+        uint8_to_hex(buf, result);
+        send_answer_chunk(channel_mask, buf, 1);
       }
-    } else
-    {
-      send_answer_chunk(channel_mask, "ERROR:No R|W info found in cmd", 1);
-      return NULL;
     }
-
+  } else
+  {
+    send_answer_chunk(channel_mask, "ERROR:No R|W info found in cmd", 1);
     return NULL;
   }
 
-  this_cmd = "scan"; // SCAN i2c bus command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
-  {
-    cmd_tear_down(255); // tear down all current drivers; if any.
+  return NULL;
+}
 
-    uint8_t count_slaves = 0;
 
-    for (int16_t spot = 0; spot<MAX_SA_DRV_REGISTRATIONS; spot++)
-    {
-      g_sa_drv_register[spot].raw_ = 0;
-      g_sa_drv_register[spot].disabled_ = 0;
-      g_sa_drv_register[spot].nd_ = 0;
-    }
+// SCAN i2c bus command
+const char *
+handle_cmd_token_scan(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  cmd_tear_down(255); // tear down all current drivers; if any.
+
+  uint8_t count_slaves = 0;
+
+  for (int16_t spot = 0; spot<MAX_SA_DRV_REGISTRATIONS; spot++)
+  {
+    g_sa_drv_register[spot].raw_ = 0;
+    g_sa_drv_register[spot].disabled_ = 0;
+    g_sa_drv_register[spot].nd_ = 0;
+  }
 
-    // SCL low for >1.44ms ==> MLX90614 in PWM or thermal relay requires this to enter communication mode
-    hal_write_pin(17u, 0);
-    hal_delay(2);
-    hal_write_pin(17u, 1);
+  // SCL low for >1.44ms ==> MLX90614 in PWM or thermal relay requires this to enter communication mode
+  hal_write_pin(17u, 0);
+  hal_delay(2);
+  hal_write_pin(17u, 1);
 
-    for (uint8_t sa = 1; sa<128; sa++)
+  for (uint8_t sa = 1; sa<128; sa++)
+  {
+    g_sa_list[sa].found_ = 0;
+    if (hal_i2c_slave_address_available(sa))
     {
-      g_sa_list[sa].found_ = 0;
-      if (hal_i2c_slave_address_available(sa))
-      {
-        const char *error_message;
-        char buf[16]; memset(buf, 0, sizeof(buf));
-        uint8_t is_ok = 0;
-        uint8_t is_known_driver = 0;
+      const char *error_message;
+      char buf[16]; memset(buf, 0, sizeof(buf));
+      uint8_t is_ok = 0;
+      uint8_t is_known_driver = 0;
 
-        count_slaves++;
-        g_sa_list[sa].spot_ = 0;
-        g_sa_list[sa].found_ = 1;
+      count_slaves++;
+      g_sa_list[sa].spot_ = 0;
+      g_sa_list[sa].found_ = 1;
 
-        for (uint16_t spot=1; spot<MAX_SA_DRV_REGISTRATIONS; spot++)
+      for (uint16_t spot=1; spot<MAX_SA_DRV_REGISTRATIONS; spot++)
+      {
+        if ((g_sa_drv_register[spot].sa_ == sa))
         {
-          if ((g_sa_drv_register[spot].sa_ == sa))
+          uint8_t drv = g_sa_drv_register[spot].drv_;
+          cmd_is(sa, drv, &is_ok, &error_message);
+
+          if (!is_ok)
           {
-            uint8_t drv = g_sa_drv_register[spot].drv_;
-            cmd_is(sa, drv, &is_ok, &error_message);
-
-            if (!is_ok)
-            {
-              continue;
-            }
-            is_known_driver = 1;
-            // ok we are good to go!
-            send_answer_chunk(channel_mask, this_cmd, 0);
-            send_answer_chunk(channel_mask, ":", 0);
-            uint8_to_hex(buf, sa);
-            send_answer_chunk(channel_mask, buf, 0);
-            send_answer_chunk(channel_mask, ":", 0);
-            uint8_to_hex(buf, g_sa_drv_register[spot].drv_);
-            send_answer_chunk(channel_mask, buf, 0);
-            send_answer_chunk(channel_mask, ",", 0);
-            uint8_to_hex(buf, g_sa_drv_register[spot].raw_);
-            send_answer_chunk(channel_mask, buf, 0);
-            send_answer_chunk(channel_mask, ",", 0);
-            uint8_to_hex(buf, g_sa_drv_register[spot].disabled_);
-            send_answer_chunk(channel_mask, buf, 0);
-            send_answer_chunk(channel_mask, ",", 0);
-
-            send_answer_chunk(channel_mask, i2c_stick_get_drv_name_by_drv(g_sa_drv_register[spot].drv_), 1);
-            g_sa_list[sa].spot_ = spot;
-            break;
+            continue;
           }
-        }
-        if (!is_known_driver)
-        {
+          is_known_driver = 1;
+          // ok we are good to go!
           send_answer_chunk(channel_mask, this_cmd, 0);
           send_answer_chunk(channel_mask, ":", 0);
           uint8_to_hex(buf, sa);
           send_answer_chunk(channel_mask, buf, 0);
-          send_answer_chunk(channel_mask, ":00,00,00,Unknown", 1);
-        }
-      }
-    }
-
-    if (count_slaves == 0)
-    {
-      send_answer_chunk(channel_mask, this_cmd, 0);
-      send_answer_chunk(channel_mask, ":no slaves found", 1);
-      g_active_slave = 0;
-    } else
-    {
-      if (g_active_slave == 0)
-      {
-        send_answer_chunk(channel_mask, "", 1);
-        handle_task_next(channel_mask);
-      }
+          send_answer_chunk(channel_mask, ":", 0);
+          uint8_to_hex(buf, g_sa_drv_register[spot].drv_);
+          send_answer_chunk(channel_mask, buf, 0);
+          send_answer_chunk(channel_mask, ",", 0);
+          uint8_to_hex(buf, g_sa_drv_register[spot].raw_);
+          send_answer_chunk(channel_mask, buf, 0);
+          send_answer_chunk(channel_mask, ",", 0);
+          uint8_to_hex(buf, g_sa_drv_register[spot].disabled_);
+          send_answer_chunk(channel_mask, buf, 0);
+          send_answer_chunk(channel_mask, ",", 0);
 
-      if (g_sa_list[g_active_slave].found_ == 0) // old active slave is not found on the bus anymore.
-      { // thus select next slave on the bus
-        send_answer_chunk(channel_mask, "", 1);
-        handle_task_next(channel_mask);
+          send_answer_chunk(channel_mask, i2c_stick_get_drv_name_by_drv(g_sa_drv_register[spot].drv_), 1);
+          g_sa_list[sa].spot_ = spot;
+          break;
+        }
       }
-    }
-    return NULL;
-  }
-
-  this_cmd = "ls"; // List Slave command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
-  {
-    uint8_t count_slaves = 0;
-
-    for (uint8_t sa = 1; sa<128; sa++)
-    {
-      if (g_sa_list[sa].found_)
+      i2c_stick_update_sa_ops(sa);
+      if (!is_known_driver)
       {
-        count_slaves++;
-        char buf[16]; memset(buf, 0, sizeof(buf));
-        int16_t spot = g_sa_list[sa].spot_;
         send_answer_chunk(channel_mask, this_cmd, 0);
         send_answer_chunk(channel_mask, ":", 0);
         uint8_to_hex(buf, sa);
         send_answer_chunk(channel_mask, buf, 0);
-        send_answer_chunk(channel_mask, ":", 0);
-        uint8_to_hex(buf, g_sa_drv_register[spot].drv_);
-        send_answer_chunk(channel_mask, buf, 0);
-        send_answer_chunk(channel_mask, ",", 0);
-        uint8_to_hex(buf, g_sa_drv_register[spot].raw_);
-        send_answer_chunk(channel_mask, buf, 0);
-        send_answer_chunk(channel_mask, ",", 0);
-        uint8_to_hex(buf, g_sa_drv_register[spot].disabled_);
-        send_answer_chunk(channel_mask, buf, 0);
-        send_answer_chunk(channel_mask, ",", 0);
-
-        send_answer_chunk(channel_mask, i2c_stick_get_drv_name_by_drv(g_sa_drv_register[spot].drv_), 1);
+        send_answer_chunk(channel_mask, ":00,00,00,Unknown", 1);
       }
     }
-
-    if (count_slaves == 0)
-    {
-      send_answer_chunk(channel_mask, this_cmd, 0);
-      send_answer_chunk(channel_mask, ":no slaves listed", 1);
-    }
-    return NULL;
   }
 
-  this_cmd = "dis"; // DIsable Slave command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+  if (count_slaves == 0)
+  {
+    send_answer_chunk(channel_mask, this_cmd, 0);
+    send_answer_chunk(channel_mask, ":no slaves found", 1);
+    g_active_slave = 0;
+  } else
   {
-    int16_t sa = -1;
-    int16_t i = -1;
-    if (cmd[strlen(this_cmd)] == ':')
+    if (g_active_slave == 0)
     {
-      sa = atohex8(cmd+strlen(this_cmd)+1);
-      if (*(cmd+strlen(this_cmd)+3) == ':')
-      {
-        i = strlen(this_cmd)+4;
-      }
+      send_answer_chunk(channel_mask, "", 1);
+      handle_task_next(channel_mask);
     }
-    if (sa < 0)
-    {
-      sa = g_active_slave;
-    }
-    uint8_t disable = 1;
-    if (i > 0)
-    {
-      disable = atoi(cmd+i);
+
+    if (g_sa_list[g_active_slave].found_ == 0) // old active slave is not found on the bus anymore.
+    { // thus select next slave on the bus
+      send_answer_chunk(channel_mask, "", 1);
+      handle_task_next(channel_mask);
     }
+  }
+  return NULL;
+}
 
-    char buf[16]; memset(buf, 0, sizeof(buf));
-    send_answer_chunk(channel_mask, this_cmd, 0);
-    send_answer_chunk(channel_mask, ":", 0);
-    uint8_to_hex(buf, sa);
-    send_answer_chunk(channel_mask, buf, 0);
-    send_answer_chunk(channel_mask, ":", 0);
 
-    if (g_sa_list[sa].found_) // only allow disable of discovered slaves
+// List Slave command
+const char *
+handle_cmd_token_ls(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  uint8_t count_slaves = 0;
+
+  for (uint8_t sa = 1; sa<128; sa++)
+  {
+    if (g_sa_list[sa].found_)
     {
+      count_slaves++;
+      char buf[16]; memset(buf, 0, sizeof(buf));
       int16_t spot = g_sa_list[sa].spot_;
-      if (disable > 0)
-      {
-        g_sa_drv_register[spot].disabled_ = 1;
-        uint8_to_hex(buf, 1);
-      } else
-      {
-        g_sa_drv_register[spot].disabled_ = 0;
-        uint8_to_hex(buf, 0);
-      }
+      send_answer_chunk(channel_mask, this_cmd, 0);
+      send_answer_chunk(channel_mask, ":", 0);
+      uint8_to_hex(buf, sa);
       send_answer_chunk(channel_mask, buf, 0);
       send_answer_chunk(channel_mask, ":", 0);
-      send_answer_chunk(channel_mask, "OK [i2c-stick register]", 1);
-    } else
-    {
-      send_answer_chunk(channel_mask, "FAIL: slave not seen by scan; try scan again", 1);
+      uint8_to_hex(buf, g_sa_drv_register[spot].drv_);
+      send_answer_chunk(channel_mask, buf, 0);
+      send_answer_chunk(channel_mask, ",", 0);
+      uint8_to_hex(buf, g_sa_drv_register[spot].raw_);
+      send_answer_chunk(channel_mask, buf, 0);
+      send_answer_chunk(channel_mask, ",", 0);
+      uint8_to_hex(buf, g_sa_drv_register[spot].disabled_);
+      send_answer_chunk(channel_mask, buf, 0);
+      send_answer_chunk(channel_mask, ",", 0);
+
+      send_answer_chunk(channel_mask, i2c_stick_get_drv_name_by_drv(g_sa_drv_register[spot].drv_), 1);
     }
-    return NULL;
   }
 
-  this_cmd = "mv"; // Measure (sensor) Value command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+  if (count_slaves == 0)
   {
-    int16_t sa = -1;
-    if (cmd[strlen(this_cmd)] == ':')
-    {
-      sa = atohex8(cmd+strlen(this_cmd)+1);
-    }
-    if (sa < 0)
-    {
-      sa = g_active_slave;
-    }
-
-    handle_cmd_mv(sa, channel_mask);
-    return NULL;
+    send_answer_chunk(channel_mask, this_cmd, 0);
+    send_answer_chunk(channel_mask, ":no slaves listed", 1);
   }
+  return NULL;
+}
+
 
-  this_cmd = "pwm"; // Pulse With Modulation command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+// DIsable Slave command
+const char *
+handle_cmd_token_dis(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  int16_t sa = -1;
+  int16_t i = -1;
+  if (cmd[strlen(this_cmd)] == ':')
   {
-    int16_t pin_no = -1;
-    if (cmd[strlen(this_cmd)] == ':')
+    sa = atohex8(cmd+strlen(this_cmd)+1);
+    if (*(cmd+strlen(this_cmd)+3) == ':')
     {
-      const char *p = cmd+strlen(this_cmd)+1;
-      if (('0' <= *p) && (*p <= '9'))
-      {
-        pin_no = atoi(p);
-      }
+      i = strlen(this_cmd)+4;
     }
-    if (pin_no >= 0)
+  }
+  if (sa < 0)
+  {
+    sa = g_active_slave;
+  }
+  uint8_t disable = 1;
+  if (i > 0)
+  {
+    disable = atoi(cmd+i);
+  }
+
+  char buf[16]; memset(buf, 0, sizeof(buf));
+  send_answer_chunk(channel_mask, this_cmd, 0);
+  send_answer_chunk(channel_mask, ":", 0);
+  uint8_to_hex(buf, sa);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ":", 0);
+
+  if (g_sa_list[sa].found_) // only allow disable of discovered slaves
+  {
+    int16_t spot = g_sa_list[sa].spot_;
+    if (disable > 0)
     {
-      const char *p = strchr(cmd+strlen(this_cmd)+1, ':');
-      int16_t pwm = -1;
-      if (p)
-      {
-        pwm = atoi(p+1);
-      }
-      if ((pwm >= 0) && (pwm <= 255))
-      {
-        hal_i2c_set_pwm(pin_no, pwm);
-        send_answer_chunk(channel_mask, this_cmd, 0);
-        send_answer_chunk(channel_mask, ":OK", 1);
-      } else
-      {
-        send_answer_chunk(channel_mask, this_cmd, 0);
-        send_answer_chunk(channel_mask, ":FAIL:Invalid pwm value", 1);
-      }
+      g_sa_drv_register[spot].disabled_ = 1;
+      uint8_to_hex(buf, 1);
     } else
     {
-      send_answer_chunk(channel_mask, this_cmd, 0);
-      send_answer_chunk(channel_mask, ":FAIL:pwm invalid pin_no", 1);
+      g_sa_drv_register[spot].disabled_ = 0;
+      uint8_to_hex(buf, 0);
     }
+    send_answer_chunk(channel_mask, buf, 0);
+    send_answer_chunk(channel_mask, ":", 0);
+    send_answer_chunk(channel_mask, "OK [i2c-stick register]", 1);
+  } else
+  {
+    send_answer_chunk(channel_mask, "FAIL: slave not seen by scan; try scan again", 1);
+  }
+  return NULL;
+}
 
 
-    return NULL;
+// Measure (sensor) Value command
+const char *
+handle_cmd_token_mv(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  int16_t sa = -1;
+  if (cmd[strlen(this_cmd)] == ':')
+  {
+    sa = atohex8(cmd+strlen(this_cmd)+1);
+  }
+  if (sa < 0)
+  {
+    sa = g_active_slave;
   }
 
-  this_cmd = "pinval"; // Pin value command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+  handle_cmd_mv(sa, channel_mask);
+  return NULL;
+}
+
+
+// Pulse With Modulation command
+const char *
+handle_cmd_token_pwm(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  int16_t pin_no = -1;
+  if (cmd[strlen(this_cmd)] == ':')
   {
-    int16_t pin_num = -1;
-    if (cmd[strlen(this_cmd)] == ':')
-    {
-      const char *p = cmd+strlen(this_cmd)+1;
-      if (('0' <= *p) && (*p <= '9'))
-      {
-        pin_num = atoi(p);
-      }
-    }
-    if (pin_num >= 0)
-    {
-      const char *p = strchr(cmd+strlen(this_cmd)+1, ':');
-      int16_t pval = -1;
-      if (p)
-      {
-        pval = atoi(p+1);
-      }
-      if ((pval == 0) || (pval == 1))
-      {
-        hal_write_pin(pin_num, pval);
-        send_answer_chunk(channel_mask, this_cmd, 0);
-        send_answer_chunk(channel_mask, ":OK", 1);
-      } else
-      {
-        send_answer_chunk(channel_mask, this_cmd, 0);
-        send_answer_chunk(channel_mask, ":FAIL:Invalid pin value", 1);
-      }
-    } else
+    const char *p = cmd+strlen(this_cmd)+1;
+    if (('0' <= *p) && (*p <= '9'))
     {
-      send_answer_chunk(channel_mask, this_cmd, 0);
-      send_answer_chunk(channel_mask, ":FAIL:pwm invalid pin_num", 1);
+      pin_no = atoi(p);
     }
-    return NULL;
   }
-
-  this_cmd = "nd"; // New Data command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+  if (pin_no >= 0)
   {
-    int16_t sa = -1;
-    if (cmd[strlen(this_cmd)] == ':')
+    const char *p = strchr(cmd+strlen(this_cmd)+1, ':');
+    int16_t pwm = -1;
+    if (p)
     {
-      sa = atohex8(cmd+strlen(this_cmd)+1);
+      pwm = atoi(p+1);
     }
-    if (sa < 0)
+    if ((pwm >= 0) && (pwm <= 255))
     {
-      sa = g_active_slave;
+      hal_i2c_set_pwm(pin_no, pwm);
+      send_answer_chunk(channel_mask, this_cmd, 0);
+      send_answer_chunk(channel_mask, ":OK", 1);
+    } else
+    {
+      send_answer_chunk(channel_mask, this_cmd, 0);
+      send_answer_chunk(channel_mask, ":FAIL:Invalid pwm value", 1);
     }
-
-    handle_cmd_nd(sa, channel_mask);
-    return NULL;
+  } else
+  {
+    send_answer_chunk(channel_mask, this_cmd, 0);
+    send_answer_chunk(channel_mask, ":FAIL:pwm invalid pin_no", 1);
   }
 
-  this_cmd = "as"; // Active Slave command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
-  {
-    send_answer_chunk(channel_mask, "as:", 0);
-    char buf[16]; memset(buf, 0, sizeof(buf));
-    send_answer_chunk(channel_mask, bytetohex(g_active_slave), 0);
-    send_answer_chunk(channel_mask, ":", 0);
 
-    int16_t spot = g_sa_list[g_active_slave].spot_;
+  return NULL;
+}
 
-    send_answer_chunk(channel_mask, bytetostr(g_sa_drv_register[spot].drv_), 0);
-    send_answer_chunk(channel_mask, ",", 0);
-    send_answer_chunk(channel_mask, i2c_stick_get_drv_name_by_drv(g_sa_drv_register[spot].drv_), 1);
-    return NULL;
-  }
 
-  this_cmd = "sn"; // Serial Number command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+// Pin value command
+const char *
+handle_cmd_token_pinval(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  int16_t pin_num = -1;
+  if (cmd[strlen(this_cmd)] == ':')
   {
-    int16_t sa = -1;
-    if (cmd[strlen(this_cmd)] == ':')
-    {
-      sa = atohex8(cmd+strlen(this_cmd)+1);
-    }
-    if (sa < 0)
+    const char *p = cmd+strlen(this_cmd)+1;
+    if (('0' <= *p) && (*p <= '9'))
     {
-      sa = g_active_slave;
+      pin_num = atoi(p);
     }
-
-    handle_cmd_sn(sa, channel_mask);
-    return NULL;
   }
-
-  this_cmd = "cs"; // Config Slave command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+  if (pin_num >= 0)
   {
-    int16_t sa = -1;
-    if (cmd[strlen(this_cmd)] == ':')
+    const char *p = strchr(cmd+strlen(this_cmd)+1, ':');
+    int16_t pval = -1;
+    if (p)
     {
-      sa = atohex8(cmd+strlen(this_cmd)+1);
+      pval = atoi(p+1);
     }
-    uint8_t i = 0;
-    if (sa < 0)
+    if ((pval == 0) || (pval == 1))
     {
-      sa = g_active_slave;
-    }
-    for (; i<strlen(cmd); i++)
+      hal_write_pin(pin_num, pval);
+      send_answer_chunk(channel_mask, this_cmd, 0);
+      send_answer_chunk(channel_mask, ":OK", 1);
+    } else
     {
-      if (cmd[i] == ':')
-      {
-        i++;
-        break;
-      }
+      send_answer_chunk(channel_mask, this_cmd, 0);
+      send_answer_chunk(channel_mask, ":FAIL:Invalid pin value", 1);
     }
-
-    handle_cmd_cs(sa, channel_mask, cmd+i);
-    return NULL;
+  } else
+  {
+    send_answer_chunk(channel_mask, this_cmd, 0);
+    send_answer_chunk(channel_mask, ":FAIL:pwm invalid pin_num", 1);
   }
+  return NULL;
+}
 
-  this_cmd = "+cs:"; // Config Slave command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+
+// New Data command
+const char *
+handle_cmd_token_nd(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  int16_t sa = -1;
+  if (cmd[strlen(this_cmd)] == ':')
   {
-    int16_t sa = atohex8(cmd+strlen(this_cmd));
-    if (sa < 0)
-    {
-      sa = g_active_slave;
-    }
-    uint8_t i = strlen(this_cmd);
-    for (; i<strlen(cmd); i++)
-    {
-      if (cmd[i] == ':')
-      {
-        i++;
-        break;
-      }
-    }
+    sa = atohex8(cmd+strlen(this_cmd)+1);
+  }
+  if (sa < 0)
+  {
+    sa = g_active_slave;
+  }
 
-    handle_cmd_cs_write(sa, channel_mask, cmd+i);
-    return NULL;
+  handle_cmd_nd(sa, channel_mask);
+  return NULL;
+}
+
+
+// Active Slave command
+const char *
+handle_cmd_token_as(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  send_answer_chunk(channel_mask, "as:", 0);
+  char buf[16]; memset(buf, 0, sizeof(buf));
+  send_answer_chunk(channel_mask, bytetohex(g_active_slave), 0);
+  send_answer_chunk(channel_mask, ":", 0);
+
+  int16_t spot = g_sa_list[g_active_slave].spot_;
+
+  send_answer_chunk(channel_mask, bytetostr(g_sa_drv_register[spot].drv_), 0);
+  send_answer_chunk(channel_mask, ",", 0);
+  send_answer_chunk(channel_mask, i2c_stick_get_drv_name_by_drv(g_sa_drv_register[spot].drv_), 1);
+  return NULL;
+}
+
+
+// Serial Number command
+const char *
+handle_cmd_token_sn(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  int16_t sa = -1;
+  if (cmd[strlen(this_cmd)] == ':')
+  {
+    sa = atohex8(cmd+strlen(this_cmd)+1);
   }
+  if (sa < 0)
+  {
+    sa = g_active_slave;
+  }
+
+  handle_cmd_sn(sa, channel_mask);
+  return NULL;
+}
 
-  this_cmd = "mr"; // Memory Read command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+
+// Config Slave command
+const char *
+handle_cmd_token_cs(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  int16_t sa = -1;
+  if (cmd[strlen(this_cmd)] == ':')
   {
-    int16_t sa = -1;
-    uint8_t i = 0;
-    if (cmd[strlen(this_cmd)] == ':')
-    {
-      sa = atohex8(cmd+strlen(this_cmd)+1);
-      i += strlen(this_cmd)+1;
-    }
-    if (sa < 0)
-    {
-      sa = g_active_slave;
-    }
-    for (; i<strlen(cmd); i++)
+    sa = atohex8(cmd+strlen(this_cmd)+1);
+  }
+  uint8_t i = 0;
+  if (sa < 0)
+  {
+    sa = g_active_slave;
+  }
+  for (; i<strlen(cmd); i++)
+  {
+    if (cmd[i] == ':')
     {
-      if (cmd[i] == ':')
-      {
-        i++;
-        break;
-      }
+      i++;
+      break;
     }
-
-    handle_cmd_mr(sa, channel_mask, cmd+i);
-    return NULL;
   }
 
-  this_cmd = "mw"; // Memory Write command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+  handle_cmd_cs(sa, channel_mask, cmd+i);
+  return NULL;
+}
+
+
+// Config Slave command
+const char *
+handle_cmd_token_cs_write(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  int16_t sa = atohex8(cmd+strlen(this_cmd));
+  if (sa < 0)
   {
-    int16_t sa = -1;
-    uint8_t i = 0;
-    if (cmd[strlen(this_cmd)] == ':')
-    {
-      sa = atohex8(cmd+strlen(this_cmd)+1);
-      i += strlen(this_cmd)+1;
-    }
-    if (sa < 0)
-    {
-      sa = g_active_slave;
-    }
-    for (; i<strlen(cmd); i++)
+    sa = g_active_slave;
+  }
+  uint8_t i = strlen(this_cmd);
+  for (; i<strlen(cmd); i++)
+  {
+    if (cmd[i] == ':')
     {
-      if (cmd[i] == ':')
-      {
-        i++;
-        break;
-      }
+      i++;
+      break;
     }
-
-    handle_cmd_mw(sa, channel_mask, cmd+i);
-    return NULL;
   }
 
-  this_cmd = "is"; // IS likely the correct product for this driver command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+  handle_cmd_cs_write(sa, channel_mask, cmd+i);
+  return NULL;
+}
+
+
+// Memory Read command
+const char *
+handle_cmd_token_mr(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  int16_t sa = -1;
+  uint8_t i = 0;
+  if (cmd[strlen(this_cmd)] == ':')
   {
-    int16_t sa = -1;
-    if (cmd[strlen(this_cmd)] == ':')
+    sa = atohex8(cmd+strlen(this_cmd)+1);
+    i += strlen(this_cmd)+1;
+  }
+  if (sa < 0)
+  {
+    sa = g_active_slave;
+  }
+  for (; i<strlen(cmd); i++)
+  {
+    if (cmd[i] == ':')
     {
-      sa = atohex8(cmd+strlen(this_cmd)+1);
+      i++;
+      break;
     }
-    if (sa < 0)
+  }
+
+  handle_cmd_mr(sa, channel_mask, cmd+i);
+  return NULL;
+}
+
+
+// Memory Write command
+const char *
+handle_cmd_token_mw(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  int16_t sa = -1;
+  uint8_t i = 0;
+  if (cmd[strlen(this_cmd)] == ':')
+  {
+    sa = atohex8(cmd+strlen(this_cmd)+1);
+    i += strlen(this_cmd)+1;
+  }
+  if (sa < 0)
+  {
+    sa = g_active_slave;
+  }
+  for (; i<strlen(cmd); i++)
+  {
+    if (cmd[i] == ':')
     {
-      sa = g_active_slave;
+      i++;
+      break;
     }
+  }
 
-    handle_cmd_is(sa, channel_mask);
-    return NULL;
+  handle_cmd_mw(sa, channel_mask, cmd+i);
+  return NULL;
+}
+
+
+// IS likely the correct product for this driver command
+const char *
+handle_cmd_token_is(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  int16_t sa = -1;
+  if (cmd[strlen(this_cmd)] == ':')
+  {
+    sa = atohex8(cmd+strlen(this_cmd)+1);
+  }
+  if (sa < 0)
+  {
+    sa = g_active_slave;
   }
 
-  this_cmd = "raw"; // read raw sensor data command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+  handle_cmd_is(sa, channel_mask);
+  return NULL;
+}
+
+
+// read raw sensor data command
+const char *
+handle_cmd_token_raw(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  int16_t sa = -1;
+  if (cmd[strlen(this_cmd)] == ':')
   {
-    int16_t sa = -1;
-    if (cmd[strlen(this_cmd)] == ':')
-    {
-      sa = atohex8(cmd+strlen(this_cmd)+1);
-    }
-    uint8_t i = 0;
-    if (sa < 0)
-    {
-      sa = g_active_slave;
-    }
-    for (; i<strlen(cmd); i++)
+    sa = atohex8(cmd+strlen(this_cmd)+1);
+  }
+  uint8_t i = 0;
+  if (sa < 0)
+  {
+    sa = g_active_slave;
+  }
+  for (; i<strlen(cmd); i++)
+  {
+    if (cmd[i] == ':')
     {
-      if (cmd[i] == ':')
-      {
-        i++;
-        break;
-      }
+      i++;
+      break;
     }
+  }
 
-    handle_cmd_raw(sa, channel_mask);
-    return NULL;
+  handle_cmd_raw(sa, channel_mask);
+  return NULL;
+}
+
+
+// List Applications command
+const char *
+handle_cmd_token_la(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  cmd_la(channel_mask);
+  return NULL;
+}
+
+
+// Config Application command
+const char *
+handle_cmd_token_ca(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  int16_t app_id = g_app_id;
+  uint8_t i = strlen(this_cmd);
+  if (cmd[i] == ':')
+  {
+    i++;
+    app_id = atoi(cmd+i);
   }
 
-  this_cmd = "la"; // List Applications command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+  if ((app_id < 0) || (app_id >= 256))
   {
-    cmd_la(channel_mask);
+    send_answer_chunk(channel_mask, cmd, 0);
+    send_answer_chunk(channel_mask, ":FAILED (invalid APP id)", 1);
     return NULL;
   }
 
-  this_cmd = "ca"; // Config Application command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+
+  for (; i<strlen(cmd); i++)
   {
-    int16_t app_id = g_app_id;
-    uint8_t i = strlen(this_cmd);
     if (cmd[i] == ':')
     {
       i++;
-      app_id = atoi(cmd+i);
-    }
-
-    if ((app_id < 0) || (app_id >= 256))
-    {
-      send_answer_chunk(channel_mask, cmd, 0);
-      send_answer_chunk(channel_mask, ":FAILED (invalid APP id)", 1);
-      return NULL;
+      break;
     }
+  }
 
+  cmd_ca(app_id, channel_mask, cmd+i);
+  return NULL;
+}
 
-    for (; i<strlen(cmd); i++)
-    {
-      if (cmd[i] == ':')
-      {
-        i++;
-        break;
-      }
-    }
 
-    cmd_ca(app_id, channel_mask, cmd+i);
-    return NULL;
+// Config Application command
+const char *
+handle_cmd_token_ca_write(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  char app_id_str[32]; memset(app_id_str, 0, sizeof(app_id_str));
+  // Copy from cmd+strlen(this_cmd) to app_id_str until ':' or end of string
+  size_t j = 0;
+  for (size_t k = strlen(this_cmd); cmd[k] != '\0' && cmd[k] != ':' && j < sizeof(app_id_str) - 1; ++k, ++j) {
+    app_id_str[j] = cmd[k];
   }
+  app_id_str[j] = '\0';
+  const char *parameters = cmd + strlen(this_cmd) + j + 1;
 
-  this_cmd = "+ca:"; // Config Application command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+  int16_t app_id = i2c_stick_get_app_id(app_id_str);
+  if (app_id == APP_NONE)
   {
-    char app_id_str[32]; memset(app_id_str, 0, sizeof(app_id_str));
-    // Copy from cmd+strlen(this_cmd) to app_id_str until ':' or end of string
-    size_t j = 0;
-    for (size_t k = strlen(this_cmd); cmd[k] != '\0' && cmd[k] != ':' && j < sizeof(app_id_str) - 1; ++k, ++j) {
-      app_id_str[j] = cmd[k];
-    }
-    app_id_str[j] = '\0';
-    const char *parameters = cmd + strlen(this_cmd) + j + 1;
+    app_id = atoi(app_id_str);
+  }
+  if ((app_id < 0) || (app_id >= 256))
+  {
+    send_answer_chunk(channel_mask, "+ca:FAILED (invalid APP id)", 1);
+  } else
+  {
+    cmd_ca_write(app_id, channel_mask, parameters);
+  }
 
-    int16_t app_id = i2c_stick_get_app_id(app_id_str);
+  return NULL;
+}
+
+
+// APPlication command
+const char *
+handle_cmd_token_app(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  const char *app_id_str = cmd+strlen(this_cmd);
+  int16_t app_id = g_app_id;
+  if (cmd[strlen(this_cmd)] == ':')
+  {
+    app_id = i2c_stick_get_app_id(app_id_str);
     if (app_id == APP_NONE)
     {
       app_id = atoi(app_id_str);
     }
-    if ((app_id < 0) || (app_id >= 256))
-    {
-      send_answer_chunk(channel_mask, "+ca:FAILED (invalid APP id)", 1);
-    } else
-    {
-      cmd_ca_write(app_id, channel_mask, parameters);
-    }
-
-    return NULL;
   }
 
-  this_cmd = "app"; // APPlication command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+  send_answer_chunk(channel_mask, "app:", 0);
+  char buf[8]; memset(buf, 0, sizeof(buf));
+  itoa(app_id, buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  if (app_id == APP_NONE)
   {
-    const char *app_id_str = cmd+strlen(this_cmd);
-    int16_t app_id = g_app_id;
-    if (cmd[strlen(this_cmd)] == ':')
-    {
-      app_id = i2c_stick_get_app_id(app_id_str);
-      if (app_id == APP_NONE)
-      {
-        app_id = atoi(app_id_str);
-      }
-    }
-
-    send_answer_chunk(channel_mask, "app:", 0);
-    char buf[8]; memset(buf, 0, sizeof(buf));
-    itoa(app_id, buf, 10);
-    send_answer_chunk(channel_mask, buf, 0);
-    if (app_id == APP_NONE)
-    {
-      send_answer_chunk(channel_mask, ":None", 1);
-    } else
-    {
-      send_answer_chunk(channel_mask, ":", 0);
-      send_answer_chunk(channel_mask, i2c_stick_get_app_name(app_id), 1);
-    }
-    return NULL;
+    send_answer_chunk(channel_mask, ":None", 1);
+  } else
+  {
+    send_answer_chunk(channel_mask, ":", 0);
+    send_answer_chunk(channel_mask, i2c_stick_get_app_name(app_id), 1);
   }
+  return NULL;
+}
+
 
-  this_cmd = "+app:"; // APPlication command
-  if (!strncmp(this_cmd, cmd, strlen(this_cmd)))
+// APPlication command
+const char *
+handle_cmd_token_app_write(uint8_t channel_mask, const char *cmd, const char *this_cmd)
+{
+  const char *app_id_str = cmd+strlen(this_cmd);
+  int16_t app_id = i2c_stick_get_app_id(app_id_str);
+  if (app_id == APP_NONE)
   {
-    const char *app_id_str = cmd+strlen(this_cmd);
-    int16_t app_id = i2c_stick_get_app_id(app_id_str);
-    if (app_id == APP_NONE)
-    {
-      app_id = atoi(app_id_str);
-    }
+    app_id = atoi(app_id_str);
+  }
 
-    send_answer_chunk(channel_mask, "+app", 0);
+  send_answer_chunk(channel_mask, "+app", 0);
 
-    if ((app_id < 0) || (app_id >= 256))
-    {
-      send_answer_chunk(channel_mask, ":FAILED (invalid APP id)", 1);
-    } else
+  if ((app_id < 0) || (app_id >= 256))
+  {
+    send_answer_chunk(channel_mask, ":FAILED (invalid APP id)", 1);
+  } else
+  {
+    if (g_app_id != app_id)
     {
-      if (g_app_id != app_id)
-      {
-        if (g_app_id != APP_NONE)
-        { // end the previous app
-          cmd_app_end(channel_mask);
-        }
+      if (g_app_id != APP_NONE)
+      { // end the previous app
+        cmd_app_end(channel_mask);
       }
-      // begin the new app
-      g_app_id = cmd_app_begin(app_id, channel_mask);
     }
-    return NULL;
+    // begin the new app
+    g_app_id = cmd_app_begin(app_id, channel_mask);
   }
-
-  return cmd;
+  return NULL;
 }
 
 
-void
-handle_cmd_mv(uint8_t sa, uint8_t channel_mask)
+const char *
+handle_cmd(uint8_t channel_mask, const char *cmd)
 {
-  float mv_list[768+1];
-  uint16_t mv_count = sizeof(mv_list)/sizeof(mv_list[0]);
-  char buf[20];
-  const char *error_message = NULL;
-  uint32_t time_stamp = hal_get_millis();
+  const i2c_stick_cmd_t *entry = i2c_stick_cmd_lookup(cmd);
+  if (entry == NULL) return cmd; // unknown command
+  return entry->handler_(channel_mask, cmd, entry->match_);
+}
 
-  send_answer_chunk(channel_mask, "mv:", 0);
-  uint8_to_hex(buf, sa);
-  send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ":", 0);
 
+static uint8_t
+sa_to_drv(uint8_t sa)
+{
   if (!g_sa_list[sa].found_)
-  { // not found!
-    uint32_to_dec(buf, time_stamp, 8);
-    send_answer_chunk(channel_mask, buf, 0);
-    send_answer_chunk(channel_mask, ":", 0);
-    send_answer_chunk(channel_mask, "FAIL: Slave not found; try scan command!", 1);
-    return;
+  {
+    return 0;
   }
+  return g_sa_drv_register[g_sa_list[sa].spot_].drv_;
+}
 
-  if (cmd_mv(sa, mv_list, &mv_count, &error_message) == 0)
+
+static void
+quant_temperature_range(const float *mv_list, uint16_t mv_count, float *offset, float *scale)
+{ // the TA value at the head of the list is no pixel; keep it out of the AUTO span.
+  if (mv_count > 0)
   {
-    uint32_to_dec(buf, time_stamp, 8);
-    send_answer_chunk(channel_mask, buf, 0);
-    send_answer_chunk(channel_mask, ":", 0);
-    send_answer_chunk(channel_mask, "FAIL: no device driver assigned", 1);
+    mv_list++;
+    mv_count--;
+  }
+  i2c_stick_quant_range(mv_list, mv_count, offset, scale);
+}
+
+
+void
+send_mv_answer(uint8_t sa, uint8_t channel_mask, const float *mv_list, uint16_t mv_count, uint32_t time_stamp, const char *error_message)
+{
+  char buf[20];
+
+  if ((g_config_host & 0x000F) == HOST_CFG_FORMAT_FRAME)
+  {
+    if (error_message != NULL)
+    {
+      send_frame_error(channel_mask, FRAME_TYPE_MV, sa, sa_to_drv(sa), time_stamp, error_message);
+      return;
+    }
+    if (i2c_stick_quant_is_active(sa))
+    {
+      float offset_scale[2];
+      quant_temperature_range(mv_list, mv_count, &offset_scale[0], &offset_scale[1]);
+      send_frame_begin(channel_mask, FRAME_TYPE_MV_Q8, sa, sa_to_drv(sa), time_stamp, sizeof(offset_scale) + mv_count);
+      send_frame_data(offset_scale, sizeof(offset_scale));
+      send_quant_list(channel_mask, mv_list, mv_count, offset_scale[0], offset_scale[1]);
+      send_frame_end();
+      return;
+    }
+    // all supported targets are little endian; floats are sent as-is.
+    send_frame(channel_mask, FRAME_TYPE_MV, sa, sa_to_drv(sa), time_stamp, mv_list, mv_count * sizeof(mv_list[0]));
     return;
   }
-  time_stamp = hal_get_millis(); // update timestamp when data is available.
+
+  send_answer_chunk(channel_mask, "mv:", 0);
+  uint8_to_hex(buf, sa);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ":", 0);
   uint32_to_dec(buf, time_stamp, 8);
   send_answer_chunk(channel_mask, buf, 0);
   send_answer_chunk(channel_mask, ":", 0);
@@ -1107,30 +1283,10 @@ handle_cmd_mv(uint8_t sa, uint8_t channel_mask)
     send_answer_chunk(channel_mask, error_message, 1);
     return;
   }
-  if (mv_count == 0)
-  {
-    send_answer_chunk(channel_mask, "FAIL: local buffer not big enough", 1);
-    return;
-  }
 
   if ((g_config_host & 0x000F) == HOST_CFG_FORMAT_DEC)
   {
-    for (int16_t i=0; i<mv_count; i++)
-    {
-      memset(buf, 0, sizeof(buf));
-      const char *p = my_dtostrf(mv_list[i], 14, 2, buf);
-      while (*p == ' ') p++; // remove leading space
-      if ((p - buf) > 10) p = "NaN"; // should never ever happen!
-
-      if (i < (mv_count - 1))
-      { // not yet last element...
-        send_answer_chunk(channel_mask, p, 0);
-        send_answer_chunk(channel_mask, ",", 0);
-      } else
-      { // last element...
-        send_answer_chunk(channel_mask, p, 1);
-      }
-    }
+    send_float_list_dec(channel_mask, mv_list, mv_count, 2);
   }
 
   if ((g_config_host & 0x000F) == HOST_CFG_FORMAT_HEX)
@@ -1156,6 +1312,25 @@ handle_cmd_mv(uint8_t sa, uint8_t channel_mask)
     }
   }
 
+  if (((g_config_host & 0x000F) == HOST_CFG_FORMAT_BIN) && (i2c_stick_quant_is_active(sa)))
+  { // "Q8:<offset>:<scale>:<count>" in text format, followed by one byte per value.
+    char buf[FLOAT_TO_DEC_MAX_LEN + 1];
+    float offset;
+    float scale;
+    quant_temperature_range(mv_list, mv_count, &offset, &scale);
+    send_answer_chunk(channel_mask, "Q8:", 0);
+    buf[float_to_sci(buf, offset)] = '\0';
+    send_answer_chunk(channel_mask, buf, 0);
+    send_answer_chunk(channel_mask, ":", 0);
+    buf[float_to_sci(buf, scale)] = '\0';
+    send_answer_chunk(channel_mask, buf, 0);
+    send_answer_chunk(channel_mask, ":", 0);
+    itoa(mv_count, buf, 10);
+    send_answer_chunk(channel_mask, buf, 1);
+    send_quant_list(channel_mask, mv_list, mv_count, offset, scale);
+    return;
+  }
+
   if ((g_config_host & 0x000F) == HOST_CFG_FORMAT_BIN)
   {
     // send in text format the length of the byte-stream in binary format.
@@ -1174,33 +1349,119 @@ handle_cmd_mv(uint8_t sa, uint8_t channel_mask)
 
 
 void
-handle_cmd_raw(uint8_t sa, uint8_t channel_mask)
+send_mv_delta_answer(uint8_t sa, uint8_t channel_mask, const float *mv_list, uint16_t mv_count, uint32_t time_stamp, const delta_run_t *run_list, uint16_t run_count)
+{ // only the runs of changed values; DEC and FRAME format.
+  if ((g_config_host & 0x000F) == HOST_CFG_FORMAT_FRAME)
+  {
+    uint16_t payload_length = sizeof(mv_count);
+    for (uint16_t r=0; r<run_count; r++)
+    {
+      payload_length += 2 * sizeof(uint16_t) + run_list[r].count_ * sizeof(mv_list[0]);
+    }
+    send_frame_begin(channel_mask, FRAME_TYPE_MV_DELTA, sa, sa_to_drv(sa), time_stamp, payload_length);
+    send_frame_data(&mv_count, sizeof(mv_count));
+    for (uint16_t r=0; r<run_count; r++)
+    {
+      send_frame_data(&run_list[r].first_, sizeof(run_list[r].first_));
+      send_frame_data(&run_list[r].count_, sizeof(run_list[r].count_));
+      send_frame_data(&mv_list[run_list[r].first_], run_list[r].count_ * sizeof(mv_list[0]));
+    }
+    send_frame_end();
+    return;
+  }
+
+  char buf[512];
+  uint16_t pos = 0;
+  memcpy(buf, "mvd:", 4); pos += 4;
+  uint8_to_hex(buf + pos, sa); pos += 2;
+  buf[pos++] = ':';
+  uint32_to_dec(buf + pos, time_stamp, 8); pos += strlen(buf + pos);
+  buf[pos++] = ':';
+  itoa(mv_count, buf + pos, 10); pos += strlen(buf + pos);
+  buf[pos++] = ':';
+  for (uint16_t r=0; r<run_count; r++)
+  {
+    const delta_run_t *run = &run_list[r];
+    for (uint16_t i=run->first_; i<run->first_+run->count_; i++)
+    {
+      if ((pos + FLOAT_TO_DEC_MAX_LEN + 8) > sizeof(buf))
+      {
+        buf[pos] = '\0';
+        send_answer_chunk(channel_mask, buf, 0);
+        pos = 0;
+      }
+      if (i == run->first_)
+      {
+        if (r > 0) buf[pos++] = ';';
+        itoa(i, buf + pos, 10); pos += strlen(buf + pos);
+        buf[pos++] = '=';
+      } else
+      {
+        buf[pos++] = ',';
+      }
+      pos += float_to_dec(buf + pos, mv_list[i], 2);
+    }
+  }
+  buf[pos] = '\0';
+  send_answer_chunk(channel_mask, buf, 1);
+}
+
+
+void
+handle_cmd_mv(uint8_t sa, uint8_t channel_mask)
 {
-  uint16_t raw_list[834]; memset(raw_list, 0, sizeof(raw_list));
-  uint16_t raw_count = sizeof(raw_list)/sizeof(raw_list[0]);
-  char buf[16];
+  uint16_t mv_count = 768+1;
   const char *error_message = NULL;
-
-  send_answer_chunk(channel_mask, "raw:", 0);
-  uint8_to_hex(buf, sa);
-  send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ":", 0);
+  uint32_t time_stamp = hal_get_millis();
 
   if (!g_sa_list[sa].found_)
   { // not found!
-    send_answer_chunk(channel_mask, "FAIL: Slave[", 0);
-    uint8_to_hex(buf, sa);
-    send_answer_chunk(channel_mask, buf, 0);
-    send_answer_chunk(channel_mask, "] not found; try scan command!", 1);
+    send_mv_answer(sa, channel_mask, NULL, 0, time_stamp, "Slave not found; try scan command!");
     return;
   }
 
-  if (cmd_raw(sa, raw_list, &raw_count, &error_message) == 0)
+  scratch_scope_t scope;
+  scratch_begin(&scope);
+  float *mv_list = (float *)scratch_alloc(mv_count * sizeof(float));
+  if (mv_list == NULL)
   {
-    send_answer_chunk(channel_mask, "FAIL: no device driver assigned", 1);
+    send_mv_answer(sa, channel_mask, NULL, 0, time_stamp, "scratch arena exhausted");
+  } else if (cmd_mv(sa, mv_list, &mv_count, &error_message) == 0)
+  {
+    send_mv_answer(sa, channel_mask, mv_list, 0, time_stamp, "no device driver assigned");
+  } else
+  {
+    time_stamp = hal_get_millis(); // update timestamp when data is available.
+    if ((error_message == NULL) && (mv_count == 0))
+    {
+      error_message = "local buffer not big enough";
+    }
+    send_mv_answer(sa, channel_mask, mv_list, mv_count, time_stamp, error_message);
+  }
+  scratch_end(&scope);
+}
+
+
+void
+send_raw_answer(uint8_t sa, uint8_t channel_mask, const uint16_t *raw_list, uint16_t raw_count, uint32_t time_stamp, const char *error_message)
+{
+  char buf[16];
+
+  if ((g_config_host & 0x000F) == HOST_CFG_FORMAT_FRAME)
+  {
+    if (error_message != NULL)
+    {
+      send_frame_error(channel_mask, FRAME_TYPE_RAW, sa, sa_to_drv(sa), time_stamp, error_message);
+      return;
+    }
+    send_frame(channel_mask, FRAME_TYPE_RAW, sa, sa_to_drv(sa), time_stamp, raw_list, raw_count * sizeof(raw_list[0]));
     return;
   }
-  uint32_t time_stamp = hal_get_millis(); // update timestamp when data is available.
+
+  send_answer_chunk(channel_mask, "raw:", 0);
+  uint8_to_hex(buf, sa);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ":", 0);
   uint32_to_dec(buf, time_stamp, 8);
   send_answer_chunk(channel_mask, buf, 0);
   send_answer_chunk(channel_mask, ":", 0);
@@ -1212,12 +1473,6 @@ handle_cmd_raw(uint8_t sa, uint8_t channel_mask)
     return;
   }
 
-  if (raw_count == 0)
-  {
-    send_answer_chunk(channel_mask, "FAIL: local buffer not big enough", 1);
-    return;
-  }
-
   if ((g_config_host & 0x000F) == HOST_CFG_FORMAT_BIN)
   {
     char buf[16]; memset(buf, 0, sizeof(buf));
@@ -1241,7 +1496,98 @@ handle_cmd_raw(uint8_t sa, uint8_t channel_mask)
       }
     }
   }
+}
+
+
+void
+handle_cmd_raw(uint8_t sa, uint8_t channel_mask)
+{
+  uint16_t raw_count = 834;
+  char buf[16];
+  const char *error_message = NULL;
+  uint8_t framed = ((g_config_host & 0x000F) == HOST_CFG_FORMAT_FRAME);
+
+  if (!g_sa_list[sa].found_)
+  { // not found!
+    if (framed)
+    {
+      send_frame_error(channel_mask, FRAME_TYPE_RAW, sa, 0, hal_get_millis(), "Slave not found; try scan command!");
+      return;
+    }
+    send_answer_chunk(channel_mask, "raw:", 0);
+    uint8_to_hex(buf, sa);
+    send_answer_chunk(channel_mask, buf, 0);
+    send_answer_chunk(channel_mask, ":", 0);
+    send_answer_chunk(channel_mask, "FAIL: Slave[", 0);
+    uint8_to_hex(buf, sa);
+    send_answer_chunk(channel_mask, buf, 0);
+    send_answer_chunk(channel_mask, "] not found; try scan command!", 1);
+    return;
+  }
+
+  scratch_scope_t scope;
+  scratch_begin(&scope);
+  uint16_t *raw_list = (uint16_t *)scratch_alloc(raw_count * sizeof(uint16_t));
+  if (raw_list == NULL)
+  {
+    send_raw_answer(sa, channel_mask, NULL, 0, hal_get_millis(), "scratch arena exhausted");
+  } else
+  {
+    memset(raw_list, 0, raw_count * sizeof(uint16_t));
+    if (cmd_raw(sa, raw_list, &raw_count, &error_message) == 0)
+    {
+      if (framed)
+      {
+        send_frame_error(channel_mask, FRAME_TYPE_RAW, sa, sa_to_drv(sa), hal_get_millis(), "no device driver assigned");
+      } else
+      {
+        send_answer_chunk(channel_mask, "raw:", 0);
+        uint8_to_hex(buf, sa);
+        send_answer_chunk(channel_mask, buf, 0);
+        send_answer_chunk(channel_mask, ":", 0);
+        send_answer_chunk(channel_mask, "FAIL: no device driver assigned", 1);
+      }
+    } else
+    {
+      uint32_t time_stamp = hal_get_millis(); // update timestamp when data is available.
+      if ((error_message == NULL) && (raw_count == 0))
+      {
+        error_message = "local buffer not big enough";
+      }
+      send_raw_answer(sa, channel_mask, raw_list, raw_count, time_stamp, error_message);
+    }
+  }
+  scratch_end(&scope);
+}
+
+
+void
+handle_cmd_nd_frame(uint8_t sa, uint8_t channel_mask)
+{
+  uint8_t nd = 0;
+  const char *error_message = NULL;
+  uint8_t drv = sa_to_drv(sa);
+
+  if (!g_sa_list[sa].found_)
+  { // not found!
+    send_frame_error(channel_mask, FRAME_TYPE_ND, sa, drv, hal_get_millis(), "Slave not found; try scan command!");
+    return;
+  }
+
+  if (cmd_nd(sa, &nd, &error_message) == 0)
+  {
+    send_frame_error(channel_mask, FRAME_TYPE_ND, sa, drv, hal_get_millis(), "no device driver assigned");
+    return;
+  }
 
+  if (error_message != NULL)
+  {
+    send_frame_error(channel_mask, FRAME_TYPE_ND, sa, drv, hal_get_millis(), error_message);
+    return;
+  }
+
+  nd = nd ? 1 : 0;
+  send_frame(channel_mask, FRAME_TYPE_ND, sa, drv, hal_get_millis(), &nd, sizeof(nd));
 }
 
 
@@ -1252,6 +1598,12 @@ handle_cmd_nd(uint8_t sa, uint8_t channel_mask)
   char buf[16]; memset(buf, 0, sizeof(buf));
   const char *error_message = NULL;
 
+  if ((g_config_host & 0x000F) == HOST_CFG_FORMAT_FRAME)
+  {
+    handle_cmd_nd_frame(sa, channel_mask);
+    return;
+  }
+
   send_answer_chunk(channel_mask, "nd:", 0);
   uint8_to_hex(buf, sa);
   send_answer_chunk(channel_mask, buf, 0);
@@ -1381,10 +1733,51 @@ handle_cmd_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
 
 
 
+static void
+send_mr_answer(uint8_t channel_mask, const uint16_t *mem_list, uint16_t mem_start_address, uint16_t mem_count, uint8_t bit_per_address, uint8_t address_increments)
+{
+  char buf[16];
+  uint16_to_hex(buf, mem_start_address);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",", 0);
+
+  uint8_to_hex(buf, bit_per_address);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",", 0);
+
+  uint8_to_hex(buf, address_increments);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",", 0);
+
+  uint16_to_hex(buf, mem_count);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",DATA,", 0);
+
+  if (mem_count == 0)
+  {
+    send_answer_chunk(channel_mask, "no data", 1);
+  } else
+  {
+    for (uint16_t i=0; i<mem_count; i++)
+    {
+      uint16_to_hex(buf, mem_list[i]);
+
+      if (i < (mem_count - 1))
+      { // not yet last element...
+        send_answer_chunk(channel_mask, buf, 0);
+        send_answer_chunk(channel_mask, ",", 0);
+      } else
+      { // last element...
+        send_answer_chunk(channel_mask, buf, 1);
+      }
+    }
+  }
+}
+
+
 void
 handle_cmd_mr(uint8_t sa, uint8_t channel_mask, const char *input)
 {
-  uint16_t mem_list[1024];
   uint16_t mem_start_address = 0;
   uint16_t mem_count = 1;
   uint8_t bit_per_address = 0;
@@ -1432,61 +1825,30 @@ handle_cmd_mr(uint8_t sa, uint8_t channel_mask, const char *input)
     return;
   }
 
-  if (cmd_mr(sa, mem_list, mem_start_address, mem_count, &bit_per_address, &address_increments, &error_message) == 0)
+  scratch_scope_t scope;
+  scratch_begin(&scope);
+  uint16_t *mem_list = (uint16_t *)scratch_alloc(mem_count * sizeof(uint16_t));
+  if (mem_list == NULL)
+  {
+    send_answer_chunk(channel_mask, "FAIL: scratch arena exhausted; read less words", 1);
+  } else if (cmd_mr(sa, mem_list, mem_start_address, mem_count, &bit_per_address, &address_increments, &error_message) == 0)
   {
     send_answer_chunk(channel_mask, "FAIL: no device driver assigned", 1);
-    return;
-  }
-
-  if (error_message != NULL)
+  } else if (error_message != NULL)
   {
     send_answer_chunk(channel_mask, "FAIL: ", 0);
     send_answer_chunk(channel_mask, error_message, 1);
-    return;
-  }
-
-  uint16_to_hex(buf, mem_start_address);
-  send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ",", 0);
-
-  uint8_to_hex(buf, bit_per_address);
-  send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ",", 0);
-
-  uint8_to_hex(buf, address_increments);
-  send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ",", 0);
-
-  uint16_to_hex(buf, mem_count);
-  send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ",DATA,", 0);
-
-  if (mem_count == 0)
-  {
-    send_answer_chunk(channel_mask, "no data", 1);
   } else
   {
-    for (uint16_t i=0; i<mem_count; i++)
-    {
-      uint16_to_hex(buf, mem_list[i]);
-
-      if (i < (mem_count - 1))
-      { // not yet last element...
-        send_answer_chunk(channel_mask, buf, 0);
-        send_answer_chunk(channel_mask, ",", 0);
-      } else
-      { // last element...
-        send_answer_chunk(channel_mask, buf, 1);
-      }
-    }
+    send_mr_answer(channel_mask, mem_list, mem_start_address, mem_count, bit_per_address, address_increments);
   }
+  scratch_end(&scope);
 }
 
 
 void
 handle_cmd_mw(uint8_t sa, uint8_t channel_mask, const char *input)
 {
-  uint16_t mem_list[1024];
   uint16_t mem_start_address = 0;
   uint16_t mem_count = 1;
   uint8_t bit_per_address = 0;
@@ -1520,8 +1882,29 @@ handle_cmd_mw(uint8_t sa, uint8_t channel_mask, const char *input)
     return;
   }
 
+  uint16_t max_count = 0; // one word per ','
+  for (const char *q = strchr(p, ','); q != NULL; q = strchr(q+1, ','))
+  {
+    max_count++;
+  }
+  if (max_count == 0)
+  {
+    send_answer_chunk(channel_mask, "FAIL: no data given", 1);
+    return;
+  }
+
+  scratch_scope_t scope;
+  scratch_begin(&scope);
+  uint16_t *mem_list = (uint16_t *)scratch_alloc(max_count * sizeof(uint16_t));
+  if (mem_list == NULL)
+  {
+    send_answer_chunk(channel_mask, "FAIL: scratch arena exhausted", 1);
+    scratch_end(&scope);
+    return;
+  }
+
   uint16_t i=0;
-  for (; i<(sizeof(mem_list)/sizeof(mem_list[0])); i++)
+  for (; i<max_count; i++)
   {
     p = strchr(p, ',');
     if (p == NULL)
@@ -1541,23 +1924,18 @@ handle_cmd_mw(uint8_t sa, uint8_t channel_mask, const char *input)
   if (mem_count == 0)
   {
     send_answer_chunk(channel_mask, "FAIL: no data given", 1);
-    return;
-  }
-
-  if (cmd_mw(sa, mem_list, mem_start_address, mem_count, &bit_per_address, &address_increments, &error_message) == 0)
+  } else if (cmd_mw(sa, mem_list, mem_start_address, mem_count, &bit_per_address, &address_increments, &error_message) == 0)
   {
     send_answer_chunk(channel_mask, "FAIL: no device driver assigned", 1);
-    return;
-  }
-
-  if (error_message != NULL)
+  } else if (error_message != NULL)
   {
     send_answer_chunk(channel_mask, "FAIL: ", 0);
     send_answer_chunk(channel_mask, error_message, 1);
-    return;
+  } else
+  {
+    send_answer_chunk(channel_mask, "OK", 1);
   }
-
-  send_answer_chunk(channel_mask, "OK", 1);
+  scratch_end(&scope);
 }
 
 
@@ -1618,6 +1996,9 @@ cmd_ch(uint8_t channel_mask, const char *input)
     case HOST_CFG_FORMAT_BIN:
       value = "BIN";
       break;
+    case HOST_CFG_FORMAT_FRAME:
+      value = "FRAME";
+      break;
     default:
       value = "Unknown";
   }
@@ -1652,6 +2033,53 @@ cmd_ch(uint8_t channel_mask, const char *input)
   sprintf(buf, "%d(%s)", freq, value);
   send_answer_chunk(channel_mask, buf, 1);
 
+  i2c_stick_tx_stats_t tx_stats;
+  i2c_stick_tx_get_stats(&tx_stats);
+  send_answer_chunk(channel_mask, "ch:TX_BUF=", 0);
+  itoa(tx_stats.size_, buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",", 0);
+  itoa(tx_stats.high_water_mark_, buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",", 0);
+  itoa(tx_stats.overflow_count_, buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, "(size,high_water,overflow)", 1);
+
+  send_answer_chunk(channel_mask, "ch:DELTA=", 0);
+  float deadband = i2c_stick_delta_get_deadband();
+  if (deadband < 0)
+  {
+    send_answer_chunk(channel_mask, "OFF", 1);
+  } else
+  {
+    const char *p = my_dtostrf(deadband, 10, 2, buf);
+    while (*p == ' ') p++; // remove leading space
+    send_answer_chunk(channel_mask, p, 0);
+    send_answer_chunk(channel_mask, "(degC)", 1);
+  }
+
+  send_answer_chunk(channel_mask, "ch:KEYFRAME=", 0);
+  itoa(i2c_stick_delta_get_keyframe_interval(), buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, "(frames)", 1);
+
+  send_answer_chunk(channel_mask, "ch:QUANT=", 0);
+  const quant_cfg_t *quant = i2c_stick_quant_get_cfg();
+  if (quant->mode_ == QUANT_FIXED)
+  {
+    char dec_buf[FLOAT_TO_DEC_MAX_LEN + 1];
+    dec_buf[float_to_dec(dec_buf, quant->lo_, 2)] = '\0';
+    send_answer_chunk(channel_mask, dec_buf, 0);
+    send_answer_chunk(channel_mask, ",", 0);
+    dec_buf[float_to_dec(dec_buf, quant->hi_, 2)] = '\0';
+    send_answer_chunk(channel_mask, dec_buf, 0);
+    send_answer_chunk(channel_mask, "(degC)", 1);
+  } else
+  {
+    send_answer_chunk(channel_mask, (quant->mode_ == QUANT_AUTO) ? "AUTO" : "OFF", 1);
+  }
+
   for (uint16_t spot=1; spot<MAX_SA_DRV_REGISTRATIONS; spot++)
   {
     uint8_t sa = g_sa_drv_register[spot].sa_;
@@ -1768,6 +2196,11 @@ cmd_ch_write(uint8_t channel_mask, const char *input)
         value = HOST_CFG_FORMAT_BIN;
         valid = true;
       }
+      else if (!strcmp(p, "FRAME"))
+      {
+        value = HOST_CFG_FORMAT_FRAME;
+        valid = true;
+      }
     }
     if (!valid)
     {
@@ -1778,6 +2211,7 @@ cmd_ch_write(uint8_t channel_mask, const char *input)
     }
     g_config_host &= ~0x000F;
     g_config_host |= (value & 0x000F);
+    i2c_stick_delta_reset(); // the host starts over with a new parser.
     send_answer_chunk(channel_mask, "+ch:OK [host-register]", 1);
     return 1;
   }
@@ -1843,6 +2277,77 @@ cmd_ch_write(uint8_t channel_mask, const char *input)
     return 1;
   }
 
+  var_name = "DELTA=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  {
+    const char *p = input+strlen(var_name);
+    float value = -1.0f;
+    uint8_t valid = false;
+
+    if (!strcmp(p, "OFF"))
+    {
+      valid = true;
+    }
+    else if ((('0' <= p[0]) && (p[0] <= '9')) || (p[0] == '.'))
+    {
+      value = atof(p);
+      valid = true;
+    }
+    if (!valid)
+    {
+      send_answer_chunk(channel_mask, "+ch:", 0);
+      send_answer_chunk(channel_mask, input, 0);
+      send_answer_chunk(channel_mask, ":ERROR: Invalid value", 1);
+      return 0;
+    }
+    i2c_stick_delta_set_deadband(value);
+
+    send_answer_chunk(channel_mask, "+ch:OK [host-register]", 1);
+    return 1;
+  }
+
+  var_name = "KEYFRAME=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  {
+    const char *p = input+strlen(var_name);
+    uint16_t value = 0;
+    uint8_t valid = false;
+
+    if (('0' <= p[0]) && (p[0] <= '9'))
+    {
+      value = atoi(p);
+      if (value < 256)
+      {
+        valid = true;
+      }
+    }
+    if (!valid)
+    {
+      send_answer_chunk(channel_mask, "+ch:", 0);
+      send_answer_chunk(channel_mask, input, 0);
+      send_answer_chunk(channel_mask, ":ERROR: Invalid value", 1);
+      return 0;
+    }
+    i2c_stick_delta_set_keyframe_interval(value);
+
+    send_answer_chunk(channel_mask, "+ch:OK [host-register]", 1);
+    return 1;
+  }
+
+  var_name = "QUANT=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  {
+    if (i2c_stick_quant_parse(input+strlen(var_name)) < 0)
+    {
+      send_answer_chunk(channel_mask, "+ch:", 0);
+      send_answer_chunk(channel_mask, input, 0);
+      send_answer_chunk(channel_mask, ":ERROR: Invalid value", 1);
+      return 0;
+    }
+    send_answer_chunk(channel_mask, "+ch:OK [host-register]", 1);
+    return 1;
+  }
+
   var_name = "SA_DRV=";
   if (!strncmp(var_name, input, strlen(var_name)))
   {
@@ -1890,6 +2395,7 @@ cmd_ch_write(uint8_t channel_mask, const char *input)
           g_sa_drv_register[spot].drv_ = 0;
         }
       }
+      i2c_stick_update_sa_ops(sa);
     }
 
     send_answer_chunk(channel_mask, "+ch:OK [host-register]", 1);
@@ -1932,6 +2438,14 @@ handle_cmd_sos(uint8_t channel_mask, const char *input)
       send_answer_chunk(channel_mask, "    - +ch:I2C_FREQ=F50k", 1);
       send_answer_chunk(channel_mask, "    - +ch:I2C_FREQ=F20k", 1);
       send_answer_chunk(channel_mask, "    - +ch:I2C_FREQ=F10k", 1);
+      send_answer_chunk(channel_mask, "3] change-only streaming in continuous mode (DEC and FRAME format):", 1);
+      send_answer_chunk(channel_mask, "    - +ch:DELTA=0.2     (dead-band in degC)", 1);
+      send_answer_chunk(channel_mask, "    - +ch:DELTA=OFF", 1);
+      send_answer_chunk(channel_mask, "    - +ch:KEYFRAME=50   (full frame every n frames; 0 => only when needed)", 1);
+      send_answer_chunk(channel_mask, "4] 8-bit quantised mv values (BIN and FRAME format; thermal array pixel lists):", 1);
+      send_answer_chunk(channel_mask, "    - +ch:QUANT=AUTO    (offset and scale from the min and max of each answer)", 1);
+      send_answer_chunk(channel_mask, "    - +ch:QUANT=20,40   (fixed span in degC)", 1);
+      send_answer_chunk(channel_mask, "    - +ch:QUANT=OFF", 1);
       return;
     }
     this_cmd = ":dis";
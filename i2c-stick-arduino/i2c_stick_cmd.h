@@ -2,6 +2,8 @@
 #define __I2C_STICK_CMD_H__
 
 #include <stdint.h>
+#include "i2c_stick_delta.h"
+#include "i2c_stick_format.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -12,11 +14,16 @@ char nibble_to_hex(uint8_t nibble);
 void uint8_to_hex(char *hex, uint8_t dec);
 void uint16_to_hex(char *hex, uint16_t dec);
 void uint32_to_dec(char *str, uint32_t dec, int8_t digits);
+uint16_t crc16_update(uint16_t crc, const void *data, uint16_t length);
 int16_t atohex8(const char *in);
 int32_t atohex16(const char *in);
 const char *bytetohex(uint8_t dec);
 const char *bytetostr(uint8_t dec);
-char *my_dtostrf(float val,  int8_t char_num, uint8_t precision, char *chr_buffer);
+void send_float_list_dec(uint8_t channel_mask, const float *list, uint16_t count, uint8_t precision);
+// 'cs:SA:<var_name>=<value>'
+void send_cs_value(uint8_t sa, uint8_t channel_mask, const char *var_name, const char *value);
+// '+cs:SA:<var_name>=OK [hub-register]' for result 0, otherwise '=FAIL; <fail_reason>'
+void send_cs_write_answer(uint8_t sa, uint8_t channel_mask, const char *var_name, int8_t result, const char *fail_reason);
 
 // command functions.
 
@@ -24,7 +31,11 @@ char *my_dtostrf(float val,  int8_t char_num, uint8_t precision, char *chr_buffe
 const char *handle_cmd(uint8_t channel_mask, const char *cmd);
 void handle_cmd_mv(uint8_t sa, uint8_t channel_mask);
 void handle_cmd_raw(uint8_t sa, uint8_t channel_mask);
+void send_mv_answer(uint8_t sa, uint8_t channel_mask, const float *mv_list, uint16_t mv_count, uint32_t time_stamp, const char *error_message);
+void send_mv_delta_answer(uint8_t sa, uint8_t channel_mask, const float *mv_list, uint16_t mv_count, uint32_t time_stamp, const delta_run_t *run_list, uint16_t run_count);
+void send_raw_answer(uint8_t sa, uint8_t channel_mask, const uint16_t *raw_list, uint16_t raw_count, uint32_t time_stamp, const char *error_message);
 void handle_cmd_nd(uint8_t sa, uint8_t channel_mask);
+void handle_cmd_nd_frame(uint8_t sa, uint8_t channel_mask);
 void handle_cmd_sn(uint8_t sa, uint8_t channel_mask);
 void handle_cmd_ch(uint8_t channel_mask, const char *input);
 void handle_cmd_ch_write(uint8_t channel_mask, const char *input);
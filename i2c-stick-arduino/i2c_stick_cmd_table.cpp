@@ -0,0 +1,152 @@
+// this file is automatically generated:
+// please edit 'context.yaml', and then:
+// run the python doit script `python dodo.py generate` or `doit generate`.
+
+#include "i2c_stick_cmd_table.h"
+#include "i2c_stick.h"
+
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+static const i2c_stick_cmd_t g_cmd_table[I2C_STICK_CMD_TABLE_SIZE] =
+{
+  { NULL, NULL, NULL }, // 0
+  { NULL, NULL, NULL }, // 1
+  { NULL, NULL, NULL }, // 2
+  { NULL, NULL, NULL }, // 3
+  { "ls", "ls", handle_cmd_token_ls }, // 4
+  { NULL, NULL, NULL }, // 5
+  { "as", "as", handle_cmd_token_as }, // 6
+  { "mw", "mw", handle_cmd_token_mw }, // 7
+  { "mem", "mem", handle_cmd_token_mem }, // 8
+  { NULL, NULL, NULL }, // 9
+  { "ch", "ch", handle_cmd_token_ch }, // 10
+  { "nd", "nd", handle_cmd_token_nd }, // 11
+  { NULL, NULL, NULL }, // 12
+  { NULL, NULL, NULL }, // 13
+  { NULL, NULL, NULL }, // 14
+  { NULL, NULL, NULL }, // 15
+  { "fv", "fv", handle_cmd_token_fv }, // 16
+  { "+ca", "+ca:", handle_cmd_token_ca_write }, // 17
+  { "bi", "bi", handle_cmd_token_bi }, // 18
+  { NULL, NULL, NULL }, // 19
+  { NULL, NULL, NULL }, // 20
+  { NULL, NULL, NULL }, // 21
+  { "sos", "sos", handle_cmd_token_sos }, // 22
+  { NULL, NULL, NULL }, // 23
+  { NULL, NULL, NULL }, // 24
+  { "dis", "dis", handle_cmd_token_dis }, // 25
+  { NULL, NULL, NULL }, // 26
+  { NULL, NULL, NULL }, // 27
+  { NULL, NULL, NULL }, // 28
+  { NULL, NULL, NULL }, // 29
+  { NULL, NULL, NULL }, // 30
+  { NULL, NULL, NULL }, // 31
+  { "+app", "+app:", handle_cmd_token_app_write }, // 32
+  { "app", "app", handle_cmd_token_app }, // 33
+  { "scan", "scan", handle_cmd_token_scan }, // 34
+  { NULL, NULL, NULL }, // 35
+  { NULL, NULL, NULL }, // 36
+  { "ca", "ca", handle_cmd_token_ca }, // 37
+  { "i2c", "i2c:", handle_cmd_token_i2c }, // 38
+  { NULL, NULL, NULL }, // 39
+  { "raw", "raw", handle_cmd_token_raw }, // 40
+#ifdef BUFFER_COMMAND_ENABLE
+  { "buf", "buf", handle_cmd_token_buf }, // 41
+#else
+  { NULL, NULL, NULL }, // 41
+#endif // BUFFER_COMMAND_ENABLE
+  { "+ch", "+ch:", handle_cmd_token_ch_write }, // 42
+  { "cs", "cs", handle_cmd_token_cs }, // 43
+  { "help", "help", handle_cmd_token_help }, // 44
+  { NULL, NULL, NULL }, // 45
+  { "la", "la", handle_cmd_token_la }, // 46
+  { NULL, NULL, NULL }, // 47
+  { "mv", "mv", handle_cmd_token_mv }, // 48
+  { NULL, NULL, NULL }, // 49
+  { "pinval", "pinval", handle_cmd_token_pinval }, // 50
+  { "stack", "stack", handle_cmd_token_stack }, // 51
+  { NULL, NULL, NULL }, // 52
+  { "sn", "sn", handle_cmd_token_sn }, // 53
+  { NULL, NULL, NULL }, // 54
+  { "mlx", "mlx", handle_cmd_token_mlx }, // 55
+  { "pwm", "pwm", handle_cmd_token_pwm }, // 56
+  { NULL, NULL, NULL }, // 57
+  { "is", "is", handle_cmd_token_is }, // 58
+  { "+cs", "+cs:", handle_cmd_token_cs_write }, // 59
+  { "mr", "mr", handle_cmd_token_mr }, // 60
+  { NULL, NULL, NULL }, // 61
+  { NULL, NULL, NULL }, // 62
+  { NULL, NULL, NULL }, // 63
+};
+
+
+uint8_t
+i2c_stick_cmd_hash(const char *token, uint8_t len)
+{ // FNV-1a with a seed found by dodo.py such that no two tokens collide.
+  uint32_t h = I2C_STICK_CMD_HASH_SEED;
+  for (uint8_t i=0; i<len; i++)
+  {
+    h ^= (uint8_t)(token[i]);
+    h *= 16777619UL;
+  }
+  h ^= h >> 16;
+  return h & (I2C_STICK_CMD_TABLE_SIZE - 1);
+}
+
+
+const i2c_stick_cmd_t *
+i2c_stick_cmd_lookup(const char *cmd)
+{
+  uint8_t len = 0;
+  while ((cmd[len] != '\0') && (cmd[len] != ':') && (len < 255)) len++;
+
+  const i2c_stick_cmd_t *entry = &g_cmd_table[i2c_stick_cmd_hash(cmd, len)];
+  if (entry->token_ == NULL) return NULL;
+  if (strncmp(entry->token_, cmd, len) || (entry->token_[len] != '\0')) return NULL;
+  if (strncmp(entry->match_, cmd, strlen(entry->match_))) return NULL;
+  return entry;
+}
+
+
+void
+i2c_stick_cmd_help(uint8_t channel_mask)
+{
+  send_answer_chunk(channel_mask, "- mlx  ==>  test uplink communication", 1);
+  send_answer_chunk(channel_mask, "- help ==>  this help!", 1);
+  send_answer_chunk(channel_mask, "- sos  ==>  more detailed help!", 1);
+  send_answer_chunk(channel_mask, "- fv   ==>  Firmware Version", 1);
+  send_answer_chunk(channel_mask, "- bi   ==>  Board Info", 1);
+  send_answer_chunk(channel_mask, "- mem  ==>  Memory usage (handle pools, scratch arena, heap, stack)", 1);
+  send_answer_chunk(channel_mask, "- stack ==>  Stack depth; 'stack:reset' restarts the peak measurement", 1);
+  send_answer_chunk(channel_mask, "- scan ==>  SCAN I2C bus for slaves", 1);
+  send_answer_chunk(channel_mask, "- ls   ==>  List Slaves (already discovered with 'scan')", 1);
+  send_answer_chunk(channel_mask, "- dis  ==>  DIsable Slave (for continuous dump mode)", 1);
+  send_answer_chunk(channel_mask, "- i2c  ==>  low level I2C", 1);
+  send_answer_chunk(channel_mask, "- ch   ==>  Configuration of Host (I2C freq, output format)", 1);
+#ifdef BUFFER_COMMAND_ENABLE
+  send_answer_chunk(channel_mask, "- buf  ==>  buffer command", 1);
+#endif // BUFFER_COMMAND_ENABLE
+  send_answer_chunk(channel_mask, "", 1);
+  send_answer_chunk(channel_mask, "- as   ==>  Active Slave", 1);
+  send_answer_chunk(channel_mask, "- mv   ==>  Measure Value of the sensor", 1);
+  send_answer_chunk(channel_mask, "- sn   ==>  Serial Number of slave", 1);
+  send_answer_chunk(channel_mask, "- cs   ==>  Configuration of Slave", 1);
+  send_answer_chunk(channel_mask, "- nd   ==>  New Data available", 1);
+  send_answer_chunk(channel_mask, "- mr   ==>  Memory Read", 1);
+  send_answer_chunk(channel_mask, "- mw   ==>  Memory Write", 1);
+  send_answer_chunk(channel_mask, "- raw  ==>  RAW sensor data dump", 1);
+  send_answer_chunk(channel_mask, "", 1);
+  send_answer_chunk(channel_mask, "- la   ==>  List Applications", 1);
+  send_answer_chunk(channel_mask, "- app  ==>  APPlication id", 1);
+  send_answer_chunk(channel_mask, "- ca   ==>  Configuration of Application", 1);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+// this file is automatically generated:
+// please edit 'context.yaml', and then:
+// run the python doit script `python dodo.py generate` or `doit generate`.
+
+#ifndef __I2C_STICK_CMD_TABLE_H__
+#define __I2C_STICK_CMD_TABLE_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the command table is a perfect hash table on the command token (the
+// characters before the first ':'); see 'commands' in context.yaml.
+#define I2C_STICK_CMD_HASH_SEED 14078UL
+#define I2C_STICK_CMD_TABLE_SIZE 64
+
+typedef const char *(*i2c_stick_cmd_handler_t)(uint8_t channel_mask, const char *cmd, const char *this_cmd);
+
+typedef struct
+{
+  const char *token_;
+  const char *match_;
+  i2c_stick_cmd_handler_t handler_;
+} i2c_stick_cmd_t;
+
+// command handlers, implemented in i2c_stick_cmd.cpp:
+const char *handle_cmd_token_mlx(uint8_t channel_mask, const char *cmd, const char *this_cmd); // mlx
+const char *handle_cmd_token_help(uint8_t channel_mask, const char *cmd, const char *this_cmd); // help
+const char *handle_cmd_token_sos(uint8_t channel_mask, const char *cmd, const char *this_cmd); // sos
+const char *handle_cmd_token_fv(uint8_t channel_mask, const char *cmd, const char *this_cmd); // fv
+const char *handle_cmd_token_bi(uint8_t channel_mask, const char *cmd, const char *this_cmd); // bi
+const char *handle_cmd_token_mem(uint8_t channel_mask, const char *cmd, const char *this_cmd); // mem
+const char *handle_cmd_token_stack(uint8_t channel_mask, const char *cmd, const char *this_cmd); // stack
+const char *handle_cmd_token_scan(uint8_t channel_mask, const char *cmd, const char *this_cmd); // scan
+const char *handle_cmd_token_ls(uint8_t channel_mask, const char *cmd, const char *this_cmd); // ls
+const char *handle_cmd_token_dis(uint8_t channel_mask, const char *cmd, const char *this_cmd); // dis
+const char *handle_cmd_token_i2c(uint8_t channel_mask, const char *cmd, const char *this_cmd); // i2c:
+const char *handle_cmd_token_ch(uint8_t channel_mask, const char *cmd, const char *this_cmd); // ch
+const char *handle_cmd_token_ch_write(uint8_t channel_mask, const char *cmd, const char *this_cmd); // +ch:
+#ifdef BUFFER_COMMAND_ENABLE
+const char *handle_cmd_token_buf(uint8_t channel_mask, const char *cmd, const char *this_cmd); // buf
+#endif // BUFFER_COMMAND_ENABLE
+const char *handle_cmd_token_as(uint8_t channel_mask, const char *cmd, const char *this_cmd); // as
+const char *handle_cmd_token_mv(uint8_t channel_mask, const char *cmd, const char *this_cmd); // mv
+const char *handle_cmd_token_sn(uint8_t channel_mask, const char *cmd, const char *this_cmd); // sn
+const char *handle_cmd_token_cs(uint8_t channel_mask, const char *cmd, const char *this_cmd); // cs
+const char *handle_cmd_token_cs_write(uint8_t channel_mask, const char *cmd, const char *this_cmd); // +cs:
+const char *handle_cmd_token_nd(uint8_t channel_mask, const char *cmd, const char *this_cmd); // nd
+const char *handle_cmd_token_mr(uint8_t channel_mask, const char *cmd, const char *this_cmd); // mr
+const char *handle_cmd_token_mw(uint8_t channel_mask, const char *cmd, const char *this_cmd); // mw
+const char *handle_cmd_token_raw(uint8_t channel_mask, const char *cmd, const char *this_cmd); // raw
+const char *handle_cmd_token_is(uint8_t channel_mask, const char *cmd, const char *this_cmd); // is
+const char *handle_cmd_token_pwm(uint8_t channel_mask, const char *cmd, const char *this_cmd); // pwm
+const char *handle_cmd_token_pinval(uint8_t channel_mask, const char *cmd, const char *this_cmd); // pinval
+const char *handle_cmd_token_la(uint8_t channel_mask, const char *cmd, const char *this_cmd); // la
+const char *handle_cmd_token_app(uint8_t channel_mask, const char *cmd, const char *this_cmd); // app
+const char *handle_cmd_token_app_write(uint8_t channel_mask, const char *cmd, const char *this_cmd); // +app:
+const char *handle_cmd_token_ca(uint8_t channel_mask, const char *cmd, const char *this_cmd); // ca
+const char *handle_cmd_token_ca_write(uint8_t channel_mask, const char *cmd, const char *this_cmd); // +ca:
+
+uint8_t i2c_stick_cmd_hash(const char *token, uint8_t len);
+
+const i2c_stick_cmd_t *i2c_stick_cmd_lookup(const char *cmd);
+
+void i2c_stick_cmd_help(uint8_t channel_mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_CMD_TABLE_H__
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "i2c_stick_delta.h"
+
+#include <string.h>
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DELTA_MERGE_GAP 1 // unchanged values between two runs that are sent along
+
+static delta_slave_t g_delta_slave_list[DELTA_MAX_SLAVES];
+static float g_delta_arena[DELTA_ARENA_VALUES]; // the reference lists, packed in order of allocation
+static uint16_t g_delta_arena_used;
+static delta_run_t g_delta_run_list[DELTA_MAX_RUNS];
+static float g_delta_deadband = -1.0f;
+static uint8_t g_delta_keyframe_interval = DELTA_KEYFRAME_INTERVAL;
+
+
+void
+i2c_stick_delta_set_deadband(float deadband)
+{
+  g_delta_deadband = (deadband < 0.0f) ? -1.0f : deadband;
+  i2c_stick_delta_reset();
+}
+
+
+float
+i2c_stick_delta_get_deadband()
+{
+  return g_delta_deadband;
+}
+
+
+void
+i2c_stick_delta_set_keyframe_interval(uint8_t interval)
+{
+  g_delta_keyframe_interval = interval;
+}
+
+
+uint8_t
+i2c_stick_delta_get_keyframe_interval()
+{
+  return g_delta_keyframe_interval;
+}
+
+
+void
+i2c_stick_delta_reset()
+{
+  for (uint8_t i=0; i<DELTA_MAX_SLAVES; i++)
+  {
+    g_delta_slave_list[i].sa_ = 0;
+    g_delta_slave_list[i].count_ = 0;
+    g_delta_slave_list[i].value_ = NULL;
+  }
+  g_delta_arena_used = 0;
+}
+
+
+static void
+delta_values_free(delta_slave_t *slave)
+{ // give the values of slave back; the lists behind it move down to keep the arena packed.
+  if (slave->value_ == NULL)
+  {
+    return;
+  }
+  float *end = slave->value_ + slave->count_;
+  memmove(slave->value_, end, (g_delta_arena + g_delta_arena_used - end) * sizeof(float));
+  for (uint8_t i=0; i<DELTA_MAX_SLAVES; i++)
+  {
+    delta_slave_t *other = &g_delta_slave_list[i];
+    if ((other->value_ != NULL) && (other->value_ > slave->value_))
+    {
+      other->value_ -= slave->count_;
+    }
+  }
+  g_delta_arena_used -= slave->count_;
+  slave->value_ = NULL;
+  slave->count_ = 0;
+}
+
+
+static void
+delta_slave_free(delta_slave_t *slave)
+{
+  delta_values_free(slave);
+  slave->sa_ = 0;
+}
+
+
+static delta_slave_t *
+delta_find_slave(uint8_t sa)
+{ // the slot of sa, or a new one, or NULL when all are taken.
+  delta_slave_t *free_slave = NULL;
+  for (uint8_t i=0; i<DELTA_MAX_SLAVES; i++)
+  {
+    delta_slave_t *slave = &g_delta_slave_list[i];
+    if (slave->sa_ == sa)
+    {
+      return slave;
+    }
+    if ((slave->sa_ == 0) && (free_slave == NULL))
+    {
+      free_slave = slave;
+    }
+  }
+  if (free_slave != NULL)
+  {
+    free_slave->sa_ = sa;
+    free_slave->count_ = 0;
+    free_slave->value_ = NULL;
+  }
+  return free_slave;
+}
+
+
+static uint8_t
+delta_differs(float a, float b, float deadband)
+{
+  if ((a != a) || (b != b))
+  { // NAN: only a change when one of both is valid
+    return (a != a) != (b != b);
+  }
+  return fabsf(a - b) > deadband;
+}
+
+
+static int16_t
+delta_keyframe(delta_slave_t *slave, const float *mv_list, uint16_t mv_count)
+{
+  if (slave->count_ != mv_count)
+  { // (re-)size the reference at the end of the arena
+    delta_values_free(slave);
+    if (mv_count > DELTA_ARENA_VALUES - g_delta_arena_used)
+    { // no room; this slave gets full lists.
+      delta_slave_free(slave);
+      return -1;
+    }
+    slave->value_ = g_delta_arena + g_delta_arena_used;
+    g_delta_arena_used += mv_count;
+  }
+  memcpy(slave->value_, mv_list, mv_count * sizeof(float));
+  slave->count_ = mv_count;
+  slave->frames_since_key_ = 0;
+  return -1;
+}
+
+
+int16_t
+i2c_stick_delta_update(uint8_t sa, const float *mv_list, uint16_t mv_count, const char *error_message, const delta_run_t **run_list)
+{
+  *run_list = g_delta_run_list;
+  if (g_delta_deadband < 0.0f)
+  {
+    return -1;
+  }
+  delta_slave_t *slave = delta_find_slave(sa);
+  if (slave == NULL)
+  {
+    return -1;
+  }
+  if ((error_message != NULL) || (mv_count == 0))
+  { // the host drops its reference at an error.
+    delta_slave_free(slave);
+    return -1;
+  }
+  if ((slave->count_ != mv_count) ||
+      ((g_delta_keyframe_interval > 0) && (slave->frames_since_key_ + 1 >= g_delta_keyframe_interval)))
+  {
+    return delta_keyframe(slave, mv_list, mv_count);
+  }
+
+  uint16_t run_count = 0;
+  uint16_t value_count = 0;
+  for (uint16_t i=0; i<mv_count; i++)
+  {
+    if (!delta_differs(mv_list[i], slave->value_[i], g_delta_deadband))
+    {
+      continue;
+    }
+    if (run_count > 0)
+    {
+      delta_run_t *run = &g_delta_run_list[run_count - 1];
+      uint16_t end = run->first_ + run->count_;
+      if (i - end <= DELTA_MERGE_GAP)
+      {
+        value_count += i + 1 - end;
+        run->count_ = i + 1 - run->first_;
+        continue;
+      }
+    }
+    if (run_count >= DELTA_MAX_RUNS)
+    {
+      return delta_keyframe(slave, mv_list, mv_count);
+    }
+    delta_run_t *run = &g_delta_run_list[run_count++];
+    run->first_ = i;
+    run->count_ = 1;
+    value_count++;
+  }
+  // payload size in 16-bit words: count + (first, n) per run + 2 per float.
+  if ((1 + 2 * (uint32_t)run_count + 2 * (uint32_t)value_count) >= 2 * (uint32_t)mv_count)
+  {
+    return delta_keyframe(slave, mv_list, mv_count);
+  }
+
+  for (uint16_t r=0; r<run_count; r++)
+  {
+    const delta_run_t *run = &g_delta_run_list[r];
+    memcpy(&slave->value_[run->first_], &mv_list[run->first_], run->count_ * sizeof(float));
+  }
+  if (slave->frames_since_key_ < 255)
+  {
+    slave->frames_since_key_++;
+  }
+  return run_count;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
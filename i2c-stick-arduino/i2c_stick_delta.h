@@ -0,0 +1,69 @@
+#ifndef __I2C_STICK_DELTA_H__
+#define __I2C_STICK_DELTA_H__
+
+#include <stdint.h>
+#include "i2c_stick_fw_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Change-only streaming
+// *********************
+//
+// Enabled with `+ch:DELTA=<dead-band degC>` (`+ch:DELTA=OFF` to disable);
+// only for the DEC and FRAME formats. In continuous mode the last
+// transmitted 'mv' list is kept per slave, and a new list is sent as the
+// runs of values which moved more than the dead-band away from it:
+//
+//   DEC:   @SA:DRV:mvd:SA:TIME:COUNT:first=v,v,..;first=v,..
+//   FRAME: FRAME_TYPE_MV_DELTA, payload: uint16_t count, then per run
+//          uint16_t first, uint16_t n, float32[n]
+//
+// COUNT is the length of the full list. The host patches its copy of the
+// last list; an unchanged list gives a delta without runs. A full 'mv'
+// answer (keyframe) is sent on the first frame, every KEYFRAME frames
+// (`+ch:KEYFRAME=<n>`), when the list length changes, after an error, and
+// when a delta would not be smaller than the full list.
+// Small gaps between changed values are sent along to save a run header.
+//
+// The reference lists share one arena of DELTA_ARENA_VALUES floats; a slave
+// takes as many as its list holds, so a few short lists do not cost a full
+// frame each. A slave for which the arena has no room keeps getting full
+// lists.
+
+struct delta_run_t
+{
+  uint16_t first_; // index in the mv list
+  uint16_t count_;
+};
+
+struct delta_slave_t
+{
+  uint8_t sa_; // 0 => free
+  uint8_t frames_since_key_;
+  uint16_t count_;
+  float *value_; // as last transmitted; count_ values in the delta arena
+};
+
+
+// dead-band in degC; < 0 => OFF
+void i2c_stick_delta_set_deadband(float deadband);
+float i2c_stick_delta_get_deadband();
+void i2c_stick_delta_set_keyframe_interval(uint8_t interval);
+uint8_t i2c_stick_delta_get_keyframe_interval();
+
+// forget all reference frames; the next frame of every slave is a keyframe.
+void i2c_stick_delta_reset();
+
+// compare a new mv list with the last transmitted one of slave 'sa', and
+// update the reference with what will be sent.
+// returns -1 => send the full list (keyframe, error or delta OFF);
+// otherwise the number of runs in *run_list (valid until the next call).
+int16_t i2c_stick_delta_update(uint8_t sa, const float *mv_list, uint16_t mv_count, const char *error_message, const delta_run_t **run_list);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_DELTA_H__
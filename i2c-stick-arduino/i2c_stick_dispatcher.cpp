@@ -22,16 +22,150 @@
 #include <stdlib.h>
 
 
+// driver operations tables, indexed by driver id.
+static const i2c_stick_drv_ops_t g_drv_ops_90394 =
+{
+  DRV_MLX90394_ID,
+  cmd_90394_register_driver,
+  cmd_90394_init,
+  cmd_90394_mv,
+  cmd_90394_raw,
+  cmd_90394_nd,
+  cmd_90394_rp,
+  cmd_90394_sn,
+  cmd_90394_cs,
+  cmd_90394_cs_write,
+  cmd_90394_mr,
+  cmd_90394_mw,
+  cmd_90394_is,
+  cmd_90394_tear_down,
+};
+static const i2c_stick_drv_ops_t g_drv_ops_90614 =
+{
+  DRV_MLX90614_ID,
+  cmd_90614_register_driver,
+  cmd_90614_init,
+  cmd_90614_mv,
+  cmd_90614_raw,
+  cmd_90614_nd,
+  cmd_90614_rp,
+  cmd_90614_sn,
+  cmd_90614_cs,
+  cmd_90614_cs_write,
+  cmd_90614_mr,
+  cmd_90614_mw,
+  cmd_90614_is,
+  cmd_90614_tear_down,
+};
+static const i2c_stick_drv_ops_t g_drv_ops_90632 =
+{
+  DRV_MLX90632_ID,
+  cmd_90632_register_driver,
+  cmd_90632_init,
+  cmd_90632_mv,
+  cmd_90632_raw,
+  cmd_90632_nd,
+  cmd_90632_rp,
+  cmd_90632_sn,
+  cmd_90632_cs,
+  cmd_90632_cs_write,
+  cmd_90632_mr,
+  cmd_90632_mw,
+  cmd_90632_is,
+  cmd_90632_tear_down,
+};
+static const i2c_stick_drv_ops_t g_drv_ops_90640 =
+{
+  DRV_MLX90640_ID,
+  cmd_90640_register_driver,
+  cmd_90640_init,
+  cmd_90640_mv,
+  cmd_90640_raw,
+  cmd_90640_nd,
+  cmd_90640_rp,
+  cmd_90640_sn,
+  cmd_90640_cs,
+  cmd_90640_cs_write,
+  cmd_90640_mr,
+  cmd_90640_mw,
+  cmd_90640_is,
+  cmd_90640_tear_down,
+};
+static const i2c_stick_drv_ops_t g_drv_ops_90641 =
+{
+  DRV_MLX90641_ID,
+  cmd_90641_register_driver,
+  cmd_90641_init,
+  cmd_90641_mv,
+  cmd_90641_raw,
+  cmd_90641_nd,
+  cmd_90641_rp,
+  cmd_90641_sn,
+  cmd_90641_cs,
+  cmd_90641_cs_write,
+  cmd_90641_mr,
+  cmd_90641_mw,
+  cmd_90641_is,
+  cmd_90641_tear_down,
+};
+static const i2c_stick_drv_ops_t g_drv_ops_90642 =
+{
+  DRV_MLX90642_ID,
+  cmd_90642_register_driver,
+  cmd_90642_init,
+  cmd_90642_mv,
+  cmd_90642_raw,
+  cmd_90642_nd,
+  cmd_90642_rp,
+  cmd_90642_sn,
+  cmd_90642_cs,
+  cmd_90642_cs_write,
+  cmd_90642_mr,
+  cmd_90642_mw,
+  cmd_90642_is,
+  cmd_90642_tear_down,
+};
+
+static const i2c_stick_drv_ops_t *g_drv_ops[] =
+{
+  NULL,
+  &g_drv_ops_90394,
+  &g_drv_ops_90614,
+  &g_drv_ops_90632,
+  &g_drv_ops_90640,
+  &g_drv_ops_90641,
+  &g_drv_ops_90642,
+};
+
+#define DRV_OPS_COUNT (sizeof(g_drv_ops) / sizeof(g_drv_ops[0]))
+
+const i2c_stick_drv_ops_t *g_sa_ops[128];
+
+
+const i2c_stick_drv_ops_t *
+i2c_stick_get_drv_ops(uint8_t drv)
+{
+  if (drv >= DRV_OPS_COUNT) return NULL;
+  return g_drv_ops[drv];
+}
+
+
+void
+i2c_stick_update_sa_ops(uint8_t sa)
+{ // call whenever g_sa_list[sa].spot_ or the driver registered at that spot changes.
+  if (sa > 127) return;
+  g_sa_ops[sa] = i2c_stick_get_drv_ops(g_sa_drv_register[g_sa_list[sa].spot_].drv_);
+}
+
+
 int16_t 
 i2c_stick_register_all_drivers()
 {
   int16_t result = 1;
-  if (cmd_90394_register_driver() < 0) result = -1;
-  if (cmd_90614_register_driver() < 0) result = -1;
-  if (cmd_90632_register_driver() < 0) result = -1;
-  if (cmd_90640_register_driver() < 0) result = -1;
-  if (cmd_90641_register_driver() < 0) result = -1;
-  if (cmd_90642_register_driver() < 0) result = -1;
+  for (uint8_t drv = 1; drv < DRV_OPS_COUNT; drv++)
+  {
+    if (g_drv_ops[drv]->register_driver_() < 0) result = -1;
+  }
   return result;
 }
 
@@ -106,33 +240,11 @@ cmd_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_messag
   // sanity check
   if (sa > 127) { return 0; }
 
-  uint16_t spot = g_sa_list[sa].spot_;
-  uint8_t drv = g_sa_drv_register[spot].drv_;
+  const i2c_stick_drv_ops_t *ops = g_sa_ops[sa];
+  if (ops == NULL) { return 0; }
 
-  switch(drv)
-  {
-    case DRV_MLX90394_ID:
-      cmd_90394_mv(sa, mv_list, mv_count, error_message);
-      break;
-    case DRV_MLX90614_ID:
-      cmd_90614_mv(sa, mv_list, mv_count, error_message);
-      break;
-    case DRV_MLX90632_ID:
-      cmd_90632_mv(sa, mv_list, mv_count, error_message);
-      break;
-    case DRV_MLX90640_ID:
-      cmd_90640_mv(sa, mv_list, mv_count, error_message);
-      break;
-    case DRV_MLX90641_ID:
-      cmd_90641_mv(sa, mv_list, mv_count, error_message);
-      break;
-    case DRV_MLX90642_ID:
-      cmd_90642_mv(sa, mv_list, mv_count, error_message);
-      break;
-    default:
-      return 0;
-  }
-  return drv;
+  ops->mv_(sa, mv_list, mv_count, error_message);
+  return ops->drv_;
 }
 
 
@@ -142,33 +254,11 @@ cmd_raw(uint8_t sa, uint16_t *raw_list, uint16_t *raw_count, char const **error_
   // sanity check
   if (sa > 127) { return 0; }
 
-  uint16_t spot = g_sa_list[sa].spot_;
-  uint8_t drv = g_sa_drv_register[spot].drv_;
+  const i2c_stick_drv_ops_t *ops = g_sa_ops[sa];
+  if (ops == NULL) { return 0; }
 
-  switch(drv)
-  {
-    case DRV_MLX90394_ID:
-      cmd_90394_raw(sa, raw_list, raw_count, error_message);
-      break;
-    case DRV_MLX90614_ID:
-      cmd_90614_raw(sa, raw_list, raw_count, error_message);
-      break;
-    case DRV_MLX90632_ID:
-      cmd_90632_raw(sa, raw_list, raw_count, error_message);
-      break;
-    case DRV_MLX90640_ID:
-      cmd_90640_raw(sa, raw_list, raw_count, error_message);
-      break;
-    case DRV_MLX90641_ID:
-      cmd_90641_raw(sa, raw_list, raw_count, error_message);
-      break;
-    case DRV_MLX90642_ID:
-      cmd_90642_raw(sa, raw_list, raw_count, error_message);
-      break;
-    default:
-      return 0;
-  }
-  return drv;
+  ops->raw_(sa, raw_list, raw_count, error_message);
+  return ops->drv_;
 }
 
 
@@ -178,70 +268,43 @@ cmd_nd(uint8_t sa, uint8_t *nd, char const **error_message)
   // sanity check
   if (sa > 127) { return 0; }
 
-  uint16_t spot = g_sa_list[sa].spot_;
-  uint8_t drv = g_sa_drv_register[spot].drv_;
+  const i2c_stick_drv_ops_t *ops = g_sa_ops[sa];
+  if (ops == NULL) { return 0; }
 
-  switch(drv)
-  {
-    case DRV_MLX90394_ID:
-      cmd_90394_nd(sa, nd, error_message);
-      break;
-    case DRV_MLX90614_ID:
-      cmd_90614_nd(sa, nd, error_message);
-      break;
-    case DRV_MLX90632_ID:
-      cmd_90632_nd(sa, nd, error_message);
-      break;
-    case DRV_MLX90640_ID:
-      cmd_90640_nd(sa, nd, error_message);
-      break;
-    case DRV_MLX90641_ID:
-      cmd_90641_nd(sa, nd, error_message);
-      break;
-    case DRV_MLX90642_ID:
-      cmd_90642_nd(sa, nd, error_message);
-      break;
-    default:
-      return 0;
-  }
-  return drv;
+  ops->nd_(sa, nd, error_message);
+  return ops->drv_;
 }
 
 
 uint8_t
-cmd_sn(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message)
+cmd_rp(uint8_t sa, uint32_t *period_ms, char const **error_message)
 {
   // sanity check
   if (sa > 127) { return 0; }
 
-  uint16_t spot = g_sa_list[sa].spot_;
-  uint8_t drv = g_sa_drv_register[spot].drv_;
+  const i2c_stick_drv_ops_t *ops = g_sa_ops[sa];
+  if (ops == NULL) { return 0; }
 
-  switch(drv)
+  ops->rp_(sa, period_ms, error_message);
+  return ops->drv_;
+}
+
+
+uint8_t
+cmd_sn(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message)
+{
+  // sanity check
+  if (sa > 127) { return 0; }
+
+  const i2c_stick_drv_ops_t *ops = g_sa_ops[sa];
+  if (ops == NULL)
   {
-    case DRV_MLX90394_ID:
-      cmd_90394_sn(sa, sn_list, sn_count, error_message);
-      break;
-    case DRV_MLX90614_ID:
-      cmd_90614_sn(sa, sn_list, sn_count, error_message);
-      break;
-    case DRV_MLX90632_ID:
-      cmd_90632_sn(sa, sn_list, sn_count, error_message);
-      break;
-    case DRV_MLX90640_ID:
-      cmd_90640_sn(sa, sn_list, sn_count, error_message);
-      break;
-    case DRV_MLX90641_ID:
-      cmd_90641_sn(sa, sn_list, sn_count, error_message);
-      break;
-    case DRV_MLX90642_ID:
-      cmd_90642_sn(sa, sn_list, sn_count, error_message);
-      break;
-    default:
-      *sn_count = 0;
-      return 0;
+    *sn_count = 0;
+    return 0;
   }
-  return drv;
+
+  ops->sn_(sa, sn_list, sn_count, error_message);
+  return ops->drv_;
 }
 
 
@@ -252,7 +315,6 @@ cmd_cs(uint8_t sa, uint8_t channel_mask, const char *input)
   if (sa > 127) { return 0; }
 
   uint16_t spot = g_sa_list[sa].spot_;
-  uint8_t drv = g_sa_drv_register[spot].drv_;
   uint8_t raw = g_sa_drv_register[spot].raw_;
 
   char buf[16]; memset(buf, 0, sizeof(buf));
@@ -264,30 +326,11 @@ cmd_cs(uint8_t sa, uint8_t channel_mask, const char *input)
   itoa(raw, buf, 10);
   send_answer_chunk(channel_mask, buf, 1);
 
-  switch(drv)
-  {
-    case DRV_MLX90394_ID:
-      cmd_90394_cs(sa, channel_mask, input);
-      break;
-    case DRV_MLX90614_ID:
-      cmd_90614_cs(sa, channel_mask, input);
-      break;
-    case DRV_MLX90632_ID:
-      cmd_90632_cs(sa, channel_mask, input);
-      break;
-    case DRV_MLX90640_ID:
-      cmd_90640_cs(sa, channel_mask, input);
-      break;
-    case DRV_MLX90641_ID:
-      cmd_90641_cs(sa, channel_mask, input);
-      break;
-    case DRV_MLX90642_ID:
-      cmd_90642_cs(sa, channel_mask, input);
-      break;
-    default:
-      return 0;
-  }
-  return drv;
+  const i2c_stick_drv_ops_t *ops = g_sa_ops[sa];
+  if (ops == NULL) { return 0; }
+
+  ops->cs_(sa, channel_mask, input);
+  return ops->drv_;
 }
 
 
@@ -333,30 +376,11 @@ cmd_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
     return drv;
   }
 
-  switch(drv)
-  {
-    case DRV_MLX90394_ID:
-      cmd_90394_cs_write(sa, channel_mask, input);
-      break;
-    case DRV_MLX90614_ID:
-      cmd_90614_cs_write(sa, channel_mask, input);
-      break;
-    case DRV_MLX90632_ID:
-      cmd_90632_cs_write(sa, channel_mask, input);
-      break;
-    case DRV_MLX90640_ID:
-      cmd_90640_cs_write(sa, channel_mask, input);
-      break;
-    case DRV_MLX90641_ID:
-      cmd_90641_cs_write(sa, channel_mask, input);
-      break;
-    case DRV_MLX90642_ID:
-      cmd_90642_cs_write(sa, channel_mask, input);
-      break;
-    default:
-      return 0;
-  }
-  return drv;
+  const i2c_stick_drv_ops_t *ops = g_sa_ops[sa];
+  if (ops == NULL) { return 0; }
+
+  ops->cs_write_(sa, channel_mask, input);
+  return ops->drv_;
 }
 
 
@@ -366,34 +390,11 @@ cmd_mr(uint8_t sa, uint16_t *mem_list, uint16_t mem_start_address, uint16_t mem_
   // sanity check
   if (sa > 127) { return 0; }
 
-  uint16_t spot = g_sa_list[sa].spot_;
-  uint8_t drv = g_sa_drv_register[spot].drv_;
+  const i2c_stick_drv_ops_t *ops = g_sa_ops[sa];
+  if (ops == NULL) { return 0; }
 
-  switch(drv)
-  {
-    case DRV_MLX90394_ID:
-      cmd_90394_mr(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
-      break;
-    case DRV_MLX90614_ID:
-      cmd_90614_mr(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
-      break;
-    case DRV_MLX90632_ID:
-      cmd_90632_mr(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
-      break;
-    case DRV_MLX90640_ID:
-      cmd_90640_mr(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
-      break;
-    case DRV_MLX90641_ID:
-      cmd_90641_mr(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
-      break;
-    case DRV_MLX90642_ID:
-      cmd_90642_mr(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
-      break;
-    default:
-      return 0;
-  }
-
-  return drv;
+  ops->mr_(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
+  return ops->drv_;
 }
 
 
@@ -403,70 +404,25 @@ cmd_mw(uint8_t sa, uint16_t *mem_list, uint16_t mem_start_address, uint16_t mem_
   // sanity check
   if (sa > 127) { return 0; }
 
-  uint16_t spot = g_sa_list[sa].spot_;
-  uint8_t drv = g_sa_drv_register[spot].drv_;
-
-  switch(drv)
-  {
-    case DRV_MLX90394_ID:
-      cmd_90394_mw(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
-      break;
-    case DRV_MLX90614_ID:
-      cmd_90614_mw(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
-      break;
-    case DRV_MLX90632_ID:
-      cmd_90632_mw(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
-      break;
-    case DRV_MLX90640_ID:
-      cmd_90640_mw(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
-      break;
-    case DRV_MLX90641_ID:
-      cmd_90641_mw(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
-      break;
-    case DRV_MLX90642_ID:
-      cmd_90642_mw(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
-      break;
-    default:
-      return 0;
-  }
+  const i2c_stick_drv_ops_t *ops = g_sa_ops[sa];
+  if (ops == NULL) { return 0; }
 
-  return drv;
+  ops->mw_(sa, mem_list, mem_start_address, mem_count, bit_per_address, address_increments, error_message);
+  return ops->drv_;
 }
 
 
 uint8_t
 cmd_is(uint8_t sa, uint8_t drv, uint8_t *is_ok, char const **error_message)
 {
-  if ((drv <= 0) || (drv > 63))
+  const i2c_stick_drv_ops_t *ops = i2c_stick_get_drv_ops(drv);
+  if (ops == NULL)
   {
     *is_ok = 0;
     return 0;
   }
 
-  switch(drv)
-  {
-    case DRV_MLX90394_ID:
-      cmd_90394_is(sa, is_ok, error_message);
-      break;
-    case DRV_MLX90614_ID:
-      cmd_90614_is(sa, is_ok, error_message);
-      break;
-    case DRV_MLX90632_ID:
-      cmd_90632_is(sa, is_ok, error_message);
-      break;
-    case DRV_MLX90640_ID:
-      cmd_90640_is(sa, is_ok, error_message);
-      break;
-    case DRV_MLX90641_ID:
-      cmd_90641_is(sa, is_ok, error_message);
-      break;
-    case DRV_MLX90642_ID:
-      cmd_90642_is(sa, is_ok, error_message);
-      break;
-    default:
-      return 0;
-  }
-
+  ops->is_(sa, is_ok, error_message);
   return drv;
 }
 
@@ -486,33 +442,11 @@ cmd_tear_down(uint8_t sa)
   // sanity check
   if (sa > 127) { return 0; }
 
-  uint16_t spot = g_sa_list[sa].spot_;
-  uint8_t drv = g_sa_drv_register[spot].drv_;
+  const i2c_stick_drv_ops_t *ops = g_sa_ops[sa];
+  if (ops == NULL) { return 0; }
 
-  switch(drv)
-  {
-    case DRV_MLX90394_ID:
-      cmd_90394_tear_down(sa);
-      break;
-    case DRV_MLX90614_ID:
-      cmd_90614_tear_down(sa);
-      break;
-    case DRV_MLX90632_ID:
-      cmd_90632_tear_down(sa);
-      break;
-    case DRV_MLX90640_ID:
-      cmd_90640_tear_down(sa);
-      break;
-    case DRV_MLX90641_ID:
-      cmd_90641_tear_down(sa);
-      break;
-    case DRV_MLX90642_ID:
-      cmd_90642_tear_down(sa);
-      break;
-    default:
-      return 0;
-  }
-  return drv;
+  ops->tear_down_(sa);
+  return ops->drv_;
 }
 
 
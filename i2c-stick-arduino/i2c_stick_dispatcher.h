@@ -39,9 +39,35 @@ uint8_t i2c_stick_get_app_id(const char *drv_name);
 
 void handle_applications(uint8_t channel_mask);
 
+// driver operations; one constant table per driver, see g_sa_ops for the per slave cache.
+typedef struct
+{
+  uint8_t drv_;
+  int16_t (*register_driver_)();
+  void (*init_)(uint8_t sa);
+  void (*mv_)(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_message);
+  void (*raw_)(uint8_t sa, uint16_t *raw_list, uint16_t *raw_count, char const **error_message);
+  void (*nd_)(uint8_t sa, uint8_t *nd, char const **error_message);
+  void (*rp_)(uint8_t sa, uint32_t *period_ms, char const **error_message);
+  void (*sn_)(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message);
+  void (*cs_)(uint8_t sa, uint8_t channel_mask, const char *input);
+  void (*cs_write_)(uint8_t sa, uint8_t channel_mask, const char *input);
+  void (*mr_)(uint8_t sa, uint16_t *mem_data, uint16_t mem_start_address, uint16_t mem_count, uint8_t *bit_per_address, uint8_t *address_increments, char const **error_message);
+  void (*mw_)(uint8_t sa, uint16_t *mem_data, uint16_t mem_start_address, uint16_t mem_count, uint8_t *bit_per_address, uint8_t *address_increments, char const **error_message);
+  void (*is_)(uint8_t sa, uint8_t *is_ok, char const **error_message);
+  void (*tear_down_)(uint8_t sa);
+} i2c_stick_drv_ops_t;
+
+// driver operations of each slave address; follows g_sa_list[sa].spot_, NULL when no driver.
+extern const i2c_stick_drv_ops_t *g_sa_ops[128];
+
+const i2c_stick_drv_ops_t *i2c_stick_get_drv_ops(uint8_t drv);
+void i2c_stick_update_sa_ops(uint8_t sa);
+
 uint8_t cmd_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_message);
 uint8_t cmd_raw(uint8_t sa, uint16_t *raw_list, uint16_t *raw_count, char const **error_message);
 uint8_t cmd_nd(uint8_t sa, uint8_t *nd, char const **error_message);
+uint8_t cmd_rp(uint8_t sa, uint32_t *period_ms, char const **error_message);
 uint8_t cmd_sn(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message);
 uint8_t cmd_cs(uint8_t sa, uint8_t channel_mask, const char *input);
 uint8_t cmd_cs_write(uint8_t sa, uint8_t channel_mask, const char *input);
@@ -0,0 +1,153 @@
+#ifndef __I2C_STICK_FAST_MATH_H__
+#define __I2C_STICK_FAST_MATH_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Single precision fourth root
+// ****************************
+//
+// The thermal To formula needs x^(1/4) three times per pixel; sqrt(sqrt(x))
+// is software emulated on MCU's without FPU (Cortex-M0+).
+//
+// fast_root4f computes the inverse fourth root z = x^(-1/4) from an
+// exponent-quartering initial guess followed by 3 Newton steps
+// (z <- z * (5 - x*z^4) / 4; multiplications only), and returns x * z^3.
+//
+// Error bound: relative error < 7e-7 for all positive normal x, and < 5.5e-7
+// i.e. less than 0.0003 K for object temperatures between -40 and 300 degC
+// (well below the 1/32 degC output resolution); see test/fast_math_test.cpp.
+// x <= 0 returns 0 (x == 0) or NAN, just like sqrt(sqrt(x)).
+
+#define FAST_ROOT4_MAGIC 0x4F578000UL
+
+static inline float
+fast_root4f(float x)
+{
+  if (!(x > 0.0f))
+  {
+    return (x == 0.0f) ? 0.0f : NAN;
+  }
+  uint32_t i;
+  float z;
+  memcpy(&i, &x, sizeof(i));
+  i = FAST_ROOT4_MAGIC - (i >> 2);
+  memcpy(&z, &i, sizeof(z));
+
+  float z2 = z * z;
+  z = z * (1.25f - 0.25f * x * z2 * z2);
+  z2 = z * z;
+  z = z * (1.25f - 0.25f * x * z2 * z2);
+  z2 = z * z;
+  z = z * (1.25f - 0.25f * x * z2 * z2);
+  return x * z * z * z;
+}
+
+
+// Median networks
+// ***************
+//
+// Fixed compare/exchange networks; same result as sorting the values and
+// taking the middle element (odd count) or the average of the 2 middle
+// elements (even count).
+
+static inline float
+median3f(float a, float b, float c)
+{
+  float lo = (a < b) ? a : b;
+  float hi = (a < b) ? b : a;
+  hi = (hi < c) ? hi : c;
+  return (lo < hi) ? hi : lo;
+}
+
+
+static inline float
+median4f(float a, float b, float c, float d)
+{ // the 2 middle elements are max(min(a,b),min(c,d)) and min(max(a,b),max(c,d))
+  float lo_ab = (a < b) ? a : b;
+  float hi_ab = (a < b) ? b : a;
+  float lo_cd = (c < d) ? c : d;
+  float hi_cd = (c < d) ? d : c;
+  float x2 = (lo_ab < lo_cd) ? lo_cd : lo_ab;
+  float x3 = (hi_ab < hi_cd) ? hi_ab : hi_cd;
+  return (x2 + x3)/2.0;
+}
+
+
+static inline float
+median6f_self2(float s, float a, float b, float c, float d)
+{ // median of {a, b, c, d, s, s}: sort a..d, then clamp s into the middle.
+  float t;
+  if (b < a) { t = a; a = b; b = t; }
+  if (d < c) { t = c; c = d; d = t; }
+  if (c < a) { t = a; a = c; c = t; }
+  if (d < b) { t = b; b = d; d = t; }
+  if (c < b) { t = b; b = c; c = t; }
+  float x3 = (s < a) ? a : s;
+  x3 = (x3 < c) ? x3 : c;
+  float x4 = (s < b) ? b : s;
+  x4 = (x4 < d) ? x4 : d;
+  return (x3 + x4)/2.0;
+}
+
+
+// int16 variants (fixed point pixel storage); same networks as above, the
+// even count average rounds half away from zero.
+
+static inline int16_t
+median3s(int16_t a, int16_t b, int16_t c)
+{
+  int16_t lo = (a < b) ? a : b;
+  int16_t hi = (a < b) ? b : a;
+  hi = (hi < c) ? hi : c;
+  return (lo < hi) ? hi : lo;
+}
+
+
+static inline int16_t
+average2s(int16_t a, int16_t b)
+{
+  int32_t sum = (int32_t)a + b;
+  return (int16_t)((sum >= 0) ? ((sum + 1) / 2) : ((sum - 1) / 2));
+}
+
+
+static inline int16_t
+median4s(int16_t a, int16_t b, int16_t c, int16_t d)
+{
+  int16_t lo_ab = (a < b) ? a : b;
+  int16_t hi_ab = (a < b) ? b : a;
+  int16_t lo_cd = (c < d) ? c : d;
+  int16_t hi_cd = (c < d) ? d : c;
+  int16_t x2 = (lo_ab < lo_cd) ? lo_cd : lo_ab;
+  int16_t x3 = (hi_ab < hi_cd) ? hi_ab : hi_cd;
+  return average2s(x2, x3);
+}
+
+
+static inline int16_t
+median6s_self2(int16_t s, int16_t a, int16_t b, int16_t c, int16_t d)
+{
+  int16_t t;
+  if (b < a) { t = a; a = b; b = t; }
+  if (d < c) { t = c; c = d; d = t; }
+  if (c < a) { t = a; a = c; c = t; }
+  if (d < b) { t = b; b = d; d = t; }
+  if (c < b) { t = b; b = c; c = t; }
+  int16_t x3 = (s < a) ? a : s;
+  x3 = (x3 < c) ? x3 : c;
+  int16_t x4 = (s < b) ? b : s;
+  x4 = (x4 < d) ? x4 : d;
+  return average2s(x3, x4);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_FAST_MATH_H__
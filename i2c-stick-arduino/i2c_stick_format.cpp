@@ -0,0 +1,289 @@
+#include "i2c_stick_format.h"
+
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// https://github.com/pmalasp/dtostrf/blob/master/dtostrf.c
+char *my_dtostrf( float val,  int8_t char_num, uint8_t precision, char *chr_buffer)
+{
+  int       right_j;
+  int       i, j ;
+  float     r_val;
+  long      i_val;
+  char      c_sign;
+
+
+  // check the sign
+  if (val < 0.0) {
+    // print the - sign
+    c_sign = '-';
+
+    // process the absolute value
+    val = - val;
+  } else {
+    // put a space for positive numbers
+    c_sign = ' ';
+
+  }
+
+  // check the left-right justification
+  if (char_num < 0)
+  {
+    // set the flag
+    right_j = 1;
+
+    // make the number positive
+    char_num = -char_num;
+
+  } else {
+    right_j = 0;
+  }
+
+
+  // no native exponential function for int
+  j=1;
+  for(i=0; i < (char_num - precision - 3 );i++) j *= 10;
+
+  // Hackish fail-fast behavior for larger-than-what-can-be-printed values, countig the precision + sign ('-') +'.' + '\0'
+  if (val >= (float)(j))
+  {
+    // not enough space
+    // strcpy(chr_buffer, "ovf"); - this is very byte consuming (388 bytes) , so we go for the cheap array
+    chr_buffer[0] = 'o';
+    chr_buffer[1] = 'v';
+    chr_buffer[2] = 'f';
+    chr_buffer[3] = '\0';
+
+    // finish here
+    return chr_buffer;
+  }
+
+
+
+  // Simplistic rounding strategy so that e.g. print(1.999, 2)
+  // prints as "2.00"
+  r_val = 0.5;
+  for ( i = 0; i < precision; i++) {
+      r_val /= 10.0;
+  }
+  val += r_val;
+
+  // Extract the integer and decimal part of the number and print it
+  i_val = (long) val;
+  r_val = val - (float) i_val;
+
+
+  // print the integral part ... but it is in reverse order ... so leaves the space for  '.' and the decimal part (and remember that array indexes start from 0
+  i = char_num - precision - 2;
+  do
+  {
+      chr_buffer[i] = '0' + ( i_val % 10);
+      i_val /= 10;
+      i--;
+
+  }   while ( i_val > 0) ;
+
+  // add the sign char
+  chr_buffer[i] = c_sign;
+
+  // prepare for the decimal part
+  j = char_num - precision - 1;
+
+  // Print the decimal point, but only if there are digits beyond
+  if (precision > 0) {
+    chr_buffer[j] = '.';
+    j++;
+
+    // Extract digits from the remainder one at a time
+    while (precision > 0) {
+      // prepare the data
+      r_val *= 10.0;
+      i_val  = (int)    r_val;
+      r_val -= (float)  i_val;
+
+      // update the string
+      chr_buffer[j] = '0' + ( i_val );
+      j++;
+
+      // use precision as the counter
+      precision--;
+    }
+  }
+
+  // terminate the string
+  chr_buffer[j] = '\0';
+
+  // check the justification direction
+  if (right_j)
+  {
+    // pad the string with leading ' '
+    while (i > 0)
+    {
+      i--;
+
+      chr_buffer[i] = ' ';
+    }
+
+  }
+
+ // return the pointer to the first char of the prepared string
+ return ( &chr_buffer[i]);
+}
+
+
+static const char g_digit_pairs[] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
+
+static const uint32_t g_pow10[] = {1, 10, 100, 1000, 10000};
+static const float g_half_lsb[] = {0.5f, 0.05f, 0.005f, 0.0005f, 0.00005f};
+
+
+uint8_t
+float_to_dec(char *str, float val, uint8_t precision)
+{ // my_dtostrf without padding, but the digits are produced with integer arithmetic only.
+  // returns the number of characters written (no terminator); at most FLOAT_TO_DEC_MAX_LEN.
+  if (val != val)
+  {
+    memcpy(str, "NaN", 3);
+    return 3;
+  }
+  if (precision > 4) precision = 4;
+
+  char *p = str;
+  if (val < 0)
+  {
+    *p++ = '-';
+    val = -val;
+  }
+  if (val >= 21000000.0f)
+  { // does not fit the 32 bit scaled value; this is not a temperature.
+    char tmp[20];
+    const char *q = my_dtostrf(val, 14, precision, tmp);
+    while (*q == ' ') q++;
+    uint8_t n = strlen(q);
+    memmove(p, q, n);
+    return (p - str) + n;
+  }
+
+  // round like my_dtostrf: add half of the last digit, then truncate.
+  val += g_half_lsb[precision];
+  uint32_t int_part = (uint32_t)val;
+  uint32_t frac_part = (uint32_t)((val - (float)int_part) * g_pow10[precision]);
+
+  // integer part, two digits at a time, written backwards in a small buffer.
+  char tmp[10];
+  char *t = tmp + sizeof(tmp);
+  while (int_part >= 100)
+  {
+    uint32_t q = int_part / 100;
+    uint32_t r = int_part - q * 100;
+    t -= 2;
+    t[0] = g_digit_pairs[2*r];
+    t[1] = g_digit_pairs[2*r+1];
+    int_part = q;
+  }
+  if (int_part >= 10)
+  {
+    t -= 2;
+    t[0] = g_digit_pairs[2*int_part];
+    t[1] = g_digit_pairs[2*int_part+1];
+  } else
+  {
+    *--t = '0' + int_part;
+  }
+  uint8_t n = tmp + sizeof(tmp) - t;
+  memcpy(p, t, n);
+  p += n;
+
+  if (precision > 0)
+  {
+    *p++ = '.';
+    for (int8_t d=precision-1; d>=0; d--)
+    {
+      p[d] = '0' + (frac_part % 10);
+      frac_part /= 10;
+    }
+    p += precision;
+  }
+  return p - str;
+}
+
+
+uint8_t
+float_to_sci(char *str, float val)
+{ // scientific notation with 9 significant digits; enough to restore the exact float.
+  // returns the number of characters written (no terminator); at most FLOAT_TO_DEC_MAX_LEN.
+  if (val != val)
+  {
+    memcpy(str, "NaN", 3);
+    return 3;
+  }
+  char *p = str;
+  double v = val;
+  if (v < 0)
+  {
+    *p++ = '-';
+    v = -v;
+  }
+  if (v > 3.5e38)
+  {
+    memcpy(p, "inf", 3);
+    return (p - str) + 3;
+  }
+  if (v == 0)
+  {
+    *p++ = '0';
+    return p - str;
+  }
+
+  int16_t exponent = 0;
+  while (v >= 10.0) { v /= 10.0; exponent++; }
+  while (v < 1.0) { v *= 10.0; exponent--; }
+  uint32_t mantissa = (uint32_t)(v * 1e8 + 0.5); // 9 digits
+  if (mantissa >= 1000000000UL)
+  {
+    mantissa /= 10;
+    exponent++;
+  }
+
+  char digits[9];
+  for (int8_t d=8; d>=0; d--)
+  {
+    digits[d] = '0' + (mantissa % 10);
+    mantissa /= 10;
+  }
+  *p++ = digits[0];
+  *p++ = '.';
+  memcpy(p, digits+1, 8);
+  p += 8;
+  *p++ = 'e';
+  if (exponent < 0)
+  {
+    *p++ = '-';
+    exponent = -exponent;
+  }
+  if (exponent >= 10)
+  {
+    *p++ = '0' + (exponent / 10);
+  }
+  *p++ = '0' + (exponent % 10);
+  return p - str;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
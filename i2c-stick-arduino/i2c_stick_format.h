@@ -0,0 +1,36 @@
+#ifndef __I2C_STICK_FORMAT_H__
+#define __I2C_STICK_FORMAT_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Number formatting
+// *****************
+//
+// The text answers format the measurement values here; hardware independent
+// (see test/format_test.cpp).
+//
+// my_dtostrf: fixed width, right aligned ('char_num' characters).
+// float_to_dec: my_dtostrf without padding, integer arithmetic only; for
+//               the (long) mv lists. It rounds once, where my_dtostrf
+//               truncates digit by digit in float: at (near) ties and
+//               beyond the float resolution the last digit may be one up.
+// float_to_sci: 9 significant digits, restores the exact float.
+//
+// float_to_dec and float_to_sci return the number of characters written (no
+// terminator), at most FLOAT_TO_DEC_MAX_LEN.
+
+#define FLOAT_TO_DEC_MAX_LEN 16
+
+char *my_dtostrf(float val,  int8_t char_num, uint8_t precision, char *chr_buffer);
+uint8_t float_to_dec(char *str, float val, uint8_t precision);
+uint8_t float_to_sci(char *str, float val);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_FORMAT_H__
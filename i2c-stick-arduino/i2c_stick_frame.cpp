@@ -0,0 +1,116 @@
+#include "i2c_stick_frame.h"
+#include "i2c_stick.h"
+#include "i2c_stick_cmd.h"
+
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+// streaming COBS encoder state; only one frame can be under construction at a time.
+static uint8_t g_frame_channel_mask;
+static uint8_t g_frame_block[255]; // [0] => COBS code, [1..254] => data
+static uint8_t g_frame_block_length;
+static uint16_t g_frame_crc;
+static uint16_t g_frame_sequence;
+
+
+static void
+frame_flush_block()
+{
+  g_frame_block[0] = g_frame_block_length + 1;
+  send_answer_chunk_binary(g_frame_channel_mask, (const char *)g_frame_block, g_frame_block_length + 1, 0);
+  g_frame_block_length = 0;
+}
+
+
+static void
+frame_encode(const uint8_t *data, uint16_t length)
+{
+  for (uint16_t i=0; i<length; i++)
+  {
+    if (data[i] == 0)
+    {
+      frame_flush_block();
+      continue;
+    }
+    g_frame_block_length++;
+    g_frame_block[g_frame_block_length] = data[i];
+    if (g_frame_block_length == 254)
+    {
+      frame_flush_block();
+    }
+  }
+}
+
+
+void
+send_frame_data(const void *data, uint16_t length)
+{
+  g_frame_crc = crc16_update(g_frame_crc, data, length);
+  frame_encode((const uint8_t *)data, length);
+}
+
+
+void
+send_frame_begin(uint8_t channel_mask, uint8_t type, uint8_t sa, uint8_t drv, uint32_t time_stamp, uint16_t payload_length)
+{
+  uint8_t header[FRAME_HEADER_SIZE];
+  header[0] = type;
+  header[1] = sa;
+  header[2] = drv;
+  header[3] = g_frame_sequence;
+  header[4] = g_frame_sequence >> 8;
+  header[5] = time_stamp;
+  header[6] = time_stamp >> 8;
+  header[7] = time_stamp >> 16;
+  header[8] = time_stamp >> 24;
+  header[9] = payload_length;
+  header[10] = payload_length >> 8;
+  g_frame_sequence++;
+
+  g_frame_channel_mask = channel_mask;
+  g_frame_block_length = 0;
+  g_frame_crc = 0xFFFF;
+
+  const char delimiter = 0x00;
+  send_answer_chunk_binary(channel_mask, &delimiter, 1, 0);
+  send_frame_data(header, sizeof(header));
+}
+
+
+void
+send_frame_end()
+{
+  uint8_t crc[2];
+  crc[0] = g_frame_crc;
+  crc[1] = g_frame_crc >> 8;
+  frame_encode(crc, sizeof(crc));
+  frame_flush_block();
+
+  const char delimiter = 0x00;
+  send_answer_chunk_binary(g_frame_channel_mask, &delimiter, 1, 1);
+}
+
+
+void
+send_frame(uint8_t channel_mask, uint8_t type, uint8_t sa, uint8_t drv, uint32_t time_stamp, const void *payload, uint16_t payload_length)
+{
+  send_frame_begin(channel_mask, type, sa, drv, time_stamp, payload_length);
+  send_frame_data(payload, payload_length);
+  send_frame_end();
+}
+
+
+void
+send_frame_error(uint8_t channel_mask, uint8_t type, uint8_t sa, uint8_t drv, uint32_t time_stamp, const char *error_message)
+{
+  send_frame(channel_mask, type | FRAME_TYPE_FLAG_ERROR, sa, drv, time_stamp, error_message, strlen(error_message));
+}
+
+
+#ifdef __cplusplus
+}
+#endif
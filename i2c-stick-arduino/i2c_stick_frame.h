@@ -0,0 +1,54 @@
+#ifndef __I2C_STICK_FRAME_H__
+#define __I2C_STICK_FRAME_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Framed binary protocol
+// **********************
+//
+// Enabled with `+ch:FORMAT=FRAME`; the streaming answers (mv, raw, nd and
+// the application records) are then sent as frames:
+//
+//   0x00 | COBS( header | payload | crc16 ) | 0x00
+//
+// header (11 bytes, little endian):
+//   uint8_t  type            FRAME_TYPE_xxx, bit 7 set => payload is an error message
+//   uint8_t  sa              slave address (7-bit)
+//   uint8_t  drv             driver id (or application id for FRAME_TYPE_APP)
+//   uint16_t sequence        incremented for every frame
+//   uint32_t time_stamp      milli-seconds
+//   uint16_t payload_length  in bytes
+//
+// crc16: CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over header and
+// payload, little endian.
+//
+// COBS guarantees there is no 0x00 inside a frame, so the host can
+// re-synchronise on the next 0x00 after a lost byte.
+
+#define FRAME_TYPE_MV         0x01 // payload: float32[]
+#define FRAME_TYPE_RAW        0x02 // payload: uint16_t[]
+#define FRAME_TYPE_ND         0x03 // payload: uint8_t (0 or 1)
+#define FRAME_TYPE_APP        0x04 // payload: float32[]
+#define FRAME_TYPE_MV_DELTA   0x05 // payload: uint16_t count, runs of (uint16_t first, uint16_t n, float32[n]); see i2c_stick_delta.h
+#define FRAME_TYPE_MV_Q8      0x06 // payload: float32 offset, float32 scale, uint8_t[]; see i2c_stick_quant.h
+#define FRAME_TYPE_FLAG_ERROR 0x80 // payload: error message (ASCII, no terminator)
+
+#define FRAME_HEADER_SIZE 11
+
+
+void send_frame_begin(uint8_t channel_mask, uint8_t type, uint8_t sa, uint8_t drv, uint32_t time_stamp, uint16_t payload_length);
+void send_frame_data(const void *data, uint16_t length);
+void send_frame_end();
+
+void send_frame(uint8_t channel_mask, uint8_t type, uint8_t sa, uint8_t drv, uint32_t time_stamp, const void *payload, uint16_t payload_length);
+void send_frame_error(uint8_t channel_mask, uint8_t type, uint8_t sa, uint8_t drv, uint32_t time_stamp, const char *error_message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_FRAME_H__
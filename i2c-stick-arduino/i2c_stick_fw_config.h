@@ -17,6 +17,57 @@
 // =============
 
 #define BUFFER_CHANNEL_SIZE (2*1024)
+#define TX_BUFFER_SIZE (8*1024)
+#define ACQ_QUEUE_SIZE 3
+
+// continuous mode scheduler
+#define SCHED_MAX_SLAVES 128 // one per 7-bit slave address
+#define SCHED_REBUILD_MS 500
+#define SCHED_MIN_POLL_MS 1
+
+// I2C transaction engine
+#define I2C_DMA_MIN_BYTES 64 // RP2040: reads of at least this size use one DMA burst
+#define I2C_XFER_TIMEOUT_MS 100 // margin on top of the transfer time at the bus clock
 #define MAX_SA_DRV_REGISTRATIONS 128
 
+// register shadow cache (control/configuration registers per sensor handle)
+#define REG_SHADOW_MAX_HANDLES 16
+#define REG_SHADOW_VERIFY_DEFAULT REG_SHADOW_VERIFY_ALWAYS
+
+// thermal arrays (MLX90640/41): keep the per pixel state (last To frame, IIR
+// history) as int16 fixed point instead of float; half the RAM per sensor.
+// THERMAL_Q_FRAC_BITS fractional bits: 5 => 1/32 degC, +/-1024 degC.
+//#define THERMAL_STORAGE_INT16
+#define THERMAL_Q_FRAC_BITS 5
+#define TEMPORAL_FILTER_MAX_BLOCKS 8 // history frames of the moving average filter
+#define ROI_MAX_COUNT 4 // regions of interest per sensor
+#define SUMMARY_MAX_BINS 16 // histogram bins of the frame summary
+
+// change-only streaming in continuous mode (+ch:DELTA=, +ch:KEYFRAME=); the
+// last transmitted frame is kept for up to DELTA_MAX_SLAVES slaves, each
+// taking its list length from an arena of DELTA_ARENA_VALUES floats (two
+// MLX90640 frames, or e.g. one MLX90640 and five MLX90641 frames); the
+// others keep getting full frames.
+#define DELTA_MAX_SLAVES 8
+#define DELTA_ARENA_VALUES (2*(768+1))
+#define DELTA_MAX_RUNS 64 // more runs of changed values => keyframe
+#define DELTA_KEYFRAME_INTERVAL 50 // default frames between keyframes
+
+// scratch arena for the temporary buffers of the command paths; the deepest
+// nesting is 'mv' (769 floats) around a driver init (832 words EEPROM dump),
+// or with THERMAL_STORAGE_INT16 around the float work frame of the To
+// calculation (768 floats).
+#ifdef THERMAL_STORAGE_INT16
+#define SCRATCH_ARENA_SIZE (7*1024)
+#else
+#define SCRATCH_ARENA_SIZE (6*1024)
+#endif // THERMAL_STORAGE_INT16
+
+// calibration cache (extracted sensor parameters keyed by serial number)
+#define CALIB_CACHE_ENABLE
+#define EEPROM_EMULATION_SIZE 4096 // bytes; RP2040 flash emulated EEPROM
+#define CALIB_CACHE_EEPROM_OFFSET 512 // bytes below are used by the applications
+#define CALIB_CACHE_NV_SIZE (32*1024) // USB MSC builds: tail of the flash partition, kept out of the USB drive
+#define CALIB_CACHE_MAX_PENDING 4 // queued stores/invalidations until the main loop flushes them
+
 #endif // __I2C_STICK_FW_CONFIG_H__
@@ -15,15 +15,78 @@ uint64_t hal_get_millis();
 int16_t hal_i2c_slave_address_available(uint8_t sa);
 void hal_i2c_set_clock_frequency(uint32_t frequency_in_hz);
 
+void hal_i2c_bus_lock();
+void hal_i2c_bus_unlock();
+
 int16_t hal_i2c_direct_read(uint8_t sa, uint8_t *read_buffer, uint16_t read_n_bytes);
 int16_t hal_i2c_direct_write(uint8_t sa, uint8_t *write_buffer, uint16_t write_n_bytes);
 int16_t hal_i2c_indirect_read(uint8_t sa, uint8_t *write_buffer, uint16_t write_n_bytes, uint8_t *read_buffer, uint16_t read_n_bytes);
 
+// I2C transaction engine
+// A transaction is a write phase, a read phase, or a write phase followed by a
+// repeated start and a read phase. Transactions are queued by the caller (no
+// allocation), executed in order by hal_i2c_xfer_poll and completed with an
+// optional callback.
+#define HAL_I2C_XFER_IDLE   0
+#define HAL_I2C_XFER_QUEUED 1
+#define HAL_I2C_XFER_BUSY   2
+#define HAL_I2C_XFER_DONE   3
+
+#define HAL_I2C_XFER_FLAG_NO_STOP 0x01 // write only: end without STOP condition
+
+struct hal_i2c_xfer_t;
+typedef void (*hal_i2c_xfer_cb_t)(struct hal_i2c_xfer_t *xfer);
+
+struct hal_i2c_xfer_t
+{
+  uint8_t sa_;
+  uint8_t flags_;
+  // when a read must be split in chunks, the address in write_buffer_ (big endian)
+  // advances by one for every bytes_per_address_ bytes read; 0 => plain continuation.
+  uint8_t bytes_per_address_;
+  const uint8_t *write_buffer_;
+  uint16_t write_n_bytes_;
+  uint8_t *read_buffer_;
+  uint16_t read_n_bytes_;
+  hal_i2c_xfer_cb_t done_cb_;
+  void *context_;
+  volatile uint8_t state_;
+  int16_t result_; // 0 => OK
+  struct hal_i2c_xfer_t *next_;
+};
+
+int16_t hal_i2c_xfer_submit(hal_i2c_xfer_t *xfer);
+void hal_i2c_xfer_poll();
+int16_t hal_i2c_xfer_wait(hal_i2c_xfer_t *xfer);
+// 1 => a read of read_n_bytes continues in the background once hal_i2c_xfer_poll started it.
+uint8_t hal_i2c_xfer_is_async(uint16_t read_n_bytes);
+// the time a transaction of n_bytes (write + read) may take at the current
+// bus clock, including a margin of I2C_XFER_TIMEOUT_MS.
+uint32_t hal_i2c_xfer_timeout_ms(uint16_t n_bytes);
+int16_t hal_i2c_transfer(uint8_t sa, const uint8_t *write_buffer, uint16_t write_n_bytes, uint8_t *read_buffer, uint16_t read_n_bytes, uint8_t bytes_per_address);
+
 void hal_write_pin(uint8_t pin, uint8_t state);
 uint8_t hal_read_pin(uint8_t pin);
 
 void hal_i2c_set_pwm(uint8_t pin_no, uint8_t pwm);
 
+// non-volatile storage (calibration cache); a flat byte area of
+// hal_nv_size() bytes, 0 => not available. read/write return 0 on success.
+uint32_t hal_nv_size();
+int16_t hal_nv_read(uint32_t address, void *buffer, uint16_t n_bytes);
+int16_t hal_nv_write(uint32_t address, const void *buffer, uint16_t n_bytes);
+void hal_nv_commit();
+
+// memory statistics (mem command); 0 => not available on this platform.
+void hal_mem_stack_paint(); // of the calling core; core0 also asks the other core(s) to repaint
+void hal_mem_stack_poll(); // in the loop of the other core(s): repaint when asked
+uint32_t hal_mem_stack_size(uint8_t core);
+uint32_t hal_mem_stack_peak(uint8_t core);
+uint32_t hal_mem_stack_now(); // current depth of the calling core
+uint32_t hal_mem_heap_size();
+uint32_t hal_mem_heap_used();
+uint32_t hal_mem_heap_peak();
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,396 @@
+#include "i2c_stick.h"
+#include "i2c_stick_hal.h"
+#include "i2c_stick_arduino.h"
+
+#include <Arduino.h>
+#include <Wire.h>
+
+#ifdef ARDUINO_ARCH_RP2040
+#include <hardware/i2c.h>
+#include <hardware/dma.h>
+#endif // ARDUINO_ARCH_RP2040
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+static hal_i2c_xfer_t *g_xfer_head; // first queued transaction
+static hal_i2c_xfer_t *g_xfer_tail; // last queued transaction
+static hal_i2c_xfer_t *g_xfer_busy; // transaction in progress (DMA only)
+static uint32_t g_xfer_start_ms;
+static uint32_t g_xfer_timeout_ms; // of the transaction in progress
+static uint32_t g_clock_hz = 100000;
+
+
+static void
+i2c_xfer_drain()
+{ // complete the transaction in progress and the queued ones before the controller is touched.
+  while ((g_xfer_busy != NULL) || (g_xfer_head != NULL))
+  {
+    hal_i2c_xfer_poll();
+  }
+}
+
+
+void
+hal_i2c_set_clock_frequency(uint32_t frequency_in_hz)
+{
+  uint32_t frequency_in_hz_corrected = frequency_in_hz;
+#ifdef ARDUINO_ARCH_RP2040
+  if (frequency_in_hz ==  100000) frequency_in_hz_corrected = frequency_in_hz * 1.05;
+  if (frequency_in_hz == 1000000) frequency_in_hz_corrected = frequency_in_hz * 1.25;
+  if (frequency_in_hz ==  400000) frequency_in_hz_corrected = frequency_in_hz * 1.105;
+#endif
+  i2c_xfer_drain(); // a DMA read may still be running
+  WIRE.end();
+  WIRE.setClock(frequency_in_hz_corrected); // RP2040 requires first to set the clock
+  WIRE.begin();
+  WIRE.setClock(frequency_in_hz_corrected); // NRF52840 requires first begin, then set clock.
+  g_clock_hz = frequency_in_hz;
+}
+
+
+uint32_t
+hal_i2c_xfer_timeout_ms(uint16_t n_bytes)
+{ // 9 clocks per byte (plus the address byte) at the bus clock, plus a margin.
+  uint32_t clock_hz = (g_clock_hz > 0) ? g_clock_hz : 100000;
+  return ((uint32_t)(n_bytes + 1) * 9 * 1000 + clock_hz - 1) / clock_hz + I2C_XFER_TIMEOUT_MS;
+}
+
+
+static int16_t
+i2c_wire_result(int16_t result)
+{
+#ifdef ARDUINO_ARCH_RP2040
+  if (result == 4) result = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
+#endif
+  return result;
+}
+
+
+static int16_t
+i2c_wire_write_address(hal_i2c_xfer_t *xfer, uint16_t offset)
+{
+  WIRE.beginTransmission(xfer->sa_);
+  if ((offset == 0) || (xfer->bytes_per_address_ == 0))
+  {
+    WIRE.write(xfer->write_buffer_, xfer->write_n_bytes_);
+  } else
+  { // restart the read at the address of the next chunk
+    uint32_t address = 0;
+    for (uint16_t i=0; i<xfer->write_n_bytes_; i++)
+    {
+      address = (address << 8) | xfer->write_buffer_[i];
+    }
+    address += offset / xfer->bytes_per_address_;
+    for (int16_t i=xfer->write_n_bytes_-1; i>=0; i--)
+    {
+      WIRE.write(uint8_t(address >> (8*i)));
+    }
+  }
+  return i2c_wire_result(WIRE.endTransmission(false)); // repeated start
+}
+
+
+static int16_t
+i2c_wire_transfer(hal_i2c_xfer_t *xfer)
+{
+  WIRE.endTransmission();
+  delayMicroseconds(5);
+
+  if (xfer->read_n_bytes_ == 0)
+  {
+    WIRE.beginTransmission(xfer->sa_);
+    WIRE.write(xfer->write_buffer_, xfer->write_n_bytes_);
+    return i2c_wire_result(WIRE.endTransmission(!(xfer->flags_ & HAL_I2C_XFER_FLAG_NO_STOP)));
+  }
+
+  // the Wire library buffers at most READ_BUFFER_SIZE bytes per request.
+  for (uint16_t offset = 0; offset < xfer->read_n_bytes_; )
+  {
+    uint16_t n = xfer->read_n_bytes_ - offset;
+    if (n > READ_BUFFER_SIZE) n = READ_BUFFER_SIZE;
+
+    if ((xfer->write_n_bytes_ > 0) && ((offset == 0) || (xfer->bytes_per_address_ > 0)))
+    {
+      int16_t result = i2c_wire_write_address(xfer, offset);
+      if (result != 0) return result;
+    }
+
+    if (WIRE.requestFrom((int)(xfer->sa_), (int)n) != n)
+    {
+      return -1;
+    }
+    for (uint16_t i=0; i<n; i++)
+    {
+      xfer->read_buffer_[offset+i] = (uint8_t)WIRE.read();
+    }
+    offset += n;
+  }
+
+  return i2c_wire_result(WIRE.endTransmission()); // stop transmitting
+}
+
+
+#ifdef ARDUINO_ARCH_RP2040
+// DMA backed reads: the address phase is written by the CPU, the read commands
+// are fed by a TX DMA channel from a constant command word and the data is
+// collected by a RX DMA channel; one address phase for the whole read.
+#ifdef USE_WIRE1
+  #define I2C_DMA_INST i2c1
+#else
+  #define I2C_DMA_INST i2c0
+#endif
+
+static int g_dma_tx = -1;
+static int g_dma_rx = -1;
+static uint8_t g_dma_unavailable; // claiming the channels failed; Wire only
+static uint8_t g_dma_last_cmd_pending;
+static const uint32_t g_dma_read_cmd = I2C_IC_DATA_CMD_CMD_BITS;
+
+
+static void
+i2c_dma_push_cmd(i2c_hw_t *hw, uint32_t cmd)
+{
+  while (!(hw->status & I2C_IC_STATUS_TFNF_BITS))
+  {
+    tight_loop_contents();
+  }
+  hw->data_cmd = cmd;
+}
+
+
+static uint8_t
+i2c_dma_start(hal_i2c_xfer_t *xfer)
+{
+  if (g_dma_rx < 0)
+  {
+    g_dma_tx = dma_claim_unused_channel(false);
+    g_dma_rx = dma_claim_unused_channel(false);
+    if ((g_dma_tx < 0) || (g_dma_rx < 0))
+    { // no DMA available; use the Wire library.
+      if (g_dma_tx >= 0) dma_channel_unclaim(g_dma_tx);
+      if (g_dma_rx >= 0) dma_channel_unclaim(g_dma_rx);
+      g_dma_tx = -1;
+      g_dma_rx = -1;
+      g_dma_unavailable = 1;
+      return 0;
+    }
+  }
+
+  WIRE.endTransmission();
+  delayMicroseconds(5);
+
+  i2c_hw_t *hw = i2c_get_hw(I2C_DMA_INST);
+  hw->enable = 0;
+  hw->tar = xfer->sa_;
+  hw->dma_tdlr = 4;
+  hw->dma_rdlr = 0;
+  hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+  hw->enable = 1;
+  (void)hw->clr_intr;
+
+  uint16_t n = xfer->read_n_bytes_;
+
+  dma_channel_config c = dma_channel_get_default_config(g_dma_rx);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+  channel_config_set_read_increment(&c, false);
+  channel_config_set_write_increment(&c, true);
+  channel_config_set_dreq(&c, i2c_get_dreq(I2C_DMA_INST, false));
+  dma_channel_configure(g_dma_rx, &c, xfer->read_buffer_, &hw->data_cmd, n, true);
+
+  for (uint16_t i=0; i<xfer->write_n_bytes_; i++)
+  {
+    i2c_dma_push_cmd(hw, xfer->write_buffer_[i]);
+  }
+  i2c_dma_push_cmd(hw, I2C_IC_DATA_CMD_CMD_BITS | (xfer->write_n_bytes_ ? I2C_IC_DATA_CMD_RESTART_BITS : 0));
+
+  // n >= I2C_DMA_MIN_BYTES, so there are always middle read commands
+  c = dma_channel_get_default_config(g_dma_tx);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+  channel_config_set_read_increment(&c, false);
+  channel_config_set_write_increment(&c, false);
+  channel_config_set_dreq(&c, i2c_get_dreq(I2C_DMA_INST, true));
+  dma_channel_configure(g_dma_tx, &c, &hw->data_cmd, &g_dma_read_cmd, n - 2, true);
+  g_dma_last_cmd_pending = 1;
+  return 1;
+}
+
+
+static void
+i2c_dma_abort()
+{ // stop feeding and collecting before the controller is released.
+  dma_channel_abort(g_dma_tx);
+  dma_channel_abort(g_dma_rx);
+  g_dma_last_cmd_pending = 0;
+}
+
+
+static void
+i2c_dma_finish(hal_i2c_xfer_t *xfer, int16_t result)
+{
+  i2c_hw_t *hw = i2c_get_hw(I2C_DMA_INST);
+  hw->dma_cr = 0;
+  I2C_DMA_INST->restart_on_next = false;
+  xfer->result_ = result;
+}
+
+
+static uint8_t
+i2c_dma_poll(hal_i2c_xfer_t *xfer)
+{ // return 1 when the transaction is completed.
+  i2c_hw_t *hw = i2c_get_hw(I2C_DMA_INST);
+
+  if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS)
+  {
+    uint32_t abort_source = hw->tx_abrt_source;
+    i2c_dma_abort(); // else the TX channel refills the FIFO once the abort is cleared
+    (void)hw->clr_tx_abrt;
+    i2c_dma_finish(xfer, (abort_source & I2C_IC_TX_ABRT_SOURCE_ABRT_7B_ADDR_NOACK_BITS) ? 2 : 3);
+    return 1;
+  }
+
+  if (g_dma_last_cmd_pending)
+  {
+    if (dma_channel_is_busy(g_dma_tx)) return 0;
+    i2c_dma_push_cmd(hw, I2C_IC_DATA_CMD_CMD_BITS | I2C_IC_DATA_CMD_STOP_BITS);
+    g_dma_last_cmd_pending = 0;
+  }
+
+  if ((!dma_channel_is_busy(g_dma_rx)) && (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_STOP_DET_BITS))
+  {
+    (void)hw->clr_stop_det;
+    i2c_dma_finish(xfer, 0);
+    return 1;
+  }
+
+  if ((millis() - g_xfer_start_ms) > g_xfer_timeout_ms)
+  {
+    i2c_dma_abort();
+    hw->enable |= I2C_IC_ENABLE_ABORT_BITS;
+    i2c_dma_finish(xfer, -2);
+    return 1;
+  }
+  return 0;
+}
+#endif // ARDUINO_ARCH_RP2040
+
+
+static void
+i2c_xfer_complete(hal_i2c_xfer_t *xfer)
+{
+  xfer->state_ = HAL_I2C_XFER_DONE;
+  if (xfer->done_cb_)
+  {
+    xfer->done_cb_(xfer);
+  }
+}
+
+
+int16_t
+hal_i2c_xfer_submit(hal_i2c_xfer_t *xfer)
+{
+  if ((xfer->sa_ > 127) || ((xfer->read_n_bytes_ > 0) && (xfer->read_buffer_ == NULL)))
+  {
+    return -1;
+  }
+  xfer->state_ = HAL_I2C_XFER_QUEUED;
+  xfer->result_ = 0;
+  xfer->next_ = NULL;
+  if (g_xfer_tail)
+  {
+    g_xfer_tail->next_ = xfer;
+  } else
+  {
+    g_xfer_head = xfer;
+  }
+  g_xfer_tail = xfer;
+  return 0;
+}
+
+
+void
+hal_i2c_xfer_poll()
+{
+#ifdef ARDUINO_ARCH_RP2040
+  if (g_xfer_busy)
+  {
+    if (!i2c_dma_poll(g_xfer_busy)) return;
+    hal_i2c_xfer_t *xfer = g_xfer_busy;
+    g_xfer_busy = NULL;
+    i2c_xfer_complete(xfer);
+  }
+#endif // ARDUINO_ARCH_RP2040
+
+  // start the next transaction; Wire transfers complete right away.
+  while (g_xfer_head)
+  {
+    hal_i2c_xfer_t *xfer = g_xfer_head;
+    g_xfer_head = xfer->next_;
+    if (g_xfer_head == NULL) g_xfer_tail = NULL;
+    xfer->state_ = HAL_I2C_XFER_BUSY;
+    g_xfer_start_ms = millis();
+    g_xfer_timeout_ms = hal_i2c_xfer_timeout_ms(xfer->write_n_bytes_ + xfer->read_n_bytes_);
+
+#ifdef ARDUINO_ARCH_RP2040
+    if ((xfer->read_n_bytes_ >= I2C_DMA_MIN_BYTES) && (xfer->write_n_bytes_ <= 8))
+    {
+      if (i2c_dma_start(xfer))
+      {
+        g_xfer_busy = xfer;
+        return;
+      }
+    }
+#endif // ARDUINO_ARCH_RP2040
+
+    xfer->result_ = i2c_wire_transfer(xfer);
+    i2c_xfer_complete(xfer);
+  }
+}
+
+
+int16_t
+hal_i2c_xfer_wait(hal_i2c_xfer_t *xfer)
+{
+  while ((xfer->state_ == HAL_I2C_XFER_QUEUED) || (xfer->state_ == HAL_I2C_XFER_BUSY))
+  {
+    hal_i2c_xfer_poll();
+  }
+  return xfer->result_;
+}
+
+
+uint8_t
+hal_i2c_xfer_is_async(uint16_t read_n_bytes)
+{
+#ifdef ARDUINO_ARCH_RP2040
+  return (read_n_bytes >= I2C_DMA_MIN_BYTES) && (!g_dma_unavailable);
+#else
+  (void)read_n_bytes;
+  return 0;
+#endif // ARDUINO_ARCH_RP2040
+}
+
+
+int16_t
+hal_i2c_transfer(uint8_t sa, const uint8_t *write_buffer, uint16_t write_n_bytes, uint8_t *read_buffer, uint16_t read_n_bytes, uint8_t bytes_per_address)
+{
+  hal_i2c_xfer_t xfer;
+  memset(&xfer, 0, sizeof(xfer));
+  xfer.sa_ = sa;
+  xfer.bytes_per_address_ = bytes_per_address;
+  xfer.write_buffer_ = write_buffer;
+  xfer.write_n_bytes_ = write_n_bytes;
+  xfer.read_buffer_ = read_buffer;
+  xfer.read_n_bytes_ = read_n_bytes;
+
+  int16_t result = hal_i2c_xfer_submit(&xfer);
+  if (result != 0) return result;
+  return hal_i2c_xfer_wait(&xfer);
+}
+
+
+#ifdef __cplusplus
+}
+#endif
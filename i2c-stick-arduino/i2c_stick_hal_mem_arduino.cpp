@@ -0,0 +1,170 @@
+#include "i2c_stick.h"
+#include "i2c_stick_hal.h"
+#include "i2c_stick_arduino.h"
+
+#include <Arduino.h>
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_RP2040) || defined(__IMXRT1062__)
+#include <malloc.h>
+#define HAS_MALLINFO
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Each core paints its own stack with a pattern at startup; the peak usage is
+// the part where the pattern got overwritten since. Only the core itself knows
+// how deep its stack is right now, so core0 asks core1 to repaint.
+#define STACK_PAINT_PATTERN 0xA5C3A5C3UL
+#define STACK_PAINT_MARGIN 256 // bytes below the current stack pointer left untouched
+
+#if defined(ARDUINO_ARCH_RP2040)
+// pico-sdk linker script: core0 stack in SCRATCH_Y, core1 stack in SCRATCH_X
+// (core1 is launched on it as long as core1_separate_stack is not set).
+extern uint32_t __StackBottom;
+extern uint32_t __StackTop;
+extern uint32_t __StackOneBottom;
+extern uint32_t __StackOneTop;
+#define HAS_STACK_PAINT
+#define STACK_CORES 2
+#define STACK_CORE() (rp2040.cpuid())
+static uint32_t * const g_stack_bottom[STACK_CORES] = { &__StackBottom, &__StackOneBottom };
+static uint32_t * const g_stack_top[STACK_CORES] = { &__StackTop, &__StackOneTop };
+#elif defined(__IMXRT1062__)
+// Teensy 4.x: the stack grows down from the end of DTCM towards .bss
+extern unsigned long _ebss;
+extern unsigned long _estack;
+#define HAS_STACK_PAINT
+#define STACK_CORES 1
+#define STACK_CORE() (0)
+static uint32_t * const g_stack_bottom[STACK_CORES] = { (uint32_t *)&_ebss };
+static uint32_t * const g_stack_top[STACK_CORES] = { (uint32_t *)&_estack };
+#endif
+
+#ifdef HAS_STACK_PAINT
+static volatile uint8_t g_stack_paint_request; // bit n => core n repaints on its next hal_mem_stack_poll
+#endif // HAS_STACK_PAINT
+
+
+void
+hal_mem_stack_paint()
+{
+#ifdef HAS_STACK_PAINT
+  uint8_t core = STACK_CORE();
+  volatile uint32_t here = 0;
+  uint32_t *end = (uint32_t *)((uintptr_t)&here - STACK_PAINT_MARGIN);
+  for (uint32_t *p = g_stack_bottom[core]; p < end; p++)
+  {
+    *p = STACK_PAINT_PATTERN;
+  }
+  if (core == 0)
+  {
+    g_stack_paint_request = (1U << STACK_CORES) - 2; // all other cores
+  }
+#endif // HAS_STACK_PAINT
+}
+
+
+void
+hal_mem_stack_poll()
+{
+#ifdef HAS_STACK_PAINT
+  uint8_t bit = 1U << STACK_CORE();
+  if (g_stack_paint_request & bit)
+  {
+    hal_mem_stack_paint();
+    g_stack_paint_request &= ~bit;
+  }
+#endif // HAS_STACK_PAINT
+}
+
+
+uint32_t
+hal_mem_stack_size(uint8_t core)
+{
+#ifdef HAS_STACK_PAINT
+  if (core >= STACK_CORES) return 0;
+  return (uintptr_t)g_stack_top[core] - (uintptr_t)g_stack_bottom[core];
+#else
+  (void)core;
+  return 0;
+#endif // HAS_STACK_PAINT
+}
+
+
+uint32_t
+hal_mem_stack_peak(uint8_t core)
+{
+#ifdef HAS_STACK_PAINT
+  if (core >= STACK_CORES) return 0;
+  const uint32_t *p = g_stack_bottom[core];
+  while ((p < g_stack_top[core]) && (*p == STACK_PAINT_PATTERN))
+  {
+    p++;
+  }
+  return (uintptr_t)g_stack_top[core] - (uintptr_t)p;
+#else
+  (void)core;
+  return 0;
+#endif // HAS_STACK_PAINT
+}
+
+
+uint32_t
+hal_mem_stack_now()
+{
+#ifdef HAS_STACK_PAINT
+  volatile uint32_t here = 0;
+  return (uintptr_t)g_stack_top[STACK_CORE()] - (uintptr_t)&here;
+#else
+  return 0;
+#endif // HAS_STACK_PAINT
+}
+
+
+uint32_t
+hal_mem_heap_size()
+{
+#if defined(ARDUINO_ARCH_RP2040)
+  return rp2040.getTotalHeap();
+#elif defined(ARDUINO_ARCH_ESP32)
+  return ESP.getHeapSize();
+#else
+  return 0;
+#endif
+}
+
+
+uint32_t
+hal_mem_heap_used()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  return ESP.getHeapSize() - ESP.getFreeHeap();
+#elif defined(HAS_MALLINFO)
+  struct mallinfo mi = mallinfo();
+  return mi.uordblks;
+#else
+  return 0;
+#endif
+}
+
+
+uint32_t
+hal_mem_heap_peak()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  return ESP.getHeapSize() - ESP.getMinFreeHeap();
+#elif defined(HAS_MALLINFO)
+  struct mallinfo mi = mallinfo(); // newlib: the arena only grows, so it is the high water mark
+  return mi.arena;
+#else
+  return 0;
+#endif
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,76 @@
+#include "i2c_stick_pool.h"
+
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static pool_t *g_pool_list; // registered pools
+
+
+void
+pool_register(pool_t *pool)
+{
+  if (pool->is_registered_) return;
+  pool->is_registered_ = 1;
+  pool->next_ = g_pool_list;
+  g_pool_list = pool;
+}
+
+
+void *
+pool_alloc(pool_t *pool)
+{
+  pool_register(pool);
+  for (uint8_t i=0; i<pool->capacity_; i++)
+  {
+    if (!(pool->used_mask_ & (1UL<<i)))
+    {
+      pool->used_mask_ |= (1UL<<i);
+      uint8_t used = pool_used(pool);
+      if (used > pool->peak_) pool->peak_ = used;
+      uint8_t *object = pool->storage_ + (uint32_t)i * pool->object_size_;
+      memset(object, 0, pool->object_size_);
+      return object;
+    }
+  }
+  return NULL; // pool exhausted
+}
+
+
+void
+pool_free(pool_t *pool, void *object)
+{
+  if (object == NULL) return;
+  uint32_t offset = (uint8_t *)object - pool->storage_;
+  uint8_t i = offset / pool->object_size_;
+  if (i < pool->capacity_)
+  {
+    pool->used_mask_ &= ~(1UL<<i);
+  }
+}
+
+
+uint8_t
+pool_used(const pool_t *pool)
+{
+  uint8_t n = 0;
+  for (uint32_t m = pool->used_mask_; m; m &= m - 1)
+  {
+    n++;
+  }
+  return n;
+}
+
+
+pool_t *
+pool_first()
+{
+  return g_pool_list;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
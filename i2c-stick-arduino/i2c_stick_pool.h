@@ -0,0 +1,48 @@
+#ifndef __I2C_STICK_POOL_H__
+#define __I2C_STICK_POOL_H__
+
+#include <stdint.h>
+#include "i2c_stick_fw_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Object pools
+// ************
+//
+// Driver handles (and their filter state) come from a statically sized pool
+// instead of the heap; the capacity is the driver's MAX_..._SLAVES. A
+// rescan releases and re-acquires the same slots, so the heap does not
+// fragment and allocation time is bounded by the capacity (max 32).
+//
+// Pools register themselves on first use (or explicitly at driver
+// registration) such that the 'mem' command can report the occupancy.
+
+struct pool_t
+{
+  const char *name_;
+  uint8_t *storage_;
+  uint16_t object_size_;
+  uint8_t capacity_;
+  uint8_t peak_;
+  uint8_t is_registered_;
+  uint32_t used_mask_;
+  pool_t *next_;
+};
+
+#define POOL_DEFINE(var, name, type, capacity) \
+  static type var##_storage[capacity]; \
+  static pool_t var = { name, (uint8_t *)var##_storage, sizeof(type), capacity, 0, 0, 0, NULL }
+
+void pool_register(pool_t *pool);
+void *pool_alloc(pool_t *pool); // zero-filled object or NULL when the pool is full
+void pool_free(pool_t *pool, void *object);
+uint8_t pool_used(const pool_t *pool);
+pool_t *pool_first();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_POOL_H__
@@ -0,0 +1,116 @@
+#include "i2c_stick_quant.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static quant_cfg_t g_quant_cfg = { QUANT_OFF, 0.0f, 100.0f };
+static uint32_t g_quant_sa_mask[128/32]; // bit sa => temperature list
+
+
+int8_t
+i2c_stick_quant_parse(const char *input)
+{
+  if (!strcmp(input, "OFF"))
+  {
+    g_quant_cfg.mode_ = QUANT_OFF;
+    return 0;
+  }
+  if (!strcmp(input, "AUTO"))
+  {
+    g_quant_cfg.mode_ = QUANT_AUTO;
+    return 0;
+  }
+  const char *p_hi = strchr(input, ',');
+  if (p_hi == NULL) return -1;
+  float lo = atof(input);
+  float hi = atof(p_hi+1);
+  if (!(lo < hi)) return -1;
+  g_quant_cfg.mode_ = QUANT_FIXED;
+  g_quant_cfg.lo_ = lo;
+  g_quant_cfg.hi_ = hi;
+  return 0;
+}
+
+
+const quant_cfg_t *
+i2c_stick_quant_get_cfg()
+{
+  return &g_quant_cfg;
+}
+
+
+void
+i2c_stick_quant_set_temperature_list(uint8_t sa, uint8_t is_temperature_list)
+{
+  if (sa >= 128) return;
+  if (is_temperature_list)
+  {
+    g_quant_sa_mask[sa >> 5] |= (1UL << (sa & 31));
+  } else
+  {
+    g_quant_sa_mask[sa >> 5] &= ~(1UL << (sa & 31));
+  }
+}
+
+
+uint8_t
+i2c_stick_quant_is_active(uint8_t sa)
+{
+  if ((g_quant_cfg.mode_ == QUANT_OFF) || (sa >= 128)) return 0;
+  return (g_quant_sa_mask[sa >> 5] >> (sa & 31)) & 1;
+}
+
+
+void
+i2c_stick_quant_range(const float *list, uint16_t count, float *offset, float *scale)
+{
+  float lo = g_quant_cfg.lo_;
+  float hi = g_quant_cfg.hi_;
+  if (g_quant_cfg.mode_ != QUANT_FIXED)
+  {
+    lo = INFINITY;
+    hi = -INFINITY;
+    for (uint16_t i=0; i<count; i++)
+    {
+      float value = list[i];
+      if (value != value) continue; // NAN
+      lo = (value < lo) ? value : lo;
+      hi = (value > hi) ? value : hi;
+    }
+    if (lo > hi)
+    { // no valid value
+      lo = 0.0f;
+      hi = 0.0f;
+    }
+  }
+  *offset = lo;
+  *scale = (hi - lo) / QUANT_MAX;
+}
+
+
+void
+i2c_stick_quant_list(const float *list, uint16_t count, float offset, float scale, uint8_t *out)
+{
+  const float gain = (scale > 0.0f) ? (1.0f / scale) : 0.0f;
+  for (uint16_t i=0; i<count; i++)
+  {
+    float value = list[i];
+    if (value != value)
+    {
+      out[i] = QUANT_INVALID;
+      continue;
+    }
+    float q = (value - offset) * gain + 0.5f;
+    out[i] = (q <= 0.0f) ? 0 : ((q >= QUANT_MAX) ? QUANT_MAX : (uint8_t)q);
+  }
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,67 @@
+#ifndef __I2C_STICK_QUANT_H__
+#define __I2C_STICK_QUANT_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 8-bit quantised mv output
+// *************************
+//
+// Enabled with `+ch:QUANT=AUTO` or `+ch:QUANT=<lo>,<hi>` (`+ch:QUANT=OFF`
+// to disable); applies to the BIN and FRAME formats. Every 'mv' value is
+// sent as one byte q, with a per-answer offset and scale:
+//
+//   value = offset + q * scale      (q = QUANT_INVALID => NAN)
+//
+// AUTO takes offset and scale from the minimum and maximum of the list (NAN
+// skipped); a fixed span maps lo..hi on 0..QUANT_MAX, values outside the
+// span saturate.
+//
+// Only temperature lists are quantised: the thermal array drivers mark
+// their slave while the mv answer holds the pixels or the ROI values (the
+// TA value at the head is quantised along, but is left out of the AUTO span;
+// it saturates when outside). Other answers, like the
+// summary with its pixel positions and histogram counts or the short
+// lists of the single pixel sensors, are sent as usual.
+//
+//   BIN:   "Q8:<offset>:<scale>:<count>" + CRLF, then count bytes; offset
+//          and scale with 9 significant digits (the exact float)
+//   FRAME: FRAME_TYPE_MV_Q8, payload: float32 offset, float32 scale, uint8_t[count]
+
+#define QUANT_OFF   0
+#define QUANT_AUTO  1
+#define QUANT_FIXED 2
+
+#define QUANT_MAX     254
+#define QUANT_INVALID 255
+
+struct quant_cfg_t
+{
+  uint8_t mode_; // QUANT_xxx
+  float lo_; // QUANT_FIXED span in degC
+  float hi_;
+};
+
+
+// input: "OFF", "AUTO" or "lo,hi" (lo < hi); 0 => ok; -1 => syntax or outbound.
+int8_t i2c_stick_quant_parse(const char *input);
+const quant_cfg_t *i2c_stick_quant_get_cfg();
+
+// drivers: 1 => the mv answers of sa are temperature lists.
+void i2c_stick_quant_set_temperature_list(uint8_t sa, uint8_t is_temperature_list);
+// 1 => quantise the mv answer of sa.
+uint8_t i2c_stick_quant_is_active(uint8_t sa);
+
+// offset and scale for the list according to the configuration.
+void i2c_stick_quant_range(const float *list, uint16_t count, float *offset, float *scale);
+// quantise count values into out.
+void i2c_stick_quant_list(const float *list, uint16_t count, float offset, float scale, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_QUANT_H__
@@ -0,0 +1,163 @@
+#include "i2c_stick_reg_shadow.h"
+
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static reg_shadow_t *g_reg_shadow_list[REG_SHADOW_MAX_HANDLES];
+
+
+void
+reg_shadow_attach(reg_shadow_t *shadow, uint8_t sa, const uint16_t *address_list, uint8_t count)
+{
+  if (count > REG_SHADOW_SIZE) count = REG_SHADOW_SIZE;
+  reg_shadow_detach(shadow);
+  memset(shadow, 0, sizeof(reg_shadow_t));
+  shadow->sa_ = sa;
+  shadow->count_ = count;
+  shadow->verify_policy_ = REG_SHADOW_VERIFY_DEFAULT;
+  memcpy(shadow->address_, address_list, count * sizeof(uint16_t));
+
+  for (uint8_t i=0; i<REG_SHADOW_MAX_HANDLES; i++)
+  {
+    if (g_reg_shadow_list[i] == NULL)
+    {
+      g_reg_shadow_list[i] = shadow;
+      return;
+    }
+  }
+  // no free spot; the handle works without shadow.
+}
+
+
+void
+reg_shadow_detach(reg_shadow_t *shadow)
+{
+  for (uint8_t i=0; i<REG_SHADOW_MAX_HANDLES; i++)
+  {
+    if (g_reg_shadow_list[i] == shadow)
+    {
+      g_reg_shadow_list[i] = NULL;
+    }
+  }
+}
+
+
+reg_shadow_t *
+reg_shadow_find(uint8_t sa)
+{
+  for (uint8_t i=0; i<REG_SHADOW_MAX_HANDLES; i++)
+  {
+    if ((g_reg_shadow_list[i]) && (g_reg_shadow_list[i]->sa_ == sa))
+    {
+      return g_reg_shadow_list[i];
+    }
+  }
+  return NULL;
+}
+
+
+static int8_t
+reg_shadow_index(reg_shadow_t *shadow, uint16_t address)
+{
+  if (shadow == NULL) return -1;
+  for (uint8_t i=0; i<shadow->count_; i++)
+  {
+    if (shadow->address_[i] == address)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+
+uint8_t
+reg_shadow_read(reg_shadow_t *shadow, uint16_t address, uint16_t *value)
+{ // return 1 when served from the shadow.
+  int8_t i = reg_shadow_index(shadow, address);
+  if ((i < 0) || !(shadow->valid_mask_ & (1U<<i)))
+  {
+    return 0;
+  }
+  *value = shadow->value_[i];
+  shadow->read_saved_++;
+  return 1;
+}
+
+
+void
+reg_shadow_update(reg_shadow_t *shadow, uint16_t address, uint16_t value)
+{
+  int8_t i = reg_shadow_index(shadow, address);
+  if (i < 0) return;
+  shadow->value_[i] = value;
+  shadow->valid_mask_ |= (1U<<i);
+}
+
+
+void
+reg_shadow_drop(reg_shadow_t *shadow, uint16_t address)
+{
+  int8_t i = reg_shadow_index(shadow, address);
+  if (i < 0) return;
+  shadow->valid_mask_ &= ~(1U<<i);
+}
+
+
+void
+reg_shadow_invalidate(reg_shadow_t *shadow)
+{
+  if (shadow == NULL) return;
+  shadow->valid_mask_ = 0;
+}
+
+
+void
+reg_shadow_invalidate_all()
+{ // general call reset; all sensors on the bus reload their registers.
+  for (uint8_t i=0; i<REG_SHADOW_MAX_HANDLES; i++)
+  {
+    reg_shadow_invalidate(g_reg_shadow_list[i]);
+  }
+}
+
+
+uint8_t
+reg_shadow_verify_write(reg_shadow_t *shadow, uint8_t is_eeprom)
+{ // return 1 when the write must be read back.
+  uint8_t policy = (shadow) ? shadow->verify_policy_ : REG_SHADOW_VERIFY_ALWAYS;
+  if ((policy == REG_SHADOW_VERIFY_ALWAYS) ||
+      ((policy == REG_SHADOW_VERIFY_EEPROM) && (is_eeprom)))
+  {
+    return 1;
+  }
+  shadow->verify_saved_++;
+  return 0;
+}
+
+
+const char *
+reg_shadow_policy_to_str(uint8_t policy)
+{
+  if (policy == REG_SHADOW_VERIFY_EEPROM) return "EEPROM";
+  if (policy == REG_SHADOW_VERIFY_NEVER) return "NEVER";
+  return "ALWAYS";
+}
+
+
+int8_t
+reg_shadow_policy_from_str(const char *input)
+{
+  if (!strcmp(input, "ALWAYS")) return REG_SHADOW_VERIFY_ALWAYS;
+  if (!strcmp(input, "EEPROM")) return REG_SHADOW_VERIFY_EEPROM;
+  if (!strcmp(input, "NEVER")) return REG_SHADOW_VERIFY_NEVER;
+  return -1;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
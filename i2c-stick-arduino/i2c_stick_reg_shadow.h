@@ -0,0 +1,63 @@
+#ifndef __I2C_STICK_REG_SHADOW_H__
+#define __I2C_STICK_REG_SHADOW_H__
+
+#include <stdint.h>
+#include "i2c_stick_fw_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Register shadow cache
+// *********************
+//
+// Each sensor handle owns a reg_shadow_t with a copy of a few control and
+// configuration registers, attached by slave address such that the I2C
+// driver layer of the sensor can find it. Single word reads of a shadowed
+// register are served from the copy once it is valid; writes update it.
+//
+// The copy is only invalidated by the driver (cs_write, mw) or a reset; the
+// registers listed must therefore not be changed by the sensor itself.
+//
+// The verify policy selects which writes are read back for verification;
+// the counters report the bus transactions saved.
+
+#define REG_SHADOW_SIZE 4
+
+#define REG_SHADOW_VERIFY_ALWAYS 0
+#define REG_SHADOW_VERIFY_EEPROM 1 // only EEPROM writes
+#define REG_SHADOW_VERIFY_NEVER  2
+
+struct reg_shadow_t
+{
+  uint8_t sa_;
+  uint8_t count_;
+  uint8_t valid_mask_; // bit n set => value_[n] holds the register content
+  uint8_t verify_policy_;
+  uint16_t address_[REG_SHADOW_SIZE];
+  uint16_t value_[REG_SHADOW_SIZE];
+  uint32_t read_saved_; // reads served from the shadow
+  uint32_t verify_saved_; // verification reads skipped by the policy
+};
+
+
+void reg_shadow_attach(reg_shadow_t *shadow, uint8_t sa, const uint16_t *address_list, uint8_t count);
+void reg_shadow_detach(reg_shadow_t *shadow);
+reg_shadow_t *reg_shadow_find(uint8_t sa);
+
+// shadow may be NULL in all functions below (no handle => no caching).
+uint8_t reg_shadow_read(reg_shadow_t *shadow, uint16_t address, uint16_t *value);
+void reg_shadow_update(reg_shadow_t *shadow, uint16_t address, uint16_t value);
+void reg_shadow_drop(reg_shadow_t *shadow, uint16_t address);
+void reg_shadow_invalidate(reg_shadow_t *shadow);
+void reg_shadow_invalidate_all();
+uint8_t reg_shadow_verify_write(reg_shadow_t *shadow, uint8_t is_eeprom);
+
+const char *reg_shadow_policy_to_str(uint8_t policy);
+int8_t reg_shadow_policy_from_str(const char *input);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_REG_SHADOW_H__
@@ -0,0 +1,416 @@
+#include "i2c_stick_roi.h"
+#include "i2c_stick.h"
+#include "i2c_stick_cmd.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+static void
+roi_mask_set(uint32_t *mask, uint16_t pix)
+{
+  mask[pix >> 5] |= (1UL << (pix & 31));
+}
+
+
+static uint8_t
+roi_mask_get(const uint32_t *mask, uint16_t pix)
+{
+  return (mask[pix >> 5] >> (pix & 31)) & 1;
+}
+
+
+static void
+roi_update(roi_set_t *set)
+{ // derive the compute mask and the spans from the rectangles.
+  uint32_t union_mask[ROI_MAX_PIXELS / 32];
+  memset(union_mask, 0, sizeof(union_mask));
+  memset(set->compute_mask_, 0, sizeof(set->compute_mask_));
+  set->span_count_ = 0;
+
+  for (uint8_t i=0; i<set->count_; i++)
+  {
+    const roi_rect_t *rect = &set->rect_[i];
+    int16_t c0 = rect->col_ - ROI_MARGIN;
+    int16_t c1 = rect->col_ + rect->width_ + ROI_MARGIN;
+    int16_t r0 = rect->row_ - ROI_MARGIN;
+    int16_t r1 = rect->row_ + rect->height_ + ROI_MARGIN;
+    if (c0 < 0) c0 = 0;
+    if (r0 < 0) r0 = 0;
+    if (c1 > set->cols_) c1 = set->cols_;
+    if (r1 > set->rows_) r1 = set->rows_;
+    for (int16_t r=r0; r<r1; r++)
+    {
+      for (int16_t c=c0; c<c1; c++)
+      {
+        roi_mask_set(set->compute_mask_, r * set->cols_ + c);
+      }
+    }
+    for (uint8_t r=rect->row_; r<rect->row_+rect->height_; r++)
+    {
+      for (uint8_t c=rect->col_; c<rect->col_+rect->width_; c++)
+      {
+        roi_mask_set(union_mask, r * set->cols_ + c);
+      }
+    }
+  }
+
+  if (set->count_ == 0)
+  { // no ROI: one span over the full frame
+    set->span_[0].first_ = 0;
+    set->span_[0].count_ = set->cols_ * set->rows_;
+    set->span_count_ = 1;
+    return;
+  }
+  for (uint8_t r=0; r<set->rows_; r++)
+  {
+    uint8_t c = 0;
+    while (c < set->cols_)
+    {
+      uint16_t pix = r * set->cols_ + c;
+      if (!roi_mask_get(union_mask, pix))
+      {
+        c++;
+        continue;
+      }
+      roi_span_t *span = &set->span_[set->span_count_++];
+      span->first_ = pix;
+      span->count_ = 0;
+      while ((c < set->cols_) && roi_mask_get(union_mask, r * set->cols_ + c))
+      {
+        span->count_++;
+        c++;
+      }
+    }
+  }
+}
+
+
+void
+roi_init(roi_set_t *set, uint8_t cols, uint8_t rows)
+{
+  memset(set, 0, sizeof(roi_set_t));
+  set->cols_ = cols;
+  set->rows_ = rows;
+  set->output_ = ROI_OUTPUT_PIXELS;
+  roi_update(set);
+}
+
+
+void
+roi_clear(roi_set_t *set)
+{
+  set->count_ = 0;
+  roi_update(set);
+}
+
+
+static const char *
+roi_parse_uint(const char *p, uint16_t *value)
+{ // return the position after the number, or NULL when there is no number.
+  if ((*p < '0') || (*p > '9')) return NULL;
+  uint16_t v = 0;
+  while ((*p >= '0') && (*p <= '9'))
+  {
+    v = v * 10 + (*p - '0');
+    if (v > 255) return NULL;
+    p++;
+  }
+  *value = v;
+  return p;
+}
+
+
+int8_t
+roi_parse(roi_set_t *set, const char *input, uint8_t append)
+{
+  roi_rect_t rect_list[ROI_MAX_COUNT];
+  uint8_t count = 0;
+  uint16_t pixel_count = 0;
+  if (append)
+  {
+    count = set->count_;
+    memcpy(rect_list, set->rect_, sizeof(rect_list));
+    for (uint8_t i=0; i<count; i++)
+    {
+      pixel_count += rect_list[i].width_ * rect_list[i].height_;
+    }
+  }
+
+  const char *p = input;
+  for (;;)
+  {
+    uint16_t value[4];
+    for (uint8_t i=0; i<4; i++)
+    {
+      p = roi_parse_uint(p, &value[i]);
+      if (p == NULL) return -1;
+      if ((i < 3) && (*p++ != ',')) return -1;
+    }
+    if ((value[2] == 0) || (value[3] == 0)) return -1;
+    if ((value[0] + value[2] > set->cols_) || (value[1] + value[3] > set->rows_)) return -1;
+    if (count >= ROI_MAX_COUNT) return -2;
+    pixel_count += value[2] * value[3];
+    if (pixel_count > set->cols_ * set->rows_) return -2;
+
+    rect_list[count].col_ = value[0];
+    rect_list[count].row_ = value[1];
+    rect_list[count].width_ = value[2];
+    rect_list[count].height_ = value[3];
+    count++;
+
+    if (*p == '\0') break;
+    if (*p++ != ';') return -1;
+  }
+
+  memcpy(set->rect_, rect_list, sizeof(rect_list));
+  set->count_ = count;
+  roi_update(set);
+  return 0;
+}
+
+
+static char *
+roi_append(char *dst, const char *end, const char *str)
+{ // copy str up to end (exclusive; keeps room for the terminator)
+  while ((*str) && (dst < end))
+  {
+    *dst++ = *str++;
+  }
+  *dst = '\0';
+  return dst;
+}
+
+
+static char *
+roi_append_uint(char *dst, const char *end, uint16_t value)
+{
+  char buf[8];
+  itoa(value, buf, 10);
+  return roi_append(dst, end, buf);
+}
+
+
+void
+roi_to_str(const roi_set_t *set, char *buf, uint16_t size)
+{
+  char *p = buf;
+  const char *end = buf + size - 1;
+  *p = '\0';
+  if (!roi_is_active(set))
+  {
+    roi_append(p, end, "OFF");
+    return;
+  }
+  for (uint8_t i=0; i<set->count_; i++)
+  {
+    const roi_rect_t *rect = &set->rect_[i];
+    if (i > 0) p = roi_append(p, end, ";");
+    p = roi_append_uint(p, end, rect->col_);
+    p = roi_append(p, end, ",");
+    p = roi_append_uint(p, end, rect->row_);
+    p = roi_append(p, end, ",");
+    p = roi_append_uint(p, end, rect->width_);
+    p = roi_append(p, end, ",");
+    p = roi_append_uint(p, end, rect->height_);
+  }
+}
+
+
+void
+roi_header_to_str(const roi_set_t *set, char *buf, uint16_t size)
+{
+  static const char *stat_list[] = { "_MIN,", "_MAX,", "_MEAN," };
+  char *p = buf;
+  const char *end = buf + size - 1;
+  *p = '\0';
+  for (uint8_t i=0; i<set->count_; i++)
+  {
+    if (set->output_ == ROI_OUTPUT_STATS)
+    {
+      for (uint8_t s=0; s<3; s++)
+      {
+        p = roi_append(p, end, "ROI");
+        p = roi_append_uint(p, end, i);
+        p = roi_append(p, end, stat_list[s]);
+      }
+    } else
+    {
+      p = roi_append(p, end, "ROI");
+      p = roi_append_uint(p, end, i);
+      p = roi_append(p, end, "_[");
+      p = roi_append_uint(p, end, set->rect_[i].width_ * set->rect_[i].height_);
+      p = roi_append(p, end, "],");
+    }
+  }
+  if ((p > buf) && (p[-1] == ','))
+  {
+    p[-1] = '\0';
+  }
+}
+
+
+const char *
+roi_output_to_str(uint8_t output)
+{
+  if (output == ROI_OUTPUT_STATS) return "STATS";
+  return "PIXELS";
+}
+
+
+int8_t
+roi_output_from_str(const char *input)
+{
+  if (!strcmp(input, "PIXELS")) return ROI_OUTPUT_PIXELS;
+  if (!strcmp(input, "STATS")) return ROI_OUTPUT_STATS;
+  return -1;
+}
+
+
+uint16_t
+roi_output_count(const roi_set_t *set)
+{
+  if (set->output_ == ROI_OUTPUT_STATS)
+  {
+    return 3 * set->count_;
+  }
+  uint16_t count = 0;
+  for (uint8_t i=0; i<set->count_; i++)
+  {
+    count += set->rect_[i].width_ * set->rect_[i].height_;
+  }
+  return count;
+}
+
+
+typedef float (*roi_value_fn)(const void *frame, uint16_t pix, float scale);
+
+
+static float
+roi_value_float(const void *frame, uint16_t pix, float scale)
+{
+  (void)scale;
+  return ((const float *)frame)[pix];
+}
+
+
+static float
+roi_value_int16(const void *frame, uint16_t pix, float scale)
+{
+  int16_t value = ((const int16_t *)frame)[pix];
+  if (value == INT16_MIN) return NAN;
+  return value * scale;
+}
+
+
+static void
+roi_extract(const roi_set_t *set, const void *frame, roi_value_fn value_fn, float scale, float *out)
+{
+  for (uint8_t i=0; i<set->count_; i++)
+  {
+    const roi_rect_t *rect = &set->rect_[i];
+    float lo = INFINITY;
+    float hi = -INFINITY;
+    float sum = 0;
+    uint16_t n = 0;
+    for (uint8_t r=rect->row_; r<rect->row_+rect->height_; r++)
+    {
+      uint16_t pix = r * set->cols_ + rect->col_;
+      for (uint8_t c=0; c<rect->width_; c++, pix++)
+      {
+        float value = value_fn(frame, pix, scale);
+        if (set->output_ != ROI_OUTPUT_STATS)
+        {
+          *out++ = value;
+          continue;
+        }
+        if (value != value) continue; // NAN
+        lo = (value < lo) ? value : lo;
+        hi = (value > hi) ? value : hi;
+        sum += value;
+        n++;
+      }
+    }
+    if (set->output_ == ROI_OUTPUT_STATS)
+    {
+      *out++ = n ? lo : NAN;
+      *out++ = n ? hi : NAN;
+      *out++ = n ? sum / n : NAN;
+    }
+  }
+}
+
+
+void
+roi_extract_float(const roi_set_t *set, const float *frame, float *out)
+{
+  roi_extract(set, frame, roi_value_float, 1.0f, out);
+}
+
+
+void
+roi_extract_int16(const roi_set_t *set, const int16_t *frame, float scale, float *out)
+{
+  roi_extract(set, frame, roi_value_int16, scale, out);
+}
+
+
+void
+roi_cs(uint8_t sa, uint8_t channel_mask, const roi_set_t *set)
+{
+  char buf[128];
+  roi_to_str(set, buf, sizeof(buf));
+  send_cs_value(sa, channel_mask, "ROI", buf);
+  send_cs_value(sa, channel_mask, "ROI_OUTPUT", roi_output_to_str(set->output_));
+}
+
+
+uint8_t
+roi_cs_write(uint8_t sa, uint8_t channel_mask, roi_set_t *set, const char *input)
+{
+  char too_many[48];
+  char *p = roi_append(too_many, too_many + sizeof(too_many) - 1, "max " xstr(ROI_MAX_COUNT) " ROI's of ");
+  p = roi_append_uint(p, too_many + sizeof(too_many) - 1, set->cols_ * set->rows_);
+  roi_append(p, too_many + sizeof(too_many) - 1, " pixels in total");
+
+  const char *var_name = "ROI=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  { // the ROI's replace the full frame; OFF returns to the full frame.
+    int8_t r = 0;
+    if (!strcmp(input+strlen(var_name), "OFF"))
+    {
+      roi_clear(set);
+    } else
+    {
+      r = roi_parse(set, input+strlen(var_name), 0);
+    }
+    send_cs_write_answer(sa, channel_mask, "ROI", r, (r == -2) ? too_many : "expect OFF or col,row,width,height[;...]");
+    return (r == 0) ? 2 : 1;
+  }
+  var_name = "ROI+=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  { // add one ROI; a command line is too short for a list of them.
+    int8_t r = roi_parse(set, input+strlen(var_name), 1);
+    send_cs_write_answer(sa, channel_mask, "ROI", r, (r == -2) ? too_many : "expect col,row,width,height");
+    return (r == 0) ? 2 : 1;
+  }
+  var_name = "ROI_OUTPUT=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  {
+    int8_t output = roi_output_from_str(input+strlen(var_name));
+    if (output >= 0) set->output_ = output;
+    send_cs_write_answer(sa, channel_mask, "ROI_OUTPUT", (output >= 0) ? 0 : -1, "expect PIXELS or STATS");
+    return 1;
+  }
+  return 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,99 @@
+#ifndef __I2C_STICK_ROI_H__
+#define __I2C_STICK_ROI_H__
+
+#include <stdint.h>
+#include "i2c_stick_fw_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Regions of interest
+// *******************
+//
+// Up to ROI_MAX_COUNT rectangles (col,row,width,height) on a thermal array of
+// cols x rows pixels. With at least one ROI set, the drivers only calculate
+// and filter the ROI pixels, and 'mv' reports either the ROI pixels (rect by
+// rect, row-major) or min,max,mean per ROI; without ROI the full frame is
+// reported as before.
+//
+// Derived from the rectangles at each change:
+// - compute_mask_: the ROI pixels plus a margin of ROI_MARGIN pixels; the
+//   bad pixel and deinterlace corrections read the neighbours of a pixel.
+// - span_: the union of the ROI pixels as runs within a row; disjoint, so
+//   the temporal filter visits every pixel once. Without ROI it is one span
+//   over the full frame.
+
+#define ROI_OUTPUT_PIXELS 0
+#define ROI_OUTPUT_STATS  1
+
+#define ROI_MARGIN 2
+#define ROI_MAX_PIXELS 768
+#define ROI_MAX_SPANS (ROI_MAX_COUNT * 24) // 24 rows max
+
+struct roi_rect_t
+{
+  uint8_t col_;
+  uint8_t row_;
+  uint8_t width_;
+  uint8_t height_;
+};
+
+struct roi_span_t
+{
+  uint16_t first_; // pixel number
+  uint16_t count_;
+};
+
+struct roi_set_t
+{
+  uint8_t cols_;
+  uint8_t rows_;
+  uint8_t count_; // 0 => off; full frame
+  uint8_t output_; // ROI_OUTPUT_*
+  uint8_t span_count_;
+  roi_rect_t rect_[ROI_MAX_COUNT];
+  roi_span_t span_[ROI_MAX_SPANS];
+  uint32_t compute_mask_[ROI_MAX_PIXELS / 32];
+};
+
+
+void roi_init(roi_set_t *set, uint8_t cols, uint8_t rows);
+void roi_clear(roi_set_t *set);
+// input: "col,row,width,height[;col,row,width,height...]"; append => keep the
+// current rectangles. 0 => ok; -1 => syntax or out of the array; -2 => too
+// many rectangles or pixels (the sum may not exceed the array size).
+int8_t roi_parse(roi_set_t *set, const char *input, uint8_t append);
+// "OFF" or "c,r,w,h;c,r,w,h"
+void roi_to_str(const roi_set_t *set, char *buf, uint16_t size);
+// column names after TA: "ROI0_[w*h],ROI1_[w*h]" or "ROI0_MIN,ROI0_MAX,ROI0_MEAN,..."
+void roi_header_to_str(const roi_set_t *set, char *buf, uint16_t size);
+const char *roi_output_to_str(uint8_t output);
+int8_t roi_output_from_str(const char *input);
+
+static inline uint8_t
+roi_is_active(const roi_set_t *set)
+{
+  return set->count_ > 0;
+}
+
+// number of values reported after TA
+uint16_t roi_output_count(const roi_set_t *set);
+
+// fill out[roi_output_count()] from a full frame; frame and out may not overlap.
+// The int16 variant converts with 'scale' (degC per LSB); INT16_MIN is invalid.
+void roi_extract_float(const roi_set_t *set, const float *frame, float *out);
+void roi_extract_int16(const roi_set_t *set, const int16_t *frame, float scale, float *out);
+
+// the cs answers ROI= and ROI_OUTPUT= of the thermal array drivers.
+void roi_cs(uint8_t sa, uint8_t channel_mask, const roi_set_t *set);
+// the cs_write settings ROI=, ROI+= and ROI_OUTPUT=, answered here.
+// 0 => input is not a ROI setting; 1 => answered; 2 => answered and the ROI
+// pixels changed, the caller restarts its temporal filter.
+uint8_t roi_cs_write(uint8_t sa, uint8_t channel_mask, roi_set_t *set, const char *input);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_ROI_H__
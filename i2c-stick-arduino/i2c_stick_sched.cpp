@@ -0,0 +1,99 @@
+#include "i2c_stick_sched.h"
+#include "i2c_stick.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static_assert(SCHED_MAX_SLAVES >= 128, "SCHED_MAX_SLAVES must cover all slave addresses");
+
+static uint8_t g_sched_list[SCHED_MAX_SLAVES]; // the enabled slave addresses
+static uint8_t g_sched_count;
+static uint8_t g_sched_valid;
+static uint32_t g_sched_build_ms;
+static uint32_t g_sched_period_ms[128]; // per slave address; 0 => unknown, poll every SCHED_MIN_POLL_MS
+static uint32_t g_sched_next_poll_ms[128];
+static uint32_t g_sched_member_mask[128/32]; // bit sa set => sa is in g_sched_list
+
+
+static uint8_t
+sched_is_enabled(uint8_t sa)
+{
+  int16_t spot = g_sa_list[sa].spot_;
+  return g_sa_list[sa].found_ && (!(g_sa_drv_register[spot].disabled_)) && (g_sa_drv_register[spot].drv_ > 0);
+}
+
+
+static void
+sched_build(uint32_t now_ms)
+{ // (re-)build the compact list; keep the deadlines of the slaves which were already in.
+  g_sched_count = 0;
+  for (uint8_t sa=0; sa<128; sa++)
+  {
+    uint32_t bit = 1UL << (sa & 31);
+    if (!sched_is_enabled(sa))
+    {
+      g_sched_member_mask[sa >> 5] &= ~bit;
+      continue;
+    }
+    if (!(g_sched_member_mask[sa >> 5] & bit))
+    { // new in the list
+      g_sched_member_mask[sa >> 5] |= bit;
+      g_sched_period_ms[sa] = 0;
+      g_sched_next_poll_ms[sa] = now_ms;
+    }
+    g_sched_list[g_sched_count++] = sa;
+  }
+  g_sched_build_ms = now_ms;
+  g_sched_valid = 1;
+}
+
+
+int16_t
+i2c_stick_sched_due(uint32_t now_ms)
+{ // returns the slave address which is the longest overdue, or -1 when none is due.
+  if ((!g_sched_valid) || ((now_ms - g_sched_build_ms) >= SCHED_REBUILD_MS))
+  { // pick up the changes of scan, dis, raw,...
+    sched_build(now_ms);
+  }
+
+  int16_t sa = -1;
+  int32_t most_overdue = -1;
+  for (uint8_t i=0; i<g_sched_count; i++)
+  {
+    int32_t overdue = (int32_t)(now_ms - g_sched_next_poll_ms[g_sched_list[i]]);
+    if (overdue > most_overdue)
+    {
+      most_overdue = overdue;
+      sa = g_sched_list[i];
+    }
+  }
+  return sa;
+}
+
+
+void
+i2c_stick_sched_done(uint8_t sa, uint8_t nd, uint32_t period_ms, uint32_t now_ms)
+{
+  if ((sa >= 128) || (!(g_sched_member_mask[sa >> 5] & (1UL << (sa & 31)))))
+  {
+    return;
+  }
+  if (nd)
+  { // next data is expected one period later; wake up a little early.
+    g_sched_period_ms[sa] = period_ms;
+    uint32_t wait_ms = period_ms - (period_ms >> 3);
+    if (wait_ms < SCHED_MIN_POLL_MS) wait_ms = SCHED_MIN_POLL_MS;
+    g_sched_next_poll_ms[sa] = now_ms + wait_ms;
+  } else
+  { // not yet there; poll again soon.
+    uint32_t wait_ms = g_sched_period_ms[sa] >> 5;
+    if (wait_ms < SCHED_MIN_POLL_MS) wait_ms = SCHED_MIN_POLL_MS;
+    g_sched_next_poll_ms[sa] = now_ms + wait_ms;
+  }
+}
+
+
+#ifdef __cplusplus
+}
+#endif
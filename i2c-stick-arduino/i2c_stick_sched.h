@@ -0,0 +1,30 @@
+#ifndef __I2C_STICK_SCHED_H__
+#define __I2C_STICK_SCHED_H__
+
+#include <stdint.h>
+#include "i2c_stick_fw_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Continuous mode scheduler
+// *************************
+//
+// Keeps a compact list of the enabled slaves, together with the time at
+// which the next new data is expected (from the refresh period reported by
+// the driver through `cmd_rp`). A slave is only polled for new data once its
+// deadline is (nearly) reached, instead of on every pass of the main loop.
+//
+// The timing is kept per slave address, so every enabled slave fits the
+// list (SCHED_MAX_SLAVES covers all 7-bit addresses).
+
+
+int16_t i2c_stick_sched_due(uint32_t now_ms);
+void i2c_stick_sched_done(uint8_t sa, uint8_t nd, uint32_t period_ms, uint32_t now_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_SCHED_H__
@@ -0,0 +1,76 @@
+#include "i2c_stick_scratch.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static uint32_t g_scratch_arena[(SCRATCH_ARENA_SIZE + 3) / 4];
+static uint32_t g_scratch_used; // bytes
+static uint32_t g_scratch_peak; // bytes
+
+
+void
+scratch_begin(scratch_scope_t *scope)
+{
+  scope->mark_ = g_scratch_used;
+}
+
+
+void *
+scratch_alloc(uint32_t n_bytes)
+{
+  n_bytes = (n_bytes + 3) & ~3UL;
+  if (n_bytes > (sizeof(g_scratch_arena) - g_scratch_used))
+  {
+    return NULL; // arena exhausted
+  }
+  void *p = (uint8_t *)g_scratch_arena + g_scratch_used;
+  g_scratch_used += n_bytes;
+  if (g_scratch_used > g_scratch_peak) g_scratch_peak = g_scratch_used;
+  return p;
+}
+
+
+void
+scratch_end(scratch_scope_t *scope)
+{
+  if (scope->mark_ < g_scratch_used)
+  {
+    g_scratch_used = scope->mark_;
+  }
+}
+
+
+uint32_t
+scratch_used()
+{
+  return g_scratch_used;
+}
+
+
+uint32_t
+scratch_peak()
+{
+  return g_scratch_peak;
+}
+
+
+uint32_t
+scratch_size()
+{
+  return sizeof(g_scratch_arena);
+}
+
+
+void
+scratch_reset_peak()
+{
+  g_scratch_peak = g_scratch_used;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
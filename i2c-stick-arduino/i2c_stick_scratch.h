@@ -0,0 +1,52 @@
+#ifndef __I2C_STICK_SCRATCH_H__
+#define __I2C_STICK_SCRATCH_H__
+
+#include <stdint.h>
+#include "i2c_stick_fw_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Scratch arena
+// *************
+//
+// The command paths need a few kilobytes of temporary memory (a frame of
+// measured values, raw data, an EEPROM dump, a memory read). Instead of
+// putting those arrays on the stack, they are taken from one statically
+// allocated arena of SCRATCH_ARENA_SIZE bytes.
+//
+// Allocations are released in scopes (last in, first out):
+//
+//   scratch_scope_t scope;
+//   scratch_begin(&scope);
+//   float *mv_list = (float *)scratch_alloc(769 * sizeof(float));
+//   ...
+//   scratch_end(&scope); // releases everything allocated since begin
+//
+// Scopes nest, e.g. 'mv' on a sensor that is not initialized yet holds the
+// measured values while the driver init dumps the EEPROM.
+// scratch_alloc returns NULL when the arena is exhausted; the caller
+// reports an error, nothing is overwritten.
+//
+// The arena is owned by the one holding the I2C bus lock (all command
+// paths and the acquisition run under that lock).
+
+struct scratch_scope_t
+{
+  uint32_t mark_;
+};
+
+void scratch_begin(scratch_scope_t *scope);
+void *scratch_alloc(uint32_t n_bytes); // 4-byte aligned, or NULL when the arena is exhausted
+void scratch_end(scratch_scope_t *scope);
+uint32_t scratch_used();
+uint32_t scratch_peak();
+uint32_t scratch_size();
+void scratch_reset_peak();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_SCRATCH_H__
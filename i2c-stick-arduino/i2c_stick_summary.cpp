@@ -0,0 +1,328 @@
+#include "i2c_stick_summary.h"
+#include "i2c_stick.h"
+#include "i2c_stick_cmd.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+void
+summary_init(summary_cfg_t *cfg)
+{
+  memset(cfg, 0, sizeof(summary_cfg_t));
+  cfg->bin_lo_ = 0.0f;
+  cfg->bin_hi_ = 100.0f;
+}
+
+
+int8_t
+summary_hist_parse(summary_cfg_t *cfg, const char *input)
+{
+  if (!strcmp(input, "OFF"))
+  {
+    cfg->bin_count_ = 0;
+    return 0;
+  }
+  const char *p_lo = strchr(input, ',');
+  if (p_lo == NULL) return -1;
+  const char *p_hi = strchr(p_lo+1, ',');
+  if (p_hi == NULL) return -1;
+  int16_t bin_count = atoi(input);
+  float lo = atof(p_lo+1);
+  float hi = atof(p_hi+1);
+  if ((bin_count < 1) || (bin_count > SUMMARY_MAX_BINS)) return -1;
+  if (!(lo < hi)) return -1;
+  cfg->bin_count_ = bin_count;
+  cfg->bin_lo_ = lo;
+  cfg->bin_hi_ = hi;
+  return 0;
+}
+
+
+static char *
+summary_append(char *dst, const char *end, const char *str)
+{ // copy str up to end (exclusive; keeps room for the terminator)
+  while ((*str) && (dst < end))
+  {
+    *dst++ = *str++;
+  }
+  *dst = '\0';
+  return dst;
+}
+
+
+static char *
+summary_append_int(char *dst, const char *end, int16_t value)
+{
+  char buf[8];
+  itoa(value, buf, 10);
+  return summary_append(dst, end, buf);
+}
+
+
+static char *
+summary_append_float(char *dst, const char *end, float value)
+{
+  char buf[16];
+  const char *p = my_dtostrf(value, 10, 2, buf);
+  while (*p == ' ') p++; // remove leading space
+  return summary_append(dst, end, p);
+}
+
+
+void
+summary_hist_to_str(const summary_cfg_t *cfg, char *buf, uint16_t size)
+{
+  char *p = buf;
+  const char *end = buf + size - 1;
+  *p = '\0';
+  if (cfg->bin_count_ == 0)
+  {
+    summary_append(p, end, "OFF");
+    return;
+  }
+  p = summary_append_int(p, end, cfg->bin_count_);
+  p = summary_append(p, end, ",");
+  p = summary_append_float(p, end, cfg->bin_lo_);
+  p = summary_append(p, end, ",");
+  summary_append_float(p, end, cfg->bin_hi_);
+}
+
+
+static void
+summary_columns_to_str(const summary_cfg_t *cfg, const char *stats, const char *bins, char *buf, uint16_t size)
+{
+  char *p = buf;
+  const char *end = buf + size - 1;
+  *p = '\0';
+  p = summary_append(p, end, stats);
+  if (cfg->bin_count_ > 0)
+  {
+    p = summary_append(p, end, bins);
+    p = summary_append_int(p, end, cfg->bin_count_);
+    summary_append(p, end, "]");
+  }
+}
+
+
+void
+summary_header_to_str(const summary_cfg_t *cfg, char *buf, uint16_t size)
+{
+  summary_columns_to_str(cfg, "MIN,MAX,MEAN,HOT_COL,HOT_ROW", ",HIST_[", buf, size);
+}
+
+
+void
+summary_unit_to_str(const summary_cfg_t *cfg, char *buf, uint16_t size)
+{
+  summary_columns_to_str(cfg, "DegC,DegC,DegC,px,px", ",count[", buf, size);
+}
+
+
+void
+summary_res_to_str(const summary_cfg_t *cfg, uint16_t lsb, char *buf, uint16_t size)
+{
+  char stats[32];
+  char *p = stats;
+  const char *end = stats + sizeof(stats) - 1;
+  for (uint8_t i=0; i<3; i++)
+  {
+    p = summary_append_int(p, end, lsb);
+    p = summary_append(p, end, ",");
+  }
+  summary_append(p, end, "1,1");
+  summary_columns_to_str(cfg, stats, ",1[", buf, size);
+}
+
+
+static void
+summary_finish(const summary_cfg_t *cfg, float lo, float hi, float sum, uint16_t n, uint16_t hot_pix, uint8_t cols, const uint16_t *bin_list, float *out)
+{
+  out[0] = n ? lo : NAN;
+  out[1] = n ? hi : NAN;
+  out[2] = n ? sum / n : NAN;
+  out[3] = n ? (hot_pix % cols) : NAN;
+  out[4] = n ? (hot_pix / cols) : NAN;
+  for (uint8_t b=0; b<cfg->bin_count_; b++)
+  {
+    out[SUMMARY_STAT_COUNT + b] = bin_list[b];
+  }
+}
+
+
+void
+summary_compute_float(const summary_cfg_t *cfg, const float *frame, uint8_t cols, const roi_span_t *span_list, uint8_t span_count, float *out)
+{
+  uint16_t bin_list[SUMMARY_MAX_BINS];
+  memset(bin_list, 0, sizeof(bin_list));
+  const int16_t last_bin = (int16_t)cfg->bin_count_ - 1;
+  const float bin_lo = cfg->bin_lo_;
+  const float bin_gain = cfg->bin_count_ / (cfg->bin_hi_ - cfg->bin_lo_);
+
+  float lo = INFINITY;
+  float hi = -INFINITY;
+  float sum = 0;
+  uint16_t n = 0;
+  uint16_t hot_pix = 0;
+  for (uint8_t s=0; s<span_count; s++)
+  {
+    uint16_t end = span_list[s].first_ + span_list[s].count_;
+    for (uint16_t pix=span_list[s].first_; pix<end; pix++)
+    {
+      float value = frame[pix];
+      if (value != value) continue; // NAN
+      lo = (value < lo) ? value : lo;
+      hot_pix = (value > hi) ? pix : hot_pix;
+      hi = (value > hi) ? value : hi;
+      sum += value;
+      n++;
+      if (last_bin >= 0)
+      {
+        float x = (value - bin_lo) * bin_gain;
+        int16_t b = (x <= 0.0f) ? 0 : ((x >= last_bin) ? last_bin : (int16_t)x);
+        bin_list[b]++;
+      }
+    }
+  }
+  summary_finish(cfg, lo, hi, sum, n, hot_pix, cols, bin_list, out);
+}
+
+
+void
+summary_compute_int16(const summary_cfg_t *cfg, const int16_t *frame, float scale, uint8_t cols, const roi_span_t *span_list, uint8_t span_count, float *out)
+{
+  uint16_t bin_list[SUMMARY_MAX_BINS];
+  memset(bin_list, 0, sizeof(bin_list));
+  const int16_t last_bin = (int16_t)cfg->bin_count_ - 1;
+  // bins in LSB: b = (value - bin_lo) * bin_count / bin_range, with
+  // (value - bin_lo) clamped to the range first.
+  const int32_t bin_lo = (int32_t)floorf(cfg->bin_lo_ / scale + 0.5f);
+  int32_t bin_range = (int32_t)floorf(cfg->bin_hi_ / scale + 0.5f) - bin_lo;
+  if (bin_range < 1) bin_range = 1;
+  const int32_t bin_count = cfg->bin_count_;
+
+  int16_t lo = INT16_MAX;
+  int16_t hi = INT16_MIN;
+  int32_t sum = 0;
+  uint16_t n = 0;
+  uint16_t hot_pix = 0;
+  for (uint8_t s=0; s<span_count; s++)
+  {
+    uint16_t end = span_list[s].first_ + span_list[s].count_;
+    for (uint16_t pix=span_list[s].first_; pix<end; pix++)
+    {
+      int16_t value = frame[pix];
+      if (value == INT16_MIN) continue; // invalid
+      lo = (value < lo) ? value : lo;
+      hot_pix = (value > hi) ? pix : hot_pix;
+      hi = (value > hi) ? value : hi;
+      sum += value;
+      n++;
+      if (last_bin >= 0)
+      {
+        int32_t x = (int32_t)value - bin_lo;
+        x = (x < 0) ? 0 : ((x >= bin_range) ? (bin_range - 1) : x);
+        bin_list[(x * bin_count) / bin_range]++;
+      }
+    }
+  }
+  summary_finish(cfg, lo * scale, hi * scale, sum * scale, n, hot_pix, cols, bin_list, out);
+}
+
+
+void
+summary_cs(uint8_t sa, uint8_t channel_mask, const summary_cfg_t *cfg)
+{
+  char buf[64];
+  send_cs_value(sa, channel_mask, "SUMMARY", cfg->is_enabled_ ? "ON" : "OFF");
+  summary_hist_to_str(cfg, buf, sizeof(buf));
+  send_cs_value(sa, channel_mask, "HIST", buf);
+}
+
+
+void
+summary_cs_mv(uint8_t sa, uint8_t channel_mask, const summary_cfg_t *cfg, const roi_set_t *roi, uint16_t lsb_ta, uint16_t lsb_to)
+{
+  char buf[128];
+  const char *end = buf + sizeof(buf) - 1;
+  char *p;
+  if (cfg->is_enabled_)
+  { // only the frame statistics follow TA
+    p = summary_append(buf, end, "TA,");
+    summary_header_to_str(cfg, p, end - p + 1);
+    send_cs_value(sa, channel_mask, "RO:MV_HEADER", buf);
+
+    p = summary_append(buf, end, "DegC,");
+    summary_unit_to_str(cfg, p, end - p + 1);
+    send_cs_value(sa, channel_mask, "RO:MV_UNIT", buf);
+
+    p = summary_append_int(buf, end, lsb_ta);
+    p = summary_append(p, end, ",");
+    summary_res_to_str(cfg, lsb_to, p, end - p + 1);
+    send_cs_value(sa, channel_mask, "RO:MV_RES", buf);
+    return;
+  }
+
+  // only the ROI values or the full frame follow TA
+  char count[8];
+  if (roi_is_active(roi))
+  {
+    p = summary_append(buf, end, "TA,");
+    roi_header_to_str(roi, p, end - p + 1);
+    itoa(roi_output_count(roi), count, 10);
+  } else
+  {
+    itoa(roi->cols_ * roi->rows_, count, 10);
+    p = summary_append(buf, end, "TA,TO_[");
+    p = summary_append(p, end, count);
+    summary_append(p, end, "]");
+  }
+  send_cs_value(sa, channel_mask, "RO:MV_HEADER", buf);
+
+  p = summary_append(buf, end, "DegC,DegC[");
+  p = summary_append(p, end, count);
+  summary_append(p, end, "]");
+  send_cs_value(sa, channel_mask, "RO:MV_UNIT", buf);
+
+  p = summary_append_int(buf, end, lsb_ta);
+  p = summary_append(p, end, ",");
+  p = summary_append_int(p, end, lsb_to);
+  p = summary_append(p, end, "[");
+  p = summary_append(p, end, count);
+  summary_append(p, end, "]");
+  send_cs_value(sa, channel_mask, "RO:MV_RES", buf);
+}
+
+
+uint8_t
+summary_cs_write(uint8_t sa, uint8_t channel_mask, summary_cfg_t *cfg, const char *input)
+{
+  const char *var_name = "SUMMARY=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  { // report the frame statistics instead of the pixels
+    int8_t r = -1;
+    if (!strcmp(input+strlen(var_name), "ON")) r = 1;
+    if (!strcmp(input+strlen(var_name), "OFF")) r = 0;
+    if (r >= 0) cfg->is_enabled_ = r;
+    send_cs_write_answer(sa, channel_mask, "SUMMARY", (r >= 0) ? 0 : -1, "expect ON or OFF");
+    return 1;
+  }
+  var_name = "HIST=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  {
+    int8_t r = summary_hist_parse(cfg, input+strlen(var_name));
+    send_cs_write_answer(sa, channel_mask, "HIST", r, "expect OFF or bins(1.." xstr(SUMMARY_MAX_BINS) "),lo,hi");
+    return 1;
+  }
+  return 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,74 @@
+#ifndef __I2C_STICK_SUMMARY_H__
+#define __I2C_STICK_SUMMARY_H__
+
+#include <stdint.h>
+#include "i2c_stick_fw_config.h"
+#include "i2c_stick_roi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Frame summary
+// *************
+//
+// Instead of every pixel, 'mv' reports TA followed by:
+//   MIN, MAX, MEAN, HOT_COL, HOT_ROW[, HIST_0..HIST_n-1]
+// computed in one pass over the frame (or over the ROI spans when ROI's are
+// set). HOT_COL/HOT_ROW locate the maximum. The optional histogram counts
+// the pixels in bin_count_ equal bins from bin_lo_ to bin_hi_ degC; values
+// outside the range go to the first or last bin. Invalid pixels (NAN, or
+// INT16_MIN for the int16 variant) are skipped; without any valid pixel the
+// statistics are NAN.
+
+#define SUMMARY_STAT_COUNT 5 // MIN, MAX, MEAN, HOT_COL, HOT_ROW
+
+struct summary_cfg_t
+{
+  uint8_t is_enabled_;
+  uint8_t bin_count_; // 0 => no histogram
+  float bin_lo_;
+  float bin_hi_;
+};
+
+
+void summary_init(summary_cfg_t *cfg);
+// input: "OFF" or "bins,lo,hi" (1..SUMMARY_MAX_BINS bins, lo < hi).
+// 0 => ok; -1 => syntax or outbound.
+int8_t summary_hist_parse(summary_cfg_t *cfg, const char *input);
+// "OFF" or "bins,lo,hi"
+void summary_hist_to_str(const summary_cfg_t *cfg, char *buf, uint16_t size);
+// the RO:MV_HEADER, RO:MV_UNIT and RO:MV_RES values after TA; lsb is the
+// resolution of the object temperature (LSB per degC).
+void summary_header_to_str(const summary_cfg_t *cfg, char *buf, uint16_t size);
+void summary_unit_to_str(const summary_cfg_t *cfg, char *buf, uint16_t size);
+void summary_res_to_str(const summary_cfg_t *cfg, uint16_t lsb, char *buf, uint16_t size);
+
+static inline uint16_t
+summary_output_count(const summary_cfg_t *cfg)
+{ // number of values reported after TA
+  return SUMMARY_STAT_COUNT + cfg->bin_count_;
+}
+
+// fill out[summary_output_count()] from the pixels in the spans of a frame
+// with 'cols' columns; frame and out may not overlap.
+// The int16 variant works on the raw values and converts the results with
+// 'scale' (degC per LSB).
+void summary_compute_float(const summary_cfg_t *cfg, const float *frame, uint8_t cols, const roi_span_t *span_list, uint8_t span_count, float *out);
+void summary_compute_int16(const summary_cfg_t *cfg, const int16_t *frame, float scale, uint8_t cols, const roi_span_t *span_list, uint8_t span_count, float *out);
+
+// the cs answers SUMMARY= and HIST= of the thermal array drivers.
+void summary_cs(uint8_t sa, uint8_t channel_mask, const summary_cfg_t *cfg);
+// the cs answers RO:MV_HEADER, RO:MV_UNIT and RO:MV_RES of the mv answer:
+// TA followed by the statistics, the ROI values or the full frame;
+// lsb_ta/lsb_to are the resolutions (LSB per degC) of TA and of the pixels.
+void summary_cs_mv(uint8_t sa, uint8_t channel_mask, const summary_cfg_t *cfg, const roi_set_t *roi, uint16_t lsb_ta, uint16_t lsb_to);
+// the cs_write settings SUMMARY= and HIST=, answered here.
+// 0 => input is not a summary setting; 1 => answered.
+uint8_t summary_cs_write(uint8_t sa, uint8_t channel_mask, summary_cfg_t *cfg, const char *input);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_SUMMARY_H__
@@ -3,6 +3,7 @@
 #include "i2c_stick_task.h"
 #include "i2c_stick_hal.h"
 #include "i2c_stick_dispatcher.h"
+#include "i2c_stick_cmd_table.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -18,6 +19,7 @@ handle_task(uint8_t channel_mask, char task)
   if (task == ';') // go-task
   {
     g_mode = MODE_CONTINUOUS;
+    i2c_stick_delta_reset(); // start with keyframes
     send_answer_chunk(channel_mask, ";:continuous mode", 1);
     return "";
   }
@@ -137,32 +139,7 @@ handle_task_help(uint8_t channel_mask)
   send_answer_chunk(channel_mask, "- 5  ==>  scan command alias", 1);
   send_answer_chunk(channel_mask, "", 1);
   send_answer_chunk(channel_mask, "Commands: 2+ character commands with new line required", 1);
-  send_answer_chunk(channel_mask, "- mlx  ==>  test uplink communication", 1);
-  send_answer_chunk(channel_mask, "- help ==>  this help!", 1);
-  send_answer_chunk(channel_mask, "- sos  ==>  more detailed help!", 1);
-  send_answer_chunk(channel_mask, "- fv   ==>  Firmware Version", 1);
-  send_answer_chunk(channel_mask, "- bi   ==>  Board Info", 1);
-  send_answer_chunk(channel_mask, "- scan ==>  SCAN I2C bus for slaves", 1);
-  send_answer_chunk(channel_mask, "- ls   ==>  List Slaves (already discovered with 'scan')", 1);
-  send_answer_chunk(channel_mask, "- dis  ==>  DIsable Slave (for continuous dump mode)", 1);
-  send_answer_chunk(channel_mask, "- i2c  ==>  low level I2C", 1);
-  send_answer_chunk(channel_mask, "- ch   ==>  Configuration of Host (I2C freq, output format)", 1);  
-#ifdef BUFFER_COMMAND_ENABLE
-  send_answer_chunk(channel_mask, "- buf  ==>  buffer command", 1);
-#endif // BUFFER_COMMAND_ENABLE
-  send_answer_chunk(channel_mask, "", 1);
-  send_answer_chunk(channel_mask, "- as   ==>  Active Slave", 1);
-  send_answer_chunk(channel_mask, "- mv   ==>  Measure Value of the sensor", 1);
-  send_answer_chunk(channel_mask, "- sn   ==>  Serial Number of slave", 1);
-  send_answer_chunk(channel_mask, "- cs   ==>  Configuration of Slave", 1);
-  send_answer_chunk(channel_mask, "- nd   ==>  New Data available", 1);
-  send_answer_chunk(channel_mask, "- mr   ==>  Memory Read", 1);
-  send_answer_chunk(channel_mask, "- mw   ==>  Memory Write", 1);
-  send_answer_chunk(channel_mask, "- raw  ==>  RAW sensor data dump", 1);
-  send_answer_chunk(channel_mask, "", 1);
-  send_answer_chunk(channel_mask, "- la   ==>  List Applications", 1);
-  send_answer_chunk(channel_mask, "- app  ==>  APPlication id", 1);
-  send_answer_chunk(channel_mask, "- ca   ==>  Configuration of Application", 1);
+  i2c_stick_cmd_help(channel_mask); // generated from the command list in context.yaml
   send_answer_chunk(channel_mask, "", 1);
   send_answer_chunk(channel_mask, "more at https://github.com/melexis/i2c-stick", 1);
 }
@@ -0,0 +1,340 @@
+#include "i2c_stick_temporal.h"
+
+#include <string.h>
+#include <math.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TEMPORAL_IIR_STEP_GAIN 0.9f // part of a step followed by the IIR
+
+
+static temporal_gain_t
+temporal_gain(float gain)
+{
+#ifdef THERMAL_STORAGE_INT16
+  int32_t q = (int32_t)(gain * 32768.0f + 0.5f);
+  return (q > 32767) ? 32767 : q;
+#else
+  return gain;
+#endif // THERMAL_STORAGE_INT16
+}
+
+
+static inline temporal_acc_t
+temporal_abs(temporal_acc_t x)
+{
+  return (x < 0) ? -x : x;
+}
+
+
+static inline thermal_t
+temporal_to_thermal(temporal_acc_t x)
+{ // saturate; never produces THERMAL_INVALID
+#ifdef THERMAL_STORAGE_INT16
+  return (thermal_t)((x > 32767) ? 32767 : ((x < -32767) ? -32767 : x));
+#else
+  return x;
+#endif // THERMAL_STORAGE_INT16
+}
+
+
+static inline temporal_acc_t
+temporal_mul(temporal_acc_t x, temporal_gain_t gain)
+{ // x is limited to the thermal_t range, such that Q15 products fit in 32 bit.
+#ifdef THERMAL_STORAGE_INT16
+  return ((temporal_acc_t)temporal_to_thermal(x) * gain + 16384) >> 15;
+#else
+  return x * gain;
+#endif // THERMAL_STORAGE_INT16
+}
+
+
+static inline temporal_acc_t
+temporal_div(temporal_acc_t sum, uint8_t n)
+{
+#ifdef THERMAL_STORAGE_INT16
+  return (sum + ((sum >= 0) ? (n/2) : -(n/2))) / n;
+#else
+  return sum / n;
+#endif // THERMAL_STORAGE_INT16
+}
+
+
+static uint8_t
+temporal_blocks_needed(uint8_t type, uint8_t depth)
+{
+  if (type == TEMPORAL_FILTER_ALPHA_BETA) return 2;
+  if (type == TEMPORAL_FILTER_MOVING_AVERAGE) return depth;
+  return 1;
+}
+
+
+int8_t
+temporal_filter_init(temporal_filter_t *filter, pool_t *pool, uint16_t count)
+{
+  memset(filter, 0, sizeof(temporal_filter_t));
+  filter->pool_ = pool;
+  filter->count_ = count;
+  int8_t r = temporal_filter_configure(filter, TEMPORAL_FILTER_IIR, 8, 2.5f);
+  if (r != 0)
+  { // same settings, without history
+    filter->type_ = TEMPORAL_FILTER_IIR;
+    filter->depth_ = 8;
+    filter->threshold_degc_ = 2.5f;
+    filter->threshold_ = thermal_from_float(2.5f);
+    filter->gain_a_ = temporal_gain(1.0f / 8);
+  }
+  return r;
+}
+
+
+int8_t
+temporal_filter_configure(temporal_filter_t *filter, uint8_t type, uint8_t depth, float threshold_degc)
+{
+  if ((type < TEMPORAL_FILTER_IIR) || (type > TEMPORAL_FILTER_MOVING_AVERAGE)) return -1;
+  if ((depth < 1) || (depth > TEMPORAL_FILTER_MAX_DEPTH)) return -1;
+  if ((type == TEMPORAL_FILTER_ALPHA_BETA) && (depth < 2)) return -1;
+  if ((type == TEMPORAL_FILTER_MOVING_AVERAGE) && (depth > TEMPORAL_FILTER_MAX_BLOCKS)) return -1;
+
+  uint8_t available = filter->pool_->capacity_ - pool_used(filter->pool_) + filter->block_count_;
+  if (temporal_blocks_needed(type, depth) > available) return -2;
+
+  temporal_filter_reset(filter);
+  filter->type_ = type;
+  filter->depth_ = depth;
+  filter->threshold_degc_ = threshold_degc;
+  if (threshold_degc > 0)
+  {
+    filter->threshold_ = thermal_from_float(threshold_degc);
+  } else
+  { // larger than any difference of 2 thermal_t
+#ifdef THERMAL_STORAGE_INT16
+    filter->threshold_ = 65536L;
+#else
+    filter->threshold_ = INFINITY;
+#endif // THERMAL_STORAGE_INT16
+  }
+
+  float n = depth;
+  filter->gain_a_ = temporal_gain(1.0f / n);
+  filter->gain_b_ = 0;
+  if (type == TEMPORAL_FILTER_ALPHA_BETA)
+  {
+    filter->gain_a_ = temporal_gain(2.0f * (2.0f * n - 1.0f) / (n * (n + 1.0f)));
+    filter->gain_b_ = temporal_gain(6.0f / (n * (n + 1.0f)));
+  }
+  return temporal_filter_reserve(filter); // the capacity is checked above
+}
+
+
+int8_t
+temporal_filter_reserve(temporal_filter_t *filter)
+{
+  uint8_t needed = temporal_blocks_needed(filter->type_, filter->depth_);
+  for (uint8_t b=filter->block_count_; b<needed; b++)
+  {
+    filter->block_[b] = (thermal_t *)pool_alloc(filter->pool_);
+    if (filter->block_[b] == NULL)
+    {
+      temporal_filter_reset(filter);
+      return -2;
+    }
+    filter->block_count_ = b + 1;
+  }
+  filter->is_filled_ = 0;
+  return 0;
+}
+
+
+void
+temporal_filter_restart(temporal_filter_t *filter)
+{
+  filter->is_filled_ = 0;
+  filter->head_ = 0;
+}
+
+
+void
+temporal_filter_reset(temporal_filter_t *filter)
+{
+  for (uint8_t b=0; b<filter->block_count_; b++)
+  {
+    pool_free(filter->pool_, filter->block_[b]);
+    filter->block_[b] = NULL;
+  }
+  filter->block_count_ = 0;
+  temporal_filter_restart(filter);
+}
+
+
+static int8_t
+temporal_filter_fill(temporal_filter_t *filter, thermal_t *to_list, thermal_t fill_value)
+{ // start all history blocks at the current frame.
+  uint8_t needed = temporal_blocks_needed(filter->type_, filter->depth_);
+  if (filter->block_count_ < needed)
+  {
+    return -1;
+  }
+
+  for (uint16_t pix=0; pix<filter->count_; pix++)
+  {
+    to_list[pix] = thermal_is_valid(to_list[pix]) ? to_list[pix] : fill_value;
+  }
+  uint8_t value_blocks = (filter->type_ == TEMPORAL_FILTER_ALPHA_BETA) ? 1 : needed;
+  for (uint8_t b=0; b<needed; b++)
+  { // alpha-beta: the velocity starts at 0
+    if (b < value_blocks)
+    {
+      memcpy(filter->block_[b], to_list, filter->count_ * sizeof(thermal_t));
+    } else
+    {
+      memset(filter->block_[b], 0, filter->count_ * sizeof(thermal_t));
+    }
+  }
+  filter->head_ = 0;
+  filter->is_filled_ = 1;
+  return 0;
+}
+
+
+static void
+temporal_filter_iir(temporal_filter_t *filter, thermal_t *to_list, uint16_t first, uint16_t end)
+{
+  thermal_t *state = filter->block_[0];
+  const temporal_acc_t threshold = filter->threshold_;
+  const temporal_gain_t gain = filter->gain_a_;
+  const temporal_gain_t step_gain = temporal_gain(TEMPORAL_IIR_STEP_GAIN);
+  for (uint16_t pix=first; pix<end; pix++)
+  {
+    temporal_acc_t s = state[pix];
+    temporal_acc_t to = thermal_is_valid(to_list[pix]) ? (temporal_acc_t)to_list[pix] : s;
+    temporal_acc_t d = to - s;
+    temporal_gain_t g = (temporal_abs(d) >= threshold) ? step_gain : gain;
+    thermal_t out = temporal_to_thermal(s + temporal_mul(d, g));
+    state[pix] = out;
+    to_list[pix] = out;
+  }
+}
+
+
+static void
+temporal_filter_alpha_beta(temporal_filter_t *filter, thermal_t *to_list, uint16_t first, uint16_t end)
+{
+  thermal_t *position = filter->block_[0];
+  thermal_t *velocity = filter->block_[1];
+  const temporal_acc_t threshold = filter->threshold_;
+  const temporal_gain_t alpha = filter->gain_a_;
+  const temporal_gain_t beta = filter->gain_b_;
+  for (uint16_t pix=first; pix<end; pix++)
+  {
+    temporal_acc_t v = velocity[pix];
+    temporal_acc_t x = (temporal_acc_t)position[pix] + v; // prediction
+    temporal_acc_t to = thermal_is_valid(to_list[pix]) ? (temporal_acc_t)to_list[pix] : x;
+    temporal_acc_t r = to - x;
+    uint8_t is_step = (temporal_abs(r) >= threshold);
+    thermal_t x_new = temporal_to_thermal(is_step ? to : (x + temporal_mul(r, alpha)));
+    thermal_t v_new = temporal_to_thermal(is_step ? 0 : (v + temporal_mul(r, beta)));
+    position[pix] = x_new;
+    velocity[pix] = v_new;
+    to_list[pix] = x_new;
+  }
+}
+
+
+static void
+temporal_filter_moving_average(temporal_filter_t *filter, thermal_t *to_list, uint16_t first, uint16_t end)
+{
+  const uint8_t n = filter->depth_;
+  thermal_t *oldest = filter->block_[filter->head_];
+  const temporal_acc_t threshold = filter->threshold_;
+  for (uint16_t pix=first; pix<end; pix++)
+  {
+    temporal_acc_t sum = 0;
+    for (uint8_t b=0; b<n; b++)
+    {
+      sum += filter->block_[b][pix];
+    }
+    temporal_acc_t mean = temporal_div(sum, n);
+    temporal_acc_t to = thermal_is_valid(to_list[pix]) ? (temporal_acc_t)to_list[pix] : mean;
+    uint8_t is_step = (temporal_abs(to - mean) >= threshold);
+    sum += to - oldest[pix];
+    oldest[pix] = temporal_to_thermal(to);
+    to_list[pix] = temporal_to_thermal(is_step ? to : temporal_div(sum, n));
+    for (uint8_t b=0; b<n; b++)
+    { // a step restarts the average at the new value
+      filter->block_[b][pix] = is_step ? to_list[pix] : filter->block_[b][pix];
+    }
+  }
+}
+
+
+int8_t
+temporal_filter_apply(temporal_filter_t *filter, thermal_t *to_list, thermal_t fill_value)
+{
+  roi_span_t span = { 0, filter->count_ };
+  return temporal_filter_apply_spans(filter, to_list, fill_value, &span, 1);
+}
+
+
+int8_t
+temporal_filter_apply_spans(temporal_filter_t *filter, thermal_t *to_list, thermal_t fill_value, const roi_span_t *span_list, uint8_t span_count)
+{
+  if (!filter->is_filled_)
+  {
+    return temporal_filter_fill(filter, to_list, fill_value);
+  }
+  if ((filter->type_ < TEMPORAL_FILTER_IIR) || (filter->type_ > TEMPORAL_FILTER_MOVING_AVERAGE))
+  {
+    return -1;
+  }
+  for (uint8_t i=0; i<span_count; i++)
+  {
+    uint16_t first = span_list[i].first_;
+    uint16_t end = first + span_list[i].count_;
+    if (end > filter->count_) end = filter->count_;
+    switch (filter->type_)
+    {
+      case TEMPORAL_FILTER_IIR:
+        temporal_filter_iir(filter, to_list, first, end);
+        break;
+      case TEMPORAL_FILTER_ALPHA_BETA:
+        temporal_filter_alpha_beta(filter, to_list, first, end);
+        break;
+      case TEMPORAL_FILTER_MOVING_AVERAGE:
+        temporal_filter_moving_average(filter, to_list, first, end);
+        break;
+    }
+  }
+  if (filter->type_ == TEMPORAL_FILTER_MOVING_AVERAGE)
+  { // one frame older for every pixel, also the ones outside the spans.
+    filter->head_ = (filter->head_ + 1) % filter->depth_;
+  }
+  return 0;
+}
+
+
+const char *
+temporal_filter_type_to_str(uint8_t type)
+{
+  if (type == TEMPORAL_FILTER_IIR) return "IIR";
+  if (type == TEMPORAL_FILTER_ALPHA_BETA) return "AB";
+  if (type == TEMPORAL_FILTER_MOVING_AVERAGE) return "MA";
+  return "?";
+}
+
+
+int8_t
+temporal_filter_type_from_str(const char *input)
+{
+  if (!strcmp(input, "IIR")) return TEMPORAL_FILTER_IIR;
+  if (!strcmp(input, "AB")) return TEMPORAL_FILTER_ALPHA_BETA;
+  if (!strcmp(input, "MA")) return TEMPORAL_FILTER_MOVING_AVERAGE;
+  return -1;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
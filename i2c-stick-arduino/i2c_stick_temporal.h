@@ -0,0 +1,97 @@
+#ifndef __I2C_STICK_TEMPORAL_H__
+#define __I2C_STICK_TEMPORAL_H__
+
+#include <stdint.h>
+#include "i2c_stick_fw_config.h"
+#include "i2c_stick_thermal.h"
+#include "i2c_stick_pool.h"
+#include "i2c_stick_roi.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Temporal filters
+// ****************
+//
+// Per pixel filtering of consecutive frames, in place on a contiguous
+// thermal_t array:
+//
+// - IIR: state += (to - state) / depth
+// - ALPHA_BETA: position and velocity tracker; the gains correspond to a
+//   'depth' frame least squares fit (alpha = 2(2N-1)/(N(N+1)),
+//   beta = 6/(N(N+1))), depth >= 2.
+// - MOVING_AVERAGE: mean of the last 'depth' frames
+//   (max TEMPORAL_FILTER_MAX_BLOCKS).
+//
+// A difference between the new value and the filter of at least
+// 'threshold' degC is a step: the IIR follows 90% of it, the others restart
+// at the new value. threshold <= 0 disables the step detection.
+// Out of range pixels (see thermal_is_valid) do not change the filter.
+//
+// The history is kept in blocks of 'count' thermal_t taken from the
+// driver's pool (IIR 1, alpha-beta 2, moving average 'depth' blocks). They
+// are reserved when the filter is configured, so a filter which is accepted
+// never runs out of history later on. The loops select instead of branch
+// per pixel, so they can be vectorised.
+
+#define TEMPORAL_FILTER_IIR            1
+#define TEMPORAL_FILTER_ALPHA_BETA     2
+#define TEMPORAL_FILTER_MOVING_AVERAGE 3
+
+#define TEMPORAL_FILTER_MAX_DEPTH 64
+
+#ifdef THERMAL_STORAGE_INT16
+typedef int32_t temporal_acc_t; // sums and differences of thermal_t
+typedef int32_t temporal_gain_t; // Q15
+#else
+typedef float temporal_acc_t;
+typedef float temporal_gain_t;
+#endif // THERMAL_STORAGE_INT16
+
+struct temporal_filter_t
+{
+  uint8_t type_;
+  uint8_t depth_;
+  uint8_t is_filled_; // 0 => the next frame (re)starts the filter
+  uint8_t head_; // moving average: block with the oldest frame
+  uint8_t block_count_;
+  uint16_t count_; // pixels per block
+  float threshold_degc_;
+  temporal_acc_t threshold_;
+  temporal_gain_t gain_a_; // IIR: 1/depth; alpha-beta: alpha
+  temporal_gain_t gain_b_; // alpha-beta: beta
+  pool_t *pool_; // objects of (at least) count_ thermal_t
+  thermal_t *block_[TEMPORAL_FILTER_MAX_BLOCKS];
+};
+
+
+// IIR, depth 8, threshold 2.5 degC; 0 => ok; -2 => not enough blocks in the
+// pool (configured, but without history; see temporal_filter_reserve).
+int8_t temporal_filter_init(temporal_filter_t *filter, pool_t *pool, uint16_t count);
+// 0 => ok; -1 => invalid type or depth; -2 => not enough blocks in the pool.
+// On success the history blocks are reserved and the filter restarts at the
+// next frame; on failure the filter keeps its configuration and history.
+int8_t temporal_filter_configure(temporal_filter_t *filter, uint8_t type, uint8_t depth, float threshold_degc);
+// take the history blocks of the current configuration; 0 => ok; -2 => not
+// enough blocks in the pool.
+int8_t temporal_filter_reserve(temporal_filter_t *filter);
+// keep the history blocks; the filter restarts at the next frame.
+void temporal_filter_restart(temporal_filter_t *filter);
+// release the history; temporal_filter_reserve takes it again.
+void temporal_filter_reset(temporal_filter_t *filter);
+// 0 => ok; -1 => no history reserved (to_list is not changed).
+// fill_value replaces out of range pixels at the (re)start.
+int8_t temporal_filter_apply(temporal_filter_t *filter, thermal_t *to_list, thermal_t fill_value);
+// same, for the pixels in the spans only (regions of interest); a (re)start
+// still fills the history from the whole frame.
+int8_t temporal_filter_apply_spans(temporal_filter_t *filter, thermal_t *to_list, thermal_t fill_value, const roi_span_t *span_list, uint8_t span_count);
+
+const char *temporal_filter_type_to_str(uint8_t type);
+int8_t temporal_filter_type_from_str(const char *input);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_TEMPORAL_H__
@@ -0,0 +1,129 @@
+#ifndef __I2C_STICK_THERMAL_H__
+#define __I2C_STICK_THERMAL_H__
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "i2c_stick_fw_config.h"
+#include "i2c_stick_fast_math.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Thermal pixel storage
+// *********************
+//
+// The per pixel state of the thermal arrays (last To frame, IIR history) is
+// kept as thermal_t. That is float by default, or int16 fixed point with
+// THERMAL_Q_FRAC_BITS fractional bits when THERMAL_STORAGE_INT16 is defined;
+// Q5 is 1/32 degC, the resolution of the HEX and BIN output, with a range of
+// +/-1024 degC. Values out of range saturate, NAN is stored as
+// THERMAL_INVALID.
+//
+// The To calculation and the pixel corrections of the vendor libraries work
+// in float; the filters (temporal, deinterlace) work on thermal_t directly,
+// so in fixed point mode they are integer only.
+
+#ifdef THERMAL_STORAGE_INT16
+typedef int16_t thermal_t;
+#define THERMAL_INVALID INT16_MIN
+#define THERMAL_Q_ONE (1L << THERMAL_Q_FRAC_BITS)
+#else
+typedef float thermal_t;
+#endif // THERMAL_STORAGE_INT16
+
+
+static inline thermal_t
+thermal_from_float(float x)
+{
+#ifdef THERMAL_STORAGE_INT16
+  if (x != x) return THERMAL_INVALID; // NAN
+  float q = x * (float)THERMAL_Q_ONE;
+  if (q >= 32767.0f) return 32767;
+  if (q <= -32767.0f) return -32767;
+  return (int16_t)((q >= 0.0f) ? (q + 0.5f) : (q - 0.5f));
+#else
+  return x;
+#endif // THERMAL_STORAGE_INT16
+}
+
+
+static inline float
+thermal_to_float(thermal_t x)
+{
+#ifdef THERMAL_STORAGE_INT16
+  if (x == THERMAL_INVALID) return NAN;
+  return x * (1.0f / THERMAL_Q_ONE);
+#else
+  return x;
+#endif // THERMAL_STORAGE_INT16
+}
+
+
+static inline void
+thermal_list_from_float(thermal_t *dst, const float *src, uint16_t count)
+{
+#ifdef THERMAL_STORAGE_INT16
+  for (uint16_t i=0; i<count; i++)
+  {
+    dst[i] = thermal_from_float(src[i]);
+  }
+#else
+  if (dst != src) memcpy(dst, src, count * sizeof(float));
+#endif // THERMAL_STORAGE_INT16
+}
+
+
+static inline void
+thermal_list_to_float(float *dst, const thermal_t *src, uint16_t count)
+{
+#ifdef THERMAL_STORAGE_INT16
+  for (uint16_t i=0; i<count; i++)
+  {
+    dst[i] = thermal_to_float(src[i]);
+  }
+#else
+  if (dst != src) memcpy(dst, src, count * sizeof(float));
+#endif // THERMAL_STORAGE_INT16
+}
+
+
+static inline uint8_t
+thermal_is_valid(thermal_t x)
+{ // plausible object temperature: -100..1000 degC
+#ifdef THERMAL_STORAGE_INT16
+  return (x != THERMAL_INVALID) && (thermal_from_float(-100.0f) <= x) && (x <= thermal_from_float(1000.0f));
+#else
+  return (-100 <= x) && (x <= 1000);
+#endif // THERMAL_STORAGE_INT16
+}
+
+
+static inline uint8_t
+thermal_differs(thermal_t a, thermal_t b, thermal_t threshold)
+{ // |a - b| > threshold
+#ifdef THERMAL_STORAGE_INT16
+  int32_t d = (int32_t)a - b;
+  return ((d < 0) ? -d : d) > threshold;
+#else
+  return fabs(a - b) > threshold;
+#endif // THERMAL_STORAGE_INT16
+}
+
+
+#ifdef THERMAL_STORAGE_INT16
+#define thermal_median3 median3s
+#define thermal_median4 median4s
+#define thermal_median6_self2 median6s_self2
+#else
+#define thermal_median3 median3f
+#define thermal_median4 median4f
+#define thermal_median6_self2 median6f_self2
+#endif // THERMAL_STORAGE_INT16
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_THERMAL_H__
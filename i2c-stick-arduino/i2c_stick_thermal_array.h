@@ -0,0 +1,203 @@
+#ifndef __I2C_STICK_THERMAL_ARRAY_H__
+#define __I2C_STICK_THERMAL_ARRAY_H__
+
+#include <stdint.h>
+#include <string.h>
+#include "i2c_stick_fw_config.h"
+#include "i2c_stick_thermal.h"
+#include "i2c_stick_temporal.h"
+#include "i2c_stick_roi.h"
+#include "i2c_stick_summary.h"
+
+// Thermal array pipeline
+// **********************
+//
+// The processing stages shared by the thermal array drivers, after the To
+// calculation of the sensor library:
+//
+//   deinterlace -> temporal filter -> output (summary, ROI or full frame)
+//
+// thermal_array_t<ROWS, COLS> is instantiated once per array geometry
+// (MLX90640: 24x32, MLX90641: 12x16); the dimensions are compile time
+// constants, so the loops get fixed trip counts. The acquisition, the To
+// calculation and the bad pixel correction stay in the sensor libraries:
+// their calibration layouts and equations differ per sensor.
+//
+// C++ only; the drivers include it outside their extern "C" block.
+
+#ifdef __cplusplus
+
+// the output stage for float frames, and for int16 (thermal_t) frames in
+// fixed point mode.
+static inline void
+thermal_array_summary(const summary_cfg_t *cfg, const float *frame, uint8_t cols, const roi_set_t *roi, float *out)
+{
+  summary_compute_float(cfg, frame, cols, roi->span_, roi->span_count_, out);
+}
+
+
+static inline void
+thermal_array_extract(const roi_set_t *roi, const float *frame, float *out)
+{
+  roi_extract_float(roi, frame, out);
+}
+
+
+static inline void
+thermal_array_copy(float *dst, const float *src, uint16_t count)
+{
+  if (dst != src) memcpy(dst, src, count * sizeof(float));
+}
+
+
+#ifdef THERMAL_STORAGE_INT16
+static inline void
+thermal_array_summary(const summary_cfg_t *cfg, const thermal_t *frame, uint8_t cols, const roi_set_t *roi, float *out)
+{
+  summary_compute_int16(cfg, frame, 1.0f / THERMAL_Q_ONE, cols, roi->span_, roi->span_count_, out);
+}
+
+
+static inline void
+thermal_array_extract(const roi_set_t *roi, const thermal_t *frame, float *out)
+{
+  roi_extract_int16(roi, frame, 1.0f / THERMAL_Q_ONE, out);
+}
+
+
+static inline void
+thermal_array_copy(float *dst, const thermal_t *src, uint16_t count)
+{
+  thermal_list_to_float(dst, src, count);
+}
+#endif // THERMAL_STORAGE_INT16
+
+
+template <uint8_t ROWS, uint8_t COLS>
+struct thermal_array_t
+{
+  static constexpr uint8_t rows_ = ROWS;
+  static constexpr uint8_t cols_ = COLS;
+  static constexpr uint16_t pixels_ = (uint16_t)ROWS * COLS;
+
+  static_assert((ROWS >= 2) && (COLS >= 2), "the deinterlace filter needs two neighbours");
+  static_assert(pixels_ <= ROI_MAX_PIXELS, "ROI compute mask too small for this array");
+
+  struct block_t
+  { // temporal filter history; one frame
+    thermal_t state_[pixels_];
+  };
+
+  // pixels of 'subpage' (chess pattern) deviating more than 0.7 from the
+  // median of their 4-neighbours (other sub-page) are replaced by that median.
+  // Only pixels of 'subpage' are written, their neighbours are never modified;
+  // so it works in place.
+  static void
+  deinterlace(thermal_t *to_list, uint8_t subpage)
+  {
+    const thermal_t threshold = thermal_from_float(0.7f);
+    for (uint8_t row=0; row<ROWS; row++)
+    {
+      thermal_t *cur = &to_list[row * COLS];
+      const thermal_t *up = (row > 0) ? (cur - COLS) : NULL;
+      const thermal_t *down = (row < ROWS-1) ? (cur + COLS) : NULL;
+      uint8_t col = (subpage ^ row ^ 0x01) & 0x01;
+      if ((up == NULL) || (down == NULL))
+      {
+        for (; col<COLS; col+=2)
+        {
+          deinterlace_border(cur, up, down, col, threshold);
+        }
+        continue;
+      }
+      if (col == 0)
+      {
+        deinterlace_border(cur, up, down, col, threshold);
+        col += 2;
+      }
+      for (; col<COLS-1; col+=2)
+      { // inner pixels: all 4 neighbours
+        thermal_t self = cur[col];
+        thermal_t a = thermal_median6_self2(self, up[col], down[col], cur[col-1], cur[col+1]);
+        if (thermal_differs(a, self, threshold))
+        {
+          cur[col] = a;
+        }
+      }
+      if (col == COLS-1)
+      {
+        deinterlace_border(cur, up, down, col, threshold);
+      }
+    }
+  }
+
+  // temporal filter over the ROI spans, or over the full frame without ROI.
+  // 0 => ok; -1 => the filter has no history reserved (frame unchanged).
+  static int8_t
+  apply_filter(temporal_filter_t *filter, const roi_set_t *roi, thermal_t *to_list, float ta)
+  {
+    if (roi_is_active(roi))
+    {
+      return temporal_filter_apply_spans(filter, to_list, thermal_from_float(ta), roi->span_, roi->span_count_);
+    }
+    return temporal_filter_apply(filter, to_list, thermal_from_float(ta));
+  }
+
+  // same, for a float frame (the work frame of the To calculation).
+  static int8_t
+  apply_filter_float(temporal_filter_t *filter, const roi_set_t *roi, float *frame, float ta)
+  {
+#ifdef THERMAL_STORAGE_INT16
+    thermal_t to_list[pixels_];
+    thermal_list_from_float(to_list, frame, pixels_);
+#else
+    thermal_t *to_list = frame;
+#endif // THERMAL_STORAGE_INT16
+    int8_t r = apply_filter(filter, roi, to_list, ta);
+    thermal_list_to_float(frame, to_list, pixels_);
+    return r;
+  }
+
+  // fill out with the statistics (summary), the ROI values, or the full
+  // frame; returns the number of values. frame and out may only overlap
+  // for the full frame, when they are the same.
+  template <typename pixel_t>
+  static uint16_t
+  output(const summary_cfg_t *summary, const roi_set_t *roi, const pixel_t *frame, float *out)
+  {
+    if (summary->is_enabled_)
+    {
+      thermal_array_summary(summary, frame, COLS, roi, out);
+      return summary_output_count(summary);
+    }
+    if (roi_is_active(roi))
+    {
+      thermal_array_extract(roi, frame, out);
+      return roi_output_count(roi);
+    }
+    thermal_array_copy(out, frame, pixels_);
+    return pixels_;
+  }
+
+private:
+  static void
+  deinterlace_border(thermal_t *cur, const thermal_t *up, const thermal_t *down, uint8_t col, thermal_t threshold)
+  { // the available neighbours and the pixel itself.
+    thermal_t self = cur[col];
+    thermal_t n[3];
+    uint8_t count = 0;
+    if (up != NULL) n[count++] = up[col];
+    if (down != NULL) n[count++] = down[col];
+    if (col > 0) n[count++] = cur[col-1];
+    if (col < COLS-1) n[count++] = cur[col+1];
+    thermal_t a = (count == 2) ? thermal_median3(n[0], n[1], self) : thermal_median4(n[0], n[1], n[2], self);
+    if (thermal_differs(a, self, threshold))
+    {
+      cur[col] = a;
+    }
+  }
+};
+
+#endif // __cplusplus
+
+#endif // __I2C_STICK_THERMAL_ARRAY_H__
@@ -0,0 +1,88 @@
+#ifndef __I2C_STICK_THERMAL_TO_H__
+#define __I2C_STICK_THERMAL_TO_H__
+
+#include <stdint.h>
+#include <math.h>
+#include "i2c_stick_fast_math.h"
+
+// Object temperature of the thermal arrays
+// ****************************************
+//
+// The MLX90640 and MLX90641 libraries compensate the pixel data each in their
+// own way (calibration layout, sub-page pattern), but the final step is the
+// same: from the compensated IR signal and sensitivity to To, with the
+// ksTo/ct temperature ranges (4 for the MLX90640, 8 for the MLX90641).
+//
+// thermal_calculate_to<PIXELS, RANGES> runs that step over the PIXELS pixels
+// the library supplies in pixel_list (e.g. the 384 pixels of an MLX90640
+// sub-page), or over pixels 0..PIXELS-1 when pixel_list is NULL; a
+// compensate(pixel, &ir, &alpha) functor gives the compensated IR signal and
+// sensitivity. Pixels outside pixel_mask (NULL => all) are skipped, their
+// result is left untouched.
+//
+// C++ only.
+
+#ifdef __cplusplus
+
+template <uint8_t RANGES>
+struct thermal_to_cfg_t
+{
+  float ta_tr_;             // taTr: the reflected and ambient radiation
+  float ks_to_sx_;          // ksTo of the range holding 0 degC
+  float ks_to_sx_corr_;     // 1 - ks_to_sx_ * 273.15
+  float alpha_corr_r_[RANGES];
+  const float *ks_to_;      // RANGES entries
+  const int16_t *ct_;       // RANGES entries; the lower corner temperatures
+  uint8_t fast_root_;       // 1 => fast_root4f
+};
+
+
+static inline float
+thermal_root4(float x, uint8_t fast_root)
+{
+  if (fast_root)
+  {
+    return fast_root4f(x);
+  }
+  return sqrt(sqrt(x));
+}
+
+
+template <uint8_t RANGES>
+static inline float
+thermal_pixel_to(const thermal_to_cfg_t<RANGES> *cfg, float ir_data, float alpha_compensated)
+{
+  float sx = alpha_compensated * alpha_compensated * alpha_compensated * (ir_data + alpha_compensated * cfg->ta_tr_);
+  sx = thermal_root4(sx, cfg->fast_root_) * cfg->ks_to_sx_;
+  float to = thermal_root4(ir_data / (alpha_compensated * cfg->ks_to_sx_corr_ + sx) + cfg->ta_tr_, cfg->fast_root_) - 273.15;
+
+  uint8_t range = 0;
+  while ((range < RANGES-1) && (to >= cfg->ct_[range+1]))
+  {
+    range++;
+  }
+  return thermal_root4(ir_data / (alpha_compensated * cfg->alpha_corr_r_[range] * (1 + cfg->ks_to_[range] * (to - cfg->ct_[range]))) + cfg->ta_tr_, cfg->fast_root_) - 273.15;
+}
+
+
+template <uint16_t PIXELS, uint8_t RANGES, typename compensate_t>
+static inline void
+thermal_calculate_to(const thermal_to_cfg_t<RANGES> *cfg, const uint16_t *pixel_list, const uint32_t *pixel_mask, compensate_t compensate, float *result)
+{
+  for (uint16_t i=0; i<PIXELS; i++)
+  {
+    uint16_t pixel = (pixel_list != NULL) ? pixel_list[i] : i;
+    if ((pixel_mask != NULL) && !(pixel_mask[pixel >> 5] & (1UL << (pixel & 31))))
+    {
+      continue;
+    }
+    float ir_data;
+    float alpha_compensated;
+    compensate(pixel, &ir_data, &alpha_compensated);
+    result[pixel] = thermal_pixel_to(cfg, ir_data, alpha_compensated);
+  }
+}
+
+#endif // __cplusplus
+
+#endif // __I2C_STICK_THERMAL_TO_H__
@@ -0,0 +1,126 @@
+#include "i2c_stick_tx.h"
+
+#include <string.h>
+
+static_assert((TX_BUFFER_SIZE & (TX_BUFFER_SIZE - 1)) == 0, "TX_BUFFER_SIZE must be a power of two; the used bytes are the unsigned index difference modulo the size");
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static uint8_t g_tx_buffer[TX_BUFFER_SIZE];
+static volatile uint32_t g_tx_head; // write index (producer)
+static volatile uint32_t g_tx_tail; // read index (consumer)
+static uint32_t g_tx_high_water_mark;
+static uint32_t g_tx_overflow_count;
+
+
+uint32_t
+i2c_stick_tx_used()
+{
+  return (g_tx_head - g_tx_tail) % TX_BUFFER_SIZE;
+}
+
+
+uint32_t
+i2c_stick_tx_free()
+{ // one byte is kept free to distinguish 'full' from 'empty'
+  return TX_BUFFER_SIZE - 1 - i2c_stick_tx_used();
+}
+
+
+uint16_t
+i2c_stick_tx_write(const uint8_t *data, uint16_t length)
+{ // queue as much as possible; returns the number of bytes queued.
+  uint32_t n = i2c_stick_tx_free();
+  if (n > length)
+  {
+    n = length;
+  }
+
+  uint32_t head = g_tx_head;
+  uint32_t first = TX_BUFFER_SIZE - head;
+  if (first > n) first = n;
+  memcpy(&g_tx_buffer[head], data, first);
+  memcpy(&g_tx_buffer[0], data + first, n - first);
+  g_tx_head = (head + n) % TX_BUFFER_SIZE;
+
+  uint32_t used = i2c_stick_tx_used();
+  if (used > g_tx_high_water_mark)
+  {
+    g_tx_high_water_mark = used;
+  }
+  return n;
+}
+
+
+uint8_t
+i2c_stick_tx_queue(const uint8_t *data, uint16_t length, i2c_stick_tx_drain_t drain)
+{ // queue all bytes; when the ring buffer is full, call 'drain' until there is
+  // room again, or without 'drain' (NULL) drop the bytes which do not fit.
+  // Returns 1 when the writer had to wait or drop (overflow), 0 otherwise.
+  uint16_t n = i2c_stick_tx_write(data, length);
+  if (n == length)
+  {
+    return 0;
+  }
+  g_tx_overflow_count++;
+  if (drain == NULL)
+  {
+    return 1;
+  }
+  data += n;
+  length -= n;
+  while (length > 0)
+  {
+    drain();
+    n = i2c_stick_tx_write(data, length);
+    data += n;
+    length -= n;
+  }
+  return 1;
+}
+
+
+uint16_t
+i2c_stick_tx_peek(const uint8_t **data)
+{ // returns the largest contiguous block which is ready to be sent.
+  uint32_t head = g_tx_head;
+  uint32_t tail = g_tx_tail;
+  *data = &g_tx_buffer[tail];
+  if (head >= tail)
+  {
+    return head - tail;
+  }
+  return TX_BUFFER_SIZE - tail;
+}
+
+
+void
+i2c_stick_tx_consume(uint16_t length)
+{
+  g_tx_tail = (g_tx_tail + length) % TX_BUFFER_SIZE;
+}
+
+
+void
+i2c_stick_tx_get_stats(i2c_stick_tx_stats_t *stats)
+{
+  stats->size_ = TX_BUFFER_SIZE;
+  stats->used_ = i2c_stick_tx_used();
+  stats->high_water_mark_ = g_tx_high_water_mark;
+  stats->overflow_count_ = g_tx_overflow_count;
+}
+
+
+void
+i2c_stick_tx_reset_stats()
+{
+  g_tx_high_water_mark = i2c_stick_tx_used();
+  g_tx_overflow_count = 0;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
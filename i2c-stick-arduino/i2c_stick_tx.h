@@ -0,0 +1,42 @@
+#ifndef __I2C_STICK_TX_H__
+#define __I2C_STICK_TX_H__
+
+#include <stdint.h>
+#include "i2c_stick_fw_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// TX ring buffer
+// **************
+//
+// The answers to the host are queued in a ring buffer and drained in the
+// background (from the main loop), such that the firmware does not have to
+// wait for the USB/UART transfer to complete before starting the next I2C
+// transaction.
+
+struct i2c_stick_tx_stats_t
+{
+  uint32_t size_;            // capacity of the ring buffer in bytes
+  uint32_t used_;            // bytes currently queued
+  uint32_t high_water_mark_; // maximum bytes ever queued
+  uint32_t overflow_count_;  // number of times a writer had to wait for free space, or dropped bytes
+};
+
+typedef void (*i2c_stick_tx_drain_t)();
+
+uint16_t i2c_stick_tx_write(const uint8_t *data, uint16_t length);
+uint8_t i2c_stick_tx_queue(const uint8_t *data, uint16_t length, i2c_stick_tx_drain_t drain);
+uint16_t i2c_stick_tx_peek(const uint8_t **data);
+void i2c_stick_tx_consume(uint16_t length);
+uint32_t i2c_stick_tx_used();
+uint32_t i2c_stick_tx_free();
+void i2c_stick_tx_get_stats(i2c_stick_tx_stats_t *stats);
+void i2c_stick_tx_reset_stats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __I2C_STICK_TX_H__
@@ -2,6 +2,7 @@
 #include "i2c_stick.h"
 #include "i2c_stick_cmd.h"
 #include "i2c_stick_dispatcher.h"
+#include "i2c_stick_pool.h"
 #include "i2c_stick_hal.h"
 #include "mlx90394_hal.h"
 #include "mlx90394_api.h"
@@ -25,6 +26,7 @@ extern "C" {
 
 
 static MLX90394_t *g_mlx90394_list[MAX_MLX90394_SLAVES];
+POOL_DEFINE(g_mlx90394_pool, "MLX90394", MLX90394_t, MAX_MLX90394_SLAVES);
 
 
 MLX90394_t *
@@ -66,8 +68,8 @@ cmd_90394_get_handle(uint8_t sa)
   {
     if (g_mlx90394_list[i] == NULL)
     {
-      g_mlx90394_list[i] = (MLX90394_t *)malloc(sizeof(MLX90394_t));;
-      memset(g_mlx90394_list[i], 0, sizeof(MLX90394_t));
+      g_mlx90394_list[i] = (MLX90394_t *)pool_alloc(&g_mlx90394_pool);
+      if (g_mlx90394_list[i] == NULL) return NULL;
       g_mlx90394_list[i]->slave_address_ = 0x80 | sa;
       return g_mlx90394_list[i];
     }
@@ -89,7 +91,7 @@ delete_handle(uint8_t sa)
     if ((g_mlx90394_list[i]->slave_address_ & 0x7F) == sa)
     { // found!
       memset(g_mlx90394_list[i], 0, sizeof(MLX90394_t));
-      free(g_mlx90394_list[i]);
+      pool_free(&g_mlx90394_pool, g_mlx90394_list[i]);
       g_mlx90394_list[i] = NULL;
     }
   }
@@ -100,6 +102,7 @@ int16_t
 cmd_90394_register_driver()
 {
   int16_t r = 0;
+  pool_register(&g_mlx90394_pool);
 
   r = i2c_stick_register_driver(0x60, DRV_MLX90394_ID);
   if (r < 0) return r;
@@ -306,6 +309,50 @@ cmd_90394_nd(uint8_t sa, uint8_t *nd, char const **error_message)
 }
 
 
+void
+cmd_90394_rp(uint8_t sa, uint32_t *period_ms, char const **error_message)
+{ // the time between two new data events; 0 => unknown.
+  MLX90394_t *mlx = cmd_90394_get_handle(sa);
+  *period_ms = 0;
+  if (mlx == NULL)
+  {
+    *error_message = MLX90394_ERROR_NO_FREE_HANDLE;
+    return;
+  }
+  if (mlx->slave_address_ & 0x80)
+  {
+    cmd_90394_init(sa);
+  }
+
+  switch (mlx->mode_)
+  {
+    case MLX90394_MODE_5Hz:
+      *period_ms = 200;
+      break;
+    case MLX90394_MODE_10Hz:
+      *period_ms = 100;
+      break;
+    case MLX90394_MODE_15Hz:
+      *period_ms = 66;
+      break;
+    case MLX90394_MODE_50Hz:
+      *period_ms = 20;
+      break;
+    case MLX90394_MODE_100Hz:
+      *period_ms = 10;
+      break;
+    case MLX90394_MODE_200Hz:
+      *period_ms = 5;
+      break;
+    case MLX90394_MODE_500Hz:
+      *period_ms = 2;
+      break;
+    default: // single, self-test, >500Hz or power-down; poll as before.
+      *period_ms = 0;
+  }
+}
+
+
 void
 cmd_90394_sn(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message)
 {
@@ -19,9 +19,12 @@ struct MLX90394_t
 
 int16_t cmd_90394_register_driver();
 
+void cmd_90394_init(uint8_t sa);
+
 void cmd_90394_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_message);
 void cmd_90394_raw(uint8_t sa, uint16_t *raw_list, uint16_t *raw_count, char const **error_message);
 void cmd_90394_nd(uint8_t sa, uint8_t *nd, char const **error_message);
+void cmd_90394_rp(uint8_t sa, uint32_t *period_ms, char const **error_message);
 void cmd_90394_sn(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message);
 void cmd_90394_cs(uint8_t sa, uint8_t channel_mask, const char *input);
 void cmd_90394_cs_write(uint8_t sa, uint8_t channel_mask, const char *input);
@@ -17,6 +17,7 @@
 #include <Arduino.h>
 
 #include "i2c_stick_arduino.h"
+#include "i2c_stick_hal.h"
 #include "mlx90394_hal.h"
 
 
@@ -30,18 +31,15 @@ mlx90394_i2c_init()
 int
 mlx90394_i2c_direct_read(uint8_t sa, uint16_t *data, uint8_t count)
 {
-  int ack = 0;
+  uint8_t *p = (uint8_t *)data;
 
-  WIRE.endTransmission();
-  mlx90394_delay_us(5);
-
-  WIRE.beginTransmission(sa);
-  ack = WIRE.requestFrom(sa, count, (uint8_t)(true));
-  Serial.printf("request from ret: %d\n", ack);
-  for (uint8_t i=0; i<count; i++)
+  if (hal_i2c_transfer(sa, NULL, 0, p, count, 0) != 0)
   {
-    uint8_t val = WIRE.read();
-    data[i] = val;
+    return -1;
+  }
+  for (int16_t i=count-1; i>=0; i--)
+  { // widen in place from the back; data[i] only overwrites bytes 2i and 2i+1 (>= i)
+    data[i] = p[i];
   }
   return 0;
 }
@@ -50,31 +48,15 @@ mlx90394_i2c_direct_read(uint8_t sa, uint16_t *data, uint8_t count)
 int
 mlx90394_i2c_addressed_read(uint8_t sa, uint8_t read_address, uint16_t *data, uint8_t count)
 {
-  int ack = 0;
+  uint8_t *p = (uint8_t *)data;
 
-  WIRE.endTransmission();
-  mlx90394_delay_us(5);
-
-  WIRE.beginTransmission(sa);
-  WIRE.write(uint8_t(read_address));
-  ack = WIRE.endTransmission(false);     // repeated start
-#ifdef ARDUINO_ARCH_RP2040  
-  if (ack == 4) ack = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-  if (ack != 0x00)
+  if (hal_i2c_transfer(sa, &read_address, 1, p, count, 1) != 0)
   {
-      return -1;
-  }
-  ack = WIRE.requestFrom(sa, count, (uint8_t)(true));
-  if (ack != count)
-  {
-    return -2;
+    return -1;
   }
-
-  for (uint8_t i=0; i<count; i++)
-  {
-    uint8_t val = WIRE.read();
-    data[i] = val;
+  for (int16_t i=count-1; i>=0; i--)
+  { // widen in place from the back; data[i] only overwrites bytes 2i and 2i+1 (>= i)
+    data[i] = p[i];
   }
   return 0;
 }
@@ -83,29 +65,16 @@ mlx90394_i2c_addressed_read(uint8_t sa, uint8_t read_address, uint16_t *data, ui
 void
 mlx90394_i2c_set_clock_frequency(int freq)
 {
-  WIRE.end();          // some MCU cannot change the clock while I2C is active.
-  WIRE.setClock(freq); // RP2040 requires first to set the clock
-  WIRE.begin();
-  WIRE.setClock(freq); // NRF52840 requires first begin, then set clock.
+  hal_i2c_set_clock_frequency(freq); // waits for the I2C engine to be idle
 }
 
 
 int
 mlx90394_i2c_addressed_write(uint8_t sa, uint8_t write_address, uint8_t data)
 {
-  int ack = 0;
+  uint8_t cmd[2] = { write_address, data };
 
-  WIRE.endTransmission();
-  mlx90394_delay_us(5);
-
-  WIRE.beginTransmission(sa);
-  WIRE.write(write_address);
-  WIRE.write(data);
-  ack = WIRE.endTransmission();
-#ifdef ARDUINO_ARCH_RP2040
-  if (ack == 4) ack = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-  if (ack != 0x00)
+  if (hal_i2c_transfer(sa, cmd, 2, NULL, 0, 0) != 0)
   {
     return -1;
   }
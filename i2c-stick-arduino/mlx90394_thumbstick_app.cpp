@@ -4,6 +4,7 @@
 #include "i2c_stick_dispatcher.h"
 #include "i2c_stick_cmd.h"
 #include "i2c_stick_hal.h"
+#include "i2c_stick_frame.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -70,9 +71,6 @@ handle_90394_thumbstick_app(uint8_t channel_mask)
   char buf[32]; memset(buf, 0, sizeof(buf));
   if (hal_get_millis() - prev_time > 100)
   {
-    send_answer_chunk(channel_mask, "#", 0);
-    itoa(APP_MLX90394_THUMBSTICK_ID, buf, 10);
-    send_answer_chunk(channel_mask, buf, 0);
     uint8_t ok = 1;
     int16_t x = 0x7FFF;
     int16_t y = 0x7FFF;
@@ -94,12 +92,24 @@ handle_90394_thumbstick_app(uint8_t channel_mask)
     deflect = atan2(sqrt(x*x + y*y), z)*180/M_PI;
 
     // report the result
+	  uint32_t time_stamp = hal_get_millis();
+    if ((g_config_host & 0x000F) == HOST_CFG_FORMAT_FRAME)
+    {
+      float values[] = {float(x), float(y), float(z), float(t), heading, deflect};
+      send_frame(channel_mask, FRAME_TYPE_APP, g_sa, APP_MLX90394_THUMBSTICK_ID, time_stamp, values, sizeof(values));
+      prev_time = hal_get_millis();
+      return;
+    }
+
+    send_answer_chunk(channel_mask, "#", 0);
+    itoa(APP_MLX90394_THUMBSTICK_ID, buf, 10);
+    send_answer_chunk(channel_mask, buf, 0);
+
     send_answer_chunk(channel_mask, ":", 0);
 		uint8_to_hex(buf, g_sa);
 		send_answer_chunk(channel_mask, buf, 0);
 
     send_answer_chunk(channel_mask, ":", 0);
-	  uint32_t time_stamp = hal_get_millis();
     uint32_to_dec(buf, time_stamp, 8);
 		send_answer_chunk(channel_mask, buf, 0);
 
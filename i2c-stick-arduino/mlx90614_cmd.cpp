@@ -4,6 +4,7 @@
 #include "i2c_stick.h"
 #include "i2c_stick_cmd.h"
 #include "i2c_stick_dispatcher.h"
+#include "i2c_stick_pool.h"
 #include "i2c_stick_hal.h"
 
 #include <string.h>
@@ -24,6 +25,7 @@ extern "C" {
 
 
 static MLX90614_t *g_mlx90614_list[MAX_MLX90614_SLAVES];
+POOL_DEFINE(g_mlx90614_pool, "MLX90614", MLX90614_t, MAX_MLX90614_SLAVES);
 
 
 int16_t atohex8(const char *in);
@@ -68,8 +70,8 @@ cmd_90614_get_handle(uint8_t sa)
   {
     if (g_mlx90614_list[i] == NULL)
     {
-      g_mlx90614_list[i] = (MLX90614_t *)malloc(sizeof(MLX90614_t));;
-      memset(g_mlx90614_list[i], 0, sizeof(MLX90614_t));
+      g_mlx90614_list[i] = (MLX90614_t *)pool_alloc(&g_mlx90614_pool);
+      if (g_mlx90614_list[i] == NULL) return NULL;
       g_mlx90614_list[i]->slave_address_ = 0x80 | sa;
       return g_mlx90614_list[i];
     }
@@ -91,7 +93,7 @@ delete_handle(uint8_t sa)
     if ((g_mlx90614_list[i]->slave_address_ & 0x7F) == sa)
     { // found!
       memset(g_mlx90614_list[i], 0, sizeof(MLX90614_t));
-      free(g_mlx90614_list[i]);
+      pool_free(&g_mlx90614_pool, g_mlx90614_list[i]);
       g_mlx90614_list[i] = NULL;
     }
   }
@@ -102,6 +104,7 @@ int16_t
 cmd_90614_register_driver()
 {
   int16_t r = 0;
+  pool_register(&g_mlx90614_pool);
   r = i2c_stick_register_driver(0x5A, DRV_MLX90614_ID);
   if (r < 0) return r;
   r = i2c_stick_register_driver(0x3E, DRV_MLX90614_ID); // MLX90616 uses the same driver.
@@ -248,6 +251,20 @@ cmd_90614_nd(uint8_t sa, uint8_t *nd, char const **error_message)
 }
 
 
+void
+cmd_90614_rp(uint8_t sa, uint32_t *period_ms, char const **error_message)
+{ // the time between two new data events; 0 => unknown.
+  MLX90614_t *mlx = cmd_90614_get_handle(sa);
+  if (mlx == NULL)
+  {
+    *period_ms = 0;
+    *error_message = MLX90614_ERROR_NO_FREE_HANDLE;
+    return;
+  }
+  *period_ms = 200; // see the nd timer in cmd_90614_nd
+}
+
+
 void
 cmd_90614_sn(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message)
 {
@@ -500,7 +517,12 @@ cmd_90614_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
       // // disconnect old-SA.
       // cmd_90614_tear_down(sa);
       // we assume that the new SA will use the same driver!
-      i2c_stick_register_driver(new_sa, DRV_MLX90614_ID);
+      int16_t spot = i2c_stick_register_driver(new_sa, DRV_MLX90614_ID);
+      if (spot > 0)
+      { // the 'found' bit is for the scan, once the sensor answers at the new SA.
+        g_sa_list[new_sa].spot_ = spot;
+        i2c_stick_update_sa_ops(new_sa);
+      }
       // todo: scan only the new_sa (not here, as not yet active...)
 
       send_answer_chunk(channel_mask, ":SA=OK! [mlx-EE]", 1);
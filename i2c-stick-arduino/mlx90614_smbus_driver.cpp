@@ -20,6 +20,7 @@
 #include "mlx90614_smbus_driver.h"
 
 #include "i2c_stick_arduino.h"
+#include "i2c_stick_hal.h"
 
 
 uint8_t Calculate_PEC(uint8_t, uint8_t);
@@ -33,47 +34,24 @@ void MLX90614_SMBusInit()
 int MLX90614_SMBusRead(uint8_t slaveAddr, uint8_t readAddress, uint16_t *data)
 {
     uint8_t sa;                           
-    int ack = 0;
     uint8_t pec;                               
-    uint8_t pec_read;                               
+    uint8_t val[3];
 
     sa = (slaveAddr << 1);
-    
-    WIRE.endTransmission();
-    delayMicroseconds(5);    
 
-    WIRE.beginTransmission(slaveAddr);
-    pec = Calculate_PEC(0, sa);
-    WIRE.write(uint8_t(readAddress));           
-    pec = Calculate_PEC(pec, uint8_t(readAddress));
-    ack = WIRE.endTransmission(false);     // repeated start
-#ifdef ARDUINO_ARCH_RP2040  
-    if (ack == 4) ack = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-    if (ack != 0x00)
+    if (hal_i2c_transfer(slaveAddr, &readAddress, 1, val, 3, 0) != 0)
     {
         return -1;
     }
-    WIRE.requestFrom(slaveAddr, (uint8_t)(3), (uint8_t)(true));
+
+    pec = Calculate_PEC(0, sa);
+    pec = Calculate_PEC(pec, uint8_t(readAddress));
     pec = Calculate_PEC(pec, sa|1);
-    uint8_t val = WIRE.read();
-    pec = Calculate_PEC(pec, val);
-    *data = (uint16_t)(val);
-    val = WIRE.read();
-    pec = Calculate_PEC(pec, val);
-    *data |= ((uint16_t)(val)<<8);    
-    pec_read = WIRE.read();
-        
-    ack = WIRE.endTransmission();     // stop transmitting
-#ifdef ARDUINO_ARCH_RP2040  
-    if (ack == 4) ack = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-   if (ack != 0x00)
-    {
-        return -1; 
-    }          
+    pec = Calculate_PEC(pec, val[0]);
+    pec = Calculate_PEC(pec, val[1]);
+    *data = (uint16_t)(val[0]) | ((uint16_t)(val[1])<<8);
 
-    if (pec != pec_read)
+    if (pec != val[2])
     {
         return -2;
     }
@@ -83,17 +61,13 @@ int MLX90614_SMBusRead(uint8_t slaveAddr, uint8_t readAddress, uint16_t *data)
 
 void MLX90614_SMBusFreqSet(int freq)
 {
-    WIRE.end();          // some MCU cannot change the clock while I2C is active.
-    WIRE.setClock(freq); // RP2040 requires first to set the clock
-    WIRE.begin();
-    WIRE.setClock(freq); // NRF52840 requires first begin, then set clock.
+    hal_i2c_set_clock_frequency(freq); // waits for the I2C engine to be idle
 }
 
 int MLX90614_SMBusWrite(uint8_t slaveAddr, uint8_t writeAddress, uint16_t data)
 {
     uint8_t sa;
-    int ack = 0;
-    char cmd[4] = {0,0,0,0};
+    uint8_t cmd[4] = {0,0,0,0};
     static uint16_t dataCheck;
     uint8_t pec;
     
@@ -109,19 +83,7 @@ int MLX90614_SMBusWrite(uint8_t slaveAddr, uint8_t writeAddress, uint16_t data)
     
     cmd[3] = pec;
 
-    WIRE.endTransmission();
-    delayMicroseconds(5);    
-
-    WIRE.beginTransmission(slaveAddr);
-    WIRE.write(cmd[0]);
-    WIRE.write(cmd[1]);
-    WIRE.write(cmd[2]);
-    WIRE.write(cmd[3]);
-    ack = WIRE.endTransmission();
-#ifdef ARDUINO_ARCH_RP2040  
-    if (ack == 4) ack = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-    if (ack != 0x00)
+    if (hal_i2c_transfer(slaveAddr, cmd, 4, NULL, 0, 0) != 0)
     {
         return -1;
     }         
@@ -141,8 +103,7 @@ int MLX90614_SMBusWrite(uint8_t slaveAddr, uint8_t writeAddress, uint16_t data)
 int MLX90614_SendCommand(uint8_t slaveAddr, uint8_t command)
 {
     uint8_t sa;
-    int ack = 0;
-    char cmd[2]= {0,0};
+    uint8_t cmd[2]= {0,0};
     uint8_t pec;
     
     if(command != 0x60 && command != 0x61)
@@ -158,18 +119,7 @@ int MLX90614_SendCommand(uint8_t slaveAddr, uint8_t command)
        
     cmd[1] = pec;
 
-    WIRE.endTransmission();
-    delayMicroseconds(5);    
-
-    WIRE.beginTransmission(slaveAddr);
-    WIRE.write(cmd[0]);
-    WIRE.write(cmd[1]);
-    ack = WIRE.endTransmission();
-#ifdef ARDUINO_ARCH_RP2040  
-    if (ack == 4) ack = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-    
-    if (ack != 0x00)
+    if (hal_i2c_transfer(slaveAddr, cmd, 2, NULL, 0, 0) != 0)
     {
         return -1;
     }         
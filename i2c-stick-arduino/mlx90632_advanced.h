@@ -231,6 +231,7 @@ struct Mlx90632Device
   struct Mlx90632CalibData calib_data_;
   uint8_t slave_address_;
   uint8_t meas_select_;
+  uint16_t period_ms_; // cached cmd_90632_rp answer; 0 => read from the EEPROM
 };
 
 
@@ -242,6 +243,7 @@ int32_t _mlx90632_i2c_read_int32_t(uint8_t slave_address, uint16_t register_addr
 int16_t _mlx90632_read_adc(struct Mlx90632Device *mlx);
 int16_t _mlx90632_ee_write(struct Mlx90632Device *mlx, uint16_t register_address, uint16_t new_value);
 int16_t _mlx90632_read_calib_parameters(struct Mlx90632Device *mlx);
+int16_t _mlx90632_initialize_with_calib(struct Mlx90632Device *mlx, uint8_t i2c_slave_address, const struct Mlx90632CalibData *calib_data);
 struct Mlx90632AdcData *_mlx90632_get_adc_values(struct Mlx90632Device *mlx);
 struct Mlx90632CalibData *_mlx90632_get_calib_data(struct Mlx90632Device *mlx);
 
@@ -252,6 +252,13 @@ _mlx90632_i2c_read_int32_t(uint8_t slave_address, uint16_t register_address, int
 int16_t 
 _mlx90632_initialize(struct Mlx90632Device *mlx, uint8_t i2c_slave_address)
 {
+  return _mlx90632_initialize_with_calib(mlx, i2c_slave_address, NULL);
+}
+
+
+int16_t 
+_mlx90632_initialize_with_calib(struct Mlx90632Device *mlx, uint8_t i2c_slave_address, const struct Mlx90632CalibData *calib_data)
+{ /* calib_data: previously read calibration parameters; NULL => read from EEPROM */
   mlx->slave_address_ = i2c_slave_address;
   memset(&mlx->adc_data_, 0, sizeof(mlx->adc_data_));
   mlx->meas_select_ = 0;
@@ -260,7 +267,10 @@ _mlx90632_initialize(struct Mlx90632Device *mlx, uint8_t i2c_slave_address)
   {
     return -2;
   }
-  if (_mlx90632_read_calib_parameters(mlx))
+  if (calib_data != NULL)
+  {
+    memcpy(&mlx->calib_data_, calib_data, sizeof(struct Mlx90632CalibData));
+  } else if (_mlx90632_read_calib_parameters(mlx))
   {
     return -1;
   }
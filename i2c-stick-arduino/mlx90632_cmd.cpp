@@ -7,6 +7,8 @@
 #include "i2c_stick_cmd.h"
 #include "i2c_stick_hal.h"
 #include "i2c_stick_dispatcher.h"
+#include "i2c_stick_pool.h"
+#include "i2c_stick_calib_cache.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -25,6 +27,39 @@ extern "C" {
 #define MLX90632_ERROR_COMMUNICATION "Communication error"
 
 static Mlx90632Device *g_mlx90632_device_list[MAX_MLX90632_SLAVES];
+POOL_DEFINE(g_mlx90632_pool, "MLX90632", Mlx90632Device, MAX_MLX90632_SLAVES);
+
+
+static void
+cmd_90632_calib_cache_store(Mlx90632Device *mlx)
+{
+  uint16_t sn_list[4];
+  if (_mlx90632_i2c_read_block(mlx->slave_address_, 0x2405, sn_list, 4) == 0)
+  {
+    i2c_stick_calib_cache_store(DRV_MLX90632_ID, sn_list, 4, &mlx->calib_data_, sizeof(Mlx90632CalibData));
+  }
+}
+
+
+static int16_t
+cmd_90632_initialize(Mlx90632Device *mlx, uint8_t sa)
+{ // initialize with the calibration parameters from the cache when available.
+  uint16_t sn_list[4];
+  Mlx90632CalibData calib_data;
+  mlx->period_ms_ = 0;
+  if ((_mlx90632_i2c_read_block(sa, 0x2405, sn_list, 4) == 0) &&
+      (i2c_stick_calib_cache_load(DRV_MLX90632_ID, sn_list, 4, &calib_data, sizeof(Mlx90632CalibData)) == 0))
+  {
+    return _mlx90632_initialize_with_calib(mlx, sa, &calib_data);
+  }
+
+  int16_t result = _mlx90632_initialize(mlx, sa);
+  if (result == 0)
+  {
+    cmd_90632_calib_cache_store(mlx);
+  }
+  return result;
+}
 
 
 Mlx90632Device *
@@ -65,8 +100,7 @@ cmd_90632_get_handle(uint8_t sa)
   {
     if (g_mlx90632_device_list[i] == NULL)
     {
-      g_mlx90632_device_list[i] = new Mlx90632Device;
-      memset(g_mlx90632_device_list[i], 0, sizeof(Mlx90632Device));
+      g_mlx90632_device_list[i] = (Mlx90632Device *)pool_alloc(&g_mlx90632_pool);
       return g_mlx90632_device_list[i];
     }
   }
@@ -86,13 +120,30 @@ delete_handle(uint8_t sa)
     }
     if (g_mlx90632_device_list[i]->slave_address_ == sa)
     { // found!
-      delete g_mlx90632_device_list[i];
+      i2c_stick_calib_cache_cancel(&g_mlx90632_device_list[i]->calib_data_);
+      pool_free(&g_mlx90632_pool, g_mlx90632_device_list[i]);
       g_mlx90632_device_list[i] = NULL;
     }
   }
 }
 
 
+void
+cmd_90632_init(uint8_t sa)
+{
+  Mlx90632Device *mlx = cmd_90632_get_handle(sa);
+  if (mlx == NULL)
+  {
+    return;
+  }
+
+  if (mlx->slave_address_ == 0) // only the case of a new handle!
+  {
+    cmd_90632_initialize(mlx, sa);
+  }
+}
+
+
 void
 cmd_90632_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_message)
 {
@@ -114,7 +165,7 @@ cmd_90632_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_
 
   if (mlx->slave_address_ == 0) // only the case of a new handle!
   {
-    _mlx90632_initialize(mlx, sa);
+    cmd_90632_initialize(mlx, sa);
   }
 
   if (_mlx90632_measure_degc(mlx, &mv_list[0], &mv_list[1]) != 0)
@@ -138,7 +189,7 @@ cmd_90632_nd(uint8_t sa, uint8_t *nd, char const **error_message)
   }
   if (mlx->slave_address_ == 0) // only the case of a new handle!
   {
-    _mlx90632_initialize(mlx, sa);
+    cmd_90632_initialize(mlx, sa);
   }
 
   uint16_t reg_status = 0, cycle_pos = 0;
@@ -172,6 +223,35 @@ cmd_90632_nd(uint8_t sa, uint8_t *nd, char const **error_message)
 }
 
 
+void
+cmd_90632_rp(uint8_t sa, uint32_t *period_ms, char const **error_message)
+{ // the time between two new data events; 0 => unknown.
+  Mlx90632Device *mlx = cmd_90632_get_handle(sa);
+  *period_ms = 0;
+  if (mlx == NULL)
+  { // failed to get handle!
+    *error_message = MLX90632_ERROR_NO_FREE_HANDLE;
+    return;
+  }
+  if (mlx->slave_address_ == 0) // only the case of a new handle!
+  {
+    cmd_90632_initialize(mlx, sa);
+  }
+
+  if (mlx->period_ms_ == 0)
+  {
+    enum MLX90632_RefreshRate rr = MLX90632_RR_2Hz;
+    if (_mlx90632_ee_read_refresh_rate(mlx, &rr) < 0)
+    {
+      *error_message = MLX90632_ERROR_COMMUNICATION;
+      return;
+    }
+    mlx->period_ms_ = 2000 >> rr; // time of a single measurement
+  }
+  *period_ms = mlx->period_ms_;
+}
+
+
 void
 cmd_90632_sn(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message)
 {
@@ -211,7 +291,7 @@ cmd_90632_cs(uint8_t sa, uint8_t channel_mask, const char *input)
 
   if (mlx->slave_address_ == 0) // only the case of a new handle!
   {
-    _mlx90632_initialize(mlx, sa);
+    cmd_90632_initialize(mlx, sa);
   }
 
   MLX90632_RefreshRate rr;
@@ -347,7 +427,7 @@ cmd_90632_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
 
   if (mlx->slave_address_ == 0) // only the case of a new handle!
   {
-    _mlx90632_initialize(mlx, sa);
+    cmd_90632_initialize(mlx, sa);
   }
 
   const char *var_name = "EM=";
@@ -377,7 +457,7 @@ cmd_90632_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
     send_answer_chunk(channel_mask, buf, 0);
     if ((rr >= 0) && (rr <= 7))
     {
-      _mlx90632_ee_write_refresh_rate(mlx, MLX90632_RefreshRate(rr));
+      mlx->period_ms_ = (_mlx90632_ee_write_refresh_rate(mlx, MLX90632_RefreshRate(rr)) == 0) ? (2000 >> rr) : 0;
       send_answer_chunk(channel_mask, ":RR=OK [mlx-EE]", 1);
     } else
     {
@@ -430,6 +510,7 @@ cmd_90632_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
     _mlx90632_ee_write(mlx, 0x2481, ha_ee);
     // re-read the (updated) calibration parameters from EE
     _mlx90632_read_calib_parameters(mlx);
+    cmd_90632_calib_cache_store(mlx);
 
     send_answer_chunk(channel_mask, ":Ha=OK [mlx-EE]", 1);
     return;
@@ -479,6 +560,7 @@ cmd_90632_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
     _mlx90632_ee_write(mlx, 0x2482, hb_ee);
     // re-read the (updated) calibration parameters from EE
     _mlx90632_read_calib_parameters(mlx);
+    cmd_90632_calib_cache_store(mlx);
 
     send_answer_chunk(channel_mask, ":Hb=OK [mlx-EE]", 1);
     return;
@@ -591,8 +673,13 @@ cmd_90632_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
       g_sa_list[sa].found_ = 0; // reset 'found' bit on 'old'-SA.
 
       // we assume that the new SA will use the same driver!
-      i2c_stick_register_driver(new_sa, DRV_MLX90632_ID);
-      g_sa_list[new_sa].spot_ = 1; // set 'found' bit on 'new'-SA.
+      int16_t spot = i2c_stick_register_driver(new_sa, DRV_MLX90632_ID);
+      if (spot > 0)
+      {
+        g_sa_list[new_sa].spot_ = spot;
+        g_sa_list[new_sa].found_ = 1; // set 'found' bit on 'new'-SA.
+        i2c_stick_update_sa_ops(new_sa);
+      }
 
       send_answer_chunk(channel_mask, ":SA=OK! [mlx-EE]", 1);
     } else
@@ -675,6 +762,7 @@ cmd_90632_mw(uint8_t sa, uint16_t *mem_data, uint16_t mem_start_address, uint16_
   // indicate 16 bit at each single address:
   *bit_per_address = 16;
   *address_increments = 1;
+  mlx->period_ms_ = 0; // the refresh rate may be written
 
   // check if write in EEPROM...
   uint8_t write_in_eeprom = true;
@@ -690,6 +778,11 @@ cmd_90632_mw(uint8_t sa, uint16_t *mem_data, uint16_t mem_start_address, uint16_
   MLX90632_Reg_Mode mode;
   if (write_in_eeprom)
   { // one cannot write the EEPROM in continuos mode
+    uint16_t sn_list[4];
+    if (_mlx90632_i2c_read_block(sa, 0x2405, sn_list, 4) == 0)
+    { // the cached calibration parameters are no longer valid
+      i2c_stick_calib_cache_invalidate(DRV_MLX90632_ID, sn_list, 4);
+    }
     _mlx90632_reg_read_mode(mlx, &mode);
     _mlx90632_reg_write_mode(mlx, MLX90632_REG_MODE_HALT);
   }
@@ -783,7 +876,7 @@ cmd_90632_raw(uint8_t sa, uint16_t *raw_list, uint16_t *raw_count, char const **
 
   if (mlx->slave_address_ == 0) // only the case of a new handle!
   {
-    _mlx90632_initialize(mlx, sa);
+    cmd_90632_initialize(mlx, sa);
   }
 
   if (*raw_count < (1 + 3))
@@ -813,6 +906,7 @@ int16_t
 cmd_90632_register_driver()
 {
   int16_t r = 0;
+  pool_register(&g_mlx90632_pool);
   r = i2c_stick_register_driver(0x3A, DRV_MLX90632_ID);
   if (r < 0) return r;
   return 1;
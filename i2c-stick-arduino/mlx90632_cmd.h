@@ -12,9 +12,12 @@ extern "C" {
 
 int16_t cmd_90632_register_driver();
 
+void cmd_90632_init(uint8_t sa);
+
 void cmd_90632_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_message);
 void cmd_90632_raw(uint8_t sa, uint16_t *raw_list, uint16_t *raw_count, char const **error_message);
 void cmd_90632_nd(uint8_t sa, uint8_t *nd, char const **error_message);
+void cmd_90632_rp(uint8_t sa, uint32_t *period_ms, char const **error_message);
 void cmd_90632_sn(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message);
 void cmd_90632_cs(uint8_t sa, uint8_t channel_mask, const char *input);
 void cmd_90632_cs_write(uint8_t sa, uint8_t channel_mask, const char *input);
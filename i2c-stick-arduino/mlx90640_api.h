@@ -109,16 +109,37 @@ typedef struct
         uint16_t brokenPixels[5];
         uint16_t outlierPixels[5];  
     } paramsMLX90640;
+
+    // Per-pixel coefficients which only depend on the EEPROM parameters;
+    // build once with MLX90640_BuildCalibration after MLX90640_ExtractParameters.
+    // With them the offset compensation is three FMAs per pixel:
+    //   offset*(1 + kta*dTa)*(1 + kv*dVdd)
+    //     = offset + offsetKta*(dTa + kv*dTa*dVdd) + offsetKv*dVdd
+    // The interleave/chess correction only depends on the row parity and
+    // column modulo 4; it is derived per frame.
+    typedef struct
+    {
+        float alpha[768];       // SCALEALPHA * 2^alphaScale / alpha
+        float offsetKta[768];   // offset * kta / 2^ktaScale
+        float offsetKv[768];    // offset * kv / 2^kvScale
+    } calibrationMLX90640;
     
     int MLX90640_DumpEE(uint8_t slaveAddr, uint16_t *eeData);
     int MLX90640_SynchFrame(uint8_t slaveAddr);
     int MLX90640_TriggerMeasurement(uint8_t slaveAddr);
     int MLX90640_GetFrameData(uint8_t slaveAddr, uint16_t *frameData);
+    int MLX90640_ValidateFrameData(uint16_t *frameData);
+    int MLX90640_ValidateAuxData(uint16_t *auxData);
     int MLX90640_ExtractParameters(uint16_t *eeData, paramsMLX90640 *mlx90640);
     float MLX90640_GetVdd(uint16_t *frameData, const paramsMLX90640 *params);
     float MLX90640_GetTa(uint16_t *frameData, const paramsMLX90640 *params);
     void MLX90640_GetImage(uint16_t *frameData, const paramsMLX90640 *params, float *result);
     void MLX90640_CalculateTo(uint16_t *frameData, const paramsMLX90640 *params, float emissivity, float tr, float *result);
+    void MLX90640_BuildCalibration(const paramsMLX90640 *params, calibrationMLX90640 *calibration);
+    // Visits the 384 pixels of the current sub-page from the per mode, per
+    // sub-page index tables (in flash).
+    // pixelMask: bit n set => calculate pixel n; NULL => all pixels of the sub-page.
+    void MLX90640_CalculateToCalibrated(uint16_t *frameData, const paramsMLX90640 *params, const calibrationMLX90640 *calibration, float emissivity, float tr, float *result, uint8_t fastRoot, const uint32_t *pixelMask);
     int MLX90640_SetResolution(uint8_t slaveAddr, uint8_t resolution);
     int MLX90640_GetCurResolution(uint8_t slaveAddr);
     int MLX90640_SetRefreshRate(uint8_t slaveAddr, uint8_t refreshRate);   
@@ -4,7 +4,12 @@
 #include "i2c_stick.h"
 #include "i2c_stick_cmd.h"
 #include "i2c_stick_dispatcher.h"
+#include "i2c_stick_pool.h"
+#include "i2c_stick_scratch.h"
 #include "i2c_stick_hal.h"
+#include "i2c_stick_calib_cache.h"
+#include "i2c_stick_fast_math.h"
+#include "i2c_stick_quant.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -15,19 +20,25 @@
 extern "C" {
 #endif
 
-void cmd_90640_iir_filter(float *to_list, float *iir, uint8_t depth, float threshold);
-void cmd_90640_deinterlace_filter(float *to_list, uint8_t subpage);
-
 #ifndef MAX_MLX90640_SLAVES
-#define MAX_MLX90640_SLAVES 8
+#define MAX_MLX90640_SLAVES 8 // every slot is statically allocated
 #endif // MAX_MLX90640_SLAVES
 
+#ifndef MLX90640_FILTER_BLOCKS
+#define MLX90640_FILTER_BLOCKS TEMPORAL_FILTER_MAX_BLOCKS // temporal filter history, shared by the slaves; a moving average takes 'depth' blocks
+#endif // MLX90640_FILTER_BLOCKS
+
 #define MLX90640_ERROR_BUFFER_TOO_SMALL "Buffer too small"
 #define MLX90640_ERROR_COMMUNICATION "Communication error"
 #define MLX90640_ERROR_NEW_DATA_SET "new_data bit set during read"
 #define MLX90640_ERROR_NO_FREE_HANDLE "No free handle; pls recompile firmware with higher 'MAX_MLX90640_SLAVES'"
+#define MLX90640_ERROR_FILTER_MEMORY "Not enough filter memory; pls recompile firmware with higher 'MLX90640_FILTER_BLOCKS'"
 
 static MLX90640_t *g_mlx90640_list[MAX_MLX90640_SLAVES];
+POOL_DEFINE(g_mlx90640_pool, "MLX90640", MLX90640_t, MAX_MLX90640_SLAVES);
+
+typedef mlx90640_array_t::block_t mlx90640_filter_block_t;
+POOL_DEFINE(g_mlx90640_filter_pool, "MLX90640.FILTER", mlx90640_filter_block_t, MLX90640_FILTER_BLOCKS);
 
 
 MLX90640_t *
@@ -68,8 +79,8 @@ cmd_90640_get_handle(uint8_t sa)
   {
     if (g_mlx90640_list[i] == NULL)
     {
-      g_mlx90640_list[i] = (MLX90640_t *)malloc(sizeof(MLX90640_t));;
-      memset(g_mlx90640_list[i], 0, sizeof(MLX90640_t));
+      g_mlx90640_list[i] = (MLX90640_t *)pool_alloc(&g_mlx90640_pool);
+      if (g_mlx90640_list[i] == NULL) return NULL;
       g_mlx90640_list[i]->slave_address_ = 0x80 | sa;
       return g_mlx90640_list[i];
     }
@@ -90,12 +101,12 @@ delete_handle(uint8_t sa)
     }
     if ((g_mlx90640_list[i]->slave_address_ & 0x7F) == sa)
     { // found!
-      if (g_mlx90640_list[i]->iir_ != NULL)
-      {
-        free(g_mlx90640_list[i]->iir_);
-      }
+      reg_shadow_detach(&g_mlx90640_list[i]->shadow_);
+      i2c_stick_calib_cache_cancel(&g_mlx90640_list[i]->mlx90640_);
+      mlx90640_frame_sm_abort(&g_mlx90640_list[i]->sm_);
+      temporal_filter_reset(&g_mlx90640_list[i]->filter_);
       memset(g_mlx90640_list[i], 0, sizeof(MLX90640_t));
-      free(g_mlx90640_list[i]);
+      pool_free(&g_mlx90640_pool, g_mlx90640_list[i]);
       g_mlx90640_list[i] = NULL;
     }
   }
@@ -106,6 +117,8 @@ int16_t
 cmd_90640_register_driver()
 {
   int16_t r = 0;
+  pool_register(&g_mlx90640_pool);
+  pool_register(&g_mlx90640_filter_pool);
   r = i2c_stick_register_driver(0x33, DRV_MLX90640_ID);
   if (r < 0) return r;
   return 1;
@@ -127,16 +140,228 @@ cmd_90640_init(uint8_t sa)
   mlx->flags_ |= (1U<<MLX90640_CMD_FLAG_DEINTERLACE_FILTER);
   mlx->flags_ |= (1U<<MLX90640_CMD_FLAG_IIR_FILTER);
 
-  uint16_t ee_data[832];
+  if (temporal_filter_init(&mlx->filter_, &g_mlx90640_filter_pool, mlx90640_array_t::pixels_) != 0)
+  { // the history pool is taken by the other slaves; the filter stays off.
+    mlx->flags_ &= ~(1U<<MLX90640_CMD_FLAG_IIR_FILTER);
+  }
+  roi_init(&mlx->roi_, mlx90640_array_t::cols_, mlx90640_array_t::rows_);
+  summary_init(&mlx->summary_);
 
   MLX90640_I2CInit();
-  MLX90640_DumpEE(sa, ee_data);
-  MLX90640_ExtractParameters(ee_data, &mlx->mlx90640_);
+  static const uint16_t shadow_list[] = { 0x800D, 0x800F };
+  reg_shadow_attach(&mlx->shadow_, sa, shadow_list, 2);
+
+  // the extracted parameters are cached in flash, keyed by the serial number.
+  uint16_t sn_list[3];
+  uint8_t sn_ok = (MLX90640_I2CRead(sa, 0x2407, 3, sn_list) == 0);
+  if ((!sn_ok) || (i2c_stick_calib_cache_load(DRV_MLX90640_ID, sn_list, 3, &mlx->mlx90640_, sizeof(paramsMLX90640)) != 0))
+  {
+    scratch_scope_t scope;
+    scratch_begin(&scope);
+    uint16_t *ee_data = (uint16_t *)scratch_alloc(832 * sizeof(uint16_t));
+    if (ee_data != NULL)
+    {
+      MLX90640_DumpEE(sa, ee_data);
+      if ((MLX90640_ExtractParameters(ee_data, &mlx->mlx90640_) == 0) && (sn_ok))
+      {
+        i2c_stick_calib_cache_store(DRV_MLX90640_ID, sn_list, 3, &mlx->mlx90640_, sizeof(paramsMLX90640));
+      }
+    }
+    scratch_end(&scope);
+  }
+  MLX90640_BuildCalibration(&mlx->mlx90640_, &mlx->calibration_);
   MLX90640_SetRefreshRate(sa, 3);
+  mlx->refresh_rate_ = 3;
+  mlx->frame_data_ = mlx->frame_buffer_[0];
   mlx->slave_address_ &= 0x7F;
 }
 
 
+// Pipeline mode (FLAGS=+PIPELINE)
+// The state machine reads the next sub-page into the back buffer while
+// frame_data_ (the front buffer) waits to be calculated. A collected sub-page
+// only becomes the front once the front has been calculated; until then the
+// state machine holds in DONE. Where the pixel read runs by DMA, 'nd' waits
+// with the front until the read of the next sub-page is under way, so the To
+// calculation of sub-page N-1 overlaps with the read of sub-page N.
+
+static void
+cmd_90640_pipe_reset(MLX90640_t *mlx)
+{
+  mlx90640_frame_sm_abort(&mlx->sm_);
+  mlx->frame_used_ = (1U<<MLX90640_FRAME_USED_EMPTY);
+  mlx->pipe_drop_count_ = 0;
+  mlx->pipe_window_count_ = 0;
+  mlx->pipe_window_ms_ = hal_get_millis();
+  mlx->pipe_rate_ = 0.0f;
+}
+
+
+static void
+cmd_90640_pipe_drop(MLX90640_t *mlx)
+{ // saturates; RO:PIPE_DROPPED stays meaningful on a long run.
+  if (mlx->pipe_drop_count_ < UINT16_MAX)
+  {
+    mlx->pipe_drop_count_++;
+  }
+}
+
+
+static uint16_t *
+cmd_90640_pipe_back(MLX90640_t *mlx)
+{
+  return (mlx->frame_data_ == mlx->frame_buffer_[0]) ? mlx->frame_buffer_[1] : mlx->frame_buffer_[0];
+}
+
+
+static void
+cmd_90640_pipe_collect(MLX90640_t *mlx)
+{ // the back buffer becomes the front.
+  uint16_t *frame_data = cmd_90640_pipe_back(mlx);
+  if (!(mlx->frame_used_ & (1U<<MLX90640_FRAME_USED_EMPTY)))
+  { // one drop per collect: the front was never calculated, or the sub-pages
+    // do not alternate (the sensor went on without us).
+    if ((!(mlx->frame_used_ & (1U<<MLX90640_FRAME_USED_MV))) ||
+        (frame_data[833] == mlx->frame_data_[833]))
+    {
+      cmd_90640_pipe_drop(mlx);
+    }
+  }
+  mlx->frame_data_ = frame_data;
+  mlx->frame_used_ = 0;
+  mlx->pipe_collect_ms_ = hal_get_millis();
+}
+
+
+static int16_t
+cmd_90640_pipe_pump(MLX90640_t *mlx, uint8_t sa, uint8_t user)
+{ // advance the acquisition as far as it goes without waiting; a collected
+  // sub-page replaces the front when 'user' or the To calculation is done with it.
+  // returns 0, or the error of a failed acquisition (restarted at the next call).
+  const uint8_t collect_mask = (1U<<user) | (1U<<MLX90640_FRAME_USED_MV) | (1U<<MLX90640_FRAME_USED_EMPTY);
+  for (;;)
+  {
+    uint8_t state = mlx->sm_.state_;
+    if (state == MLX90640_SM_DONE)
+    {
+      if (!(mlx->frame_used_ & collect_mask))
+      {
+        return 0; // hold until the front is calculated
+      }
+      cmd_90640_pipe_collect(mlx);
+    }
+    if (state == MLX90640_SM_ERROR)
+    {
+      int16_t error = mlx->sm_.error_;
+      cmd_90640_pipe_drop(mlx);
+      mlx90640_frame_sm_start(&mlx->sm_, sa, cmd_90640_pipe_back(mlx), mlx90640_frame_sm_poll_interval(mlx->refresh_rate_), 0x03);
+      return error;
+    }
+    if ((state == MLX90640_SM_IDLE) || (state == MLX90640_SM_DONE))
+    {
+      mlx90640_frame_sm_start(&mlx->sm_, sa, cmd_90640_pipe_back(mlx), mlx90640_frame_sm_poll_interval(mlx->refresh_rate_), 0x03);
+      state = mlx->sm_.state_;
+    }
+    if (mlx90640_frame_sm_step(&mlx->sm_, hal_get_millis()) == state)
+    { // waiting for new data, or for the pixel read in the background
+      return 0;
+    }
+  }
+}
+
+
+static int16_t
+cmd_90640_pipe_acquire(MLX90640_t *mlx, uint8_t sa, uint8_t user, uint8_t subpage_mask)
+{ // like cmd_90640_acquire; the next read is started before the front is returned.
+  uint32_t start_ms = hal_get_millis();
+  uint32_t timeout_ms = 4 * (2000 >> (mlx->refresh_rate_ & 0x07)) + hal_i2c_xfer_timeout_ms(2 * 834);
+  for (;;)
+  {
+    int16_t error = cmd_90640_pipe_pump(mlx, sa, user);
+    if ((!(mlx->frame_used_ & ((1U<<user) | (1U<<MLX90640_FRAME_USED_EMPTY)))) &&
+        (subpage_mask & (1U<<mlx->frame_data_[833])))
+    {
+      mlx->frame_used_ |= (1U<<user);
+      return mlx->frame_data_[833];
+    }
+    if ((error == -MLX90640_I2C_NACK_ERROR) || ((hal_get_millis() - start_ms) > timeout_ms))
+    {
+      return (error < 0) ? error : -1;
+    }
+  }
+}
+
+
+static int16_t
+cmd_90640_acquire(MLX90640_t *mlx, uint8_t sa, uint8_t user, uint8_t allow_retry, uint8_t subpage_mask)
+{ // return the sub-page of a frame not yet seen by 'user', or a negative error code.
+  if (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_PIPELINE))
+  {
+    return cmd_90640_pipe_acquire(mlx, sa, user, subpage_mask);
+  }
+  if ((mlx->sm_.state_ == MLX90640_SM_DONE) && !(mlx->frame_used_ & (1U<<user)) &&
+      (subpage_mask & (1U<<mlx->frame_data_[833])))
+  { // frame already collected in the background by 'nd'
+    mlx->frame_used_ |= (1U<<user);
+    return mlx->frame_data_[833];
+  }
+
+  uint16_t poll_interval_ms = mlx90640_frame_sm_poll_interval(mlx->refresh_rate_);
+  mlx90640_frame_sm_start(&mlx->sm_, sa, mlx->frame_data_, poll_interval_ms, subpage_mask);
+  int16_t e = mlx90640_frame_sm_run(&mlx->sm_);
+  if ((e < 0) && (allow_retry))
+  {
+    MLX90640_I2CWrite(sa, 0x8000, 0x0030); // clear new data flag...
+    mlx90640_frame_sm_start(&mlx->sm_, sa, mlx->frame_data_, poll_interval_ms, subpage_mask);
+    e = mlx90640_frame_sm_run(&mlx->sm_);
+  }
+  if (e >= 0)
+  {
+    mlx->frame_used_ = (1U<<user);
+  }
+  return e;
+}
+
+
+static void
+cmd_90640_calculate_to(MLX90640_t *mlx)
+{ // update to_list_ for the sub-page in frame_data_ only (and the ROI's when set).
+  uint8_t fast_root = (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_FAST_ROOT)) ? 1 : 0;
+  const uint32_t *pixel_mask = roi_is_active(&mlx->roi_) ? mlx->roi_.compute_mask_ : NULL;
+#ifdef THERMAL_STORAGE_INT16
+  // the To calculation is in float; convert the stored frame in and out.
+  scratch_scope_t scope;
+  scratch_begin(&scope);
+  float *to_list = (float *)scratch_alloc(mlx90640_array_t::pixels_ * sizeof(float));
+  if (to_list == NULL)
+  {
+    scratch_end(&scope);
+    return; // the sub-page is not marked ready
+  }
+  thermal_list_to_float(to_list, mlx->to_list_, mlx90640_array_t::pixels_);
+  MLX90640_CalculateToCalibrated(mlx->frame_data_, &mlx->mlx90640_, &mlx->calibration_, mlx->emissivity_, mlx->t_room_, to_list, fast_root, pixel_mask);
+  thermal_list_from_float(mlx->to_list_, to_list, mlx90640_array_t::pixels_);
+  scratch_end(&scope);
+#else
+  MLX90640_CalculateToCalibrated(mlx->frame_data_, &mlx->mlx90640_, &mlx->calibration_, mlx->emissivity_, mlx->t_room_, mlx->to_list_, fast_root, pixel_mask);
+#endif // THERMAL_STORAGE_INT16
+  mlx->subpage_ready_ |= (1U<<(mlx->frame_data_[833] & 0x0001));
+
+  if (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_PIPELINE))
+  { // calculated sub-pages per second, over windows of at least a second.
+    uint32_t now = hal_get_millis();
+    uint32_t elapsed = now - mlx->pipe_window_ms_;
+    mlx->pipe_window_count_++;
+    if (elapsed >= 1000)
+    {
+      mlx->pipe_rate_ = mlx->pipe_window_count_ * 1000.0f / elapsed;
+      mlx->pipe_window_count_ = 0;
+      mlx->pipe_window_ms_ = now;
+    }
+  }
+}
+
+
 void
 cmd_90640_tear_down(uint8_t sa)
 { // nothing special to do, just release all associated memory
@@ -148,7 +373,6 @@ void
 cmd_90640_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_message)
 {
   MLX90640_t *mlx = cmd_90640_get_handle(sa);
-  uint16_t frame_data[834];
   if (mlx == NULL)
   {
     *mv_count = 0;
@@ -160,119 +384,90 @@ cmd_90640_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_
     cmd_90640_init(sa);
   }
 
-  if (*mv_count < 768+1)
-  {
+  if (*mv_count < mlx90640_array_t::pixels_+1)
+  { // also with ROI's: the full frame is the work copy in fixed point mode.
     *error_message = MLX90640_ERROR_BUFFER_TOO_SMALL;
     *mv_count = 0;
     return;
   }
-  *mv_count = 768+1;
+  *mv_count = mlx90640_array_t::pixels_+1;
 
-  int e = MLX90640_GetFrameData(sa, frame_data);
+  uint8_t full_frame = ((mlx->flags_ & (1U<<MLX90640_CMD_FLAG_ND_ON_FULL_FRAME)) ||
+                       !(mlx->flags_ & (1U<<MLX90640_CMD_FLAG_IS_INIT))) ? 1 : 0;
 
-  if (e < 0)
+  int16_t e = cmd_90640_acquire(mlx, sa, MLX90640_FRAME_USED_MV, 1, 0x03);
+  if (e >= 0)
   {
-    // allow one retry!
-    MLX90640_I2CWrite(sa, 0x8000, 0x0030); // clear new data flag...
-    e = MLX90640_GetFrameData(sa, frame_data);
-    if (e < 0)
-    {
-      *mv_count = 0;
-      *error_message = MLX90640_ERROR_COMMUNICATION;
-      if (e == -16)
+    cmd_90640_calculate_to(mlx);
+    if ((full_frame) && (mlx->subpage_ready_ != 0x03))
+    { // full frame: the other sub-page comes from the next read.
+      e = cmd_90640_acquire(mlx, sa, MLX90640_FRAME_USED_MV, 1, 0x03 & ~mlx->subpage_ready_);
+      if (e >= 0)
       {
-        *error_message = MLX90640_ERROR_NEW_DATA_SET;
+        cmd_90640_calculate_to(mlx);
       }
-      return;
     }
   }
-
-  if (!(mlx->flags_ & (1U<<MLX90640_CMD_FLAG_IS_INIT)))
-  {// make sure 2 subpages are converted at initial call.
-    e = MLX90640_GetFrameData(sa, frame_data);
-
-    if (e < 0)
+  if (e < 0)
+  {
+    *mv_count = 0;
+    *error_message = MLX90640_ERROR_COMMUNICATION;
+    if (e == -16)
     {
-      // allow one retry!
-      MLX90640_I2CWrite(sa, 0x8000, 0x0030); // clear new data flag...
-      e = MLX90640_GetFrameData(sa, frame_data);
-      if (e < 0)
-      {
-        *mv_count = 0;
-        *error_message = MLX90640_ERROR_COMMUNICATION;
-        if (e == -16)
-        {
-          *error_message = MLX90640_ERROR_NEW_DATA_SET;
-        }
-        return;
-      }
+      *error_message = MLX90640_ERROR_NEW_DATA_SET;
     }
+    return;
   }
-  float ta = MLX90640_GetTa(frame_data, &mlx->mlx90640_);
-  MLX90640_CalculateTo(frame_data, &mlx->mlx90640_, mlx->emissivity_, mlx->t_room_, mlx->to_list_);
-
+  mlx->subpage_ready_ = 0;
 
-  if ((mlx->flags_ & (1U<<MLX90640_CMD_FLAG_ND_ON_FULL_FRAME)) ||
-     !(mlx->flags_ & (1U<<MLX90640_CMD_FLAG_IS_INIT)))
-  {
-    // trick to compute both sub-pages.
-    frame_data[833] ^= 0x0001;
-    MLX90640_CalculateTo(frame_data, &mlx->mlx90640_, mlx->emissivity_, mlx->t_room_, mlx->to_list_);
-    frame_data[833] ^= 0x0001;
-  }
+  uint16_t *frame_data = mlx->frame_data_;
+  float ta = MLX90640_GetTa(frame_data, &mlx->mlx90640_);
 
+#ifdef THERMAL_STORAGE_INT16
+  // the pixel corrections are in float; mv_list is the work copy.
+  float *to_list = &mv_list[1];
+  thermal_list_to_float(to_list, mlx->to_list_, mlx90640_array_t::pixels_);
+#else
+  float *to_list = mlx->to_list_;
+#endif // THERMAL_STORAGE_INT16
+
+  // the mode of the frame itself (control register 1 copy); in pipeline mode
+  // an I2C read would have to wait for the pixel read in the background.
+  int mode = (frame_data[832] & MLX90640_CTRL_MEAS_MODE_MASK) >> MLX90640_CTRL_MEAS_MODE_SHIFT;
   if (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_BROKEN_PIXELS))
   {
-    int mode = MLX90640_GetCurMode(sa);
-    MLX90640_BadPixelsCorrection(mlx->mlx90640_.brokenPixels, mlx->to_list_, mode, &mlx->mlx90640_);
+    MLX90640_BadPixelsCorrection(mlx->mlx90640_.brokenPixels, to_list, mode, &mlx->mlx90640_);
   }
 
   if (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_OUTLIER_PIXELS))
   {
-    int mode = MLX90640_GetCurMode(sa);
-    MLX90640_BadPixelsCorrection(mlx->mlx90640_.outlierPixels, mlx->to_list_, mode, &mlx->mlx90640_);
+    MLX90640_BadPixelsCorrection(mlx->mlx90640_.outlierPixels, to_list, mode, &mlx->mlx90640_);
   }
+  thermal_list_from_float(mlx->to_list_, to_list, mlx90640_array_t::pixels_);
 
   if (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_DEINTERLACE_FILTER))
   {
-    if ((mlx->flags_ & (1U<<MLX90640_CMD_FLAG_ND_ON_FULL_FRAME)) ||
-       !(mlx->flags_ & (1U<<MLX90640_CMD_FLAG_IS_INIT)))
-    { // trick to deinterlace previous sub-pages.
-      frame_data[833] ^= 0x0001;
-      cmd_90640_deinterlace_filter(mlx->to_list_, frame_data[833]);
-      frame_data[833] ^= 0x0001;
+    if (full_frame)
+    { // deinterlace the previous sub-page as well.
+      mlx90640_array_t::deinterlace(mlx->to_list_, frame_data[833] ^ 0x0001);
     }
-    cmd_90640_deinterlace_filter(mlx->to_list_, frame_data[833]);
+    mlx90640_array_t::deinterlace(mlx->to_list_, frame_data[833]);
   }
 
   if (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_IIR_FILTER))
   {
-    if (mlx->iir_ == NULL)
-    {
-      mlx->iir_ = (float *)malloc(sizeof(float) * 768);
-      for (uint16_t pix=0; pix<768; pix++)
-      {
-        if ((-100 < mlx->to_list_[pix]) && (mlx->to_list_[pix] < 1000))
-        {
-          mlx->iir_[pix] = mlx->to_list_[pix];
-        } else
-        {
-          mlx->iir_[pix] = ta;
-        }
-      }
-    }
-    cmd_90640_iir_filter(mlx->to_list_, mlx->iir_, 8, 2.5);
-    for (uint16_t pix=0; pix<768; pix++)
+    if (mlx90640_array_t::apply_filter(&mlx->filter_, &mlx->roi_, mlx->to_list_, ta) < 0)
     {
-      mlx->to_list_[pix] = mlx->iir_[pix];
+      *mv_count = 0;
+      *error_message = MLX90640_ERROR_FILTER_MEMORY;
+      return;
     }
   }
 
   mv_list[0] = ta;
-  for (uint16_t pix=0; pix<768; pix++)
-  {
-    mv_list[pix+1] = mlx->to_list_[pix];
-  }
+  // statistics of the frame (or of the ROI's), the ROI values, or the full frame.
+  *mv_count = mlx90640_array_t::output(&mlx->summary_, &mlx->roi_, mlx->to_list_, &mv_list[1])+1;
+  i2c_stick_quant_set_temperature_list(sa, !mlx->summary_.is_enabled_);
 
   mlx->flags_ |= (1U<<MLX90640_CMD_FLAG_IS_INIT);
 }
@@ -299,7 +494,7 @@ cmd_90640_raw(uint8_t sa, uint16_t *raw_list, uint16_t *raw_count, char const **
     return;
   }
   *raw_count = 834;
-  int e = MLX90640_GetFrameData(sa, raw_list);
+  int16_t e = cmd_90640_acquire(mlx, sa, MLX90640_FRAME_USED_RAW, 0, 0x03);
   if (e < 0)
   {
     *error_message = MLX90640_ERROR_COMMUNICATION;
@@ -309,6 +504,7 @@ cmd_90640_raw(uint8_t sa, uint16_t *raw_list, uint16_t *raw_count, char const **
     }
     return;
   }
+  memcpy(raw_list, mlx->frame_data_, 834 * sizeof(uint16_t));
 }
 
 
@@ -327,19 +523,87 @@ cmd_90640_nd(uint8_t sa, uint8_t *nd, char const **error_message)
   }
   *nd = 0;
 
-  uint16_t statusRegister;
-  int error = MLX90640_I2CRead(sa, 0x8000, 1, &statusRegister);
-  if(error != 0)
+  if (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_PIPELINE))
+  { // new data once the front is collected and, with a background read, the next sub-page is being read.
+    int16_t error = cmd_90640_pipe_pump(mlx, sa, MLX90640_FRAME_USED_MV);
+    if (error == -MLX90640_I2C_NACK_ERROR)
+    {
+      *error_message = MLX90640_ERROR_COMMUNICATION;
+    }
+    if (mlx->frame_used_ & ((1U<<MLX90640_FRAME_USED_ND) | (1U<<MLX90640_FRAME_USED_EMPTY)))
+    {
+      return;
+    }
+    uint8_t state = mlx->sm_.state_;
+    uint8_t is_reading = (state >= MLX90640_SM_CLEAR_FLAG) && (state <= MLX90640_SM_DONE);
+    uint8_t is_stale = (hal_get_millis() - mlx->pipe_collect_ms_) >= (uint32_t)(2000 >> (mlx->refresh_rate_ & 0x07));
+    if ((hal_i2c_xfer_is_async(2 * MLX90640_PIXEL_NUM)) && (!is_reading) && (!is_stale))
+    {
+      return;
+    }
+    mlx->frame_used_ |= (1U<<MLX90640_FRAME_USED_ND);
+    if ((mlx->flags_ & (1U<<MLX90640_CMD_FLAG_ND_ON_FULL_FRAME)) &&
+        (mlx->frame_data_[833] == 0))
+    { // full frame: convert sub-page 0 now, report new data after sub-page 1.
+      cmd_90640_calculate_to(mlx);
+      mlx->frame_used_ |= (1U<<MLX90640_FRAME_USED_MV);
+    } else
+    {
+      *nd = 1;
+    }
+    return;
+  }
+
+  // advance the frame acquisition by one step; new data once a frame is collected.
+  uint8_t state = mlx->sm_.state_;
+  if ((state == MLX90640_SM_IDLE) || (state == MLX90640_SM_ERROR) ||
+      ((state == MLX90640_SM_DONE) && (mlx->frame_used_ & (1U<<MLX90640_FRAME_USED_ND))))
   {
-   *error_message = MLX90640_ERROR_COMMUNICATION;
-   return;
+    mlx90640_frame_sm_start(&mlx->sm_, sa, mlx->frame_data_, mlx90640_frame_sm_poll_interval(mlx->refresh_rate_), 0x03);
+    mlx->frame_used_ = 0;
   }
-  if (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_ND_ON_FULL_FRAME))
+
+  state = mlx90640_frame_sm_step(&mlx->sm_, hal_get_millis());
+  if (state == MLX90640_SM_DONE)
   {
-    *nd = ((statusRegister & 0x0009) == 0x0009) ? 1 : 0;
-  } else
+    mlx->frame_used_ |= (1U<<MLX90640_FRAME_USED_ND);
+    if ((mlx->flags_ & (1U<<MLX90640_CMD_FLAG_ND_ON_FULL_FRAME)) &&
+        (mlx->frame_data_[833] == 0))
+    { // full frame: convert sub-page 0 now, report new data after sub-page 1.
+      cmd_90640_calculate_to(mlx);
+      mlx->frame_used_ |= (1U<<MLX90640_FRAME_USED_MV);
+    } else
+    {
+      *nd = 1;
+    }
+  }
+  if ((state == MLX90640_SM_ERROR) && (mlx->sm_.error_ == -MLX90640_I2C_NACK_ERROR))
+  {
+    *error_message = MLX90640_ERROR_COMMUNICATION;
+  }
+}
+
+
+void
+cmd_90640_rp(uint8_t sa, uint32_t *period_ms, char const **error_message)
+{ // the time between two new data events; 0 => unknown.
+  MLX90640_t *mlx = cmd_90640_get_handle(sa);
+  *period_ms = 0;
+  if (mlx == NULL)
+  {
+    *error_message = MLX90640_ERROR_NO_FREE_HANDLE;
+    return;
+  }
+  if (mlx->slave_address_ & 0x80)
+  {
+    cmd_90640_init(sa);
+  }
+
+  // refresh_rate_ follows the RR setting (init, cs_write, mw); no bus read.
+  *period_ms = 2000 >> (mlx->refresh_rate_ & 0x07); // time of a single sub-page
+  if (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_ND_ON_FULL_FRAME))
   {
-    *nd = ((statusRegister & 0x0008) == 0x0008) ? 1 : 0;
+    *period_ms *= 2;
   }
 }
 
@@ -514,23 +778,112 @@ cmd_90640_cs(uint8_t sa, uint8_t channel_mask, const char *input)
     }
     send_answer_chunk(channel_mask, "ON_FULL_FRAME", 0);
   }
+  if (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_FAST_ROOT))
+  {
+    if (is_first_flag)
+    {
+      is_first_flag = 0;
+      send_answer_chunk(channel_mask, "(", 0);
+    } else
+    {
+      send_answer_chunk(channel_mask, ",", 0);
+    }
+    send_answer_chunk(channel_mask, "FAST_ROOT", 0);
+  }
+  if (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_PIPELINE))
+  {
+    if (is_first_flag)
+    {
+      is_first_flag = 0;
+      send_answer_chunk(channel_mask, "(", 0);
+    } else
+    {
+      send_answer_chunk(channel_mask, ",", 0);
+    }
+    send_answer_chunk(channel_mask, "PIPELINE", 0);
+  }
 
   send_answer_chunk(channel_mask, (is_first_flag == 0) ? ")" : "", 1);
 
   send_answer_chunk(channel_mask, "cs:", 0);
   uint8_to_hex(buf, sa);
   send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ":RO:MV_HEADER=TA,TO_[768]", 1);
+  send_answer_chunk(channel_mask, ":VERIFY=", 0);
+  send_answer_chunk(channel_mask, reg_shadow_policy_to_str(mlx->shadow_.verify_policy_), 1);
+
+  send_answer_chunk(channel_mask, "cs:", 0);
+  uint8_to_hex(buf, sa);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ":FILTER=", 0);
+  send_answer_chunk(channel_mask, temporal_filter_type_to_str(mlx->filter_.type_), 1);
+
+  send_answer_chunk(channel_mask, "cs:", 0);
+  uint8_to_hex(buf, sa);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ":DEPTH=", 0);
+  itoa(mlx->filter_.depth_, buf, 10);
+  send_answer_chunk(channel_mask, buf, 1);
 
   send_answer_chunk(channel_mask, "cs:", 0);
   uint8_to_hex(buf, sa);
   send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ":RO:MV_UNIT=DegC,DegC[768]", 1);
+  send_answer_chunk(channel_mask, ":THRESHOLD=", 0);
+  p = my_dtostrf(mlx->filter_.threshold_degc_, 10, 2, buf);
+  while (*p == ' ') p++; // remove leading space
+  send_answer_chunk(channel_mask, p, 1);
+
+  roi_cs(sa, channel_mask, &mlx->roi_);
+  summary_cs(sa, channel_mask, &mlx->summary_);
 
   send_answer_chunk(channel_mask, "cs:", 0);
   uint8_to_hex(buf, sa);
   send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ":RO:MV_RES=" xstr(MLX90640_LSB_C) "," xstr(MLX90640_LSB_C) "[768]", 1);
+  send_answer_chunk(channel_mask, ":RO:SHADOW_SAVED=", 0);
+  itoa(mlx->shadow_.read_saved_, buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",", 0);
+  itoa(mlx->shadow_.verify_saved_, buf, 10);
+  send_answer_chunk(channel_mask, buf, 1);
+
+  if (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_PIPELINE))
+  {
+    send_answer_chunk(channel_mask, "cs:", 0);
+    uint8_to_hex(buf, sa);
+    send_answer_chunk(channel_mask, buf, 0);
+    send_answer_chunk(channel_mask, ":RO:PIPE_RATE=", 0);
+    p = my_dtostrf(mlx->pipe_rate_, 10, 1, buf);
+    while (*p == ' ') p++; // remove leading space
+    send_answer_chunk(channel_mask, p, 0);
+    send_answer_chunk(channel_mask, "(subpages/s)", 1);
+
+    send_answer_chunk(channel_mask, "cs:", 0);
+    uint8_to_hex(buf, sa);
+    send_answer_chunk(channel_mask, buf, 0);
+    send_answer_chunk(channel_mask, ":RO:PIPE_DROPPED=", 0);
+    itoa(mlx->pipe_drop_count_, buf, 10);
+    send_answer_chunk(channel_mask, buf, 1);
+  }
+
+  summary_cs_mv(sa, channel_mask, &mlx->summary_, &mlx->roi_, MLX90640_LSB_C, MLX90640_LSB_C);
+}
+
+
+static int8_t
+cmd_90640_filter_configure(MLX90640_t *mlx, uint8_t type, uint8_t depth, float threshold_degc)
+{ // the history is only held while the filter is on
+  int8_t r = temporal_filter_configure(&mlx->filter_, type, depth, threshold_degc);
+  if ((r == 0) && (!(mlx->flags_ & (1U<<MLX90640_CMD_FLAG_IIR_FILTER))))
+  {
+    temporal_filter_reset(&mlx->filter_);
+  }
+  return r;
+}
+
+
+static void
+cmd_90640_filter_answer(uint8_t sa, uint8_t channel_mask, const char *var_name, int8_t result, const char *fail_reason)
+{ // answer to the temporal filter settings
+  send_cs_write_answer(sa, channel_mask, var_name, result, (result == -2) ? "not enough filter memory" : fail_reason);
 }
 
 
@@ -547,7 +900,68 @@ cmd_90640_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
   {
     cmd_90640_init(sa);
   }
-  const char *var_name = "EM=";
+  reg_shadow_invalidate(&mlx->shadow_);
+
+  const char *var_name = "VERIFY=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  {
+    int8_t policy = reg_shadow_policy_from_str(input+strlen(var_name));
+    send_answer_chunk(channel_mask, "+cs:", 0);
+    uint8_to_hex(buf, sa);
+    send_answer_chunk(channel_mask, buf, 0);
+    if (policy >= 0)
+    {
+      mlx->shadow_.verify_policy_ = policy;
+      send_answer_chunk(channel_mask, ":VERIFY=OK [hub-register]", 1);
+    } else
+    {
+      send_answer_chunk(channel_mask, ":VERIFY=FAIL; expect ALWAYS, EEPROM or NEVER", 1);
+    }
+    return;
+  }
+  var_name = "FILTER=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  {
+    int8_t type = temporal_filter_type_from_str(input+strlen(var_name));
+    int8_t r = -1;
+    if (type >= 0)
+    {
+      r = cmd_90640_filter_configure(mlx, type, mlx->filter_.depth_, mlx->filter_.threshold_degc_);
+    }
+    cmd_90640_filter_answer(sa, channel_mask, "FILTER", r, "expect IIR, AB or MA");
+    return;
+  }
+  var_name = "DEPTH=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  {
+    int16_t depth = atoi(input+strlen(var_name));
+    int8_t r = -1;
+    if ((depth >= 1) && (depth <= TEMPORAL_FILTER_MAX_DEPTH))
+    {
+      r = cmd_90640_filter_configure(mlx, mlx->filter_.type_, depth, mlx->filter_.threshold_degc_);
+    }
+    cmd_90640_filter_answer(sa, channel_mask, "DEPTH", r, "outbound (AB: 2.." xstr(TEMPORAL_FILTER_MAX_DEPTH) ", MA: 1.." xstr(TEMPORAL_FILTER_MAX_BLOCKS) ")");
+    return;
+  }
+  var_name = "THRESHOLD=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  {
+    float threshold = atof(input+strlen(var_name));
+    int8_t r = cmd_90640_filter_configure(mlx, mlx->filter_.type_, mlx->filter_.depth_, threshold);
+    cmd_90640_filter_answer(sa, channel_mask, "THRESHOLD", r, "outbound");
+    return;
+  }
+  uint8_t roi_result = roi_cs_write(sa, channel_mask, &mlx->roi_, input);
+  if (roi_result)
+  {
+    if (roi_result == 2) temporal_filter_restart(&mlx->filter_); // the pixels outside the old ROI's are stale
+    return;
+  }
+  if (summary_cs_write(sa, channel_mask, &mlx->summary_, input))
+  {
+    return;
+  }
+  var_name = "EM=";
   if (!strncmp(var_name, input, strlen(var_name)))
   {
     float em = atof(input+strlen(var_name));
@@ -593,6 +1007,11 @@ cmd_90640_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
       int ret = MLX90640_SetRefreshRate(sa, rr);
       if (ret == 0)
       {
+        mlx->refresh_rate_ = rr;
+        if (mlx->flags_ & (1U<<MLX90640_CMD_FLAG_PIPELINE))
+        {
+          cmd_90640_pipe_reset(mlx);
+        }
         send_answer_chunk(channel_mask, ":RR=OK [mlx-register]", 1);
       } else
       {
@@ -680,23 +1099,20 @@ cmd_90640_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
     }
     else if (!strcmp(input+strlen(var_name), "+IIR"))
     {
-      mlx->flags_ |= (1U<<MLX90640_CMD_FLAG_IIR_FILTER);
-      send_answer_chunk(channel_mask, ":FLAGS=OK [hub-register]", 1);
-      if (mlx->iir_ != NULL)
-      { // this will 'reset' the IIR buffer!
-        free(mlx->iir_);
-        mlx->iir_ = NULL;
+      if (temporal_filter_reserve(&mlx->filter_) == 0)
+      { // restarts at the next frame
+        mlx->flags_ |= (1U<<MLX90640_CMD_FLAG_IIR_FILTER);
+        send_answer_chunk(channel_mask, ":FLAGS=OK [hub-register]", 1);
+      } else
+      {
+        send_answer_chunk(channel_mask, ":FLAGS=FAIL; not enough filter memory", 1);
       }
     }
     else if (!strcmp(input+strlen(var_name), "-IIR"))
     {
       mlx->flags_ &= ~(1U<<MLX90640_CMD_FLAG_IIR_FILTER);
       send_answer_chunk(channel_mask, ":FLAGS=OK [hub-register]", 1);
-      if (mlx->iir_ != NULL)
-      { // clean up the IIR buffer
-        free(mlx->iir_);
-        mlx->iir_ = NULL;
-      }
+      temporal_filter_reset(&mlx->filter_); // release the history
     }
     else if (!strcmp(input+strlen(var_name), "+FF"))
     {
@@ -708,6 +1124,28 @@ cmd_90640_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
       mlx->flags_ &= ~(1U<<MLX90640_CMD_FLAG_ND_ON_FULL_FRAME);
       send_answer_chunk(channel_mask, ":FLAGS=OK [hub-register]", 1);
     }
+    else if (!strcmp(input+strlen(var_name), "+FAST_ROOT"))
+    {
+      mlx->flags_ |= (1U<<MLX90640_CMD_FLAG_FAST_ROOT);
+      send_answer_chunk(channel_mask, ":FLAGS=OK [hub-register]", 1);
+    }
+    else if (!strcmp(input+strlen(var_name), "-FAST_ROOT"))
+    {
+      mlx->flags_ &= ~(1U<<MLX90640_CMD_FLAG_FAST_ROOT);
+      send_answer_chunk(channel_mask, ":FLAGS=OK [hub-register]", 1);
+    }
+    else if (!strcmp(input+strlen(var_name), "+PIPELINE"))
+    {
+      cmd_90640_pipe_reset(mlx);
+      mlx->flags_ |= (1U<<MLX90640_CMD_FLAG_PIPELINE);
+      send_answer_chunk(channel_mask, ":FLAGS=OK [hub-register]", 1);
+    }
+    else if (!strcmp(input+strlen(var_name), "-PIPELINE"))
+    {
+      mlx90640_frame_sm_abort(&mlx->sm_);
+      mlx->flags_ &= ~(1U<<MLX90640_CMD_FLAG_PIPELINE);
+      send_answer_chunk(channel_mask, ":FLAGS=OK [hub-register]", 1);
+    }
     else
     {
       send_answer_chunk(channel_mask, ":FLAGS=FAIL; unknown value '", 0);
@@ -764,8 +1202,13 @@ cmd_90640_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
       g_sa_list[sa].found_ = 0; // reset 'found' bit on 'old'-SA.
 
       // we assume that the new SA will use the same driver!
-      i2c_stick_register_driver(new_sa, DRV_MLX90640_ID);
-      g_sa_list[new_sa].spot_ = 1; // set 'found' bit on 'new'-SA.
+      int16_t spot = i2c_stick_register_driver(new_sa, DRV_MLX90640_ID);
+      if (spot > 0)
+      {
+        g_sa_list[new_sa].spot_ = spot;
+        g_sa_list[new_sa].found_ = 1; // set 'found' bit on 'new'-SA.
+        i2c_stick_update_sa_ops(new_sa);
+      }
 
       send_answer_chunk(channel_mask, ":SA=OK! [mlx-EE]", 1);
     } else
@@ -854,6 +1297,7 @@ cmd_90640_mw(uint8_t sa, uint16_t *mem_data, uint16_t mem_start_address, uint16_
   {
     cmd_90640_init(sa);
   }
+  reg_shadow_invalidate(&mlx->shadow_);
 
   uint8_t write_in_eeprom = true;
   if (mem_start_address >= (0x2400 + 832))
@@ -870,6 +1314,11 @@ cmd_90640_mw(uint8_t sa, uint16_t *mem_data, uint16_t mem_start_address, uint16_
   uint16_t i2c_clock_enum = 0;
   if (write_in_eeprom)
   {
+    uint16_t sn_list[3];
+    if (MLX90640_I2CRead(sa, 0x2407, 3, sn_list) == 0)
+    { // the cached calibration parameters are no longer valid
+      i2c_stick_calib_cache_invalidate(DRV_MLX90640_ID, sn_list, 3);
+    }
     i2c_clock_enum = i2c_stick_get_i2c_clock_frequency();
     if (i2c_clock_enum == HOST_CFG_I2C_F1M)
     {
@@ -910,6 +1359,12 @@ cmd_90640_mw(uint8_t sa, uint16_t *mem_data, uint16_t mem_start_address, uint16_
   { // restore original I2C clock frequency
     i2c_stick_set_i2c_clock_frequency(i2c_clock_enum);
   }
+
+  if ((mem_start_address <= 0x800D) && (0x800D < (uint32_t)mem_start_address + mem_count))
+  { // the control register is written; keep refresh_rate_ in sync for cmd_90640_rp.
+    int rr = MLX90640_GetRefreshRate(sa);
+    if (rr >= 0) mlx->refresh_rate_ = rr;
+  }
 }
 
 
@@ -943,204 +1398,6 @@ cmd_90640_is(uint8_t sa, uint8_t *is_ok, char const **error_message)
 }
 
 
-void cmd_90640_iir_filter(float *to_list, float *iir, uint8_t depth, float threshold)
-{
-  for (uint16_t pix=0; pix<768; pix++)
-  {
-    if ((-100 <= to_list[pix]) && (to_list[pix] <= 1000))
-    {
-      if (fabs(to_list[pix] - iir[pix]) >= threshold)
-      {
-        iir[pix] += ((to_list[pix] - iir[pix]) * 0.9f); // take 90% of the change.
-      } else
-      {
-        iir[pix] = (to_list[pix] + iir[pix] * (depth - 1)) / depth;
-      }
-    }
-  }
-}
-
-
-static float helper_median(float *arr, uint16_t n)
-{
-  float temp = 0.0f;
-  uint16_t min_idx;
-
-  /* sorting */
-  for (uint16_t i = 0; i < n - 1; i++)
-  {
-    // Find the minimum element in unsorted array
-    min_idx = i;
-    for (uint16_t j = i + 1; j < n; j++)
-    {
-      if (arr[j] < arr[min_idx])
-      {
-        min_idx = j;
-      }
-    }
-
-    // Swap the found minimum element with the first element
-    temp = arr[i];
-    arr[i] = arr[min_idx];
-    arr[min_idx] = temp;
-  }
-
-  /* get median */
-  if((n % 2) == 0) // when even array length => average of 2 middle elements.
-    return (arr[(n-1)/2] + arr[n/2])/2.0;
-
-  return arr[n/2];
-}
-
-
-void cmd_90640_deinterlace_filter(float *to_list, uint8_t subpage)
-{
-  uint8_t odd = 0;
-  float a = 2.0f;
-  float temp_arr[6];
-
-  if (subpage == 1)
-  {
-    for (uint16_t row=0; row<24; row++)
-    {
-      for (uint16_t col=odd; col<32; col+=2)
-      {
-        if (row == 0)
-        {
-          if (col == 0)
-          {
-            temp_arr[0] = to_list[(row+1)*32+(col+0)];
-            temp_arr[1] = to_list[(row+0)*32+(col+1)];
-            temp_arr[2] = to_list[(row+0)*32+(col+0)];
-            a = helper_median(temp_arr, 3);
-          } else
-          {
-            temp_arr[0] = to_list[(row+0)*32+(col-1)];
-            temp_arr[1] = to_list[(row+1)*32+(col+0)];
-            temp_arr[2] = to_list[(row+0)*32+(col+1)];
-            temp_arr[3] = to_list[(row+0)*32+(col+0)];
-            a = helper_median(temp_arr, 4);
-          }
-        } else if (row == 23)
-        {
-          if (col == 31)
-          {
-            temp_arr[0] = to_list[(row-1)*32+(col+0)];
-            temp_arr[1] = to_list[(row+0)*32+(col-1)];
-            temp_arr[2] = to_list[(row+0)*32+(col+0)];
-            a = helper_median(temp_arr, 3);
-          } else
-          {
-            temp_arr[0] = to_list[(row+0)*32+(col-1)];
-            temp_arr[1] = to_list[(row-1)*32+(col+0)];
-            temp_arr[2] = to_list[(row+0)*32+(col+1)];
-            temp_arr[3] = to_list[(row+0)*32+(col+0)];
-            a = helper_median(temp_arr, 4);
-          }
-        } else if ((col == 0) && ((row % 2) == 0))
-        {
-          temp_arr[0] = to_list[(row-1)*32+(col+0)];
-          temp_arr[1] = to_list[(row+1)*32+(col+0)];
-          temp_arr[2] = to_list[(row+0)*32+(col+1)];
-          temp_arr[3] = to_list[(row+0)*32+(col+0)];
-          a = helper_median(temp_arr, 4);
-        } else if ((col == 31) && ((row % 2) == 1))
-        {
-          temp_arr[0] = to_list[(row+0)*32+(col-1)];
-          temp_arr[1] = to_list[(row-1)*32+(col+0)];
-          temp_arr[2] = to_list[(row+1)*32+(col+0)];
-          temp_arr[3] = to_list[(row+0)*32+(col+0)];
-          a = helper_median(temp_arr, 4);
-        } else
-        {
-          temp_arr[0] = to_list[(row-1)*32+(col+0)];
-          temp_arr[1] = to_list[(row+1)*32+(col+0)];
-          temp_arr[2] = to_list[(row+0)*32+(col-1)];
-          temp_arr[3] = to_list[(row+0)*32+(col+1)];
-          temp_arr[4] = to_list[(row+0)*32+(col+0)];
-          temp_arr[5] = to_list[(row+0)*32+(col+0)];
-          a = helper_median(temp_arr, 6);
-        }
-        if (fabs(a - to_list[row*32+col]) > 0.7)
-        {
-          to_list[row*32+col] = a;
-        }
-      }
-      odd ^= 0x01;
-    }
-  } else
-  {
-    odd = 1;
-    for (uint16_t row=0; row<24; row++)
-    {
-      for (uint16_t col=odd; col<32; col+=2)
-      {
-        if (row == 0)
-        {
-          if (col == 31)
-          {
-            temp_arr[0] = to_list[(row+0)*32+(col-1)];
-            temp_arr[1] = to_list[(row+1)*32+(col+0)];
-            temp_arr[2] = to_list[(row+0)*32+(col+0)];
-            a = helper_median(temp_arr, 3);
-          } else
-          {
-            temp_arr[0] = to_list[(row+0)*32+(col-1)];
-            temp_arr[1] = to_list[(row+1)*32+(col+0)];
-            temp_arr[2] = to_list[(row+0)*32+(col+1)];
-            temp_arr[3] = to_list[(row+0)*32+(col+0)];
-            a = helper_median(temp_arr, 4);
-          }
-        } else if (row == 23)
-        {
-          if (col == 0)
-          {
-            temp_arr[0] = to_list[(row-1)*32+(col+0)];
-            temp_arr[1] = to_list[(row+0)*32+(col+1)];
-            temp_arr[2] = to_list[(row+0)*32+(col+0)];
-            a = helper_median(temp_arr, 3);
-          } else
-          {
-            temp_arr[0] = to_list[(row+0)*32+(col-1)];
-            temp_arr[1] = to_list[(row-1)*32+(col+0)];
-            temp_arr[2] = to_list[(row+0)*32+(col+1)];
-            temp_arr[3] = to_list[(row+0)*32+(col+0)];
-            a = helper_median(temp_arr, 4);
-          }
-        } else if ((col == 0) && ((row % 2) == 1))
-        {
-          temp_arr[0] = to_list[(row-1)*32+(col+0)];
-          temp_arr[1] = to_list[(row+1)*32+(col+0)];
-          temp_arr[2] = to_list[(row+0)*32+(col+1)];
-          temp_arr[3] = to_list[(row+0)*32+(col+0)];
-          a = helper_median(temp_arr, 4);
-        } else if ((col == 31) && ((row % 2) == 0))
-        {
-          temp_arr[0] = to_list[(row+0)*32+(col-1)];
-          temp_arr[1] = to_list[(row-1)*32+(col+0)];
-          temp_arr[2] = to_list[(row+1)*32+(col+0)];
-          temp_arr[3] = to_list[(row+0)*32+(col+0)];
-          a = helper_median(temp_arr, 4);
-        } else
-        {
-          temp_arr[0] = to_list[(row-1)*32+(col+0)];
-          temp_arr[1] = to_list[(row+1)*32+(col+0)];
-          temp_arr[2] = to_list[(row+0)*32+(col-1)];
-          temp_arr[3] = to_list[(row+0)*32+(col+1)];
-          temp_arr[4] = to_list[(row+0)*32+(col+0)];
-          temp_arr[5] = to_list[(row+0)*32+(col+0)];
-          a = helper_median(temp_arr, 6);
-        }
-        if (fabs(a - to_list[row*32+col]) > 0.7)
-        {
-          to_list[row*32+col] = a;
-        }
-      }
-      odd ^= 0x01;
-    }
-  }
-}
-
 #ifdef __cplusplus
 }
 #endif
@@ -3,6 +3,15 @@
 
 #include <stdint.h>
 #include "mlx90640_api.h"
+#include "mlx90640_frame_sm.h"
+#include "i2c_stick_reg_shadow.h"
+#include "i2c_stick_thermal.h"
+#include "i2c_stick_temporal.h"
+#include "i2c_stick_roi.h"
+#include "i2c_stick_summary.h"
+#include "i2c_stick_thermal_array.h"
+
+typedef thermal_array_t<24, 32> mlx90640_array_t;
 
 #ifdef __cplusplus
 extern "C" {
@@ -16,17 +25,40 @@ struct MLX90640_t
   uint8_t flags_;
   float emissivity_;
   float t_room_;
-  float to_list_[768];
-  float *iir_;
+  thermal_t to_list_[mlx90640_array_t::pixels_];
+  temporal_filter_t filter_;
+  roi_set_t roi_;
+  summary_cfg_t summary_;
   paramsMLX90640 mlx90640_;
+  calibrationMLX90640 calibration_;
+  uint8_t refresh_rate_;
+  uint8_t frame_used_; // MLX90640_FRAME_USED_* bits; who consumed the last frame
+  uint8_t subpage_ready_; // bit n set => to_list_ holds a fresh To of sub-page n
+  mlx90640_frame_sm_t sm_;
+  uint16_t *frame_data_; // the last collected frame; one of frame_buffer_
+  uint16_t frame_buffer_[2][834]; // PIPELINE: the state machine fills one while the other is calculated
+  uint32_t pipe_collect_ms_;
+  uint32_t pipe_window_ms_;
+  uint16_t pipe_window_count_;
+  uint16_t pipe_drop_count_; // sub-pages missed or never calculated; saturates
+  float pipe_rate_; // calculated sub-pages per second
+  reg_shadow_t shadow_; // control register 1 and I2C configuration
 };
 
+// Consumers of a frame acquired by the state machine.
+#define MLX90640_FRAME_USED_ND                  0
+#define MLX90640_FRAME_USED_MV                  1
+#define MLX90640_FRAME_USED_RAW                 2
+#define MLX90640_FRAME_USED_EMPTY               7 // PIPELINE: no frame collected yet
+
 // Flags for FIR stick operations. (These are not sensor settings)
 #define MLX90640_CMD_FLAG_BROKEN_PIXELS         0
 #define MLX90640_CMD_FLAG_IIR_FILTER            1
 #define MLX90640_CMD_FLAG_OUTLIER_PIXELS        2
 #define MLX90640_CMD_FLAG_DEINTERLACE_FILTER    3
 #define MLX90640_CMD_FLAG_ND_ON_FULL_FRAME      4
+#define MLX90640_CMD_FLAG_FAST_ROOT             5
+#define MLX90640_CMD_FLAG_PIPELINE              6
 
 #define MLX90640_CMD_FLAG_IS_INIT               7
 
@@ -39,6 +71,7 @@ void cmd_90640_tear_down(uint8_t sa);
 void cmd_90640_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_message);
 void cmd_90640_raw(uint8_t sa, uint16_t *raw_list, uint16_t *raw_count, char const **error_message);
 void cmd_90640_nd(uint8_t sa, uint8_t *nd, char const **error_message);
+void cmd_90640_rp(uint8_t sa, uint32_t *period_ms, char const **error_message);
 void cmd_90640_sn(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message);
 void cmd_90640_cs(uint8_t sa, uint8_t channel_mask, const char *input);
 void cmd_90640_cs_write(uint8_t sa, uint8_t channel_mask, const char *input);
@@ -0,0 +1,186 @@
+#include "mlx90640_frame_sm.h"
+#include "mlx90640_api.h"
+#include "mlx90640_i2c_driver.h"
+#include "i2c_stick_hal.h"
+
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+uint16_t
+mlx90640_frame_sm_poll_interval(uint8_t refresh_rate)
+{ // poll the status register 8 times per sub-page
+  uint16_t interval = (2000 >> (refresh_rate & 0x07)) / 8;
+  return interval ? interval : 1;
+}
+
+
+static uint8_t
+sm_fail(mlx90640_frame_sm_t *sm, int16_t error)
+{
+  sm->error_ = error;
+  sm->state_ = MLX90640_SM_ERROR;
+  return sm->state_;
+}
+
+
+void
+mlx90640_frame_sm_start(mlx90640_frame_sm_t *sm, uint8_t sa, uint16_t *frame_data, uint16_t poll_interval_ms, uint8_t subpage_mask)
+{
+  mlx90640_frame_sm_abort(sm);
+  sm->sa_ = sa;
+  sm->frame_data_ = frame_data;
+  sm->poll_interval_ms_ = poll_interval_ms;
+  sm->subpage_mask_ = subpage_mask;
+  sm->next_poll_ms_ = 0;
+  sm->error_ = 0;
+  sm->state_ = MLX90640_SM_POLL_STATUS;
+}
+
+
+uint8_t
+mlx90640_frame_sm_step(mlx90640_frame_sm_t *sm, uint32_t now_ms)
+{
+  int error;
+  switch(sm->state_)
+  {
+    case MLX90640_SM_POLL_STATUS:
+      if ((sm->next_poll_ms_ != 0) && ((int32_t)(now_ms - sm->next_poll_ms_) < 0))
+      {
+        break; // not yet time to poll
+      }
+      error = MLX90640_I2CRead(sm->sa_, MLX90640_STATUS_REG, 1, &sm->status_);
+      if (error != MLX90640_NO_ERROR)
+      {
+        return sm_fail(sm, error);
+      }
+      if ((!MLX90640_GET_DATA_READY(sm->status_)) ||
+          (!(sm->subpage_mask_ & (1U << MLX90640_GET_FRAME(sm->status_)))))
+      {
+        sm->next_poll_ms_ = now_ms + sm->poll_interval_ms_;
+        if (sm->next_poll_ms_ == 0) sm->next_poll_ms_ = 1;
+        break;
+      }
+      sm->state_ = MLX90640_SM_CLEAR_FLAG;
+      break;
+
+    case MLX90640_SM_CLEAR_FLAG:
+      error = MLX90640_I2CWrite(sm->sa_, MLX90640_STATUS_REG, MLX90640_INIT_STATUS_VALUE);
+      if (error == -MLX90640_I2C_NACK_ERROR)
+      {
+        return sm_fail(sm, error);
+      }
+      sm->state_ = MLX90640_SM_READ_PIXELS;
+      break;
+
+    case MLX90640_SM_READ_PIXELS:
+      sm->address_[0] = MLX90640_PIXEL_DATA_START_ADDRESS >> 8;
+      sm->address_[1] = MLX90640_PIXEL_DATA_START_ADDRESS & 0x00FF;
+      memset(&sm->xfer_, 0, sizeof(sm->xfer_));
+      sm->xfer_.sa_ = sm->sa_;
+      sm->xfer_.bytes_per_address_ = 2;
+      sm->xfer_.write_buffer_ = sm->address_;
+      sm->xfer_.write_n_bytes_ = 2;
+      sm->xfer_.read_buffer_ = (uint8_t *)sm->frame_data_;
+      sm->xfer_.read_n_bytes_ = 2 * MLX90640_PIXEL_NUM;
+      if (hal_i2c_xfer_submit(&sm->xfer_) != 0)
+      {
+        return sm_fail(sm, -1);
+      }
+      sm->state_ = MLX90640_SM_WAIT_PIXELS;
+      break;
+
+    case MLX90640_SM_WAIT_PIXELS:
+      hal_i2c_xfer_poll();
+      if (sm->xfer_.state_ != HAL_I2C_XFER_DONE)
+      {
+        break;
+      }
+      if (sm->xfer_.result_ != 0)
+      {
+        return sm_fail(sm, -1);
+      }
+      for (uint16_t i=0; i<MLX90640_PIXEL_NUM; i++)
+      { // big endian on the bus
+        uint8_t *p = (uint8_t *)sm->frame_data_;
+        sm->frame_data_[i] = (uint16_t(p[2*i]) << 8) | p[2*i+1];
+      }
+      sm->state_ = MLX90640_SM_READ_AUX;
+      break;
+
+    case MLX90640_SM_READ_AUX:
+      error = MLX90640_I2CRead(sm->sa_, MLX90640_AUX_DATA_START_ADDRESS, MLX90640_AUX_NUM, sm->aux_);
+      if (error != MLX90640_NO_ERROR)
+      {
+        return sm_fail(sm, error);
+      }
+      error = MLX90640_I2CRead(sm->sa_, MLX90640_CTRL_REG, 1, &sm->frame_data_[832]);
+      if (error != MLX90640_NO_ERROR)
+      {
+        return sm_fail(sm, error);
+      }
+      sm->frame_data_[833] = MLX90640_GET_FRAME(sm->status_);
+      sm->state_ = MLX90640_SM_VALIDATE;
+      break;
+
+    case MLX90640_SM_VALIDATE:
+      if (MLX90640_ValidateAuxData(sm->aux_) == MLX90640_NO_ERROR)
+      {
+        memcpy(&sm->frame_data_[MLX90640_PIXEL_NUM], sm->aux_, sizeof(sm->aux_));
+      }
+      error = MLX90640_ValidateFrameData(sm->frame_data_);
+      if (error != MLX90640_NO_ERROR)
+      {
+        return sm_fail(sm, error);
+      }
+      error = MLX90640_I2CRead(sm->sa_, MLX90640_STATUS_REG, 1, &sm->status_);
+      if (error != MLX90640_NO_ERROR)
+      {
+        return sm_fail(sm, error);
+      }
+      if (MLX90640_GET_DATA_READY(sm->status_)) // new data became ready during the read out...
+      {
+        return sm_fail(sm, -16);
+      }
+      sm->state_ = MLX90640_SM_DONE;
+      break;
+
+    default: // IDLE, DONE, ERROR: nothing to do.
+      break;
+  }
+  return sm->state_;
+}
+
+
+int16_t
+mlx90640_frame_sm_run(mlx90640_frame_sm_t *sm)
+{ // blocking; returns the sub-page number or a negative error code
+  while ((sm->state_ != MLX90640_SM_IDLE) && (sm->state_ != MLX90640_SM_DONE) && (sm->state_ != MLX90640_SM_ERROR))
+  {
+    mlx90640_frame_sm_step(sm, hal_get_millis());
+  }
+  if (sm->state_ == MLX90640_SM_DONE)
+  {
+    return sm->frame_data_[833];
+  }
+  return sm->state_ == MLX90640_SM_ERROR ? sm->error_ : -1;
+}
+
+
+void
+mlx90640_frame_sm_abort(mlx90640_frame_sm_t *sm)
+{ // the transaction engine may still own the pixel read buffer
+  if (sm->state_ == MLX90640_SM_WAIT_PIXELS)
+  {
+    hal_i2c_xfer_wait(&sm->xfer_);
+  }
+  sm->state_ = MLX90640_SM_IDLE;
+}
+
+
+#ifdef __cplusplus
+}
+#endif
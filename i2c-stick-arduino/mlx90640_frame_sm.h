@@ -0,0 +1,52 @@
+#ifndef _MLX90640_FRAME_SM_
+#define _MLX90640_FRAME_SM_
+
+#include <stdint.h>
+#include "mlx90640_api.h"
+#include "i2c_stick_hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Incremental MLX90640 frame acquisition.
+// Every call to mlx90640_frame_sm_step does at most one short I2C transaction
+// (two for the aux data and control register; the pixel read may even run in
+// the background), such that the caller can return to loop() in between.
+#define MLX90640_SM_IDLE        0
+#define MLX90640_SM_POLL_STATUS 1
+#define MLX90640_SM_CLEAR_FLAG  2
+#define MLX90640_SM_READ_PIXELS 3
+#define MLX90640_SM_WAIT_PIXELS 4
+#define MLX90640_SM_READ_AUX    5
+#define MLX90640_SM_VALIDATE    6
+#define MLX90640_SM_DONE        7
+#define MLX90640_SM_ERROR       8
+
+struct mlx90640_frame_sm_t
+{
+  uint8_t sa_;
+  uint8_t state_;
+  uint8_t subpage_mask_; // bit n set => accept sub-page n
+  int16_t error_;
+  uint16_t poll_interval_ms_;
+  uint32_t next_poll_ms_;
+  uint16_t status_;
+  uint8_t address_[2];
+  hal_i2c_xfer_t xfer_;
+  uint16_t aux_[MLX90640_AUX_NUM];
+  uint16_t *frame_data_; // 834 words
+};
+
+uint16_t mlx90640_frame_sm_poll_interval(uint8_t refresh_rate);
+
+void mlx90640_frame_sm_start(mlx90640_frame_sm_t *sm, uint8_t sa, uint16_t *frame_data, uint16_t poll_interval_ms, uint8_t subpage_mask);
+uint8_t mlx90640_frame_sm_step(mlx90640_frame_sm_t *sm, uint32_t now_ms);
+int16_t mlx90640_frame_sm_run(mlx90640_frame_sm_t *sm);
+void mlx90640_frame_sm_abort(mlx90640_frame_sm_t *sm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
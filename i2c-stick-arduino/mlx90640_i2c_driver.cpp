@@ -21,6 +21,8 @@
 
 #include "i2c_stick.h"
 #include "i2c_stick_arduino.h"
+#include "i2c_stick_hal.h"
+#include "i2c_stick_reg_shadow.h"
 
 
 void MLX90640_I2CInit()
@@ -32,22 +34,13 @@ void MLX90640_I2CInit()
 
 int MLX90640_I2CGeneralReset(void)
 {
-    int ack;
+    uint8_t cmd = 0x06;
 
-    WIRE.endTransmission();
-    delayMicroseconds(5);
-
-    WIRE.beginTransmission(0x00);
-    WIRE.write(0x06);
-    ack = WIRE.endTransmission();
-#ifdef ARDUINO_ARCH_RP2040  
-    if (ack == 4) ack = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-
-    if (ack != 0x00)
+    if (hal_i2c_transfer(0x00, &cmd, 1, NULL, 0, 0) != 0)
     {
         return -1;
     }
+    reg_shadow_invalidate_all();
 
     delayMicroseconds(50);
     return 0;
@@ -56,78 +49,44 @@ int MLX90640_I2CGeneralReset(void)
 
 int MLX90640_I2CRead(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddressRead, uint16_t *data)
 {
-    int16_t ack = 0;
-    int16_t cnt = 0;
-    int16_t n = 0;
-    uint16_t *p;
-
-    p = data;
+    uint8_t address[2] = { uint8_t(startAddress >> 8), uint8_t(startAddress & 0x00FF) };
+    uint8_t *p = (uint8_t *)data;
 
-    WIRE.endTransmission();
-    delayMicroseconds(5);
-
-    for (cnt = 2*nMemAddressRead; cnt > 0; cnt -= READ_BUFFER_SIZE)
-    {
-      WIRE.beginTransmission(slaveAddr);
-      WIRE.write(startAddress >> 8);
-      WIRE.write(startAddress & 0x00FF);
-      ack = WIRE.endTransmission(false);     // repeated start
-#ifdef ARDUINO_ARCH_RP2040  
-      if (ack == 4) ack = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-      if (ack != 0x00)
-      {
-          return -1;
-      }
-      n = cnt > READ_BUFFER_SIZE ? READ_BUFFER_SIZE : cnt;
-      startAddress += (n/2);
-      WIRE.requestFrom((int)slaveAddr, (int)n);
-      for(; n>0; n-=2)
-      {
-        uint16_t val = WIRE.read();
-        val <<= 8;
-        val |= WIRE.read();
-        *p++ = val;
-      }
+    reg_shadow_t *shadow = (nMemAddressRead == 1) ? reg_shadow_find(slaveAddr) : NULL;
+    if (reg_shadow_read(shadow, startAddress, data))
+    { // control register; no need to go on the bus.
+        return 0;
     }
 
-    ack = WIRE.endTransmission();     // stop transmitting
-#ifdef ARDUINO_ARCH_RP2040  
-    if (ack == 4) ack = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-
-    if (ack != 0x00)
+    // one transaction for the whole block; the engine splits it (2 bytes per address) only when it must.
+    if (hal_i2c_transfer(slaveAddr, address, 2, p, 2*nMemAddressRead, 2) != 0)
     {
         return -1;
     }
 
+    for (uint16_t i=0; i<nMemAddressRead; i++)
+    { // big endian on the bus; in place is safe as word i only uses bytes 2i and 2i+1.
+        data[i] = (uint16_t(p[2*i]) << 8) | p[2*i+1];
+    }
+    reg_shadow_update(shadow, startAddress, data[0]);
+
     return 0;
 }
 
 
 void MLX90640_I2CFreqSet(int freq)
 {
-    WIRE.end();          // some MCU cannot change the clock while I2C is active.
-    WIRE.setClock(freq); // RP2040 requires first to set the clock
-    WIRE.begin();
-    WIRE.setClock(freq); // NRF52840 requires first begin, then set clock.
+    hal_i2c_set_clock_frequency(freq); // waits for the I2C engine to be idle
 }
 
 
 int MLX90640_I2CWrite(uint8_t slaveAddr, uint16_t writeAddress, uint16_t data)
 {
     uint16_t dataCheck;
-    WIRE.beginTransmission(slaveAddr);
     uint8_t writeAddress_MSB = uint8_t(writeAddress >> 8);
-    WIRE.write(uint8_t(writeAddress_MSB));
-    WIRE.write(uint8_t(writeAddress & 0xFF));
-    WIRE.write(uint8_t(data >> 8));
-    WIRE.write(uint8_t(data & 0xFF));
-    int16_t ack = WIRE.endTransmission();
-#ifdef ARDUINO_ARCH_RP2040  
-    if (ack == 4) ack = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-    if (ack != 0x00)
+    uint8_t cmd[4] = { writeAddress_MSB, uint8_t(writeAddress & 0xFF), uint8_t(data >> 8), uint8_t(data & 0xFF) };
+
+    if (hal_i2c_transfer(slaveAddr, cmd, 4, NULL, 0, 0) != 0)
     {
         return -1;
     }
@@ -136,6 +95,14 @@ int MLX90640_I2CWrite(uint8_t slaveAddr, uint16_t writeAddress, uint16_t data)
         delay(10); // 10 ms write time
     }
 
+    reg_shadow_t *shadow = reg_shadow_find(slaveAddr);
+    if (!reg_shadow_verify_write(shadow, writeAddress_MSB == 0x24))
+    {
+        reg_shadow_update(shadow, writeAddress, data);
+        return 0;
+    }
+
+    reg_shadow_drop(shadow, writeAddress); // read back from the sensor
     MLX90640_I2CRead(slaveAddr, writeAddress, 1, &dataCheck);
 
     if ( dataCheck != data)
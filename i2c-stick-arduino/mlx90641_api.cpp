@@ -16,6 +16,7 @@
  */
 #include "mlx90641_i2c_driver.h"
 #include "mlx90641_api.h"
+#include "i2c_stick_thermal_to.h"
 #include <math.h>
 
 static void ExtractVDDParameters(uint16_t *eeData, paramsMLX90641 *mlx90641);
@@ -36,6 +37,7 @@ static int CheckEEPROMValid(uint16_t *eeData);
 static int HammingDecode(uint16_t *eeData);  
 static int ValidateFrameData(uint16_t *frameData);
 static int ValidateAuxData(uint16_t *auxData);
+static void CalculateTo(uint16_t *frameData, const paramsMLX90641 *params, float emissivity, float tr, float *result, uint8_t fastRoot, const uint32_t *pixelMask);
 
 //------------------------------------------------------------------------------
   
@@ -539,26 +541,39 @@ int MLX90641_GetRefreshRate(uint8_t slaveAddr)
 //------------------------------------------------------------------------------
 
 void MLX90641_CalculateTo(uint16_t *frameData, const paramsMLX90641 *params, float emissivity, float tr, float *result)
+{
+    CalculateTo(frameData, params, emissivity, tr, result, 0, NULL);
+}
+
+//------------------------------------------------------------------------------
+
+void MLX90641_CalculateToFast(uint16_t *frameData, const paramsMLX90641 *params, float emissivity, float tr, float *result)
+{
+    CalculateTo(frameData, params, emissivity, tr, result, 1, NULL);
+}
+
+//------------------------------------------------------------------------------
+
+void MLX90641_CalculateToMasked(uint16_t *frameData, const paramsMLX90641 *params, float emissivity, float tr, float *result, uint8_t fastRoot, const uint32_t *pixelMask)
+{
+    CalculateTo(frameData, params, emissivity, tr, result, fastRoot, pixelMask);
+}
+
+//------------------------------------------------------------------------------
+
+static void CalculateTo(uint16_t *frameData, const paramsMLX90641 *params, float emissivity, float tr, float *result, uint8_t fastRoot, const uint32_t *pixelMask)
 {
     float vdd;
     float ta;
     float ta4;
     float tr4;
-    float taTr;
     float gain;
     float irDataCP;
-    float irData;
-    float alphaCompensated;
-    float Sx;
-    float To;
-    float alphaCorrR[8];
-    int8_t range;
     uint16_t subPage;
     float ktaScale;
     float kvScale;
     float alphaScale;
-    float kta;
-    float kv;
+    thermal_to_cfg_t<8> cfg;
     
     subPage = frameData[241];
     vdd = MLX90641_GetVdd(frameData, params);
@@ -570,20 +585,25 @@ void MLX90641_CalculateTo(uint16_t *frameData, const paramsMLX90641 *params, flo
     tr4 = tr4 * tr4;
     tr4 = tr4 * tr4;
     
-    taTr = tr4 - (tr4-ta4)/emissivity;
-    
-    ktaScale = pow(2,(double)params->ktaScale);
-    kvScale = pow(2,(double)params->kvScale);
-    alphaScale = pow(2,(double)params->alphaScale);
-    
-    alphaCorrR[1] = 1 / (1 + params->ksTo[1] * 20);
-    alphaCorrR[0] = alphaCorrR[1] / (1 + params->ksTo[0] * 20);
-    alphaCorrR[2] = 1 ;
-    alphaCorrR[3] = (1 + params->ksTo[2] * params->ct[3]);
-    alphaCorrR[4] = alphaCorrR[3] * (1 + params->ksTo[3] * (params->ct[4] - params->ct[3]));
-    alphaCorrR[5] = alphaCorrR[4] * (1 + params->ksTo[4] * (params->ct[5] - params->ct[4]));
-    alphaCorrR[6] = alphaCorrR[5] * (1 + params->ksTo[5] * (params->ct[6] - params->ct[5]));
-    alphaCorrR[7] = alphaCorrR[6] * (1 + params->ksTo[6] * (params->ct[7] - params->ct[6]));
+    cfg.ta_tr_ = tr4 - (tr4-ta4)/emissivity;
+    cfg.fast_root_ = fastRoot;
+    cfg.ks_to_ = params->ksTo;
+    cfg.ct_ = params->ct;
+    cfg.ks_to_sx_ = params->ksTo[2];
+    cfg.ks_to_sx_corr_ = 1 - params->ksTo[2] * 273.15;
+    
+    ktaScale = ldexpf(1.0f, params->ktaScale);
+    kvScale = ldexpf(1.0f, params->kvScale);
+    alphaScale = ldexpf(1.0f, params->alphaScale);
+    
+    cfg.alpha_corr_r_[1] = 1 / (1 + params->ksTo[1] * 20);
+    cfg.alpha_corr_r_[0] = cfg.alpha_corr_r_[1] / (1 + params->ksTo[0] * 20);
+    cfg.alpha_corr_r_[2] = 1 ;
+    cfg.alpha_corr_r_[3] = (1 + params->ksTo[2] * params->ct[3]);
+    cfg.alpha_corr_r_[4] = cfg.alpha_corr_r_[3] * (1 + params->ksTo[3] * (params->ct[4] - params->ct[3]));
+    cfg.alpha_corr_r_[5] = cfg.alpha_corr_r_[4] * (1 + params->ksTo[4] * (params->ct[5] - params->ct[4]));
+    cfg.alpha_corr_r_[6] = cfg.alpha_corr_r_[5] * (1 + params->ksTo[5] * (params->ct[6] - params->ct[5]));
+    cfg.alpha_corr_r_[7] = cfg.alpha_corr_r_[6] * (1 + params->ksTo[6] * (params->ct[7] - params->ct[6]));
     
 //------------------------- Gain calculation -----------------------------------    
     gain = frameData[202];
@@ -604,69 +624,29 @@ void MLX90641_CalculateTo(uint16_t *frameData, const paramsMLX90641 *params, flo
 
     irDataCP = irDataCP - params->cpOffset * (1 + params->cpKta * (ta - 25)) * (1 + params->cpKv * (vdd - 3.3));
     
-    for( int pixelNumber = 0; pixelNumber < 192; pixelNumber++)
-    {      
-        irData = frameData[pixelNumber];
-        if(irData > 32767)
+    // both sub-pages hold all 192 pixels
+    auto compensate = [&](uint16_t pixelNumber, float *irData, float *alphaCompensated)
+    {
+        *irData = frameData[pixelNumber];
+        if(*irData > 32767)
         {
-            irData = irData - 65536;
+            *irData = *irData - 65536;
         }
-        irData = irData * gain;
+        *irData = *irData * gain;
         
-        kta = (float)params->kta[pixelNumber]/ktaScale;
-        kv = (float)params->kv[pixelNumber]/kvScale;
+        float kta = (float)params->kta[pixelNumber]/ktaScale;
+        float kv = (float)params->kv[pixelNumber]/kvScale;
             
-        irData = irData - params->offset[subPage][pixelNumber]*(1 + kta*(ta - 25))*(1 + kv*(vdd - 3.3));                
+        *irData = *irData - params->offset[subPage][pixelNumber]*(1 + kta*(ta - 25))*(1 + kv*(vdd - 3.3));                
     
-        irData = irData - params->tgc * irDataCP;
-        
-        irData = irData / emissivity;
-        
-        alphaCompensated = SCALEALPHA*alphaScale/params->alpha[pixelNumber];
-        alphaCompensated = alphaCompensated*(1 + params->KsTa * (ta - 25));
+        *irData = *irData - params->tgc * irDataCP;
         
-        Sx = alphaCompensated * alphaCompensated * alphaCompensated * (irData + alphaCompensated * taTr);
-        Sx = sqrt(sqrt(Sx)) * params->ksTo[2];
+        *irData = *irData / emissivity;
         
-        To = sqrt(sqrt(irData/(alphaCompensated * (1 - params->ksTo[2] * 273.15) + Sx) + taTr)) - 273.15;
-                
-        if(To < params->ct[1])
-        {
-            range = 0;
-        }
-        else if(To < params->ct[2])   
-        {
-            range = 1;            
-        }   
-        else if(To < params->ct[3])
-        {
-            range = 2;            
-        }
-        else if(To < params->ct[4])
-        {
-            range = 3;            
-        }
-        else if(To < params->ct[5])
-        {
-            range = 4;            
-        }
-        else if(To < params->ct[6])
-        {
-            range = 5;            
-        }
-        else if(To < params->ct[7])
-        {
-            range = 6;            
-        }
-        else
-        {
-            range = 7;            
-        }      
-        
-        To = sqrt(sqrt(irData / (alphaCompensated * alphaCorrR[range] * (1 + params->ksTo[range] * (To - params->ct[range]))) + taTr)) - 273.15;
-        
-        result[pixelNumber] = To;
-    }
+        *alphaCompensated = SCALEALPHA*alphaScale/params->alpha[pixelNumber];
+        *alphaCompensated = *alphaCompensated*(1 + params->KsTa * (ta - 25));
+    };
+    thermal_calculate_to<192>(&cfg, NULL, pixelMask, compensate, result);
 }
 
 //------------------------------------------------------------------------------
@@ -1328,3 +1308,4 @@ int ExtractDeviatingPixels(uint16_t *eeData, paramsMLX90641 *mlx90641)
      
      return -7;    
  }        
+
@@ -60,6 +60,9 @@
     float MLX90641_GetTa(uint16_t *frameData, const paramsMLX90641 *params);
     void MLX90641_GetImage(uint16_t *frameData, const paramsMLX90641 *params, float *result);
     void MLX90641_CalculateTo(uint16_t *frameData, const paramsMLX90641 *params, float emissivity, float tr, float *result);
+    void MLX90641_CalculateToFast(uint16_t *frameData, const paramsMLX90641 *params, float emissivity, float tr, float *result);
+    // pixelMask: bit n set => calculate pixel n; NULL => all pixels.
+    void MLX90641_CalculateToMasked(uint16_t *frameData, const paramsMLX90641 *params, float emissivity, float tr, float *result, uint8_t fastRoot, const uint32_t *pixelMask);
     int MLX90641_SetResolution(uint8_t slaveAddr, uint8_t resolution);
     int MLX90641_GetCurResolution(uint8_t slaveAddr);
     int MLX90641_SetRefreshRate(uint8_t slaveAddr, uint8_t refreshRate);   
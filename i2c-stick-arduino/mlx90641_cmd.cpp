@@ -4,7 +4,11 @@
 #include "i2c_stick.h"
 #include "i2c_stick_cmd.h"
 #include "i2c_stick_dispatcher.h"
+#include "i2c_stick_pool.h"
+#include "i2c_stick_scratch.h"
 #include "i2c_stick_hal.h"
+#include "i2c_stick_calib_cache.h"
+#include "i2c_stick_quant.h"
 
 #include <string.h>
 #include <stdlib.h>
@@ -15,18 +19,26 @@
 extern "C" {
 #endif
 
-void cmd_90641_iir_filter(float *to_list, float *iir, uint8_t depth, float threshold);
-
 #ifndef MAX_MLX90641_SLAVES
-#define MAX_MLX90641_SLAVES 8
+#define MAX_MLX90641_SLAVES 8 // every slot is statically allocated
 #endif // MAX_MLX90641_SLAVES
 
+#ifndef MLX90641_FILTER_BLOCKS
+#define MLX90641_FILTER_BLOCKS TEMPORAL_FILTER_MAX_BLOCKS // temporal filter history, shared by the slaves; a moving average takes 'depth' blocks
+#endif // MLX90641_FILTER_BLOCKS
+
 #define MLX90641_ERROR_BUFFER_TOO_SMALL "Buffer too small"
 #define MLX90641_ERROR_COMMUNICATION "Communication error"
 #define MLX90641_ERROR_NEW_DATA_SET "new_data bit set during read"
 #define MLX90641_ERROR_NO_FREE_HANDLE "No free handle; pls recompile firmware with higher 'MAX_MLX90641_SLAVES'"
+#define MLX90641_ERROR_FILTER_MEMORY "Not enough filter memory; pls recompile firmware with higher 'MLX90641_FILTER_BLOCKS'"
+#define MLX90641_ERROR_SCRATCH "scratch arena exhausted"
 
 static MLX90641_t *g_mlx90641_list[MAX_MLX90641_SLAVES];
+POOL_DEFINE(g_mlx90641_pool, "MLX90641", MLX90641_t, MAX_MLX90641_SLAVES);
+
+typedef mlx90641_array_t::block_t mlx90641_filter_block_t;
+POOL_DEFINE(g_mlx90641_filter_pool, "MLX90641.FILTER", mlx90641_filter_block_t, MLX90641_FILTER_BLOCKS);
 
 
 MLX90641_t *
@@ -68,8 +80,8 @@ cmd_90641_get_handle(uint8_t sa)
   {
     if (g_mlx90641_list[i] == NULL)
     {
-      g_mlx90641_list[i] = (MLX90641_t *)malloc(sizeof(MLX90641_t));;
-      memset(g_mlx90641_list[i], 0, sizeof(MLX90641_t));
+      g_mlx90641_list[i] = (MLX90641_t *)pool_alloc(&g_mlx90641_pool);
+      if (g_mlx90641_list[i] == NULL) return NULL;
       g_mlx90641_list[i]->slave_address_ = 0x80 | sa;
       return g_mlx90641_list[i];
     }
@@ -90,12 +102,11 @@ delete_handle(uint8_t sa)
     }
     if ((g_mlx90641_list[i]->slave_address_ & 0x7F) == sa)
     { // found!
-      if (g_mlx90641_list[i]->iir_ != NULL)
-      {
-        free(g_mlx90641_list[i]->iir_);
-      }
+      reg_shadow_detach(&g_mlx90641_list[i]->shadow_);
+      i2c_stick_calib_cache_cancel(&g_mlx90641_list[i]->mlx90641_);
+      temporal_filter_reset(&g_mlx90641_list[i]->filter_);
       memset(g_mlx90641_list[i], 0, sizeof(MLX90641_t));
-      free(g_mlx90641_list[i]);
+      pool_free(&g_mlx90641_pool, g_mlx90641_list[i]);
       g_mlx90641_list[i] = NULL;
     }
   }
@@ -106,6 +117,8 @@ int16_t
 cmd_90641_register_driver()
 {
   int16_t r = 0;
+  pool_register(&g_mlx90641_pool);
+  pool_register(&g_mlx90641_filter_pool);
   r = i2c_stick_register_driver(0x33, DRV_MLX90641_ID);
   if (r < 0) return r;
   return 1;
@@ -125,12 +138,36 @@ cmd_90641_init(uint8_t sa)
   mlx->flags_ |= (1U<<MLX90641_CMD_FLAG_BROKEN_PIXELS);
   mlx->flags_ |= (1U<<MLX90641_CMD_FLAG_IIR_FILTER);
 
-  uint16_t ee_data[832];
+  if (temporal_filter_init(&mlx->filter_, &g_mlx90641_filter_pool, mlx90641_array_t::pixels_) != 0)
+  { // the history pool is taken by the other slaves; the filter stays off.
+    mlx->flags_ &= ~(1U<<MLX90641_CMD_FLAG_IIR_FILTER);
+  }
+  roi_init(&mlx->roi_, mlx90641_array_t::cols_, mlx90641_array_t::rows_);
+  summary_init(&mlx->summary_);
 
   MLX90641_I2CInit();
-  MLX90641_DumpEE(sa, ee_data);
-  MLX90641_ExtractParameters(ee_data, &mlx->mlx90641_);
-  MLX90641_SetRefreshRate(sa, 5);
+  static const uint16_t shadow_list[] = { 0x800D, 0x800F };
+  reg_shadow_attach(&mlx->shadow_, sa, shadow_list, 2);
+
+  // the extracted parameters are cached in flash, keyed by the serial number.
+  uint16_t sn_list[3];
+  uint8_t sn_ok = (MLX90641_I2CRead(sa, 0x2407, 3, sn_list) == 0);
+  if ((!sn_ok) || (i2c_stick_calib_cache_load(DRV_MLX90641_ID, sn_list, 3, &mlx->mlx90641_, sizeof(paramsMLX90641)) != 0))
+  {
+    scratch_scope_t scope;
+    scratch_begin(&scope);
+    uint16_t *ee_data = (uint16_t *)scratch_alloc(832 * sizeof(uint16_t));
+    if (ee_data != NULL)
+    {
+      MLX90641_DumpEE(sa, ee_data);
+      if ((MLX90641_ExtractParameters(ee_data, &mlx->mlx90641_) == 0) && (sn_ok))
+      {
+        i2c_stick_calib_cache_store(DRV_MLX90641_ID, sn_list, 3, &mlx->mlx90641_, sizeof(paramsMLX90641));
+      }
+    }
+    scratch_end(&scope);
+  }
+  mlx->period_ms_ = (MLX90641_SetRefreshRate(sa, 5) == 0) ? (2000 >> 5) : 0;
   mlx->slave_address_ &= 0x7F;
 }
 
@@ -158,13 +195,13 @@ cmd_90641_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_
     cmd_90641_init(sa);
   }
 
-  if (*mv_count < 192+1)
+  if (*mv_count < mlx90641_array_t::pixels_+1)
   {
     *error_message = MLX90641_ERROR_BUFFER_TOO_SMALL;
     *mv_count = 0;
     return;
   }
-  *mv_count = 192+1;
+  *mv_count = mlx90641_array_t::pixels_+1;
 
   int e = MLX90641_GetFrameData(sa, frame_data);
 
@@ -185,36 +222,55 @@ cmd_90641_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_
     }
   }
 
-  MLX90641_CalculateTo(frame_data, &mlx->mlx90641_, mlx->emissivity_, mlx->t_room_, &mv_list[1]);
+  // with ROI's or summary the full frame is a work copy; only the ROI values
+  // or the statistics are reported.
+  uint8_t is_roi = roi_is_active(&mlx->roi_);
+  scratch_scope_t scope;
+  scratch_begin(&scope);
+  float *frame = &mv_list[1];
+  if ((is_roi) || (mlx->summary_.is_enabled_))
+  {
+    frame = (float *)scratch_alloc(mlx90641_array_t::pixels_ * sizeof(float));
+    if (frame == NULL)
+    {
+      scratch_end(&scope);
+      *mv_count = 0;
+      *error_message = MLX90641_ERROR_SCRATCH;
+      return;
+    }
+    if (is_roi)
+    { // the masked calculation leaves the pixels outside the ROI's untouched
+      for (uint16_t i=0; i<mlx90641_array_t::pixels_; i++)
+      {
+        frame[i] = NAN;
+      }
+    }
+  }
+
+  uint8_t fast_root = (mlx->flags_ & (1U<<MLX90641_CMD_FLAG_FAST_ROOT)) ? 1 : 0;
+  MLX90641_CalculateToMasked(frame_data, &mlx->mlx90641_, mlx->emissivity_, mlx->t_room_, frame, fast_root, is_roi ? mlx->roi_.compute_mask_ : NULL);
   mv_list[0] = MLX90641_GetTa(frame_data, &mlx->mlx90641_);
 
   if (mlx->flags_ & (1U<<MLX90641_CMD_FLAG_BROKEN_PIXELS))
   {
-    MLX90641_BadPixelsCorrection(mlx->mlx90641_.brokenPixel, &mv_list[1]);
+    MLX90641_BadPixelsCorrection(mlx->mlx90641_.brokenPixel, frame);
   }
 
   if (mlx->flags_ & (1U<<MLX90641_CMD_FLAG_IIR_FILTER))
   {
-    if (mlx->iir_ == NULL)
-    {
-      mlx->iir_ = (float *)malloc(sizeof(float) * 192);
-      for (uint16_t pix=0; pix<192; pix++)
-      {
-        if ((-100 < mv_list[pix+1]) && (mv_list[pix+1] < 1000))
-        {
-          mlx->iir_[pix] = mv_list[pix+1];
-        } else
-        {
-          mlx->iir_[pix] = mv_list[0];
-        }
-      }
-    }
-    cmd_90641_iir_filter(&mv_list[1], mlx->iir_, 8, 2.5);
-    for (uint16_t pix=0; pix<192; pix++)
+    if (mlx90641_array_t::apply_filter_float(&mlx->filter_, &mlx->roi_, frame, mv_list[0]) < 0)
     {
-      mv_list[pix+1] = mlx->iir_[pix];
+      scratch_end(&scope);
+      *mv_count = 0;
+      *error_message = MLX90641_ERROR_FILTER_MEMORY;
+      return;
     }
   }
+
+  // statistics of the frame (or of the ROI's), the ROI values, or the full frame.
+  *mv_count = mlx90641_array_t::output(&mlx->summary_, &mlx->roi_, frame, &mv_list[1])+1;
+  i2c_stick_quant_set_temperature_list(sa, !mlx->summary_.is_enabled_);
+  scratch_end(&scope);
 }
 
 
@@ -280,6 +336,35 @@ cmd_90641_nd(uint8_t sa, uint8_t *nd, char const **error_message)
 }
 
 
+void
+cmd_90641_rp(uint8_t sa, uint32_t *period_ms, char const **error_message)
+{ // the time between two new data events; 0 => unknown.
+  MLX90641_t *mlx = cmd_90641_get_handle(sa);
+  *period_ms = 0;
+  if (mlx == NULL)
+  {
+    *error_message = MLX90641_ERROR_NO_FREE_HANDLE;
+    return;
+  }
+  if (mlx->slave_address_ & 0x80)
+  {
+    cmd_90641_init(sa);
+  }
+
+  if (mlx->period_ms_ == 0)
+  { // unknown after a memory write; read it once.
+    int rr = MLX90641_GetRefreshRate(sa);
+    if (rr < 0)
+    {
+      *error_message = MLX90641_ERROR_COMMUNICATION;
+      return;
+    }
+    mlx->period_ms_ = 2000 >> rr; // time of a single sub-page
+  }
+  *period_ms = mlx->period_ms_;
+}
+
+
 void
 cmd_90641_sn(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message)
 {
@@ -396,22 +481,80 @@ cmd_90641_cs(uint8_t sa, uint8_t channel_mask, const char *input)
     }
     send_answer_chunk(channel_mask, "IIR_FILTER", 0);
   }
+  if (mlx->flags_ & (1U<<MLX90641_CMD_FLAG_FAST_ROOT))
+  {
+    if (is_first_flag)
+    {
+      is_first_flag = 0;
+      send_answer_chunk(channel_mask, "(", 0);
+    } else
+    {
+      send_answer_chunk(channel_mask, ",", 0);
+    }
+    send_answer_chunk(channel_mask, "FAST_ROOT", 0);
+  }
   send_answer_chunk(channel_mask, (is_first_flag == 0) ? ")" : "", 1);
 
   send_answer_chunk(channel_mask, "cs:", 0);
   uint8_to_hex(buf, sa);
   send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ":RO:MV_HEADER=TA,TO_[192]", 1);
+  send_answer_chunk(channel_mask, ":VERIFY=", 0);
+  send_answer_chunk(channel_mask, reg_shadow_policy_to_str(mlx->shadow_.verify_policy_), 1);
+
+  send_answer_chunk(channel_mask, "cs:", 0);
+  uint8_to_hex(buf, sa);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ":FILTER=", 0);
+  send_answer_chunk(channel_mask, temporal_filter_type_to_str(mlx->filter_.type_), 1);
 
   send_answer_chunk(channel_mask, "cs:", 0);
   uint8_to_hex(buf, sa);
   send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ":RO:MV_UNIT=DegC,DegC[192]", 1);
+  send_answer_chunk(channel_mask, ":DEPTH=", 0);
+  itoa(mlx->filter_.depth_, buf, 10);
+  send_answer_chunk(channel_mask, buf, 1);
+
+  send_answer_chunk(channel_mask, "cs:", 0);
+  uint8_to_hex(buf, sa);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ":THRESHOLD=", 0);
+  p = my_dtostrf(mlx->filter_.threshold_degc_, 10, 2, buf);
+  while (*p == ' ') p++; // remove leading space
+  send_answer_chunk(channel_mask, p, 1);
+
+  roi_cs(sa, channel_mask, &mlx->roi_);
+  summary_cs(sa, channel_mask, &mlx->summary_);
 
   send_answer_chunk(channel_mask, "cs:", 0);
   uint8_to_hex(buf, sa);
   send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ":RO:MV_RES=" xstr(MLX90641_LSB_C) "," xstr(MLX90641_LSB_C) "[192]", 1);
+  send_answer_chunk(channel_mask, ":RO:SHADOW_SAVED=", 0);
+  itoa(mlx->shadow_.read_saved_, buf, 10);
+  send_answer_chunk(channel_mask, buf, 0);
+  send_answer_chunk(channel_mask, ",", 0);
+  itoa(mlx->shadow_.verify_saved_, buf, 10);
+  send_answer_chunk(channel_mask, buf, 1);
+
+  summary_cs_mv(sa, channel_mask, &mlx->summary_, &mlx->roi_, MLX90641_LSB_C, MLX90641_LSB_C);
+}
+
+
+static int8_t
+cmd_90641_filter_configure(MLX90641_t *mlx, uint8_t type, uint8_t depth, float threshold_degc)
+{ // the history is only held while the filter is on
+  int8_t r = temporal_filter_configure(&mlx->filter_, type, depth, threshold_degc);
+  if ((r == 0) && (!(mlx->flags_ & (1U<<MLX90641_CMD_FLAG_IIR_FILTER))))
+  {
+    temporal_filter_reset(&mlx->filter_);
+  }
+  return r;
+}
+
+
+static void
+cmd_90641_filter_answer(uint8_t sa, uint8_t channel_mask, const char *var_name, int8_t result, const char *fail_reason)
+{ // answer to the temporal filter settings
+  send_cs_write_answer(sa, channel_mask, var_name, result, (result == -2) ? "not enough filter memory" : fail_reason);
 }
 
 
@@ -428,7 +571,68 @@ cmd_90641_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
   {
     cmd_90641_init(sa);
   }
-  const char *var_name = "EM=";
+  reg_shadow_invalidate(&mlx->shadow_);
+
+  const char *var_name = "VERIFY=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  {
+    int8_t policy = reg_shadow_policy_from_str(input+strlen(var_name));
+    send_answer_chunk(channel_mask, "+cs:", 0);
+    uint8_to_hex(buf, sa);
+    send_answer_chunk(channel_mask, buf, 0);
+    if (policy >= 0)
+    {
+      mlx->shadow_.verify_policy_ = policy;
+      send_answer_chunk(channel_mask, ":VERIFY=OK [hub-register]", 1);
+    } else
+    {
+      send_answer_chunk(channel_mask, ":VERIFY=FAIL; expect ALWAYS, EEPROM or NEVER", 1);
+    }
+    return;
+  }
+  var_name = "FILTER=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  {
+    int8_t type = temporal_filter_type_from_str(input+strlen(var_name));
+    int8_t r = -1;
+    if (type >= 0)
+    {
+      r = cmd_90641_filter_configure(mlx, type, mlx->filter_.depth_, mlx->filter_.threshold_degc_);
+    }
+    cmd_90641_filter_answer(sa, channel_mask, "FILTER", r, "expect IIR, AB or MA");
+    return;
+  }
+  var_name = "DEPTH=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  {
+    int16_t depth = atoi(input+strlen(var_name));
+    int8_t r = -1;
+    if ((depth >= 1) && (depth <= TEMPORAL_FILTER_MAX_DEPTH))
+    {
+      r = cmd_90641_filter_configure(mlx, mlx->filter_.type_, depth, mlx->filter_.threshold_degc_);
+    }
+    cmd_90641_filter_answer(sa, channel_mask, "DEPTH", r, "outbound (AB: 2.." xstr(TEMPORAL_FILTER_MAX_DEPTH) ", MA: 1.." xstr(TEMPORAL_FILTER_MAX_BLOCKS) ")");
+    return;
+  }
+  var_name = "THRESHOLD=";
+  if (!strncmp(var_name, input, strlen(var_name)))
+  {
+    float threshold = atof(input+strlen(var_name));
+    int8_t r = cmd_90641_filter_configure(mlx, mlx->filter_.type_, mlx->filter_.depth_, threshold);
+    cmd_90641_filter_answer(sa, channel_mask, "THRESHOLD", r, "outbound");
+    return;
+  }
+  uint8_t roi_result = roi_cs_write(sa, channel_mask, &mlx->roi_, input);
+  if (roi_result)
+  {
+    if (roi_result == 2) temporal_filter_restart(&mlx->filter_); // the pixels outside the old ROI's are stale
+    return;
+  }
+  if (summary_cs_write(sa, channel_mask, &mlx->summary_, input))
+  {
+    return;
+  }
+  var_name = "EM=";
   if (!strncmp(var_name, input, strlen(var_name)))
   {
     float em = atof(input+strlen(var_name));
@@ -471,7 +675,7 @@ cmd_90641_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
     send_answer_chunk(channel_mask, buf, 0);
     if ((rr >= 0) && (rr <= 7))
     {
-      MLX90641_SetRefreshRate(sa, rr);
+      mlx->period_ms_ = (MLX90641_SetRefreshRate(sa, rr) == 0) ? (2000 >> rr) : 0;
       send_answer_chunk(channel_mask, ":RR=OK [mlx-register]", 1);
     } else
     {
@@ -514,13 +718,30 @@ cmd_90641_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
     }
     else if (!strcmp(input+strlen(var_name), "+IIR"))
     {
-      mlx->flags_ |= (1U<<MLX90641_CMD_FLAG_IIR_FILTER);
-      send_answer_chunk(channel_mask, ":FLAGS=OK [hub-register]", 1);
+      if (temporal_filter_reserve(&mlx->filter_) == 0)
+      { // restarts at the next frame
+        mlx->flags_ |= (1U<<MLX90641_CMD_FLAG_IIR_FILTER);
+        send_answer_chunk(channel_mask, ":FLAGS=OK [hub-register]", 1);
+      } else
+      {
+        send_answer_chunk(channel_mask, ":FLAGS=FAIL; not enough filter memory", 1);
+      }
     }
     else if (!strcmp(input+strlen(var_name), "-IIR"))
     {
       mlx->flags_ &= ~(1U<<MLX90641_CMD_FLAG_IIR_FILTER);
       send_answer_chunk(channel_mask, ":FLAGS=OK [hub-register]", 1);
+      temporal_filter_reset(&mlx->filter_); // release the history
+    }
+    else if (!strcmp(input+strlen(var_name), "+FAST_ROOT"))
+    {
+      mlx->flags_ |= (1U<<MLX90641_CMD_FLAG_FAST_ROOT);
+      send_answer_chunk(channel_mask, ":FLAGS=OK [hub-register]", 1);
+    }
+    else if (!strcmp(input+strlen(var_name), "-FAST_ROOT"))
+    {
+      mlx->flags_ &= ~(1U<<MLX90641_CMD_FLAG_FAST_ROOT);
+      send_answer_chunk(channel_mask, ":FLAGS=OK [hub-register]", 1);
     }
     else
     {
@@ -578,8 +799,13 @@ cmd_90641_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
       g_sa_list[sa].found_ = 0; // reset 'found' bit on 'old'-SA.
 
       // we assume that the new SA will use the same driver!
-      i2c_stick_register_driver(new_sa, DRV_MLX90641_ID);
-      g_sa_list[new_sa].spot_ = 1; // set 'found' bit on 'new'-SA.
+      int16_t spot = i2c_stick_register_driver(new_sa, DRV_MLX90641_ID);
+      if (spot > 0)
+      {
+        g_sa_list[new_sa].spot_ = spot;
+        g_sa_list[new_sa].found_ = 1; // set 'found' bit on 'new'-SA.
+        i2c_stick_update_sa_ops(new_sa);
+      }
 
       send_answer_chunk(channel_mask, ":SA=OK! [mlx-EE]", 1);
     } else
@@ -668,6 +894,8 @@ cmd_90641_mw(uint8_t sa, uint16_t *mem_data, uint16_t mem_start_address, uint16_
   {
     cmd_90641_init(sa);
   }
+  reg_shadow_invalidate(&mlx->shadow_);
+  mlx->period_ms_ = 0; // the RR setting may be written
 
   uint8_t write_in_eeprom = true;
   if (mem_start_address >= (0x2400 + 832))
@@ -684,6 +912,11 @@ cmd_90641_mw(uint8_t sa, uint16_t *mem_data, uint16_t mem_start_address, uint16_
   uint16_t i2c_clock_enum = 0;
   if (write_in_eeprom)
   {
+    uint16_t sn_list[3];
+    if (MLX90641_I2CRead(sa, 0x2407, 3, sn_list) == 0)
+    { // the cached calibration parameters are no longer valid
+      i2c_stick_calib_cache_invalidate(DRV_MLX90641_ID, sn_list, 3);
+    }
     i2c_clock_enum = i2c_stick_get_i2c_clock_frequency();
     if (i2c_clock_enum == HOST_CFG_I2C_F1M)
     {
@@ -757,24 +990,6 @@ cmd_90641_is(uint8_t sa, uint8_t *is_ok, char const **error_message)
 }
 
 
-void cmd_90641_iir_filter(float *to_list, float *iir, uint8_t depth, float threshold)
-{
-  for (uint16_t pix=0; pix<192; pix++)
-  {
-    if ((-100 <= to_list[pix]) && (to_list[pix] <= 1000))
-    {
-      if (fabs(to_list[pix] - iir[pix]) >= threshold)
-      {
-        iir[pix] += ((to_list[pix] - iir[pix]) * 0.9f); // take 90% of the change.
-      } else
-      {
-        iir[pix] = (to_list[pix] + (iir[pix] * (depth - 1))) / depth;
-      }
-    }
-  }
-}
-
-
 #ifdef __cplusplus
 }
 #endif
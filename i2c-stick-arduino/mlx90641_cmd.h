@@ -2,12 +2,20 @@
 #define _MLX90641_CMD_
 
 #include <stdint.h>
+#include "i2c_stick_thermal_array.h"
+
+typedef thermal_array_t<12, 16> mlx90641_array_t;
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 #include "mlx90641_api.h"
+#include "i2c_stick_reg_shadow.h"
+#include "i2c_stick_thermal.h"
+#include "i2c_stick_temporal.h"
+#include "i2c_stick_roi.h"
+#include "i2c_stick_summary.h"
 
 #define MLX90641_LSB_C 32
 
@@ -17,13 +25,18 @@ struct MLX90641_t
   uint8_t flags_;
   float emissivity_;
   float t_room_;
+  uint16_t period_ms_; // cached cmd_90641_rp answer; 0 => read from the sensor
   paramsMLX90641 mlx90641_;
-  float *iir_;
+  temporal_filter_t filter_;
+  roi_set_t roi_;
+  summary_cfg_t summary_;
+  reg_shadow_t shadow_; // control register 1 and I2C configuration
 };
 
 // Flags for FIR stick operations. (These are not sensor settings)
 #define MLX90641_CMD_FLAG_BROKEN_PIXELS         0
 #define MLX90641_CMD_FLAG_IIR_FILTER            1
+#define MLX90641_CMD_FLAG_FAST_ROOT             2
 
 int16_t cmd_90641_register_driver();
 
@@ -34,6 +47,7 @@ void cmd_90641_tear_down(uint8_t sa);
 void cmd_90641_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_message);
 void cmd_90641_raw(uint8_t sa, uint16_t *raw_list, uint16_t *raw_count, char const **error_message);
 void cmd_90641_nd(uint8_t sa, uint8_t *nd, char const **error_message);
+void cmd_90641_rp(uint8_t sa, uint32_t *period_ms, char const **error_message);
 void cmd_90641_sn(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message);
 void cmd_90641_cs(uint8_t sa, uint8_t channel_mask, const char *input);
 void cmd_90641_cs_write(uint8_t sa, uint8_t channel_mask, const char *input);
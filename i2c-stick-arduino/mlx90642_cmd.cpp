@@ -4,6 +4,9 @@
 #include "i2c_stick.h"
 #include "i2c_stick_cmd.h"
 #include "i2c_stick_dispatcher.h"
+#include "i2c_stick_pool.h"
+#include "i2c_stick_scratch.h"
+#include "i2c_stick_quant.h"
 
 #include <string.h>
 
@@ -19,12 +22,17 @@ extern "C" {
 #define MLX90642_ERROR_COMMUNICATION "Communication error"
 #define MLX90642_ERROR_NO_FREE_HANDLE "No free handle; pls recompile firmware with higher 'MAX_MLX90642_SLAVES'"
 #define MLX90642_ERROR_OUT_OF_RANGE "Out of range"
+#define MLX90642_ERROR_SCRATCH "scratch arena exhausted"
+
+#define MLX90642_COLS 32
+#define MLX90642_ROWS 24
 
 #define MLX90642_LSB_SENSOR_C 100
 #define MLX90642_LSB_OBJECT_C 50
 
 
 static MLX90642_t *g_mlx90642_list[MAX_MLX90642_SLAVES];
+POOL_DEFINE(g_mlx90642_pool, "MLX90642", MLX90642_t, MAX_MLX90642_SLAVES);
 
 
 float MLX90642_EM_to_float(int16_t emissivity)
@@ -77,8 +85,8 @@ cmd_90642_get_handle(uint8_t sa)
   {
     if (g_mlx90642_list[i] == NULL)
     {
-      g_mlx90642_list[i] = (MLX90642_t *)malloc(sizeof(MLX90642_t));;
-      memset(g_mlx90642_list[i], 0, sizeof(MLX90642_t));
+      g_mlx90642_list[i] = (MLX90642_t *)pool_alloc(&g_mlx90642_pool);
+      if (g_mlx90642_list[i] == NULL) return NULL;
       g_mlx90642_list[i]->slave_address_ = 0x80 | sa;
       return g_mlx90642_list[i];
     }
@@ -99,8 +107,9 @@ delete_handle(uint8_t sa)
     }
     if ((g_mlx90642_list[i]->slave_address_ & 0x7F) == sa)
     { // found!
+      reg_shadow_detach(&g_mlx90642_list[i]->shadow_);
       memset(g_mlx90642_list[i], 0, sizeof(MLX90642_t));
-      free(g_mlx90642_list[i]);
+      pool_free(&g_mlx90642_pool, g_mlx90642_list[i]);
       g_mlx90642_list[i] = NULL;
     }
   }
@@ -111,6 +120,7 @@ int16_t
 cmd_90642_register_driver()
 {
   int16_t r = 0;
+  pool_register(&g_mlx90642_pool);
 
   r = i2c_stick_register_driver(0x66, DRV_MLX90642_ID);
   if (r < 0) return r;
@@ -128,6 +138,10 @@ cmd_90642_init(uint8_t sa)
     return;
   }
   // init functions goes here
+  static const uint16_t shadow_list[] = { MLX90642_REFRESH_RATE_ADDRESS, MLX90642_EMISSIVITY_ADDRESS, MLX90642_APPLICATION_CONFIG_ADDRESS, MLX90642_I2C_CONFIG_ADDRESS };
+  reg_shadow_attach(&mlx->shadow_, sa, shadow_list, 4);
+  roi_init(&mlx->roi_, MLX90642_COLS, MLX90642_ROWS);
+  summary_init(&mlx->summary_);
 
   // turn off bit7, to indicate other routines this slave has been init
   mlx->slave_address_ &= 0x7F;
@@ -166,19 +180,79 @@ cmd_90642_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_
   }
   *mv_count = (768+1);
 
+  scratch_scope_t scope;
+  scratch_begin(&scope);
+  int16_t *buffer = (int16_t *)scratch_alloc(768 * sizeof(int16_t));
+  if (buffer == NULL)
+  {
+    scratch_end(&scope);
+    *mv_count = 0;
+    *error_message = MLX90642_ERROR_SCRATCH;
+    return;
+  }
+
   //
   // get the measurement values from the sensor
   //
-  int16_t buffer[768];
   uint16_t ta_read;
-  int r = MLX90642_GetImage(sa, buffer);
-  r = MLX90642_I2CRead(sa, MLX90642_TA_DATA_ADDRESS, 1, &ta_read);
+  int r = 0;
+  if (roi_is_active(&mlx->roi_))
+  { // the sensor calculates To itself; read only the rows with a ROI, one read per band of rows.
+    uint32_t row_mask = 0;
+    for (uint8_t i=0; i<mlx->roi_.count_; i++)
+    {
+      for (uint8_t row=mlx->roi_.rect_[i].row_; row<mlx->roi_.rect_[i].row_+mlx->roi_.rect_[i].height_; row++)
+      {
+        row_mask |= (1UL << row);
+      }
+    }
+    for (uint8_t row=0; (row<MLX90642_ROWS) && (r >= 0); )
+    {
+      if (!(row_mask & (1UL << row)))
+      {
+        row++;
+        continue;
+      }
+      uint8_t row_count = 0;
+      while ((row+row_count < MLX90642_ROWS) && (row_mask & (1UL << (row+row_count)))) row_count++;
+      uint16_t pix = row * MLX90642_COLS;
+      r = MLX90642_I2CRead(sa, MLX90642_TO_DATA_ADDRESS + 2*pix, row_count * MLX90642_COLS, (uint16_t *)&buffer[pix]);
+      row += row_count;
+    }
+  } else
+  {
+    r = MLX90642_GetImage(sa, buffer);
+  }
+  if (r >= 0)
+  {
+    r = MLX90642_I2CRead(sa, MLX90642_TA_DATA_ADDRESS, 1, &ta_read);
+  }
+  if (r < 0)
+  {
+    scratch_end(&scope);
+    *mv_count = 0;
+    *error_message = MLX90642_ERROR_COMMUNICATION;
+    return;
+  }
 
   mv_list[0] = float(int16_t(ta_read)) / MLX90642_LSB_SENSOR_C;
-  for (uint16_t pix=0; pix<768; pix++)
+  if (mlx->summary_.is_enabled_)
+  { // statistics of the frame, or of the ROI's when set.
+    *mv_count = summary_output_count(&mlx->summary_)+1;
+    summary_compute_int16(&mlx->summary_, buffer, 1.0f / MLX90642_LSB_OBJECT_C, MLX90642_COLS, mlx->roi_.span_, mlx->roi_.span_count_, &mv_list[1]);
+  } else if (roi_is_active(&mlx->roi_))
+  {
+    *mv_count = roi_output_count(&mlx->roi_)+1;
+    roi_extract_int16(&mlx->roi_, buffer, 1.0f / MLX90642_LSB_OBJECT_C, &mv_list[1]);
+  } else
   {
-    mv_list[1+pix] = float(buffer[pix]) / MLX90642_LSB_OBJECT_C;
+    for (uint16_t pix=0; pix<768; pix++)
+    {
+      mv_list[1+pix] = float(buffer[pix]) / MLX90642_LSB_OBJECT_C;
+    }
   }
+  i2c_stick_quant_set_temperature_list(sa, !mlx->summary_.is_enabled_);
+  scratch_end(&scope);
 }
 
 
@@ -254,6 +328,31 @@ cmd_90642_nd(uint8_t sa, uint8_t *nd, char const **error_message)
 }
 
 
+void
+cmd_90642_rp(uint8_t sa, uint32_t *period_ms, char const **error_message)
+{ // the time between two new data events; 0 => unknown.
+  MLX90642_t *mlx = cmd_90642_get_handle(sa);
+  *period_ms = 0;
+  if (mlx == NULL)
+  {
+    *error_message = MLX90642_ERROR_NO_FREE_HANDLE;
+    return;
+  }
+  if (mlx->slave_address_ & 0x80)
+  {
+    cmd_90642_init(sa);
+  }
+
+  int rr = MLX90642_GetRefreshRate(sa);
+  if (rr < 0)
+  {
+    *error_message = MLX90642_ERROR_COMMUNICATION;
+    return;
+  }
+  *period_ms = MLX90642_REF_TIME >> rr;
+}
+
+
 void
 cmd_90642_sn(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message)
 {
@@ -357,24 +456,20 @@ cmd_90642_cs(uint8_t sa, uint8_t channel_mask, const char *input)
   itoa(patch, buf, 10);
   send_answer_chunk(channel_mask, buf, 1);
 
-
-  //
-  // Send the configuration of the MV header, unit and resolution back to the terminal
-  //
   send_answer_chunk(channel_mask, "cs:", 0);
   uint8_to_hex(buf, sa);
   send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ":RO:MV_HEADER=TA,TO_[768]", 1);
+  send_answer_chunk(channel_mask, ":RO:SHADOW_SAVED=", 0);
+  itoa(mlx->shadow_.read_saved_, buf, 10);
+  send_answer_chunk(channel_mask, buf, 1);
 
-  send_answer_chunk(channel_mask, "cs:", 0);
-  uint8_to_hex(buf, sa);
-  send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ":RO:MV_UNIT=DegC,DegC[768]", 1);
+  roi_cs(sa, channel_mask, &mlx->roi_);
+  summary_cs(sa, channel_mask, &mlx->summary_);
 
-  send_answer_chunk(channel_mask, "cs:", 0);
-  uint8_to_hex(buf, sa);
-  send_answer_chunk(channel_mask, buf, 0);
-  send_answer_chunk(channel_mask, ":RO:MV_RES=" xstr(MLX90642_LSB_SENSOR_C) "," xstr(MLX90642_LSB_OBJECT_C) "[768]", 1);
+  //
+  // Send the configuration of the MV header, unit and resolution back to the terminal
+  //
+  summary_cs_mv(sa, channel_mask, &mlx->summary_, &mlx->roi_, MLX90642_LSB_SENSOR_C, MLX90642_LSB_OBJECT_C);
 }
 
 
@@ -402,6 +497,7 @@ cmd_90642_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
   //
   // Also if SA can be re-programmed, please add the correct sequence here, see also MLX90614 or MLX90632 for an extensive example.
   //
+  reg_shadow_invalidate(&mlx->shadow_);
 
   const char *var_name = "RR=";
   if (!strncmp(var_name, input, strlen(var_name)))
@@ -439,6 +535,16 @@ cmd_90642_cs_write(uint8_t sa, uint8_t channel_mask, const char *input)
     return;
   }
 
+  if (roi_cs_write(sa, channel_mask, &mlx->roi_, input))
+  {
+    return;
+  }
+
+  if (summary_cs_write(sa, channel_mask, &mlx->summary_, input))
+  {
+    return;
+  }
+
   // var_name = "BGT=";
   // if (!strncmp(var_name, input, strlen(var_name)))
   // {
@@ -527,6 +633,7 @@ cmd_90642_mw(uint8_t sa, uint16_t *mem_data, uint16_t mem_start_address, uint16_
   {
     cmd_90642_init(sa);
   }
+  reg_shadow_invalidate(&mlx->shadow_);
 
   *bit_per_address = 16;
   *address_increments = 1;
@@ -2,6 +2,9 @@
 #define _MLX90642_CMD_
 
 #include <stdint.h>
+#include "i2c_stick_reg_shadow.h"
+#include "i2c_stick_roi.h"
+#include "i2c_stick_summary.h"
 
 #ifdef  __cplusplus
 extern "C" {
@@ -13,14 +16,20 @@ struct MLX90642_t
   // local caching of sensor values whenever needed;
   // stored along with <SA>, such that multiple sensors can be supported.
   uint16_t progress_bar_;
+  reg_shadow_t shadow_; // configuration registers
+  roi_set_t roi_; // regions of interest; only their rows are read
+  summary_cfg_t summary_;
 };
 
 
 int16_t cmd_90642_register_driver();
 
+void cmd_90642_init(uint8_t sa);
+
 void cmd_90642_mv(uint8_t sa, float *mv_list, uint16_t *mv_count, char const **error_message);
 void cmd_90642_raw(uint8_t sa, uint16_t *raw_list, uint16_t *raw_count, char const **error_message);
 void cmd_90642_nd(uint8_t sa, uint8_t *nd, char const **error_message);
+void cmd_90642_rp(uint8_t sa, uint32_t *period_ms, char const **error_message);
 void cmd_90642_sn(uint8_t sa, uint16_t *sn_list, uint16_t *sn_count, char const **error_message);
 void cmd_90642_cs(uint8_t sa, uint8_t channel_mask, const char *input);
 void cmd_90642_cs_write(uint8_t sa, uint8_t channel_mask, const char *input);
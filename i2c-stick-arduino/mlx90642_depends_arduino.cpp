@@ -1,6 +1,8 @@
 #include "mlx90642_depends.h"
 #include "mlx90642.h"
 #include "i2c_stick_arduino.h"
+#include "i2c_stick_hal.h"
+#include "i2c_stick_reg_shadow.h"
 
 #include <Arduino.h>
 #include <Wire.h>
@@ -9,78 +11,59 @@
 int
 MLX90642_I2CRead(uint8_t slaveAddr, uint16_t startAddress, uint16_t nMemAddressRead, uint16_t *rData)
 {
-    int16_t ack = 0;
-    int16_t cnt = 0;
-    int16_t n = 0;
-    uint16_t *p;
+    uint8_t address[2] = { uint8_t(startAddress >> 8), uint8_t(startAddress & 0x00FF) };
+    uint8_t *p = (uint8_t *)rData;
 
-    p = rData;
-
-    WIRE.endTransmission();
-    delayMicroseconds(5);
-
-    for (cnt = 2*nMemAddressRead; cnt > 0; cnt -= READ_BUFFER_SIZE)
-    {
-      WIRE.beginTransmission(slaveAddr);
-      WIRE.write(startAddress >> 8);
-      WIRE.write(startAddress & 0x00FF);
-      ack = WIRE.endTransmission(false);     // repeated start
-#ifdef ARDUINO_ARCH_RP2040
-      if (ack == 4) ack = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-      if (ack != 0x00)
-      {
-          return -1;
-      }
-      n = cnt > READ_BUFFER_SIZE ? READ_BUFFER_SIZE : cnt;
-      startAddress += n;
-      WIRE.requestFrom((int)slaveAddr, (int)n);
-      for(; n>0; n-=2)
-      {
-        uint16_t val = WIRE.read();
-        val <<= 8;
-        val |= WIRE.read();
-        *p++ = val;
-      }
+    reg_shadow_t *shadow = (nMemAddressRead == 1) ? reg_shadow_find(slaveAddr) : NULL;
+    if (reg_shadow_read(shadow, startAddress, rData))
+    { // configuration register; no need to go on the bus.
+        return 0;
     }
 
-    ack = WIRE.endTransmission();     // stop transmitting
-#ifdef ARDUINO_ARCH_RP2040
-    if (ack == 4) ack = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-
-    if (ack != 0x00)
+    // MLX90642 addresses bytes; a split read restarts 1 address per byte further.
+    if (hal_i2c_transfer(slaveAddr, address, 2, p, 2*nMemAddressRead, 1) != 0)
     {
         return -1;
     }
 
+    for (uint16_t i=0; i<nMemAddressRead; i++)
+    { // big endian on the bus
+        rData[i] = (uint16_t(p[2*i]) << 8) | p[2*i+1];
+    }
+    reg_shadow_update(shadow, startAddress, rData[0]);
+
     return 0;
 }
 
 
 int MLX90642_I2CWrite(uint8_t slaveAddr, uint8_t *buffer, uint8_t bytesNum)
 {
-    int16_t ack = 0;
-    int16_t cnt = 0;
-    int16_t n = 0;
-    uint16_t *p;
-
-    WIRE.endTransmission();
-    delayMicroseconds(5);
-
-    WIRE.beginTransmission(slaveAddr);
-    for (uint8_t i=0; i<bytesNum; i++)
+    hal_i2c_xfer_t xfer;
+    memset(&xfer, 0, sizeof(xfer));
+    xfer.sa_ = slaveAddr;
+    xfer.flags_ = HAL_I2C_XFER_FLAG_NO_STOP;
+    xfer.write_buffer_ = buffer;
+    xfer.write_n_bytes_ = bytesNum;
+
+    if ((hal_i2c_xfer_submit(&xfer) != 0) || (hal_i2c_xfer_wait(&xfer) != 0))
     {
-        WIRE.write(buffer[i]);
+        return -1;
+    }
+
+    if (bytesNum >= 4)
+    { // the sensor firmware applies configuration writes itself; re-read them.
+        uint16_t opcode = (uint16_t(buffer[0]) << 8) | buffer[1];
+        uint16_t word = (uint16_t(buffer[2]) << 8) | buffer[3];
+        reg_shadow_t *shadow = reg_shadow_find(slaveAddr);
+        if (opcode == MLX90642_CONFIG_OPCODE)
+        {
+            reg_shadow_drop(shadow, word);
+        }
+        if ((opcode == MLX90642_CMD_OPCODE) && (word == MLX90642_ADRESSED_RESET_CMD))
+        {
+            reg_shadow_invalidate(shadow);
+        }
     }
-    ack = WIRE.endTransmission(false); // STOP condition
-#ifdef ARDUINO_ARCH_RP2040
-    if (ack == 4) ack = 0; // ignore error=4 ('other error', but I can't seem to find anything wrong; only on this MCU platform)
-#endif
-		if (ack != 0x00)
-		{
-			return -1;
-		}
 
     return 0;
 }
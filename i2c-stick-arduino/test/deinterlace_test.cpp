@@ -0,0 +1,375 @@
+// The deinterlace filter (median networks, thermal_array_t::deinterlace)
+// against the selection sort implementation it replaced, and a benchmark of
+// both. Built twice: float and THERMAL_STORAGE_INT16 storage.
+//
+// The frames mimic a recording of a person walking through the field of
+// view: a background gradient, a warm object that moves between the two
+// sub-pages (the interlace artefact the filter removes), noise and a few
+// spike pixels.
+
+#include <math.h>
+#include <string.h>
+#include "test.h"
+#include "i2c_stick_thermal_array.h"
+
+#define FRAME_COUNT 64
+
+typedef thermal_array_t<24, 32> array_90640_t;
+typedef thermal_array_t<12, 16> array_90641_t;
+
+static uint32_t g_seed = 4711;
+
+
+static float
+noise()
+{ // deterministic; roughly normal, sigma ~0.1
+  float sum = 0;
+  for (int i=0; i<4; i++)
+  {
+    g_seed = g_seed * 1664525UL + 1013904223UL;
+    sum += (float)(g_seed >> 8) / (1UL << 24);
+  }
+  return (sum - 2.0f) * 0.17f;
+}
+
+
+static void
+make_frame(float *frame, uint8_t rows, uint8_t cols, int n)
+{
+  float cx = -4.0f + 0.9f * n;
+  for (uint8_t row=0; row<rows; row++)
+  {
+    for (uint8_t col=0; col<cols; col++)
+    { // the object moved half a step between the sub-pages
+      uint8_t subpage = (row ^ col) & 1;
+      float x = col - (cx + 0.45f * subpage) * cols / 32.0f;
+      float y = row - rows / 2.0f;
+      float body = expf(-(x * x) / 8.0f - (y * y) / 40.0f);
+      float to = 21.0f + 0.05f * row + 0.03f * col + 14.0f * body + noise();
+      if (((n * 37 + row * cols + col) % 97) == 0) to += 6.0f; // spike
+      frame[row * cols + col] = to;
+    }
+  }
+}
+
+
+// the implementation before the median networks (verbatim), 32x24 only.
+static float helper_median(float *arr, uint16_t n)
+{
+  float temp = 0.0f;
+  uint16_t min_idx;
+
+  /* sorting */
+  for (uint16_t i = 0; i < n - 1; i++)
+  {
+    // Find the minimum element in unsorted array
+    min_idx = i;
+    for (uint16_t j = i + 1; j < n; j++)
+    {
+      if (arr[j] < arr[min_idx])
+      {
+        min_idx = j;
+      }
+    }
+
+    // Swap the found minimum element with the first element
+    temp = arr[i];
+    arr[i] = arr[min_idx];
+    arr[min_idx] = temp;
+  }
+
+  /* get median */
+  if((n % 2) == 0) // when even array length => average of 2 middle elements.
+    return (arr[(n-1)/2] + arr[n/2])/2.0;
+
+  return arr[n/2];
+}
+
+
+static void
+reference_deinterlace_90640(float *to_list, uint8_t subpage)
+{
+  uint8_t odd = 0;
+  float a = 2.0f;
+  float temp_arr[6];
+
+  if (subpage == 1)
+  {
+    for (uint16_t row=0; row<24; row++)
+    {
+      for (uint16_t col=odd; col<32; col+=2)
+      {
+        if (row == 0)
+        {
+          if (col == 0)
+          {
+            temp_arr[0] = to_list[(row+1)*32+(col+0)];
+            temp_arr[1] = to_list[(row+0)*32+(col+1)];
+            temp_arr[2] = to_list[(row+0)*32+(col+0)];
+            a = helper_median(temp_arr, 3);
+          } else
+          {
+            temp_arr[0] = to_list[(row+0)*32+(col-1)];
+            temp_arr[1] = to_list[(row+1)*32+(col+0)];
+            temp_arr[2] = to_list[(row+0)*32+(col+1)];
+            temp_arr[3] = to_list[(row+0)*32+(col+0)];
+            a = helper_median(temp_arr, 4);
+          }
+        } else if (row == 23)
+        {
+          if (col == 31)
+          {
+            temp_arr[0] = to_list[(row-1)*32+(col+0)];
+            temp_arr[1] = to_list[(row+0)*32+(col-1)];
+            temp_arr[2] = to_list[(row+0)*32+(col+0)];
+            a = helper_median(temp_arr, 3);
+          } else
+          {
+            temp_arr[0] = to_list[(row+0)*32+(col-1)];
+            temp_arr[1] = to_list[(row-1)*32+(col+0)];
+            temp_arr[2] = to_list[(row+0)*32+(col+1)];
+            temp_arr[3] = to_list[(row+0)*32+(col+0)];
+            a = helper_median(temp_arr, 4);
+          }
+        } else if ((col == 0) && ((row % 2) == 0))
+        {
+          temp_arr[0] = to_list[(row-1)*32+(col+0)];
+          temp_arr[1] = to_list[(row+1)*32+(col+0)];
+          temp_arr[2] = to_list[(row+0)*32+(col+1)];
+          temp_arr[3] = to_list[(row+0)*32+(col+0)];
+          a = helper_median(temp_arr, 4);
+        } else if ((col == 31) && ((row % 2) == 1))
+        {
+          temp_arr[0] = to_list[(row+0)*32+(col-1)];
+          temp_arr[1] = to_list[(row-1)*32+(col+0)];
+          temp_arr[2] = to_list[(row+1)*32+(col+0)];
+          temp_arr[3] = to_list[(row+0)*32+(col+0)];
+          a = helper_median(temp_arr, 4);
+        } else
+        {
+          temp_arr[0] = to_list[(row-1)*32+(col+0)];
+          temp_arr[1] = to_list[(row+1)*32+(col+0)];
+          temp_arr[2] = to_list[(row+0)*32+(col-1)];
+          temp_arr[3] = to_list[(row+0)*32+(col+1)];
+          temp_arr[4] = to_list[(row+0)*32+(col+0)];
+          temp_arr[5] = to_list[(row+0)*32+(col+0)];
+          a = helper_median(temp_arr, 6);
+        }
+        if (fabs(a - to_list[row*32+col]) > 0.7)
+        {
+          to_list[row*32+col] = a;
+        }
+      }
+      odd ^= 0x01;
+    }
+  } else
+  {
+    odd = 1;
+    for (uint16_t row=0; row<24; row++)
+    {
+      for (uint16_t col=odd; col<32; col+=2)
+      {
+        if (row == 0)
+        {
+          if (col == 31)
+          {
+            temp_arr[0] = to_list[(row+0)*32+(col-1)];
+            temp_arr[1] = to_list[(row+1)*32+(col+0)];
+            temp_arr[2] = to_list[(row+0)*32+(col+0)];
+            a = helper_median(temp_arr, 3);
+          } else
+          {
+            temp_arr[0] = to_list[(row+0)*32+(col-1)];
+            temp_arr[1] = to_list[(row+1)*32+(col+0)];
+            temp_arr[2] = to_list[(row+0)*32+(col+1)];
+            temp_arr[3] = to_list[(row+0)*32+(col+0)];
+            a = helper_median(temp_arr, 4);
+          }
+        } else if (row == 23)
+        {
+          if (col == 0)
+          {
+            temp_arr[0] = to_list[(row-1)*32+(col+0)];
+            temp_arr[1] = to_list[(row+0)*32+(col+1)];
+            temp_arr[2] = to_list[(row+0)*32+(col+0)];
+            a = helper_median(temp_arr, 3);
+          } else
+          {
+            temp_arr[0] = to_list[(row+0)*32+(col-1)];
+            temp_arr[1] = to_list[(row-1)*32+(col+0)];
+            temp_arr[2] = to_list[(row+0)*32+(col+1)];
+            temp_arr[3] = to_list[(row+0)*32+(col+0)];
+            a = helper_median(temp_arr, 4);
+          }
+        } else if ((col == 0) && ((row % 2) == 1))
+        {
+          temp_arr[0] = to_list[(row-1)*32+(col+0)];
+          temp_arr[1] = to_list[(row+1)*32+(col+0)];
+          temp_arr[2] = to_list[(row+0)*32+(col+1)];
+          temp_arr[3] = to_list[(row+0)*32+(col+0)];
+          a = helper_median(temp_arr, 4);
+        } else if ((col == 31) && ((row % 2) == 0))
+        {
+          temp_arr[0] = to_list[(row+0)*32+(col-1)];
+          temp_arr[1] = to_list[(row-1)*32+(col+0)];
+          temp_arr[2] = to_list[(row+1)*32+(col+0)];
+          temp_arr[3] = to_list[(row+0)*32+(col+0)];
+          a = helper_median(temp_arr, 4);
+        } else
+        {
+          temp_arr[0] = to_list[(row-1)*32+(col+0)];
+          temp_arr[1] = to_list[(row+1)*32+(col+0)];
+          temp_arr[2] = to_list[(row+0)*32+(col-1)];
+          temp_arr[3] = to_list[(row+0)*32+(col+1)];
+          temp_arr[4] = to_list[(row+0)*32+(col+0)];
+          temp_arr[5] = to_list[(row+0)*32+(col+0)];
+          a = helper_median(temp_arr, 6);
+        }
+        if (fabs(a - to_list[row*32+col]) > 0.7)
+        {
+          to_list[row*32+col] = a;
+        }
+      }
+      odd ^= 0x01;
+    }
+  }
+}
+
+
+// the same rule for any geometry: the median of the available neighbours and
+// the pixel itself (twice with all 4 neighbours).
+static void
+reference_deinterlace(float *to_list, uint8_t rows, uint8_t cols, uint8_t subpage)
+{
+  float temp_arr[6];
+  for (uint8_t row=0; row<rows; row++)
+  {
+    for (uint8_t col=(subpage ^ row ^ 1) & 1; col<cols; col+=2)
+    {
+      float self = to_list[row*cols+col];
+      uint16_t n = 0;
+      if (row > 0) temp_arr[n++] = to_list[(row-1)*cols+col];
+      if (row < rows-1) temp_arr[n++] = to_list[(row+1)*cols+col];
+      if (col > 0) temp_arr[n++] = to_list[row*cols+col-1];
+      if (col < cols-1) temp_arr[n++] = to_list[row*cols+col+1];
+      temp_arr[n++] = self;
+      if (n == 5) temp_arr[n++] = self;
+      float a = helper_median(temp_arr, n);
+      if (fabs(a - self) > 0.7)
+      {
+        to_list[row*cols+col] = a;
+      }
+    }
+  }
+}
+
+
+// the input is quantised to the pixel storage, so both see the same values.
+// float storage is bit identical. int16 storage rounds the even count
+// averages and the 0.7 threshold to the Q5 grid: a replaced value differs at
+// most 1/64, and a pixel near the threshold may be kept by one and replaced
+// by the other (|diff| just above 0.7).
+template <typename array_t>
+static void
+compare(const char *name, void (*reference)(float *, uint8_t))
+{
+  const uint16_t pixels = array_t::pixels_;
+  static float frame[768];
+  static float ref[768];
+  static thermal_t to_list[768];
+  uint32_t changed = 0;
+  uint32_t identical = 0;
+  uint32_t decisions = 0;
+  float max_diff = 0;
+
+  for (int n=0; n<FRAME_COUNT; n++)
+  {
+    make_frame(frame, array_t::rows_, array_t::cols_, n);
+    thermal_list_from_float(to_list, frame, pixels);
+    thermal_list_to_float(ref, to_list, pixels);
+    memcpy(frame, ref, pixels * sizeof(float));
+
+    uint8_t subpage = n & 1;
+    reference(ref, subpage);
+    array_t::deinterlace(to_list, subpage);
+    for (uint16_t p=0; p<pixels; p++)
+    {
+      float out = thermal_to_float(to_list[p]);
+      if (ref[p] != frame[p]) changed++;
+      if (out == ref[p]) identical++;
+      if ((ref[p] != frame[p]) != (thermal_from_float(frame[p]) != to_list[p])) decisions++;
+      if (fabsf(out - ref[p]) > max_diff) max_diff = fabsf(out - ref[p]);
+    }
+  }
+  printf("%s: %d frames, %u pixels replaced, %u of %u identical, %u other decisions, max |diff| %.4f K\n",
+         name, FRAME_COUNT, changed, identical, FRAME_COUNT * pixels, decisions, max_diff);
+  CHECK(changed > 0, "no pixel replaced; the frames do not exercise the filter");
+#ifdef THERMAL_STORAGE_INT16
+  CHECK(max_diff <= 0.7f + 1.0f / 32, "max |diff| %f", max_diff);
+#else
+  CHECK(identical == (uint32_t)FRAME_COUNT * pixels, "%u of %u identical", identical, FRAME_COUNT * pixels);
+#endif // THERMAL_STORAGE_INT16
+}
+
+
+static void
+reference_90640(float *to_list, uint8_t subpage)
+{
+  reference_deinterlace_90640(to_list, subpage);
+}
+
+
+static void
+reference_90640_generic(float *to_list, uint8_t subpage)
+{
+  reference_deinterlace(to_list, 24, 32, subpage);
+}
+
+
+static void
+reference_90641(float *to_list, uint8_t subpage)
+{
+  reference_deinterlace(to_list, 12, 16, subpage);
+}
+
+
+static void
+benchmark()
+{
+  static float frame[768];
+  static float work[768];
+  static thermal_t to_list[768];
+  const int n = 5000;
+  make_frame(frame, 24, 32, 7);
+  thermal_list_from_float(to_list, frame, 768);
+
+  double t0 = test_now_us();
+  for (int i=0; i<n; i++)
+  {
+    memcpy(work, frame, sizeof(work));
+    reference_deinterlace_90640(work, i & 1);
+    g_test_sink = work[i % 768];
+  }
+  double t1 = test_now_us();
+  static thermal_t work_list[768];
+  for (int i=0; i<n; i++)
+  {
+    memcpy(work_list, to_list, sizeof(work_list));
+    array_90640_t::deinterlace(work_list, i & 1);
+    g_test_sink = thermal_to_float(work_list[i % 768]);
+  }
+  double t2 = test_now_us();
+  printf("bench 32x24 deinterlace: selection sort %.2f us, median networks %.2f us (%s storage)\n",
+         (t1 - t0) / n, (t2 - t1) / n, sizeof(thermal_t) == 2 ? "int16" : "float");
+}
+
+
+int
+main()
+{
+  compare<array_90640_t>("32x24 vs previous implementation", reference_90640);
+  compare<array_90640_t>("32x24 vs generic reference", reference_90640_generic);
+  compare<array_90641_t>("16x12 vs generic reference", reference_90641);
+  benchmark();
+  return test_result("deinterlace_test");
+}
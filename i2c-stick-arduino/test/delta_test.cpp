@@ -0,0 +1,103 @@
+// Change-only streaming: the reference lists in the shared arena (sized per
+// slave, packed when a slave drops out) and the runs against them.
+
+#include <math.h>
+#include <string.h>
+#include "test.h"
+#include "i2c_stick_delta.h"
+
+#define FULL 769 // MLX90640: TA + 768 pixels
+#define HALF 193 // MLX90641: TA + 192 pixels
+
+static float g_list[FULL];
+
+
+static void
+make_list(float *list, uint16_t count, float base)
+{
+  for (uint16_t i=0; i<count; i++)
+  {
+    list[i] = base + 0.01f * (i % 50);
+  }
+}
+
+
+static int16_t
+update(uint8_t sa, uint16_t count, const char *error_message = NULL)
+{
+  const delta_run_t *run_list = NULL;
+  return i2c_stick_delta_update(sa, g_list, count, error_message, &run_list);
+}
+
+
+static void
+test_off()
+{
+  i2c_stick_delta_set_deadband(-1.0f);
+  make_list(g_list, FULL, 25.0f);
+  CHECK(update(0x33, FULL) == -1, "OFF: full list");
+  CHECK(update(0x33, FULL) == -1, "OFF: still full list");
+}
+
+
+static void
+test_arena()
+{
+  i2c_stick_delta_set_deadband(0.5f);
+  i2c_stick_delta_set_keyframe_interval(0);
+
+  // two full frames fill the arena; a third slave gets full lists.
+  make_list(g_list, FULL, 25.0f);
+  CHECK(update(0x33, FULL) == -1, "0x33 keyframe");
+  CHECK(update(0x34, FULL) == -1, "0x34 keyframe");
+  CHECK(update(0x35, HALF) == -1, "0x35 keyframe");
+  CHECK(update(0x35, HALF) == -1, "0x35 no room: full list");
+  CHECK(update(0x33, FULL) == 0, "0x33 unchanged");
+  CHECK(update(0x34, FULL) == 0, "0x34 unchanged");
+
+  // 0x33 drops out at an error; 0x34 moves down and keeps its reference.
+  CHECK(update(0x33, FULL, "error") == -1, "0x33 error");
+  g_list[10] += 1.0f;
+  CHECK(update(0x34, FULL) == 1, "0x34 one run after the move");
+  g_list[10] -= 1.0f;
+  CHECK(update(0x34, FULL) == 1, "0x34 back");
+
+  // the freed room holds three shorter lists, not a fourth.
+  for (uint8_t sa=0x40; sa<0x44; sa++)
+  {
+    make_list(g_list, HALF, 30.0f + sa);
+    CHECK(update(sa, HALF) == -1, "0x%02X keyframe", sa);
+  }
+  for (uint8_t sa=0x40; sa<0x44; sa++)
+  {
+    make_list(g_list, HALF, 30.0f + sa);
+    CHECK(update(sa, HALF) == ((sa < 0x43) ? 0 : -1), "0x%02X unchanged", sa);
+  }
+
+  // a length change re-sizes the reference; the others stay intact.
+  make_list(g_list, 5, 20.0f);
+  CHECK(update(0x41, 5) == -1, "0x41 new length: keyframe");
+  CHECK(update(0x41, 5) == 0, "0x41 unchanged");
+  make_list(g_list, HALF, 30.0f + 0x42);
+  CHECK(update(0x42, HALF) == 0, "0x42 unchanged after 0x41 moved");
+  make_list(g_list, HALF, 30.0f + 0x40);
+  CHECK(update(0x40, HALF) == 0, "0x40 unchanged");
+  make_list(g_list, FULL, 25.0f);
+  CHECK(update(0x34, FULL) == 0, "0x34 unchanged");
+
+  // a reset frees all references.
+  i2c_stick_delta_reset();
+  CHECK(update(0x33, FULL) == -1, "0x33 keyframe after reset");
+  CHECK(update(0x34, FULL) == -1, "0x34 keyframe after reset");
+  CHECK(update(0x33, FULL) == 0, "0x33 unchanged");
+  CHECK(update(0x34, FULL) == 0, "0x34 unchanged");
+}
+
+
+int
+main()
+{
+  test_off();
+  test_arena();
+  return test_result("delta");
+}
@@ -0,0 +1,125 @@
+// fast_root4f against the double precision fourth root: the documented error
+// bound, exhaustively over the To range (-40..300 degC) and sampled over all
+// positive normal floats; and a benchmark against sqrtf(sqrtf(x)).
+
+#include <math.h>
+#include <string.h>
+#include "test.h"
+#include "i2c_stick_fast_math.h"
+
+
+static float
+from_bits(uint32_t i)
+{
+  float x;
+  memcpy(&x, &i, sizeof(x));
+  return x;
+}
+
+
+static uint32_t
+to_bits(float x)
+{
+  uint32_t i;
+  memcpy(&i, &x, sizeof(i));
+  return i;
+}
+
+
+static void
+test_to_range()
+{ // every float x = (To + 273.15)^4 for To in -40..300 degC
+  uint32_t first = to_bits(powf(273.15f - 40.0f, 4));
+  uint32_t last = to_bits(powf(273.15f + 300.0f, 4));
+  double max_rel = 0;
+  double max_k = 0;
+  double max_rel_sqrt = 0;
+  for (uint32_t i=first; i<=last; i++)
+  {
+    float x = from_bits(i);
+    double ref = pow((double)x, 0.25);
+    float root = fast_root4f(x);
+    double rel = fabs(root - ref) / ref;
+    if (rel > max_rel) max_rel = rel;
+    double k = fabs((root - 273.15f) - (ref - 273.15));
+    if (k > max_k) max_k = k;
+    rel = fabs(sqrtf(sqrtf(x)) - ref) / ref;
+    if (rel > max_rel_sqrt) max_rel_sqrt = rel;
+  }
+  printf("-40..300 degC: %u values, max rel. error %.3g (sqrtf(sqrtf) %.3g), max |To diff| %.6f K\n",
+         last - first + 1, max_rel, max_rel_sqrt, max_k);
+  CHECK(max_rel < 5.5e-7, "max rel. error %g", max_rel);
+  CHECK(max_k < 0.0003, "max |To diff| %f K", max_k);
+}
+
+
+static void
+test_normal_range()
+{ // every 97th positive normal float
+  double max_rel = 0;
+  float worst = 0;
+  for (uint32_t i=0x00800000UL; i<0x7F800000UL; i+=97)
+  {
+    float x = from_bits(i);
+    double ref = pow((double)x, 0.25);
+    double rel = fabs(fast_root4f(x) - ref) / ref;
+    if (rel > max_rel)
+    {
+      max_rel = rel;
+      worst = x;
+    }
+  }
+  printf("positive normal floats: max rel. error %.3g at %g\n", max_rel, worst);
+  CHECK(max_rel < 7e-7, "max rel. error %g at %g", max_rel, worst);
+}
+
+
+static void
+test_special()
+{
+  CHECK(fast_root4f(0.0f) == 0.0f, "root4(0) = %g", fast_root4f(0.0f));
+  CHECK(isnan(fast_root4f(-1.0f)), "root4(-1) = %g", fast_root4f(-1.0f));
+  CHECK(isnan(fast_root4f(NAN)), "root4(NAN) = %g", fast_root4f(NAN));
+  CHECK(fast_root4f(16.0f) == 2.0f, "root4(16) = %.9g", fast_root4f(16.0f));
+  CHECK(fast_root4f(1.0f) == 1.0f, "root4(1) = %.9g", fast_root4f(1.0f));
+}
+
+
+static void
+benchmark()
+{
+  static float x[768];
+  const int n = 20000;
+  for (int p=0; p<768; p++)
+  {
+    x[p] = powf(273.15f - 40.0f + 340.0f * p / 767.0f, 4);
+  }
+
+  float sum = 0;
+  double t0 = test_now_us();
+  for (int i=0; i<n; i++)
+  {
+    for (int p=0; p<768; p++) sum += sqrtf(sqrtf(x[p]));
+    g_test_sink = sum;
+  }
+  double t1 = test_now_us();
+  for (int i=0; i<n; i++)
+  {
+    for (int p=0; p<768; p++) sum += fast_root4f(x[p]);
+    g_test_sink = sum;
+  }
+  double t2 = test_now_us();
+  printf("bench sqrtf(sqrtf(x)): %.2f ns per value\n", (t1 - t0) * 1e3 / (n * 768.0));
+  printf("bench fast_root4f:     %.2f ns per value (host FPU; the gain is on MCU's without one)\n", (t2 - t1) * 1e3 / (n * 768.0));
+}
+
+
+int
+main()
+{
+  test_special();
+  test_to_range();
+  test_normal_range();
+  benchmark();
+  return test_result("fast_math_test");
+}
@@ -0,0 +1,169 @@
+// float_to_dec against my_dtostrf (the digits of the DEC mv answer),
+// float_to_sci round trips, and a benchmark of the mv list formatting: per
+// value through my_dtostrf (as handle_cmd_mv did) versus float_to_dec.
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "i2c_stick_format.h"
+
+static uint32_t g_seed = 2024;
+
+
+static float
+rnd_float(float lo, float hi)
+{
+  g_seed = g_seed * 1664525UL + 1013904223UL;
+  return lo + (hi - lo) * ((g_seed >> 8) / (float)(1UL << 24));
+}
+
+
+static const char *
+dtostrf_trimmed(float val, uint8_t precision, char *buf)
+{
+  const char *p = my_dtostrf(val, 14, precision, buf);
+  while (*p == ' ') p++;
+  return p;
+}
+
+
+static uint32_t g_differences;
+
+
+// my_dtostrf extracts the decimals one by one in float, which truncates at
+// (near) ties and beyond the float resolution, e.g. 0.125 => "0.12" and
+// 129.505554 => "129.5055"; float_to_dec rounds once. A difference must be
+// one last digit, with the float_to_dec text correctly rounded.
+static uint8_t
+compare(float val, uint8_t precision)
+{
+  char ref_buf[20];
+  char buf[FLOAT_TO_DEC_MAX_LEN + 1];
+  const char *ref = dtostrf_trimmed(val, precision, ref_buf);
+  buf[float_to_dec(buf, val, precision)] = '\0';
+  if (strcmp(ref, buf) == 0) return 1;
+
+  double lsb = pow(10.0, -precision);
+  double ulp = nextafterf(fabsf(val), INFINITY) - fabsf(val);
+  double dec = strtod(buf, NULL);
+  CHECK(fabs(fabs(dec - strtod(ref, NULL)) - lsb) < lsb * 1e-3, "%.9g (precision %u): '%s' vs '%s'", val, precision, ref, buf);
+  CHECK(fabs(dec - val) <= lsb / 2 + ulp, "%.9g (precision %u): '%s' not rounded", val, precision, buf);
+  if (g_differences++ < 4) printf("  %.9g (precision %u): my_dtostrf '%s', float_to_dec '%s'\n", val, precision, ref, buf);
+  return 0;
+}
+
+
+static void
+test_dec()
+{
+  uint32_t count = 0;
+  uint32_t equal = 0;
+  for (uint8_t precision=0; precision<=4; precision++)
+  {
+    for (uint32_t i=0; i<200000; i++)
+    {
+      float val = rnd_float(-60.0f, 400.0f); // temperatures
+      equal += compare(val, precision);
+      count++;
+    }
+    for (int32_t i=-1000; i<=1000; i++)
+    { // decimal ties and steps, e.g. 0.125 or 23.45
+      equal += compare(i / 8.0f, precision);
+      equal += compare(i / 100.0f + 23.0f, precision);
+      count += 2;
+    }
+  }
+  const float special[] = { 0.0f, -0.0f, 1e7f, -1e7f, 20999999.0f, 3e9f, 123456789.0f };
+  for (uint8_t i=0; i<sizeof(special)/sizeof(special[0]); i++)
+  {
+    equal += compare(special[i], 2);
+    count++;
+  }
+  printf("float_to_dec: %u of %u equal to my_dtostrf, the others differ in the last digit\n", equal, count);
+
+  char buf[FLOAT_TO_DEC_MAX_LEN + 1];
+  buf[float_to_dec(buf, NAN, 2)] = '\0';
+  CHECK(strcmp(buf, "NaN") == 0, "NAN => '%s'", buf);
+  buf[float_to_dec(buf, -273.15f, 2)] = '\0';
+  CHECK(strcmp(buf, "-273.15") == 0, "-273.15 => '%s'", buf);
+  CHECK(float_to_dec(buf, -1e9f, 4) <= FLOAT_TO_DEC_MAX_LEN, "length");
+}
+
+
+static void
+test_sci()
+{
+  uint32_t bad = 0;
+  char buf[FLOAT_TO_DEC_MAX_LEN + 1];
+  for (uint32_t i=0; i<200000; i++)
+  {
+    float val;
+    g_seed = g_seed * 1664525UL + 1013904223UL;
+    uint32_t bits = g_seed & 0x7F7FFFFFUL; // finite
+    memcpy(&val, &bits, sizeof(val));
+    if (i & 1) val = -val;
+    uint8_t n = float_to_sci(buf, val);
+    buf[n] = '\0';
+    if ((n > FLOAT_TO_DEC_MAX_LEN) || (strtof(buf, NULL) != val))
+    {
+      if (bad++ < 5) printf("  %.9g => '%s'\n", val, buf);
+    }
+  }
+  CHECK(bad == 0, "%u values do not round trip", bad);
+  buf[float_to_sci(buf, 0.0f)] = '\0';
+  CHECK(strcmp(buf, "0") == 0, "0 => '%s'", buf);
+  buf[float_to_sci(buf, NAN)] = '\0';
+  CHECK(strcmp(buf, "NaN") == 0, "NAN => '%s'", buf);
+}
+
+
+static void
+benchmark()
+{ // one MLX90640 mv list: TA and 768 pixels, 2 decimals.
+  static float list[769];
+  static char out[769 * (FLOAT_TO_DEC_MAX_LEN + 1)];
+  const int n = 2000;
+  for (int i=0; i<769; i++) list[i] = rnd_float(-20.0f, 120.0f);
+
+  double t0 = test_now_us();
+  for (int k=0; k<n; k++)
+  { // as before: my_dtostrf, strip the padding, copy per value
+    char buf[20];
+    uint16_t pos = 0;
+    for (int i=0; i<769; i++)
+    {
+      if (i > 0) out[pos++] = ',';
+      const char *p = dtostrf_trimmed(list[i], 2, buf);
+      uint8_t len = strlen(p);
+      memcpy(out + pos, p, len);
+      pos += len;
+    }
+    out[pos] = '\0';
+    g_test_sink = out[k % pos];
+  }
+  double t1 = test_now_us();
+  for (int k=0; k<n; k++)
+  { // send_float_list_dec
+    uint16_t pos = 0;
+    for (int i=0; i<769; i++)
+    {
+      if (i > 0) out[pos++] = ',';
+      pos += float_to_dec(out + pos, list[i], 2);
+    }
+    out[pos] = '\0';
+    g_test_sink = out[k % pos];
+  }
+  double t2 = test_now_us();
+  printf("bench mv list (769 values): my_dtostrf %.1f us, float_to_dec %.1f us\n", (t1 - t0) / n, (t2 - t1) / n);
+}
+
+
+int
+main()
+{
+  test_dec();
+  test_sci();
+  benchmark();
+  return test_result("format_test");
+}
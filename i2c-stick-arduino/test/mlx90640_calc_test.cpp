@@ -0,0 +1,234 @@
+// MLX90640_CalculateToCalibrated against the reference MLX90640_CalculateTo
+// (bit accuracy), and a benchmark of both.
+//
+// The parameters are synthetic but in the range of real devices; the pixel
+// data is made with a simplified forward model, so the object temperatures
+// span -40..300 degC over the array.
+
+#include <math.h>
+#include <string.h>
+#include "test.h"
+#include "mlx90640_api.h"
+#include "mlx90640_i2c_driver.h"
+
+// the I2C layer is not used by the calculation.
+int MLX90640_I2CRead(uint8_t, uint16_t, uint16_t, uint16_t *) { return -1; }
+int MLX90640_I2CWrite(uint8_t, uint16_t, uint16_t) { return -1; }
+int MLX90640_I2CGeneralReset(void) { return -1; }
+
+static uint32_t g_seed = 12345;
+
+static int
+rnd(int lo, int hi)
+{ // deterministic LCG; [lo, hi]
+  g_seed = g_seed * 1664525UL + 1013904223UL;
+  return lo + (int)((g_seed >> 8) % (uint32_t)(hi - lo + 1));
+}
+
+
+static void
+make_params(paramsMLX90640 *params, uint8_t calibration_mode)
+{
+  memset(params, 0, sizeof(*params));
+  params->kVdd = -3168;
+  params->vdd25 = -13056;
+  params->KvPTAT = 0.0022f;
+  params->KtPTAT = 42.0f;
+  params->vPTAT25 = 12273;
+  params->alphaPTAT = 9.0f;
+  params->gainEE = 6000;
+  params->tgc = 0.5f;
+  params->cpKv = 0.375f;
+  params->cpKta = 0.0043f;
+  params->resolutionEE = 2;
+  params->calibrationModeEE = calibration_mode;
+  params->KsTa = -0.002f;
+  params->ksTo[0] = -0.0002f;
+  params->ksTo[1] = -0.0008f;
+  params->ksTo[2] = -0.0008f;
+  params->ksTo[3] = -0.0008f;
+  params->ksTo[4] = -0.0002f;
+  params->ct[0] = -40;
+  params->ct[1] = 0;
+  params->ct[2] = 160;
+  params->ct[3] = 320;
+  params->alphaScale = 12;
+  params->ktaScale = 13;
+  params->kvScale = 7;
+  for (int p=0; p<768; p++)
+  {
+    params->alpha[p] = (uint16_t)rnd(30000, 40000);
+    params->offset[p] = (int16_t)rnd(-120, 40);
+    params->kta[p] = (int8_t)rnd(20, 90);
+    params->kv[p] = (int8_t)rnd(20, 70);
+  }
+  params->cpAlpha[0] = 4.1e-9f;
+  params->cpAlpha[1] = 4.2e-9f;
+  params->cpOffset[0] = -60;
+  params->cpOffset[1] = -58;
+  params->ilChessC[0] = 0.5f;
+  params->ilChessC[1] = 2.0f;
+  params->ilChessC[2] = -0.25f;
+}
+
+
+static void
+make_frame(uint16_t *frame, const paramsMLX90640 *params, uint8_t chess_mode, uint8_t subpage)
+{
+  memset(frame, 0, 834 * sizeof(uint16_t));
+  frame[768] = 21147;                   // Vbe; Ta ~ 25degC
+  frame[776] = (uint16_t)(int16_t)-55;  // compensation pixels
+  frame[808] = (uint16_t)(int16_t)-53;
+  frame[778] = 6000;                    // gain
+  frame[800] = 1711;                    // PTAT
+  frame[810] = (uint16_t)(int16_t)-13080; // Vdd
+  frame[832] = (uint16_t)((2 << MLX90640_CTRL_RESOLUTION_SHIFT) | (chess_mode ? MLX90640_CTRL_MEAS_MODE_MASK : 0));
+  frame[833] = subpage;
+
+  float ta = MLX90640_GetTa(frame, params);
+  float ta4 = powf(ta + 273.15f, 4);
+  for (int p=0; p<768; p++)
+  {
+    float to = -40.0f + 340.0f * (float)((p * 389) % 768) / 767.0f;
+    float alpha = 1e-6f * 4096.0f / params->alpha[p];
+    float ir = alpha * (powf(to + 273.15f, 4) - ta4) + params->offset[p];
+    long raw = lroundf(ir);
+    if (raw > 32767) raw = 32767;
+    if (raw < -32768) raw = -32768;
+    frame[p] = (uint16_t)(int16_t)raw;
+  }
+}
+
+
+static uint32_t
+ulp_distance(float a, float b)
+{
+  int32_t ia, ib;
+  memcpy(&ia, &a, sizeof(ia));
+  memcpy(&ib, &b, sizeof(ib));
+  if (ia < 0) ia = INT32_MIN - ia;
+  if (ib < 0) ib = INT32_MIN - ib;
+  return (ia > ib) ? (uint32_t)(ia - ib) : (uint32_t)(ib - ia);
+}
+
+
+static void
+compare(uint8_t chess_mode, uint8_t subpage, uint8_t calibration_mode)
+{
+  static paramsMLX90640 params;
+  static calibrationMLX90640 calibration;
+  static uint16_t frame[834];
+  static float ref[768];
+  static float out[768];
+  static float out_fast[768];
+
+  make_params(&params, calibration_mode);
+  MLX90640_BuildCalibration(&params, &calibration);
+  make_frame(frame, &params, chess_mode, subpage);
+
+  for (int p=0; p<768; p++)
+  {
+    ref[p] = out[p] = out_fast[p] = -999.0f;
+  }
+  MLX90640_CalculateTo(frame, &params, 0.95f, 23.15f, ref);
+  MLX90640_CalculateToCalibrated(frame, &params, &calibration, 0.95f, 23.15f, out, 0, NULL);
+  MLX90640_CalculateToCalibrated(frame, &params, &calibration, 0.95f, 23.15f, out_fast, 1, NULL);
+
+  uint16_t visited = 0;
+  uint16_t identical = 0;
+  uint32_t max_ulp = 0;
+  float max_diff = 0;
+  float max_diff_fast = 0;
+  float lo = 1000, hi = -1000;
+  for (int p=0; p<768; p++)
+  {
+    CHECK((ref[p] == -999.0f) == (out[p] == -999.0f), "pixel %d visited by one calculation only", p);
+    // the index tables against the sub-page pattern
+    uint8_t pattern = chess_mode ? (((p >> 5) ^ p) & 1) : ((p >> 5) & 1);
+    CHECK((out[p] != -999.0f) == (pattern == subpage), "pixel %d of sub-page %d", p, pattern);
+    if (ref[p] == -999.0f) continue;
+    visited++;
+    if (ref[p] == out[p]) identical++;
+    uint32_t ulp = ulp_distance(ref[p], out[p]);
+    if (ulp > max_ulp) max_ulp = ulp;
+    if (fabsf(ref[p] - out[p]) > max_diff) max_diff = fabsf(ref[p] - out[p]);
+    if (fabsf(ref[p] - out_fast[p]) > max_diff_fast) max_diff_fast = fabsf(ref[p] - out_fast[p]);
+    if (ref[p] < lo) lo = ref[p];
+    if (ref[p] > hi) hi = ref[p];
+  }
+  printf("mode=%s subpage=%d calibration mode %s: %u pixels (%.1f..%.1f degC), %u bit identical, max %u ulp, max |diff| %.6f K (fast root %.6f K)\n",
+         chess_mode ? "chess" : "interleaved", subpage, (chess_mode ? 0x80 : 0) == calibration_mode ? "equal" : "differs",
+         visited, lo, hi, identical, max_ulp, max_diff, max_diff_fast);
+  CHECK(visited == 384, "%u pixels calculated", visited);
+  CHECK((lo < 0) && (hi > 250), "temperature range %.1f..%.1f", lo, hi);
+  // the reference evaluates part of the equations in double precision
+  // (e.g. 'vdd - 3.3'); the calibrated calculation stays in float.
+  CHECK(max_diff < 0.002f, "max |diff| %f", max_diff);
+  CHECK(max_diff_fast < 0.002f, "max |diff| fast root %f", max_diff_fast);
+
+  // the pixel mask only skips pixels; the others are bit identical.
+  static float masked[768];
+  uint32_t mask[24];
+  for (int i=0; i<24; i++) mask[i] = 0x55555555UL << (i & 1);
+  for (int p=0; p<768; p++) masked[p] = -999.0f;
+  MLX90640_CalculateToCalibrated(frame, &params, &calibration, 0.95f, 23.15f, masked, 0, mask);
+  for (int p=0; p<768; p++)
+  {
+    uint8_t in_mask = (mask[p >> 5] >> (p & 31)) & 1;
+    CHECK(masked[p] == (in_mask ? out[p] : -999.0f), "masked pixel %d", p);
+  }
+}
+
+
+static void
+benchmark()
+{
+  static paramsMLX90640 params;
+  static calibrationMLX90640 calibration;
+  static uint16_t frame[834];
+  static float to[768];
+  const int n = 2000;
+
+  make_params(&params, 0x80);
+  MLX90640_BuildCalibration(&params, &calibration);
+  make_frame(frame, &params, 1, 0);
+
+  double t0 = test_now_us();
+  for (int i=0; i<n; i++)
+  {
+    frame[833] = i & 1;
+    MLX90640_CalculateTo(frame, &params, 0.95f, 23.15f, to);
+  }
+  double t1 = test_now_us();
+  for (int i=0; i<n; i++)
+  {
+    frame[833] = i & 1;
+    MLX90640_CalculateToCalibrated(frame, &params, &calibration, 0.95f, 23.15f, to, 0, NULL);
+  }
+  double t2 = test_now_us();
+  for (int i=0; i<n; i++)
+  {
+    frame[833] = i & 1;
+    MLX90640_CalculateToCalibrated(frame, &params, &calibration, 0.95f, 23.15f, to, 1, NULL);
+  }
+  double t3 = test_now_us();
+  g_test_sink = to[0];
+  printf("bench sub-page To: CalculateTo %.1f us, CalculateToCalibrated %.1f us, + fast root %.1f us; calibration %u bytes\n",
+         (t1 - t0) / n, (t2 - t1) / n, (t3 - t2) / n, (unsigned)sizeof(calibrationMLX90640));
+}
+
+
+int
+main()
+{
+  for (uint8_t chess_mode=0; chess_mode<2; chess_mode++)
+  {
+    for (uint8_t subpage=0; subpage<2; subpage++)
+    {
+      compare(chess_mode, subpage, 0x80);
+      compare(chess_mode, subpage, 0x00);
+    }
+  }
+  benchmark();
+  return test_result("mlx90640_calc_test");
+}
@@ -0,0 +1,319 @@
+// The incremental MLX90640 frame acquisition (mlx90640_frame_sm) against a
+// simulated device: polling rate, sub-page selection, the validation and
+// error paths, and equivalence with the blocking MLX90640_GetFrameData.
+//
+// The device model keeps the RAM of the sensor and produces a new sub-page
+// every refresh period of simulated time; every I2C transaction takes one
+// millisecond of simulated time.
+
+#include <string.h>
+#include "test.h"
+#include "mlx90640_api.h"
+#include "mlx90640_i2c_driver.h"
+#include "mlx90640_frame_sm.h"
+#include "i2c_stick_hal.h"
+
+#define DEV_SA 0x33
+
+static uint16_t g_ram[0x10000];
+static uint32_t g_now_ms;
+static uint32_t g_next_frame_ms;
+static uint32_t g_period_ms;
+static uint32_t g_frame_count;
+static uint8_t g_nack;
+static uint32_t g_transactions;
+static uint32_t g_status_reads;
+static hal_i2c_xfer_t *g_xfer;
+
+
+static void
+dev_produce()
+{ // a new sub-page: pixels, aux data and the status register
+  uint8_t subpage = g_frame_count & 1;
+  for (uint16_t p=0; p<MLX90640_PIXEL_NUM; p++)
+  {
+    g_ram[MLX90640_PIXEL_DATA_START_ADDRESS + p] = (uint16_t)((g_frame_count * 7919UL + p * 31UL) & 0x7FFE);
+  }
+  for (uint16_t i=0; i<MLX90640_AUX_NUM; i++)
+  {
+    g_ram[MLX90640_AUX_DATA_START_ADDRESS + i] = (uint16_t)(0x1000 + g_frame_count + i);
+  }
+  g_ram[MLX90640_STATUS_REG] = (g_ram[MLX90640_STATUS_REG] & ~0x0009) | 0x0008 | subpage;
+  g_frame_count++;
+}
+
+
+static void
+dev_tick(uint32_t ms)
+{
+  g_now_ms += ms;
+  while ((int32_t)(g_now_ms - g_next_frame_ms) >= 0)
+  {
+    dev_produce();
+    g_next_frame_ms += g_period_ms;
+  }
+}
+
+
+static void
+dev_reset(uint32_t period_ms, uint32_t first_frame_ms)
+{
+  memset(g_ram, 0, sizeof(g_ram));
+  g_ram[MLX90640_CTRL_REG] = 0x1901;
+  g_ram[MLX90640_STATUS_REG] = 0x0020;
+  g_now_ms = 1000;
+  g_period_ms = period_ms;
+  g_next_frame_ms = g_now_ms + first_frame_ms;
+  g_frame_count = 0;
+  g_nack = 0;
+  g_transactions = 0;
+  g_status_reads = 0;
+  g_xfer = NULL;
+}
+
+
+int
+MLX90640_I2CRead(uint8_t sa, uint16_t address, uint16_t n, uint16_t *data)
+{
+  g_transactions++;
+  dev_tick(1);
+  if ((sa != DEV_SA) || g_nack) return -MLX90640_I2C_NACK_ERROR;
+  if (address == MLX90640_STATUS_REG) g_status_reads++;
+  memcpy(data, &g_ram[address], n * sizeof(uint16_t));
+  return MLX90640_NO_ERROR;
+}
+
+
+int
+MLX90640_I2CWrite(uint8_t sa, uint16_t address, uint16_t data)
+{
+  g_transactions++;
+  dev_tick(1);
+  if ((sa != DEV_SA) || g_nack) return -MLX90640_I2C_NACK_ERROR;
+  if (address == MLX90640_STATUS_REG)
+  { // the data ready flag is cleared by writing zero; the sub-page bits are read-only.
+    g_ram[address] = (g_ram[address] & 0x0007) | (data & 0x0030);
+    return MLX90640_NO_ERROR;
+  }
+  g_ram[address] = data;
+  return MLX90640_NO_ERROR;
+}
+
+
+int MLX90640_I2CGeneralReset(void) { return 0; }
+
+
+// the transaction engine: the pixel read continues in the background for one
+// poll, then completes.
+uint64_t hal_get_millis() { return g_now_ms; }
+
+
+int16_t
+hal_i2c_xfer_submit(hal_i2c_xfer_t *xfer)
+{
+  if (g_xfer != NULL) return -1;
+  xfer->state_ = HAL_I2C_XFER_QUEUED;
+  g_xfer = xfer;
+  return 0;
+}
+
+
+void
+hal_i2c_xfer_poll()
+{
+  hal_i2c_xfer_t *xfer = g_xfer;
+  if (xfer == NULL) return;
+  if (xfer->state_ == HAL_I2C_XFER_QUEUED)
+  {
+    xfer->state_ = HAL_I2C_XFER_BUSY;
+    return;
+  }
+  g_transactions++;
+  dev_tick(1);
+  uint16_t address = (uint16_t)((xfer->write_buffer_[0] << 8) | xfer->write_buffer_[1]);
+  for (uint16_t i=0; i<xfer->read_n_bytes_/2; i++)
+  { // big endian on the bus
+    xfer->read_buffer_[2*i] = g_ram[address + i] >> 8;
+    xfer->read_buffer_[2*i+1] = g_ram[address + i] & 0xFF;
+  }
+  xfer->result_ = ((xfer->sa_ != DEV_SA) || g_nack) ? -1 : 0;
+  xfer->state_ = HAL_I2C_XFER_DONE;
+  g_xfer = NULL;
+}
+
+
+int16_t
+hal_i2c_xfer_wait(hal_i2c_xfer_t *xfer)
+{
+  while (xfer->state_ != HAL_I2C_XFER_DONE) hal_i2c_xfer_poll();
+  return xfer->result_;
+}
+
+
+// steps the state machine with 1 ms of simulated time per call, like loop().
+static uint8_t
+drive(mlx90640_frame_sm_t *sm, uint32_t *steps, uint32_t *max_per_step)
+{
+  *steps = 0;
+  *max_per_step = 0;
+  while ((sm->state_ != MLX90640_SM_DONE) && (sm->state_ != MLX90640_SM_ERROR) && (*steps < 100000))
+  {
+    uint32_t before = g_transactions;
+    mlx90640_frame_sm_step(sm, g_now_ms);
+    if (g_transactions - before > *max_per_step) *max_per_step = g_transactions - before;
+    (*steps)++;
+    dev_tick(1);
+  }
+  return sm->state_;
+}
+
+
+static void
+test_polling()
+{
+  static mlx90640_frame_sm_t sm;
+  static uint16_t frame[834];
+  const uint8_t refresh_rate = 3; // 4Hz; 250 ms per sub-page
+  dev_reset(2000 >> refresh_rate, 200);
+
+  uint16_t interval = mlx90640_frame_sm_poll_interval(refresh_rate);
+  mlx90640_frame_sm_start(&sm, DEV_SA, frame, interval, 0x03);
+  uint32_t steps, max_per_step;
+  uint8_t state = drive(&sm, &steps, &max_per_step);
+  printf("polling: %u steps, %u status reads (interval %u ms), %u transactions, max %u per step\n",
+         steps, g_status_reads, interval, g_transactions, max_per_step);
+  CHECK(state == MLX90640_SM_DONE, "state %u, error %d", state, sm.error_);
+  CHECK(interval == 31, "poll interval %u", interval);
+  // ~200 ms wait at a 31 ms interval: 8 polls, plus the one of validate.
+  CHECK(g_status_reads <= 200U / interval + 3, "%u status reads", g_status_reads);
+  CHECK(steps > 100, "the wait is spread over %u steps", steps);
+  // READ_AUX reads the aux block and the control register; the others do one.
+  CHECK(max_per_step <= 2, "%u transactions in one step", max_per_step);
+  CHECK((g_ram[MLX90640_STATUS_REG] & 0x0008) == 0, "data ready flag not cleared");
+  CHECK(frame[833] == 0, "sub-page %u", frame[833]);
+  CHECK(frame[832] == 0x1901, "control register 0x%04X", frame[832]);
+  CHECK(memcmp(frame, &g_ram[MLX90640_PIXEL_DATA_START_ADDRESS], 2 * MLX90640_PIXEL_NUM) == 0, "pixel data");
+  CHECK(memcmp(&frame[MLX90640_PIXEL_NUM], &g_ram[MLX90640_AUX_DATA_START_ADDRESS], 2 * MLX90640_AUX_NUM) == 0, "aux data");
+}
+
+
+static void
+test_subpage_mask()
+{ // only sub-page 1 is accepted; sub-page 0 is left for the next caller.
+  static mlx90640_frame_sm_t sm;
+  static uint16_t frame[834];
+  dev_reset(250, 10);
+  mlx90640_frame_sm_start(&sm, DEV_SA, frame, 31, 0x02);
+  uint32_t steps, max_per_step;
+  uint8_t state = drive(&sm, &steps, &max_per_step);
+  CHECK(state == MLX90640_SM_DONE, "state %u, error %d", state, sm.error_);
+  CHECK(frame[833] == 1, "sub-page %u", frame[833]);
+  CHECK(g_frame_count == 2, "%u sub-pages produced", g_frame_count);
+  CHECK(mlx90640_frame_sm_run(&sm) == 1, "run on a done state machine");
+}
+
+
+static void
+test_equivalence()
+{ // the same device state through the state machine and the blocking read.
+  static mlx90640_frame_sm_t sm;
+  static uint16_t frame[834];
+  static uint16_t ref[834];
+  static uint16_t ram[0x10000];
+  for (uint8_t n=0; n<4; n++)
+  {
+    dev_reset(250, 250);
+    for (uint8_t i=0; i<=n; i++) dev_produce();
+    g_next_frame_ms = g_now_ms + 10000; // no new data during the read out
+    memcpy(ram, g_ram, sizeof(ram));
+    memset(frame, 0xAA, sizeof(frame));
+    memset(ref, 0xAA, sizeof(ref));
+
+    mlx90640_frame_sm_start(&sm, DEV_SA, frame, 31, 0x03);
+    int16_t subpage = mlx90640_frame_sm_run(&sm);
+    memcpy(g_ram, ram, sizeof(ram));
+    int result = MLX90640_GetFrameData(DEV_SA, ref);
+    CHECK(subpage == (n & 1), "state machine sub-page %d", subpage);
+    CHECK(result == subpage, "reference %d; state machine %d", result, subpage);
+    CHECK(memcmp(frame, ref, sizeof(frame)) == 0, "frame differs from MLX90640_GetFrameData (frame %u)", n);
+  }
+}
+
+
+static void
+test_errors()
+{
+  static mlx90640_frame_sm_t sm;
+  static uint16_t frame[834];
+  uint32_t steps, max_per_step;
+
+  // no acknowledge
+  dev_reset(250, 10);
+  g_nack = 1;
+  mlx90640_frame_sm_start(&sm, DEV_SA, frame, 31, 0x03);
+  CHECK(mlx90640_frame_sm_run(&sm) == -MLX90640_I2C_NACK_ERROR, "error %d", sm.error_);
+
+  // a line of the sub-page without valid data
+  dev_reset(250, 250);
+  dev_produce();
+  g_next_frame_ms = g_now_ms + 10000;
+  g_ram[MLX90640_PIXEL_DATA_START_ADDRESS] = 0x7FFF; // line 0, sub-page 0
+  mlx90640_frame_sm_start(&sm, DEV_SA, frame, 31, 0x03);
+  CHECK(mlx90640_frame_sm_run(&sm) == -MLX90640_FRAME_DATA_ERROR, "error %d", sm.error_);
+
+  // invalid aux data is not copied; the frame itself is fine
+  dev_reset(250, 250);
+  dev_produce();
+  g_next_frame_ms = g_now_ms + 10000;
+  g_ram[MLX90640_AUX_DATA_START_ADDRESS] = 0x7FFF;
+  for (uint16_t i=MLX90640_PIXEL_NUM; i<834; i++) frame[i] = 0x5555;
+  mlx90640_frame_sm_start(&sm, DEV_SA, frame, 31, 0x03);
+  CHECK(mlx90640_frame_sm_run(&sm) == 0, "error %d", sm.error_);
+  CHECK(frame[MLX90640_PIXEL_NUM] == 0x5555, "invalid aux data copied");
+
+  // new data during the read out
+  dev_reset(250, 10);
+  mlx90640_frame_sm_start(&sm, DEV_SA, frame, 31, 0x03);
+  while ((sm.state_ != MLX90640_SM_WAIT_PIXELS) && (sm.state_ != MLX90640_SM_ERROR))
+  {
+    mlx90640_frame_sm_step(&sm, g_now_ms);
+    dev_tick(1);
+  }
+  dev_produce();
+  CHECK(drive(&sm, &steps, &max_per_step) == MLX90640_SM_ERROR, "state %u", sm.state_);
+  CHECK(sm.error_ == -16, "error %d", sm.error_);
+}
+
+
+static void
+test_abort()
+{ // an abort during the background read waits for the buffer to be released.
+  static mlx90640_frame_sm_t sm;
+  static uint16_t frame[834];
+  dev_reset(250, 10);
+  mlx90640_frame_sm_start(&sm, DEV_SA, frame, 31, 0x03);
+  while ((sm.state_ != MLX90640_SM_WAIT_PIXELS) && (sm.state_ != MLX90640_SM_ERROR))
+  {
+    mlx90640_frame_sm_step(&sm, g_now_ms);
+    dev_tick(1);
+  }
+  mlx90640_frame_sm_step(&sm, g_now_ms); // the read is now in progress
+  CHECK(sm.xfer_.state_ == HAL_I2C_XFER_BUSY, "xfer state %u", sm.xfer_.state_);
+  mlx90640_frame_sm_abort(&sm);
+  CHECK(sm.state_ == MLX90640_SM_IDLE, "state %u", sm.state_);
+  CHECK(sm.xfer_.state_ == HAL_I2C_XFER_DONE, "xfer state %u", sm.xfer_.state_);
+  CHECK(g_xfer == NULL, "transaction still queued");
+  CHECK(mlx90640_frame_sm_run(&sm) == -1, "run on an idle state machine");
+}
+
+
+int
+main()
+{
+  test_polling();
+  test_subpage_mask();
+  test_equivalence();
+  test_errors();
+  test_abort();
+  return test_result("mlx90640_frame_sm_test");
+}
@@ -0,0 +1,141 @@
+// Temporal filter: history reservation, and a benchmark per filter variant.
+// Built twice: float and THERMAL_STORAGE_INT16 storage.
+
+#include <math.h>
+#include <string.h>
+#include "test.h"
+#include "i2c_stick_temporal.h"
+
+#define PIXELS 768
+
+struct block_t
+{
+  thermal_t state_[PIXELS];
+};
+POOL_DEFINE(g_pool, "TEST.FILTER", block_t, TEMPORAL_FILTER_MAX_BLOCKS);
+
+static thermal_t g_frame[PIXELS];
+
+
+static void
+make_frame(thermal_t *to_list, int n)
+{
+  for (int p=0; p<PIXELS; p++)
+  {
+    to_list[p] = thermal_from_float(25.0f + 0.01f * ((p * 7 + n * 13) % 50));
+  }
+}
+
+
+static void
+test_reservation()
+{
+  static temporal_filter_t a, b, c;
+  CHECK(temporal_filter_init(&a, &g_pool, PIXELS) == 0, "init a");
+  CHECK(temporal_filter_init(&b, &g_pool, PIXELS) == 0, "init b");
+  CHECK(pool_used(&g_pool) == 2, "IIR takes 1 block each: %u", pool_used(&g_pool));
+
+  // two moving averages of depth 4 fill the pool; configure reserves them.
+  CHECK(temporal_filter_configure(&a, TEMPORAL_FILTER_MOVING_AVERAGE, 4, 0) == 0, "a MA 4");
+  CHECK(temporal_filter_configure(&b, TEMPORAL_FILTER_MOVING_AVERAGE, 4, 0) == 0, "b MA 4");
+  CHECK(pool_used(&g_pool) == TEMPORAL_FILTER_MAX_BLOCKS, "pool full: %u", pool_used(&g_pool));
+
+  // a third filter is refused up front...
+  CHECK(temporal_filter_init(&c, &g_pool, PIXELS) == -2, "init c without history");
+  CHECK(temporal_filter_reserve(&c) == -2, "reserve c");
+  make_frame(g_frame, 0);
+  CHECK(temporal_filter_apply(&c, g_frame, 0) == -1, "c has no history");
+  // ...and a failed configure keeps the old settings and history.
+  CHECK(temporal_filter_configure(&a, TEMPORAL_FILTER_MOVING_AVERAGE, 5, 0) == -2, "a MA 5");
+  CHECK((a.depth_ == 4) && (a.block_count_ == 4), "a unchanged");
+  CHECK(temporal_filter_configure(&a, TEMPORAL_FILTER_MOVING_AVERAGE, TEMPORAL_FILTER_MAX_BLOCKS+1, 0) == -1, "MA depth above max");
+
+  // the accepted filters never run out of history.
+  for (int n=0; n<10; n++)
+  {
+    make_frame(g_frame, n);
+    CHECK(temporal_filter_apply(&a, g_frame, 0) == 0, "apply a %d", n);
+    CHECK(temporal_filter_apply(&b, g_frame, 0) == 0, "apply b %d", n);
+  }
+  temporal_filter_restart(&a);
+  CHECK(a.block_count_ == 4, "restart keeps the history");
+  temporal_filter_reset(&b);
+  CHECK(pool_used(&g_pool) == 4, "reset releases the history: %u", pool_used(&g_pool));
+  CHECK(temporal_filter_reserve(&c) == 0, "reserve c after b released");
+  CHECK(temporal_filter_apply(&c, g_frame, 0) == 0, "apply c");
+
+  // full depth moving average fits the pool alone.
+  temporal_filter_reset(&a);
+  temporal_filter_reset(&c);
+  CHECK(temporal_filter_configure(&a, TEMPORAL_FILTER_MOVING_AVERAGE, TEMPORAL_FILTER_MAX_BLOCKS, 0) == 0, "a MA max");
+  temporal_filter_reset(&a);
+  CHECK(pool_used(&g_pool) == 0, "pool empty: %u", pool_used(&g_pool));
+}
+
+
+static void
+test_filter_values()
+{ // a constant frame is a fixed point of every variant.
+  static temporal_filter_t f;
+  const uint8_t type_list[] = { TEMPORAL_FILTER_IIR, TEMPORAL_FILTER_ALPHA_BETA, TEMPORAL_FILTER_MOVING_AVERAGE };
+  temporal_filter_init(&f, &g_pool, PIXELS);
+  for (uint8_t t=0; t<3; t++)
+  {
+    CHECK(temporal_filter_configure(&f, type_list[t], 4, 2.5f) == 0, "configure %s", temporal_filter_type_to_str(type_list[t]));
+    for (int n=0; n<5; n++)
+    {
+      for (int p=0; p<PIXELS; p++) g_frame[p] = thermal_from_float(30.0f);
+      temporal_filter_apply(&f, g_frame, 0);
+    }
+    CHECK(fabsf(thermal_to_float(g_frame[100]) - 30.0f) < 0.05f, "%s: %f", temporal_filter_type_to_str(type_list[t]), thermal_to_float(g_frame[100]));
+  }
+  temporal_filter_reset(&f);
+}
+
+
+static void
+benchmark()
+{
+  static temporal_filter_t f;
+  struct { uint8_t type_; uint8_t depth_; } variant_list[] = {
+    { TEMPORAL_FILTER_IIR, 8 },
+    { TEMPORAL_FILTER_ALPHA_BETA, 8 },
+    { TEMPORAL_FILTER_MOVING_AVERAGE, 2 },
+    { TEMPORAL_FILTER_MOVING_AVERAGE, 4 },
+    { TEMPORAL_FILTER_MOVING_AVERAGE, TEMPORAL_FILTER_MAX_BLOCKS },
+  };
+  const int n = 5000;
+  temporal_filter_init(&f, &g_pool, PIXELS);
+  for (uint8_t v=0; v<sizeof(variant_list)/sizeof(variant_list[0]); v++)
+  {
+    temporal_filter_configure(&f, variant_list[v].type_, variant_list[v].depth_, 2.5f);
+    make_frame(g_frame, 0);
+    temporal_filter_apply(&f, g_frame, 0);
+    double t0 = test_now_us();
+    for (int i=0; i<n; i++)
+    {
+      g_frame[i % PIXELS] = thermal_from_float(20.0f + (i & 7));
+      temporal_filter_apply(&f, g_frame, 0);
+    }
+    double t1 = test_now_us();
+    g_test_sink = thermal_to_float(g_frame[0]);
+    printf("bench %s storage, %s depth %u: %.2f us per %d pixel frame\n",
+#ifdef THERMAL_STORAGE_INT16
+           "int16",
+#else
+           "float",
+#endif // THERMAL_STORAGE_INT16
+           temporal_filter_type_to_str(variant_list[v].type_), variant_list[v].depth_, (t1 - t0) / n, PIXELS);
+  }
+  temporal_filter_reset(&f);
+}
+
+
+int
+main()
+{
+  test_reservation();
+  test_filter_values();
+  benchmark();
+  return test_result("temporal_filter_test");
+}
@@ -0,0 +1,49 @@
+#ifndef __I2C_STICK_TEST_H__
+#define __I2C_STICK_TEST_H__
+
+// Minimal host test helpers
+// *************************
+//
+// The tests in this directory build with the host compiler (see Makefile);
+// they exercise the hardware independent parts of the firmware.
+// A test returns test_result() from main: 0 when every CHECK passed.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+static int g_test_failures = 0;
+
+#define CHECK(cond, ...) \
+  do { \
+    if (!(cond)) \
+    { \
+      g_test_failures++; \
+      printf("FAIL %s:%d: %s; ", __FILE__, __LINE__, #cond); \
+      printf(__VA_ARGS__); \
+      printf("\n"); \
+    } \
+  } while (0)
+
+
+static inline double
+test_now_us()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+
+// keeps the optimizer from dropping a benchmarked result.
+static volatile float g_test_sink;
+
+
+static inline int
+test_result(const char *name)
+{
+  printf("%s: %s\n", name, g_test_failures ? "FAILED" : "OK");
+  return g_test_failures ? 1 : 0;
+}
+
+#endif // __I2C_STICK_TEST_H__
@@ -1,16 +1,115 @@
 import serial
 import time
 import re
+import struct
+
+
+# framed binary protocol (+ch:FORMAT=FRAME); see i2c_stick_frame.h in the firmware.
+FRAME_TYPE_MV = 0x01
+FRAME_TYPE_RAW = 0x02
+FRAME_TYPE_ND = 0x03
+FRAME_TYPE_APP = 0x04
+FRAME_TYPE_MV_DELTA = 0x05
+FRAME_TYPE_MV_Q8 = 0x06
+QUANT_INVALID = 255
+FRAME_TYPE_FLAG_ERROR = 0x80
+FRAME_HEADER = struct.Struct('<BBBHIH')
+
+
+def cobs_decode(data):
+    """Decode a COBS encoded byte-string (without the 0x00 delimiters)"""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0:
+            raise ValueError("unexpected zero byte in COBS data")
+        if i + code > len(data):
+            raise ValueError("truncated COBS data")
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def crc16_ccitt(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE"""
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def dequantise(offset, scale, data):
+    """The mv values of an 8-bit quantised answer (+ch:QUANT)"""
+    return [offset + q * scale if q != QUANT_INVALID else float('nan') for q in data]
+
+
+def apply_mv_delta(mv_list, count, runs):
+    """Patch the last mv list with the runs of a delta (+ch:DELTA); returns None without a matching reference"""
+    if mv_list is None or len(mv_list) != count:
+        return None
+    mv_list = list(mv_list)
+    for first, values in runs:
+        mv_list[first:first + len(values)] = values
+    return mv_list
+
+
+def decode_frame(data):
+    """Decode one frame (COBS encoded, without the 0x00 delimiters); returns None when the frame is corrupt"""
+    try:
+        raw = cobs_decode(data)
+    except ValueError:
+        return None
+    if len(raw) < FRAME_HEADER.size + 2:
+        return None
+    (crc,) = struct.unpack_from('<H', raw, len(raw) - 2)
+    if crc16_ccitt(raw[:-2]) != crc:
+        return None
+    (frame_type, sa, drv, sequence, time_ms, payload_length) = FRAME_HEADER.unpack_from(raw, 0)
+    payload = raw[FRAME_HEADER.size:-2]
+    if len(payload) != payload_length:
+        return None
+    result = {'type': frame_type & ~FRAME_TYPE_FLAG_ERROR, 'sa': sa, 'drv': drv, 'sequence': sequence, 'time_ms': time_ms}
+    if frame_type & FRAME_TYPE_FLAG_ERROR:
+        result['error'] = payload.decode('utf-8', 'replace')
+    elif result['type'] in (FRAME_TYPE_MV, FRAME_TYPE_APP):
+        result['values'] = list(struct.unpack_from('<{}f'.format(payload_length // 4), payload))
+    elif result['type'] == FRAME_TYPE_RAW:
+        result['values'] = list(struct.unpack_from('<{}H'.format(payload_length // 2), payload))
+    elif result['type'] == FRAME_TYPE_ND:
+        result['values'] = [payload[0]]
+    elif result['type'] == FRAME_TYPE_MV_Q8:
+        (offset, scale) = struct.unpack_from('<ff', payload, 0)
+        result['values'] = dequantise(offset, scale, payload[8:])
+    elif result['type'] == FRAME_TYPE_MV_DELTA:
+        (result['count'],) = struct.unpack_from('<H', payload, 0)
+        result['runs'] = []
+        offset = 2
+        while offset + 4 <= payload_length:
+            (first, n) = struct.unpack_from('<HH', payload, offset)
+            offset += 4
+            result['runs'].append((first, list(struct.unpack_from('<{}f'.format(n), payload, offset))))
+            offset += 4 * n
+    else:
+        result['payload'] = payload
+    return result
 
 
 class I2CStick:
     ser = None
+    frame_mode = False
+    last_mv = {}  # per slave address; the reference for the delta messages
 
     def __init__(self, port):
         self.open(port)
 
     def open(self, port):
         """Open the PC connection to the I2C-stick"""
+        self.last_mv = {}
         self.ser = serial.Serial(port, 921600, timeout=5)
         self.ser.write(b'!')
         time.sleep(0.2)
@@ -24,14 +123,58 @@ class I2CStick:
             self.ser.close()
         self.ser = None
 
+    def read_frame(self):
+        """Read the next valid frame in the framed binary format; corrupt frames are skipped"""
+        while True:
+            data = self.ser.read_until(b'\x00')
+            if len(data) == 0:
+                return None  # timeout
+            data = data.rstrip(b'\x00')
+            if len(data) == 0:
+                continue  # delimiter between two frames
+            frame = decode_frame(data)
+            if frame is not None:
+                return frame
+
     def read_continuous_message(self):
         """Read the message from continuous mode"""
+        if self.frame_mode:
+            frame = self.read_frame()
+            if frame is None:
+                return None
+            mv_list = None
+            if frame['type'] in (FRAME_TYPE_MV, FRAME_TYPE_MV_Q8) and 'values' in frame:
+                mv_list = frame['values']
+            elif frame['type'] == FRAME_TYPE_MV_DELTA and 'runs' in frame:
+                mv_list = apply_mv_delta(self.last_mv.get(frame['sa']), frame['count'], frame['runs'])
+            if mv_list is None:
+                return None
+            self.last_mv[frame['sa']] = mv_list
+            return {'sa': frame['sa'], 'time': frame['time_ms'], 'drv': frame['drv'], 'mv': mv_list}
         line = self.ser.readline().decode('utf-8').rstrip()  # read a '\n' terminated line
         if line.startswith("@"):
             values = line.split(":")
-            if values[2] == 'mv':
+            sa = int(values[3], 16)
+            mv_list = None
+            if values[2] == 'mv' and values[5] == 'Q8':
+                # @SA:DRV:mv:SA:TIME:Q8:offset:scale:count, followed by count bytes
+                data = self.ser.read(int(values[8]))
+                mv_list = dequantise(float(values[6]), float(values[7]), data)
+                time_stamp = int(values[4])
+            elif values[2] == 'mv':
                 mv_list = [float(v) for v in values[-1].split(",")]
-                return {'sa': int(values[-3], 16), 'time': int(values[-2]), 'drv': int(values[1], 16), 'mv': mv_list}
+                time_stamp = int(values[-2])
+            elif values[2] == 'mvd':
+                # @SA:DRV:mvd:SA:TIME:COUNT:first=v,v;first=v,...
+                runs = []
+                for run in filter(None, values[6].split(";")):
+                    first, run_values = run.split("=")
+                    runs.append((int(first), [float(v) for v in run_values.split(",")]))
+                mv_list = apply_mv_delta(self.last_mv.get(sa), int(values[5]), runs)
+                time_stamp = int(values[4])
+            if mv_list is not None:
+                self.last_mv[sa] = mv_list
+                return {'sa': sa, 'time': time_stamp, 'drv': int(values[1], 16), 'mv': mv_list}
         return None
 
     def stop_continuous_mode(self):
@@ -49,6 +192,7 @@ class I2CStick:
         self.ser.flushInput()
         self.ser.flushOutput()
         self.ser.write(b';')
+        self.last_mv = {}  # the firmware starts with keyframes
         self.ser.readline().decode('utf-8').rstrip()  # read a '\n' terminated line
 
     def run_cmd(self, cmd):
@@ -183,6 +327,8 @@ class I2CStick:
         if a[0] != "+ch":
             return "wrong command returned"
         if a[1].startswith("OK"):
+            if item == "FORMAT":
+                self.frame_mode = str_value in ("FRAME", "3")
             return
         else:
             return a[1]